@@ -71,6 +71,19 @@
 #define sqImageFileSeek(f, pos)              		   fseek(f, pos, SEEK_SET)
 #define sqImageFileWrite(ptr, sz, count, f)  		   fwrite(ptr, sz, count, f)
 #define sqImageFileStartLocation(fileRef, fileName, size)  0
+/* sqImageFileReadSegment reads a segment of heap data from an image file;
+   platforms that can map the file may instead map its pages copy-on-write,
+   provided the file offset and the address are congruent modulo the page
+   size.  sqImageFileHeaderPadding answers how many bytes to pad the header
+   of an image being written so that heap data written at dataOffset is
+   congruent with address.  sqImageFileNoteSavedMemoryBase is told, before
+   the heap is allocated, the address at which it would have to start for
+   old space to land where it was saved.  By default segments are read, no
+   padding is added and the saved address is ignored.
+*/
+#define sqImageFileReadSegment(ptr, sz, count, f)  	   sqImageFileRead(ptr, sz, count, f)
+#define sqImageFileHeaderPadding(dataOffset, address)	   0
+#define sqImageFileNoteSavedMemoryBase(address)		   ((void)0)
 
 /* Platform-dependent macros for handling object memory. */
 
@@ -97,6 +110,58 @@
  */
 extern void *sqAllocateMemorySegmentOfSizeAboveAllocatedSizeInto(sqInt sz, void *minAddr, sqInt *asp);
 extern void sqDeallocateMemorySegmentAtOfSize(void *addr, sqInt sz);
+/* Give the pages lying wholly within [startAddr, endAddr) back to the OS,
+ * answering the number of bytes released.  The range stays mapped; its
+ * contents are undefined until next written.  sqResidentBytesFromTo answers
+ * how many bytes of [startAddr, endAddr) are backed by physical memory.
+ */
+extern usqInt sqDecommitMemoryFromTo(usqInt startAddr, usqInt endAddr);
+extern usqInt sqResidentBytesFromTo(usqInt startAddr, usqInt endAddr);
+/* Answer how many bytes of [startAddr, endAddr) are backed by huge pages. */
+extern usqInt sqHugePageBytesFromTo(usqInt startAddr, usqInt endAddr);
+/* Answer the memory limit imposed on the process (e.g. by its cgroup), or 0 if
+ * none, and whether its memory use is close enough to that limit that the VM
+ * should collect garbage and signal low space.
+ */
+extern usqInt sqMemoryLimit(void);
+extern sqInt sqMemoryIsNearLimit(void);
+
+/* Support for the parallel phases of the Spur GC.  ioNumGCThreads answers the
+ * number of threads, including the VM thread, that run a parallel phase; 1
+ * means the phase runs serially.  ioGCThreadsDo evaluates work(i, arg) for each
+ * i in [0, ioNumGCThreads()), the VM thread doing 0, and answers when all have
+ * finished.  Work functions must bracket any use of the memory manager proper
+ * (allocation, remembering) with ioLockGCThreads/ioUnlockGCThreads.
+ * ioNumThreadsDo is ioGCThreadsDo for phases outside the GC that choose their
+ * own number of threads, such as swizzling the heap at startup; it may run
+ * fewer than numThreads if the platform cannot provide them.
+ */
+extern int  ioNumGCThreads(void);
+extern void ioSetNumGCThreads(int numThreads);
+extern void ioGCThreadsDo(void (*work)(sqInt, void *), void *arg);
+extern void ioNumThreadsDo(int numThreads, void (*work)(sqInt, void *), void *arg);
+extern int  ioNumProcessors(void);
+extern void ioLockGCThreads(void);
+extern void ioUnlockGCThreads(void);
+
+/* Support for marking old space concurrently with the mutator.
+ * ioStartBackgroundGCWork runs work(arg) on a thread of its own, answering 0
+ * if it cannot (e.g. in a forked child); ioWaitForBackgroundGCWork answers
+ * when it has finished.  The marker finds the objects the mutator has stored
+ * into since it began from the pages the OS has seen written.
+ * sqCanTrackDirtyPages answers whether the platform can say which pages have
+ * been written since sqClearDirtyPages; so far only x86 Linux kernels with
+ * soft-dirty bits can, and there sqClearDirtyPages clears them process-wide.  sqDirtyPagesFromToInto sets dirty[i]
+ * non-zero for each page i of sqDirtyPageSize() bytes from startAddr written
+ * since then, answering 0 if it cannot tell, in which case all must be
+ * assumed written.
+ */
+extern int  ioStartBackgroundGCWork(void (*work)(void *), void *arg);
+extern void ioWaitForBackgroundGCWork(void);
+extern sqInt sqCanTrackDirtyPages(void);
+extern void sqClearDirtyPages(void);
+extern usqInt sqDirtyPageSize(void);
+extern sqInt sqDirtyPagesFromToInto(usqInt startAddr, usqInt endAddr, unsigned char *dirty);
 #endif /* SPURVM */
 /* Platform-dependent memory size adjustment macro. */
 
@@ -569,6 +634,26 @@ sqInt ioDisableImageWrite(void);
 /* Save/restore. */
 /* Read the image from the given file starting at the given image offset */
 size_t readImageFromFileHeapSizeStartingAt(sqImageFile f, usqInt desiredHeapSize, squeakFileOffsetType imageOffset);
+/* Print the time taken by a step of loading the image if -timephases is on. */
+void printLoadPhaseTime(char *phaseName);
+/* Write and read the heap data of images saved compressed, in frames that are
+ * compressed and decompressed on several threads where the platform has them
+ * (see sqImageCompression.c).  Both answer count if all count bytes were
+ * written or read; the reader answers 0 if the data is malformed.
+ */
+size_t sqImageFileWriteCompressed(void *ptr, size_t count, sqImageFile f);
+size_t sqImageFileReadCompressed(void *ptr, size_t count, sqImageFile f);
+/* Background snapshots.  ioForkForSnapshot forks a child process to write the
+ * image from its copy-on-write view of the heap, answering 0 in the child and
+ * 1 in the parent.  When the child exits the parent signals the semaphore with
+ * index semaIndex.  Answer -1 if the platform can't fork, or -2 if the child of
+ * a previous background snapshot is still writing.  ioExitSnapshotChild ends
+ * the child with the given status; ioBackgroundSnapshotStatus answers the exit
+ * status of the last child, or -1 while one is running.
+ */
+int  ioForkForSnapshot(sqInt semaIndex);
+void ioExitSnapshotChild(int status);
+int  ioBackgroundSnapshotStatus(void);
 
 /* Clipboard (cut/copy/paste). */
 sqInt clipboardSize(void);
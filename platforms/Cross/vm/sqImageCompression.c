@@ -0,0 +1,424 @@
+/****************************************************************************
+ *   PROJECT: Compressed heap data for Spur image files
+ *   FILE:    sqImageCompression.c
+ *   CONTENT: A small LZ77 codec, and the framing that lets heap data be
+ *            compressed and decompressed on several threads.
+ *
+ *   NOTES: Compressed heap data is a sequence of frames, each holding at most
+ *          FrameBytes of the heap data of a single segment:
+ *            4 bytes  the number of bytes of heap data, little-endian
+ *            4 bytes  the number of bytes stored, little-endian
+ *            the stored bytes, which are the heap data itself if compressing
+ *            it would not have made it smaller, and LZ data otherwise.
+ *          Frames are independent, so a batch of them can be decompressed
+ *          in parallel, and while it is the VM thread reads the next batch
+ *          from the file.  Threads come from ioNumThreadsDo, so on platforms
+ *          without a GC thread pool everything runs on the VM thread.
+ *
+ *          The LZ data is a sequence of LZ4-style sequences: a token whose
+ *          high nibble is the number of literals and whose low nibble is the
+ *          match length less MinMatch (15 in either meaning more length bytes
+ *          follow, each added in, until one is less than 255), the literals,
+ *          then a two byte little-endian offset back to the match and any
+ *          extra match length bytes.  The last sequence has only literals.
+ *
+ ****************************************************************************/
+
+#include "sq.h"
+
+#if SPURVM
+#include <stdlib.h>
+#include <string.h>
+
+#define FrameBytes (1 << 20)
+#define FrameHeaderBytes 8
+#define FramesPerBatch 16
+#define HashLog 16
+#define MaxOffset 65535
+#define MinMatch 4
+
+typedef struct {
+	unsigned char *data;	/* where the frame's heap data is/goes */
+	size_t dataBytes;
+	unsigned char *stored;	/* the frame as stored in the file */
+	size_t storedBytes;
+} ImageFrame;
+
+static ImageFrame frames[2][FramesPerBatch];
+static int numFrames[2];
+static unsigned char *frameBuffers[2];
+static unsigned int *hashTables;
+static int currentBatch, readingBatch, nextFrame, frameError;
+static sqImageFile frameFile;
+static unsigned char *readData;
+static size_t readRemaining;
+
+/* The LZ codec. */
+
+static unsigned int
+read32(const unsigned char *p)
+{
+	unsigned int v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+#define hashOf(v) (((v) * 2654435761U) >> (32 - HashLog))
+
+static unsigned char *
+emitLength(unsigned char *op, unsigned char *opLimit, size_t length)
+{
+	while (length >= 255) {
+		if (op >= opLimit)
+			return 0;
+		*op++ = 255;
+		length -= 255;
+	}
+	if (op >= opLimit)
+		return 0;
+	*op++ = (unsigned char)length;
+	return op;
+}
+
+/* Emit a sequence of numLiterals literals followed, if matchLength >= 0, by a
+ * match of matchLength + MinMatch bytes at offset.  Answer the next output
+ * position, or null if the sequence doesn't fit before opLimit.
+ */
+static unsigned char *
+emitSequence(unsigned char *op, unsigned char *opLimit,
+			 const unsigned char *literals, size_t numLiterals,
+			 size_t offset, long matchLength)
+{
+	unsigned char *token;
+	size_t lengthNibble = matchLength < 15 ? (matchLength < 0 ? 0 : matchLength) : 15;
+
+	if (op >= opLimit)
+		return 0;
+	token = op++;
+	*token = (unsigned char)(((numLiterals < 15 ? numLiterals : 15) << 4) | lengthNibble);
+	if (numLiterals >= 15
+	 && !(op = emitLength(op, opLimit, numLiterals - 15)))
+		return 0;
+	if ((size_t)(opLimit - op) < numLiterals)
+		return 0;
+	memcpy(op, literals, numLiterals);
+	op += numLiterals;
+	if (matchLength < 0)
+		return op;
+	if (opLimit - op < 2)
+		return 0;
+	*op++ = (unsigned char)(offset & 0xFF);
+	*op++ = (unsigned char)(offset >> 8);
+	if (matchLength >= 15
+	 && !(op = emitLength(op, opLimit, matchLength - 15)))
+		return 0;
+	return op;
+}
+
+/* Compress srcBytes at src into at most dstCapacity bytes at dst, using the
+ * 1 << HashLog entry table to find matches.  Answer the compressed size, or 0
+ * if it would exceed dstCapacity.
+ */
+static size_t
+lzCompress(const unsigned char *src, size_t srcBytes,
+		   unsigned char *dst, size_t dstCapacity, unsigned int *table)
+{
+	const unsigned char *ip = src, *anchor = src;
+	const unsigned char *end = src + srcBytes;
+	const unsigned char *searchLimit = srcBytes > MinMatch ? end - MinMatch : src;
+	unsigned char *op = dst, *opLimit = dst + dstCapacity;
+
+	memset(table, 0, sizeof(unsigned int) << HashLog);
+	while (ip < searchLimit) {
+		unsigned int h = hashOf(read32(ip));
+		const unsigned char *ref = src + table[h];
+		const unsigned char *mp, *rp;
+
+		table[h] = (unsigned int)(ip - src);
+		if (ref >= ip
+		 || ip - ref > MaxOffset
+		 || read32(ref) != read32(ip)) {
+			/* skip faster through data that doesn't compress */
+			ip += 1 + ((ip - anchor) >> 6);
+			continue;
+		}
+		mp = ip + MinMatch;
+		rp = ref + MinMatch;
+		while (mp < end && *mp == *rp)
+			mp++, rp++;
+		if (!(op = emitSequence(op, opLimit, anchor, ip - anchor, ip - ref,
+								(mp - ip) - MinMatch)))
+			return 0;
+		ip = anchor = mp;
+	}
+	if (!(op = emitSequence(op, opLimit, anchor, end - anchor, 0, -1)))
+		return 0;
+	return op - dst;
+}
+
+static const unsigned char *
+readLength(const unsigned char *ip, const unsigned char *ipEnd, size_t *length)
+{
+	unsigned int b;
+
+	do {
+		if (ip >= ipEnd)
+			return 0;
+		*length += (b = *ip++);
+	}
+	while (b == 255);
+	return ip;
+}
+
+/* Decompress srcBytes at src into exactly dstBytes at dst.  Answer whether
+ * the data was well-formed; nothing is written outside dst.
+ */
+static int
+lzDecompress(const unsigned char *src, size_t srcBytes,
+			 unsigned char *dst, size_t dstBytes)
+{
+	const unsigned char *ip = src, *ipEnd = src + srcBytes;
+	unsigned char *op = dst, *opEnd = dst + dstBytes;
+
+	while (ip < ipEnd) {
+		unsigned int token = *ip++;
+		size_t length = token >> 4, offset;
+		const unsigned char *match;
+
+		if (length == 15
+		 && !(ip = readLength(ip, ipEnd, &length)))
+			return 0;
+		if ((size_t)(ipEnd - ip) < length
+		 || (size_t)(opEnd - op) < length)
+			return 0;
+		memcpy(op, ip, length);
+		op += length;
+		ip += length;
+		if (ip == ipEnd)
+			break;
+		if (ipEnd - ip < 2)
+			return 0;
+		offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (offset == 0
+		 || offset > (size_t)(op - dst))
+			return 0;
+		length = token & 15;
+		if (length == 15
+		 && !(ip = readLength(ip, ipEnd, &length)))
+			return 0;
+		length += MinMatch;
+		if ((size_t)(opEnd - op) < length)
+			return 0;
+		match = op - offset;
+		if (offset >= length) {
+			memcpy(op, match, length);
+			op += length;
+		}
+		else
+			while (length-- > 0)
+				*op++ = *match++;
+	}
+	return op == opEnd;
+}
+
+/* Frames. */
+
+static void
+putLittleEndian32(unsigned char *p, size_t v)
+{
+	p[0] = v & 0xFF; p[1] = (v >> 8) & 0xFF; p[2] = (v >> 16) & 0xFF; p[3] = (v >> 24) & 0xFF;
+}
+
+static size_t
+getLittleEndian32(unsigned char *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((size_t)p[3] << 24);
+}
+
+static int
+numFrameThreads(void)
+{
+	int n = ioNumProcessors();
+
+	return n < 1 ? 1 : n > FramesPerBatch ? FramesPerBatch : n;
+}
+
+static int
+claimFrame(void)
+{
+	int i;
+
+	ioLockGCThreads();
+	i = nextFrame++;
+	ioUnlockGCThreads();
+	return i;
+}
+
+static void
+freeFrameBuffers(void)
+{
+	free(frameBuffers[0]);
+	free(frameBuffers[1]);
+	free(hashTables);
+	frameBuffers[0] = frameBuffers[1] = 0;
+	hashTables = 0;
+}
+
+static void
+compressFramesWorker(sqInt workerIndex, void *unused)
+{
+	unsigned int *table = hashTables + ((usqInt)workerIndex << HashLog);
+	int i;
+
+	while ((i = claimFrame()) < numFrames[0]) {
+		ImageFrame *frame = &frames[0][i];
+		size_t n = lzCompress(frame->data, frame->dataBytes,
+							  frame->stored, frame->dataBytes - 1, table);
+
+		if (n > 0)
+			frame->storedBytes = n;
+		else {
+			frame->stored = frame->data;
+			frame->storedBytes = frame->dataBytes;
+		}
+	}
+}
+
+/* Write count bytes of heap data at ptr to f as compressed frames.  Answer
+ * count if all were written, and less otherwise.
+ */
+size_t
+sqImageFileWriteCompressed(void *ptr, size_t count, sqImageFile f)
+{
+	unsigned char header[FrameHeaderBytes];
+	unsigned char *data = ptr;
+	size_t written = 0;
+	int i, numThreads = numFrameThreads();
+
+	frameBuffers[0] = malloc((size_t)FramesPerBatch * FrameBytes);
+	hashTables = malloc(((size_t)numThreads * sizeof(unsigned int)) << HashLog);
+	if (!frameBuffers[0] || !hashTables) {
+		freeFrameBuffers();
+		return 0;
+	}
+	while (written < count) {
+		size_t batchBytes = 0;
+
+		for (i = 0; i < FramesPerBatch && written + batchBytes < count; i++) {
+			size_t remaining = count - (written + batchBytes);
+
+			frames[0][i].data = data + written + batchBytes;
+			frames[0][i].dataBytes = remaining < FrameBytes ? remaining : FrameBytes;
+			frames[0][i].stored = frameBuffers[0] + (size_t)i * FrameBytes;
+			batchBytes += frames[0][i].dataBytes;
+		}
+		numFrames[0] = i;
+		nextFrame = 0;
+		ioNumThreadsDo(numThreads, compressFramesWorker, 0);
+		for (i = 0; i < numFrames[0]; i++) {
+			putLittleEndian32(header, frames[0][i].dataBytes);
+			putLittleEndian32(header + 4, frames[0][i].storedBytes);
+			if (sqImageFileWrite(header, 1, FrameHeaderBytes, f) != FrameHeaderBytes
+			 || sqImageFileWrite(frames[0][i].stored, 1, frames[0][i].storedBytes, f)
+					!= frames[0][i].storedBytes) {
+				freeFrameBuffers();
+				return written;
+			}
+			written += frames[0][i].dataBytes;
+		}
+	}
+	freeFrameBuffers();
+	return written;
+}
+
+/* Read the next batch of frames from frameFile into frames[batch].  Frames
+ * stored uncompressed are read straight into place.
+ */
+static void
+readFrameBatch(int batch)
+{
+	unsigned char header[FrameHeaderBytes];
+	int n;
+
+	for (n = 0; n < FramesPerBatch && readRemaining > 0; n++) {
+		ImageFrame *frame = &frames[batch][n];
+
+		if (sqImageFileRead(header, 1, FrameHeaderBytes, frameFile) != FrameHeaderBytes) {
+			frameError = 1;
+			break;
+		}
+		frame->dataBytes = getLittleEndian32(header);
+		frame->storedBytes = getLittleEndian32(header + 4);
+		if (frame->dataBytes == 0
+		 || frame->dataBytes > FrameBytes
+		 || frame->dataBytes > readRemaining
+		 || frame->storedBytes == 0
+		 || frame->storedBytes > frame->dataBytes) {
+			frameError = 1;
+			break;
+		}
+		frame->data = readData;
+		frame->stored = frame->storedBytes == frame->dataBytes
+							? readData
+							: frameBuffers[batch] + (size_t)n * FrameBytes;
+		if (sqImageFileRead(frame->stored, 1, frame->storedBytes, frameFile)
+				!= frame->storedBytes) {
+			frameError = 1;
+			break;
+		}
+		readData += frame->dataBytes;
+		readRemaining -= frame->dataBytes;
+	}
+	numFrames[batch] = n;
+}
+
+static void
+decompressFramesWorker(sqInt workerIndex, void *unused)
+{
+	int i;
+
+	if (workerIndex == 0 && readingBatch >= 0)
+		readFrameBatch(readingBatch);
+	while ((i = claimFrame()) < numFrames[currentBatch]) {
+		ImageFrame *frame = &frames[currentBatch][i];
+
+		if (frame->stored != frame->data
+		 && !lzDecompress(frame->stored, frame->storedBytes,
+						  frame->data, frame->dataBytes))
+			frameError = 1;
+	}
+}
+
+/* Read count bytes of heap data in compressed frames from f into ptr.  Answer
+ * count, or 0 if the data is malformed or the file too short.
+ */
+size_t
+sqImageFileReadCompressed(void *ptr, size_t count, sqImageFile f)
+{
+	int numThreads = numFrameThreads();
+
+	frameBuffers[0] = malloc((size_t)FramesPerBatch * FrameBytes);
+	frameBuffers[1] = malloc((size_t)FramesPerBatch * FrameBytes);
+	if (!frameBuffers[0] || !frameBuffers[1]) {
+		freeFrameBuffers();
+		return 0;
+	}
+	frameFile = f;
+	readData = ptr;
+	readRemaining = count;
+	frameError = 0;
+	readFrameBatch(currentBatch = 0);
+	while (numFrames[currentBatch] > 0 && !frameError) {
+		readingBatch = readRemaining > 0 ? 1 - currentBatch : -1;
+		nextFrame = 0;
+		ioNumThreadsDo(numThreads, decompressFramesWorker, 0);
+		if (readingBatch < 0)
+			break;
+		currentBatch = readingBatch;
+	}
+	freeFrameBuffers();
+	return frameError || readRemaining > 0 ? 0 : count;
+}
+#endif /* SPURVM */
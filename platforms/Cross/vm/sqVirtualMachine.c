@@ -200,6 +200,10 @@ sqInt stringForCString(char *);
 sqInt primitiveFailForOSError(sqLong);
 sqInt primitiveFailForFFIExceptionat(usqLong exceptionCode, usqInt pc);
 #endif
+#if VM_PROXY_MINOR > 14 /* Pooled pinned buffers for FFI & socket I/O */
+sqInt allocatePinnedBuffer(sqInt byteSize);
+sqInt releasePinnedBuffer(sqInt bufferOop);
+#endif
 
 void *ioLoadFunctionFrom(char *fnName, char *modName);
 
@@ -535,6 +539,11 @@ struct VirtualMachine* sqGetInterpreterProxy(void)
 	VM->primitiveFailForFFIExceptionat = primitiveFailForFFIExceptionat;
 #endif
 
+#if VM_PROXY_MINOR > 14 /* Pooled pinned buffers for FFI & socket I/O */
+	VM->allocatePinnedBuffer = allocatePinnedBuffer;
+	VM->releasePinnedBuffer = releasePinnedBuffer;
+#endif
+
 	return VM;
 }
 
@@ -618,10 +627,12 @@ popOutputFile()
 	*stdout = stdoutStack[stdoutStackIdx--];
 }
 
+static	int printTimes;
+static	usqLong lastLoadPhaseUsecs;
+
 void
 printPhaseTime(int phase)
 {
-	static	int printTimes;
 	static	usqLong lastusecs;
 			usqLong nowusecs, usecs;
 
@@ -632,7 +643,7 @@ printPhaseTime(int phase)
 		nowt = time(0);
 		nowtm = *localtime(&nowt);
 		printf("started at %s", asctime(&nowtm));
-		lastusecs = ioUTCMicrosecondsNow();
+		lastLoadPhaseUsecs = lastusecs = ioUTCMicrosecondsNow();
 		return;
 	}
 
@@ -656,3 +667,21 @@ printPhaseTime(int phase)
 #undef m
 #undef k
 }
+
+/* Called by the VM as it loads the image to print the time taken by each step
+ * of loading, e.g. reading the heap and swizzling it.
+ */
+void
+printLoadPhaseTime(char *phaseName)
+{
+	usqLong nowusecs, usecs;
+
+	if (!printTimes) return;
+
+	nowusecs = ioUTCMicrosecondsNow();
+	usecs = nowusecs - lastLoadPhaseUsecs;
+	lastLoadPhaseUsecs = nowusecs;
+	printf("  %s in %lu.%03lus\n", phaseName,
+			(unsigned long)(usecs / 1000000ULL),
+			(unsigned long)((usecs % 1000000ULL + 500ULL) / 1000ULL));
+}
@@ -361,6 +361,11 @@ typedef struct VirtualMachine {
   sqInt  (*methodReturnReceiver)(void);
   sqInt  (*primitiveFailForFFIExceptionat)(usqLong exceptionCode, usqInt pc);
 #endif
+
+#if VM_PROXY_MINOR > 14 /* Pooled pinned buffers for FFI & socket I/O */
+  sqInt  (*allocatePinnedBuffer)(sqInt byteSize);
+  sqInt  (*releasePinnedBuffer)(sqInt bufferOop);
+#endif
 } VirtualMachine;
 
 #endif /* _SqueakVM_H */
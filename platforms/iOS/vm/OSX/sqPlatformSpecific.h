@@ -84,6 +84,23 @@ extern usqInt sqAllocateMemory(usqInt minHeapSize, usqInt desiredHeapSize);
 # define allocateMemoryMinimumImageFileHeaderSize(heapSize, minimumMemory, fileStream, headerSize) \
 sqAllocateMemory(minimumMemory, heapSize)
 # define sqMacMemoryFree() 
+/* -mmapimage maps the image's heap data rather than reading it; see
+ * sqUnixSpurMemory.c.
+ */
+# undef sqImageFileOpen
+# undef sqImageFileReadSegment
+# undef sqImageFileHeaderPadding
+# undef sqImageFileNoteSavedMemoryBase
+extern FILE *sqImageFileOpenOrUnlink(char *fileName, char *mode);
+extern size_t sqImageFileMapOrRead(void *ptr, size_t sz, size_t count, FILE *f);
+extern usqInt sqImageFileHeaderPaddingFor(squeakFileOffsetType dataOffset, usqInt address);
+extern void sqImageFileNoteSavedMemoryBaseAt(usqInt address);
+# define sqImageFileOpen(fileName, mode) sqImageFileOpenOrUnlink(fileName, mode)
+# define sqImageFileReadSegment(ptr, sz, count, f) sqImageFileMapOrRead(ptr, sz, count, f)
+# define sqImageFileHeaderPadding(dataOffset, address) \
+	sqImageFileHeaderPaddingFor(dataOffset, address)
+# define sqImageFileNoteSavedMemoryBase(address) \
+	sqImageFileNoteSavedMemoryBaseAt(address)
 #else
 usqInt sqAllocateMemoryMac(usqInt desiredHeapSize,sqInt minHeapSize, FILE * f,usqInt headersize);
 #define allocateMemoryMinimumImageFileHeaderSize(heapSize, minimumMemory, fileStream, headerSize) \
@@ -274,6 +274,28 @@ static char *getVersionInfo(int verbose);
 		openScavengeLog();
 		return 1;
 	}
+	if ([argData isEqualToString: VMOPTIONOBJ("hugepages")]) {
+		extern int useHugePages;
+		useHugePages = 1;
+		return 1;
+	}
+	if ([argData isEqualToString: VMOPTIONOBJ("prefault")]) {
+		extern int prefaultMemory;
+		prefaultMemory = 1;
+		return 1;
+	}
+	if ([argData isEqualToString: VMOPTIONOBJ("mmapimage")]) {
+		extern int mmapImageFile;
+		mmapImageFile = 1;
+		return 1;
+	}
+# if SPURGCOPTIONS
+	if ([argData isEqualToString: VMOPTIONOBJ("cardmarking")]) {
+		extern sqInt useCardMarking;
+		useCardMarking = 1;
+		return 1;
+	}
+# endif
 #endif
 
 	/* Options with arguments */
@@ -343,6 +365,20 @@ static char *getVersionInfo(int verbose);
 		desiredCogCodeSize = [self strtobkm: peek];		 
 		return 2;
 	}
+# if COGGROWABLECODEZONE
+	if ([argData isEqualToString: VMOPTIONOBJ("maxcodesize")]) {
+		extern sqInt desiredMaxCogCodeSize;
+		desiredMaxCogCodeSize = [self strtobkm: peek];		 
+		return 2;
+	}
+# endif
+# if COGCODECACHE
+	if ([argData isEqualToString: VMOPTIONOBJ("codecache")]) {
+		extern void setMachineCodeCacheFile(char *fileName);
+		setMachineCodeCacheFile(peek);
+		return 2;
+	}
+# endif
 	if ([argData isEqualToString: VMOPTIONOBJ("dpcso")]) {
 		extern unsigned long debugPrimCallStackOffset;
 		debugPrimCallStackOffset = (unsigned long)[self strtobkm: peek];		 
@@ -358,6 +394,13 @@ static char *getVersionInfo(int verbose);
 		minBackwardJumpCountForCompile = [self strtobkm: peek];		 
 		return 2;
 	}
+# if COGMAXPIC
+	if ([argData isEqualToString: VMOPTIONOBJ("maxpic")]) {
+		extern sqInt maxCPICCases;
+		maxCPICCases = atoi(peek);
+		return 2;
+	}
+# endif
 #endif /* COGVM */
 #if SPURVM
 	if ([argData isEqualToString: VMOPTIONOBJ("maxoldspace")]) {
@@ -365,6 +408,51 @@ static char *getVersionInfo(int verbose);
 		maxOldSpaceSize = (unsigned long)[self strtobkm: peek];		 
 		return 2;
 	}
+	if ([argData isEqualToString: VMOPTIONOBJ("gcthreads")]) {
+		ioSetNumGCThreads(atoi(peek));
+		return 2;
+	}
+# if SPURGCOPTIONS
+	if ([argData isEqualToString: VMOPTIONOBJ("tenuringage")]) {
+		extern sqInt tenuringAge;
+		tenuringAge = atoi(peek);
+		return 2;
+	}
+	if ([argData isEqualToString: VMOPTIONOBJ("compactionratio")]) {
+		extern sqInt compactionMoveRatio;
+		compactionMoveRatio = atoi(peek);
+		return 2;
+	}
+	if ([argData isEqualToString: VMOPTIONOBJ("largeobjects")]) {
+		extern usqInt largeObjectThreshold;
+		largeObjectThreshold = (usqInt)[self strtobkm: peek];
+		if (largeObjectThreshold > 0 && largeObjectThreshold < sqDirtyPageSize())
+			largeObjectThreshold = sqDirtyPageSize();
+		return 2;
+	}
+	if ([argData isEqualToString: VMOPTIONOBJ("maxgcpause")]) {
+		extern sqInt maxGCPauseUsecs;
+		maxGCPauseUsecs = atoi(peek);
+		return 2;
+	}
+	if ([argData isEqualToString: VMOPTIONOBJ("pinnedsegments")]) {
+		extern usqInt pinnedSegmentSize;
+		pinnedSegmentSize = (usqInt)[self strtobkm: peek];
+		return 2;
+	}
+	if ([argData isEqualToString: VMOPTIONOBJ("gclog")]) {
+		extern void openGCLog(char *fileName);
+		openGCLog(peek);
+		return 2;
+	}
+# endif /* SPURGCOPTIONS */
+# if SIZABLEMETHODCACHE
+	if ([argData isEqualToString: VMOPTIONOBJ("methodcache")]) {
+		extern usqInt methodCacheEntries;
+		methodCacheEntries = (usqInt)[self strtobkm: peek];
+		return 2;
+	}
+# endif
 #endif
 #if 0 /* Not sure if encoding is an issue with the Cocoa VM. eem 2015-11-30 */
 	if ([argData isEqualToString: VMOPTIONOBJ("pathenc")]) {
@@ -499,14 +587,39 @@ static char *getVersionInfo(int verbose);
 #endif
 #if COGVM
 	printf("  "VMOPTION("codesize")" <size>[mk]  set machine code memory to bytes\n");
+# if COGGROWABLECODEZONE
+	printf("  "VMOPTION("maxcodesize")" <size>[mk]  let machine code memory grow up to bytes (at most 16m)\n");
+# endif
+# if COGCODECACHE
+	printf("  "VMOPTION("codecache")" <file>     compile the methods listed in file at start-up; rewrite it on snapshot and quit\n");
+# endif
 	printf("  "VMOPTION("tracestores")"          enable store tracing (assert check stores)\n");
 	printf("  "VMOPTION("cogmaxlits")" <n>       set max number of literals for methods to be compiled to machine code\n");
 	printf("  "VMOPTION("cogminjumps")" <n>      set min number of backward jumps for interpreted methods to be considered for compilation to machine code\n");
+# if COGMAXPIC
+	printf("  "VMOPTION("maxpic")" <n>           set the maximum number of cases in a closed PIC (2 to 32, default 6)\n");
+# endif
 	printf("  "VMOPTION("reportheadroom")"       report unused stack headroom on exit\n");
 #endif
 #if SPURVM
 	printf("  "VMOPTION("maxoldspace")" <size>[mk]      set max size of old space memory to bytes\n");
 	printf("  "VMOPTION("logscavenge")"          log scavenging to scavenge.log\n");
+	printf("  "VMOPTION("hugepages")"            align the heap to 2Mb and back it with transparent huge pages\n");
+	printf("  "VMOPTION("prefault")"             populate new space and the initial heap at startup\n");
+	printf("  "VMOPTION("mmapimage")"            map the image's heap data on demand, padding saved images to allow it\n");
+	printf("  "VMOPTION("gcthreads")" <num>      use num threads in parallel phases of the GC (default 1)\n");
+# if SPURGCOPTIONS
+	printf("  "VMOPTION("cardmarking")"          scan large remembered arrays by card, not in full\n");
+	printf("  "VMOPTION("tenuringage")" <num>    tenure objects that have survived num (at most 15) scavenges\n");
+	printf("  "VMOPTION("compactionratio")" <num> sweep, not compact, if moving exceeds num times the garbage (0 = always compact)\n");
+	printf("  "VMOPTION("largeobjects")" <size>[mk] give objects of at least size bytes a segment of their own\n");
+	printf("  "VMOPTION("maxgcpause")" <usecs>   mark and sweep old space in steps of at most usecs\n");
+	printf("  "VMOPTION("pinnedsegments")" <size>[mk] keep pinned objects in segments of their own of size bytes\n");
+	printf("  "VMOPTION("gclog")" <file>      write a JSON record per GC to file (- for stderr)\n");
+# endif
+# if SIZABLEMETHODCACHE
+	printf("  "VMOPTION("methodcache")" <n>[k]  size the interpreter's method cache to n entries\n");
+# endif
 #endif
 #if 0 /* Not sure if encoding is an issue with the Cocoa VM. eem 2015-11-30 */
 	printf("  "VMOPTION("pathenc")" <enc>        set encoding for pathnames (default: %s)\n",
@@ -109,6 +109,26 @@ extern void sqFilenameFromString(char *uxName, sqInt stNameIndex, int sqNameLeng
 #define ftell ftello
 #define fseek fseeko
 
+#if SPURVM
+/* -mmapimage maps the image's heap data rather than reading it; see
+ * sqUnixSpurMemory.c.
+ */
+# undef sqImageFileOpen
+# undef sqImageFileReadSegment
+# undef sqImageFileHeaderPadding
+# undef sqImageFileNoteSavedMemoryBase
+extern FILE *sqImageFileOpenOrUnlink(char *fileName, char *mode);
+extern size_t sqImageFileMapOrRead(void *ptr, size_t sz, size_t count, FILE *f);
+extern usqInt sqImageFileHeaderPaddingFor(squeakFileOffsetType dataOffset, usqInt address);
+extern void sqImageFileNoteSavedMemoryBaseAt(usqInt address);
+# define sqImageFileOpen(fileName, mode) sqImageFileOpenOrUnlink(fileName, mode)
+# define sqImageFileReadSegment(ptr, sz, count, f) sqImageFileMapOrRead(ptr, sz, count, f)
+# define sqImageFileHeaderPadding(dataOffset, address) \
+	sqImageFileHeaderPaddingFor(dataOffset, address)
+# define sqImageFileNoteSavedMemoryBase(address) \
+	sqImageFileNoteSavedMemoryBaseAt(address)
+#endif
+
 #if defined(__GNUC__)
 # if !defined(VM_LABEL)
 #	define VM_LABEL(foo) asm("\n.globl L" #foo "\nL" #foo ":")
@@ -1599,6 +1599,18 @@ static int vm_parseArgument(int argc, char **argv)
     extern sqInt desiredCogCodeSize;
     desiredCogCodeSize = strtobkm(argv[1]);	 
     return 2; }
+# if COGGROWABLECODEZONE
+  else if (argc > 1 && !strcmp(argv[0], VMOPTION("maxcodesize"))) { 
+    extern sqInt desiredMaxCogCodeSize;
+    desiredMaxCogCodeSize = strtobkm(argv[1]);	 
+    return 2; }
+# endif
+# if COGCODECACHE
+  else if (argc > 1 && !strcmp(argv[0], VMOPTION("codecache"))) { 
+    extern void setMachineCodeCacheFile(char *fileName);
+    setMachineCodeCacheFile(argv[1]);
+    return 2; }
+# endif
 # define TLSLEN (sizeof(VMOPTION("trace"))-1)
   else if (!strncmp(argv[0], VMOPTION("trace"), TLSLEN)) { 
     extern int traceFlags;
@@ -1626,6 +1638,19 @@ static int vm_parseArgument(int argc, char **argv)
     extern sqInt minBackwardJumpCountForCompile;
     minBackwardJumpCountForCompile = strtobkm(argv[1]);	 
     return 2; }
+# if COGMAXPIC
+  else if (argc > 1 && !strcmp(argv[0], VMOPTION("maxpic"))) { 
+    extern sqInt maxCPICCases;
+    maxCPICCases = atoi(argv[1]);	 
+    return 2; }
+# endif
+# if COGCODELOADHOOK
+  else if (!strcmp(argv[0], VMOPTION("perfmap"))
+        || !strcmp(argv[0], VMOPTION("jitdump"))) { 
+    extern int ioEnablePerfMap(int withJitDump);
+    ioEnablePerfMap(!strcmp(argv[0], VMOPTION("jitdump")));
+    return 1; }
+# endif
   else if (!strcmp(argv[0], VMOPTION("reportheadroom"))
         || !strcmp(argv[0], VMOPTION("rh"))) { 
     extern sqInt reportStackHeadroom;
@@ -1642,6 +1667,72 @@ static int vm_parseArgument(int argc, char **argv)
     openScavengeLog();
     return 1;
   }
+  else if (!strcmp(argv[0], VMOPTION("hugepages"))) {
+    extern int useHugePages;
+    useHugePages = 1;
+    return 1;
+  }
+  else if (!strcmp(argv[0], VMOPTION("prefault"))) {
+    extern int prefaultMemory;
+    prefaultMemory = 1;
+    return 1;
+  }
+  else if (!strcmp(argv[0], VMOPTION("mmapimage"))) {
+    extern int mmapImageFile;
+    mmapImageFile = 1;
+    return 1;
+  }
+  else if (argc > 1 && !strcmp(argv[0], VMOPTION("gcthreads"))) {
+    ioSetNumGCThreads(atoi(argv[1]));
+    return 2; }
+# if SPURGCOPTIONS
+  else if (!strcmp(argv[0], VMOPTION("cardmarking"))) {
+    extern sqInt useCardMarking;
+    useCardMarking = 1;
+    return 1;
+  }
+  else if (!strcmp(argv[0], VMOPTION("concurrentmark"))) {
+    extern sqInt concurrentMarkEnabled;
+    /* the marker needs the kernel's soft-dirty page bits; see sqUnixSpurMemory.c */
+    if (sqCanTrackDirtyPages())
+      concurrentMarkEnabled = 1;
+    else
+      fprintf(stderr, "%s: this system cannot track dirty pages; ignored\n", argv[0]);
+    return 1;
+  }
+  else if (argc > 1 && !strcmp(argv[0], VMOPTION("tenuringage"))) {
+    extern sqInt tenuringAge;
+    tenuringAge = atoi(argv[1]);
+    return 2; }
+  else if (argc > 1 && !strcmp(argv[0], VMOPTION("compactionratio"))) {
+    extern sqInt compactionMoveRatio;
+    compactionMoveRatio = atoi(argv[1]);
+    return 2; }
+  else if (argc > 1 && !strcmp(argv[0], VMOPTION("largeobjects"))) {
+    extern usqInt largeObjectThreshold;
+    largeObjectThreshold = (usqInt)strtobkm(argv[1]);
+    if (largeObjectThreshold > 0 && largeObjectThreshold < sqDirtyPageSize())
+      largeObjectThreshold = sqDirtyPageSize();
+    return 2; }
+  else if (argc > 1 && !strcmp(argv[0], VMOPTION("maxgcpause"))) {
+    extern sqInt maxGCPauseUsecs;
+    maxGCPauseUsecs = atoi(argv[1]);
+    return 2; }
+  else if (argc > 1 && !strcmp(argv[0], VMOPTION("pinnedsegments"))) {
+    extern usqInt pinnedSegmentSize;
+    pinnedSegmentSize = (usqInt)strtobkm(argv[1]);
+    return 2; }
+  else if (argc > 1 && !strcmp(argv[0], VMOPTION("gclog"))) {
+    extern void openGCLog(char *fileName);
+    openGCLog(argv[1]);
+    return 2; }
+# endif /* SPURGCOPTIONS */
+# if SIZABLEMETHODCACHE
+  else if (argc > 1 && !strcmp(argv[0], VMOPTION("methodcache"))) {
+    extern usqInt methodCacheEntries;
+    methodCacheEntries = (usqInt)strtobkm(argv[1]);
+    return 2; }
+# endif
 #endif
   else if (argc > 1 && !strcmp(argv[0], VMOPTION("textenc"))) {
     int i, len = strlen(argv[1]);
@@ -1696,14 +1787,45 @@ static void vm_printUsage(void)
 #endif
 #if COGVM
   printf("  "VMOPTION("codesize")" <size>[mk]  set machine code memory to bytes\n");
+# if COGGROWABLECODEZONE
+  printf("  "VMOPTION("maxcodesize")" <size>[mk]  let machine code memory grow up to bytes (at most 16m)\n");
+# endif
+# if COGCODECACHE
+  printf("  "VMOPTION("codecache")" <file>     compile the methods listed in file at start-up; rewrite it on snapshot and quit\n");
+# endif
   printf("  "VMOPTION("tracestores")"          enable store tracing (assert check stores)\n");
   printf("  "VMOPTION("cogmaxlits")" <n>       set max number of literals for methods compiled to machine code\n");
   printf("  "VMOPTION("cogminjumps")" <n>      set min number of backward jumps for interpreted methods to be considered for compilation to machine code\n");
+# if COGMAXPIC
+  printf("  "VMOPTION("maxpic")" <n>           set the maximum number of cases in a closed PIC (2 to 32, default 6)\n");
+# endif
+# if COGCODELOADHOOK
+  printf("  "VMOPTION("perfmap")"              write /tmp/perf-<pid>.map naming generated code for perf\n");
+  printf("  "VMOPTION("jitdump")"              write /tmp/jit-<pid>.dump of generated code for perf inject --jit\n");
+# endif
   printf("  "VMOPTION("reportheadroom")"       report unused stack headroom on exit\n");
 #endif
 #if SPURVM
   printf("  "VMOPTION("maxoldspace")" <size>[mk]    set max size of old space memory to bytes\n");
   printf("  "VMOPTION("logscavenge")"          log scavenging to scavenge.log\n");
+  printf("  "VMOPTION("hugepages")"            align the heap to 2Mb and back it with transparent huge pages\n");
+  printf("  "VMOPTION("prefault")"             populate new space and the initial heap at startup\n");
+  printf("  "VMOPTION("mmapimage")"            map the image's heap data on demand, padding saved images to allow it\n");
+  printf("  "VMOPTION("gcthreads")" <num>      use num threads in parallel phases of the GC (default 1)\n");
+# if SPURGCOPTIONS
+  printf("  "VMOPTION("cardmarking")"          scan large remembered arrays by card, not in full\n");
+  printf("  "VMOPTION("concurrentmark")"       mark old space in the background, pausing only to remark\n");
+  printf("                        (x86 Linux with soft-dirty bits only; resets them for the whole process)\n");
+  printf("  "VMOPTION("tenuringage")" <num>    tenure objects that have survived num (at most 15) scavenges\n");
+  printf("  "VMOPTION("compactionratio")" <num> sweep, not compact, if moving exceeds num times the garbage (0 = always compact)\n");
+  printf("  "VMOPTION("largeobjects")" <size>[mk] give objects of at least size bytes a segment of their own\n");
+  printf("  "VMOPTION("maxgcpause")" <usecs>   mark and sweep old space in steps of at most usecs\n");
+  printf("  "VMOPTION("pinnedsegments")" <size>[mk] keep pinned objects in segments of their own of size bytes\n");
+  printf("  "VMOPTION("gclog")" <file>      write a JSON record per GC to file (- for stderr)\n");
+# endif
+# if SIZABLEMETHODCACHE
+  printf("  "VMOPTION("methodcache")" <n>[k]  size the interpreter's method cache to n entries\n");
+# endif
 #endif
   printf("  "VMOPTION("blockonerror")"         on error or segv block, not exit.  useful for attaching gdb\n");
   printf("  "VMOPTION("blockonwarn")"          on warning block, don't warn.  useful for attaching gdb\n");
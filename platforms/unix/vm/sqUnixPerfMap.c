@@ -0,0 +1,182 @@
+/****************************************************************************
+*   PROJECT: Unix support for symbolizing JIT-generated machine code
+*			 in Linux perf profiles
+*   FILE:    sqUnixPerfMap.c
+*   CONTENT: perf map and jitdump output for the Cogit's code zone
+*
+*   NOTES:
+*  The Cogit calls codeLoadHook for every trampoline, method, block and PIC
+*  it generates, and again for every method that code compaction moves.
+*
+*  -perfmap appends "start size name" lines to /tmp/perf-<pid>.map, which perf
+*  report reads without further ado.  The map has no notion of time, so once
+*  compaction has moved methods their old ranges may be misattributed.
+*
+*  -jitdump writes a JIT_CODE_LOAD record, with a timestamp and a copy of the
+*  code, to /tmp/jit-<pid>.dump.  Record with perf record -k mono, run
+*  perf inject --jit -i perf.data -o perf.jit.data, and report on the latter;
+*  samples are then attributed exactly, across compactions.
+*
+*****************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#if defined(__linux__)
+# include <sys/syscall.h>
+#endif
+
+#include "sq.h"
+
+#if COGCODELOADHOOK
+extern void (*codeLoadHook)(usqInt address, usqInt size, char *name);
+
+/* See tools/perf/Documentation/jitdump-specification.txt in the Linux sources */
+#define JITDUMP_MAGIC	0x4A695444
+#define JITDUMP_VERSION	1
+#define JIT_CODE_LOAD	0
+
+#if defined(__x86_64__)
+# define JITDUMP_ELF_MACH 62	/* EM_X86_64 */
+#elif defined(__i386__)
+# define JITDUMP_ELF_MACH 3		/* EM_386 */
+#elif defined(__aarch64__)
+# define JITDUMP_ELF_MACH 183	/* EM_AARCH64 */
+#elif defined(__arm__)
+# define JITDUMP_ELF_MACH 40	/* EM_ARM */
+#else
+# define JITDUMP_ELF_MACH 0
+#endif
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t total_size;
+	uint32_t elf_mach;
+	uint32_t pad1;
+	uint32_t pid;
+	uint64_t timestamp;
+	uint64_t flags;
+} JitDumpHeader;
+
+typedef struct {
+	uint32_t id;
+	uint32_t total_size;
+	uint64_t timestamp;
+	uint32_t pid;
+	uint32_t tid;
+	uint64_t vma;
+	uint64_t code_addr;
+	uint64_t code_size;
+	uint64_t code_index;
+	/* followed by the NUL-terminated name and then the code */
+} JitDumpCodeLoad;
+
+static FILE *perfMap = 0;
+static FILE *jitDump = 0;
+static uint64_t jitDumpCodeIndex = 0;
+
+/* perf record -k mono timestamps samples with CLOCK_MONOTONIC */
+static uint64_t
+monotonicNanoseconds(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void
+writeJitDumpCodeLoad(usqInt address, usqInt size, char *name)
+{
+	JitDumpCodeLoad record;
+	size_t nameSize = strlen(name) + 1;
+
+	record.id = JIT_CODE_LOAD;
+	record.total_size = sizeof(record) + nameSize + size;
+	record.timestamp = monotonicNanoseconds();
+	record.pid = getpid();
+#if defined(__linux__)
+	record.tid = syscall(SYS_gettid);
+#else
+	record.tid = record.pid;
+#endif
+	record.vma = record.code_addr = address;
+	record.code_size = size;
+	record.code_index = jitDumpCodeIndex++;
+	fwrite(&record, sizeof(record), 1, jitDump);
+	fwrite(name, nameSize, 1, jitDump);
+	fwrite((void *)address, size, 1, jitDump);
+}
+
+static void
+perfCodeLoad(usqInt address, usqInt size, char *name)
+{
+	if (perfMap)
+		fprintf(perfMap, "%lx %lx %s\n", (unsigned long)address, (unsigned long)size, name);
+	if (jitDump)
+		writeJitDumpCodeLoad(address, size, name);
+}
+
+static int
+openJitDump(void)
+{
+	char fileName[64];
+	JitDumpHeader header;
+	long pageSize = sysconf(_SC_PAGESIZE);
+
+	snprintf(fileName, sizeof(fileName), "/tmp/jit-%ld.dump", (long)getpid());
+	if (!(jitDump = fopen(fileName, "w+"))) {
+		perror(fileName);
+		return 0;
+	}
+	/* perf record finds the dump by this mapping of it; it must be executable */
+	if (mmap(0, pageSize, PROT_READ | PROT_EXEC, MAP_PRIVATE, fileno(jitDump), 0)
+		== MAP_FAILED) {
+		perror("mmap jitdump");
+		fclose(jitDump);
+		jitDump = 0;
+		return 0;
+	}
+	memset(&header, 0, sizeof(header));
+	header.magic = JITDUMP_MAGIC;
+	header.version = JITDUMP_VERSION;
+	header.total_size = sizeof(header);
+	header.elf_mach = JITDUMP_ELF_MACH;
+	header.pid = getpid();
+	header.timestamp = monotonicNanoseconds();
+	fwrite(&header, sizeof(header), 1, jitDump);
+	return 1;
+}
+
+static int
+openPerfMap(void)
+{
+	char fileName[64];
+
+	snprintf(fileName, sizeof(fileName), "/tmp/perf-%ld.map", (long)getpid());
+	if (!(perfMap = fopen(fileName, "a"))) {
+		perror(fileName);
+		return 0;
+	}
+	/* keep the map complete even if the VM dies */
+	setvbuf(perfMap, 0, _IOLBF, 0);
+	return 1;
+}
+
+/* Start reporting generated code to perf, as a perf map if withJitDump is
+ * false, otherwise as a jitdump.  Must be called before the code zone is
+ * initialized so that the trampolines are reported too.
+ */
+int
+ioEnablePerfMap(int withJitDump)
+{
+	if (!(withJitDump ? openJitDump() : openPerfMap()))
+		return 0;
+	codeLoadHook = perfCodeLoad;
+	return 1;
+}
+#endif /* COGCODELOADHOOK */
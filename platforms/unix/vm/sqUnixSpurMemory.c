@@ -25,9 +25,13 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <sys/mman.h>
 
 #include "sq.h"
@@ -68,6 +72,34 @@ static unsigned long pageMask = 0;
 
 int mmapErrno = 0;
 
+/* With -hugepages segments are aligned and sized to 2Mb and advised
+ * MADV_HUGEPAGE, so that the kernel can back them with transparent huge pages
+ * and the GC's sweeps over the heap take fewer TLB misses.  With -prefault the
+ * initial allocation, which holds eden, the survivor spaces and the image, is
+ * populated up front rather than page fault by page fault.
+ */
+int useHugePages = 0;
+int prefaultMemory = 0;
+
+/* With -mmapimage the image's heap data is mapped from the image file
+ * MAP_PRIVATE rather than read, so that pages come in as they are first
+ * touched instead of all before the image starts.  A page can only be mapped
+ * where its file offset and address are congruent modulo the page size, so
+ * images saved with -mmapimage pad their header to make it so, and pages that
+ * straddle the ends of a segment are read as usual.  Mapping only pays if the
+ * image need not be swizzled, which would touch every object, so the initial
+ * allocation is first tried where old space would start at the address it was
+ * saved from.  The mapped file must not change under the VM, so writing an
+ * image over it first unlinks it, leaving the mapping its own copy.
+ */
+int mmapImageFile = 0;
+static int imageFileMapped = 0;
+static dev_t mappedImageDevice;
+static ino_t mappedImageInode;
+static usqInt savedMemoryBase = 0;
+
+# define HugePageSize (2*1024*1024)
+
 # if !defined(HAVE_MMAP)
 #	error "Spur requires mmap"
 # endif
@@ -84,6 +116,136 @@ int mmapErrno = 0;
 static int min(int x, int y) { return (x < y) ? x : y; }
 static int max(int x, int y) { return (x > y) ? x : y; }
 
+# if defined(__linux__)
+/* cgroup v2 support.  A container's memory is bounded by memory.high, where
+ * the kernel starts throttling and reclaiming, and memory.max, where it OOM
+ * kills; the lower of the two is the limit that matters.  Either may change
+ * at any time, so the limit is re-read along with memory.current whenever the
+ * VM asks whether it is near the limit.
+ */
+static char cgroupDir[PATH_MAX + 16];
+static int cgroupFound = 0; /* 0 = not yet looked, 1 = found, -1 = none */
+
+static int
+findCgroupDir(void)
+{
+	FILE *f;
+	char line[PATH_MAX];
+
+	if (cgroupFound)
+		return cgroupFound > 0;
+	cgroupFound = -1;
+	if (!(f = fopen("/proc/self/cgroup", "r")))
+		return 0;
+	while (fgets(line, sizeof(line), f))
+		if (!strncmp(line, "0::", 3)) {
+			line[strcspn(line, "\n")] = 0;
+			snprintf(cgroupDir, sizeof(cgroupDir), "/sys/fs/cgroup%s", line + 3);
+			cgroupFound = 1;
+			break;
+		}
+	fclose(f);
+	return cgroupFound > 0;
+}
+
+/* Answer the value in the named cgroup file, or 0 if absent or "max". */
+static usqInt
+cgroupValue(char *name)
+{
+	char path[PATH_MAX + 48], value[64];
+	usqInt result = 0;
+	FILE *f;
+
+	snprintf(path, sizeof(path), "%s/%s", cgroupDir, name);
+	if (!(f = fopen(path, "r")))
+		return 0;
+	if (fgets(value, sizeof(value), f) && strncmp(value, "max", 3))
+		result = strtoull(value, 0, 10);
+	fclose(f);
+	return result;
+}
+# endif /* __linux__ */
+
+/* Answer the memory limit imposed on the process, or 0 if there is none. */
+usqInt
+sqMemoryLimit(void)
+{
+# if defined(__linux__)
+	usqInt max, high;
+
+	if (!findCgroupDir())
+		return 0;
+	max = cgroupValue("memory.max");
+	high = cgroupValue("memory.high");
+	return max && high
+			? (max < high ? max : high)
+			: (max ? max : high);
+# else
+	return 0;
+# endif
+}
+
+/* Answer if the process is using more than 90% of its memory limit.  The
+ * answer is cached for 100ms, since the VM asks after every scavenge.
+ */
+sqInt
+sqMemoryIsNearLimit(void)
+{
+# if defined(__linux__)
+	static unsigned long long nextCheckUsecs = 0;
+	static sqInt nearLimit = 0;
+	unsigned long long now = ioUTCMicroseconds();
+	usqInt limit;
+
+	if (now < nextCheckUsecs)
+		return nearLimit;
+	nextCheckUsecs = now + 100000;
+	limit = sqMemoryLimit();
+	return nearLimit = limit
+						&& cgroupValue("memory.current") >= limit / 10 * 9;
+# else
+	return 0;
+# endif
+}
+
+/* Note where the heap would have to start for old space to start at the
+ * address the image was saved from.  Called by the VM before sqAllocateMemory.
+ */
+void
+sqImageFileNoteSavedMemoryBaseAt(usqInt address)
+{
+	savedMemoryBase = address;
+}
+
+/* Try to allocate the initial heap at savedMemoryBase.  Answer null if that is
+ * not possible.
+ */
+static char *
+allocateAtSavedMemoryBase(usqInt bytes, sqInt *allocatedSizePointer)
+{
+	char *alloc;
+
+	if (!savedMemoryBase
+	 || (savedMemoryBase & ((useHugePages ? HugePageSize : pageSize) - 1)))
+		return 0;
+	alloc = mmap((void *)savedMemoryBase, bytes, PROT_READ | PROT_WRITE,
+				 MAP_ANON | MAP_PRIVATE, -1, 0);
+	if (alloc == MAP_FAILED)
+		return 0;
+	if (alloc != (char *)savedMemoryBase) {
+		if (munmap(alloc, bytes) != 0)
+			perror("allocateAtSavedMemoryBase munmap");
+		return 0;
+	}
+# if defined(MADV_HUGEPAGE)
+	if (useHugePages
+	 && madvise(alloc, bytes, MADV_HUGEPAGE) != 0)
+		perror("allocateAtSavedMemoryBase madvise");
+# endif
+	*allocatedSizePointer = bytes;
+	return alloc;
+}
+
 /* Answer the address of minHeapSize rounded up to page size bytes of memory. */
 
 usqInt
@@ -92,6 +254,8 @@ sqAllocateMemory(usqInt minHeapSize, usqInt desiredHeapSize)
 	char *hint, *address, *alloc;
     unsigned long alignment;
     sqInt allocBytes;
+    usqInt limit;
+    extern usqInt maxOldSpaceSize;
 
 	if (pageSize) {
 		fprintf(stderr, "sqAllocateMemory: already called\n");
@@ -100,17 +264,48 @@ sqAllocateMemory(usqInt minHeapSize, usqInt desiredHeapSize)
 	pageSize = getpagesize();
 	pageMask = ~(pageSize - 1);
 
+	/* Unless told otherwise, keep old space to three quarters of any memory
+	 * limit, leaving the rest for new space, machine code and the C heap.
+	 */
+	if (!maxOldSpaceSize && (limit = sqMemoryLimit()))
+		maxOldSpaceSize = limit / 4 * 3;
+
 	hint = sbrk(0);
 
-	alignment = max(pageSize,1024*1024);
+	alignment = max(pageSize,useHugePages ? HugePageSize : 1024*1024);
 	address = (char *)(((usqInt)hint + alignment - 1) & ~(alignment - 1));
 
-	alloc = sqAllocateMemorySegmentOfSizeAboveAllocatedSizeInto
-				(roundUpToPage(desiredHeapSize), address, &allocBytes);
+	alloc = mmapImageFile
+			? allocateAtSavedMemoryBase(roundUpToPage(desiredHeapSize), &allocBytes)
+			: 0;
+	if (!alloc)
+		alloc = sqAllocateMemorySegmentOfSizeAboveAllocatedSizeInto
+					(roundUpToPage(desiredHeapSize), address, &allocBytes);
 	if (!alloc) {
 		fprintf(stderr, "sqAllocateMemory: initial alloc failed!\n");
 		exit(errno);
 	}
+	if (prefaultMemory) {
+		/* MAP_POPULATE only applies at mmap time, so replace the untouched
+		 * initial mapping with a populated one.  With huge pages that would
+		 * fault in small pages before MADV_HUGEPAGE took effect, so instead
+		 * touch the already advised mapping.
+		 */
+# if defined(MAP_POPULATE)
+		if (!useHugePages) {
+			if (mmap(alloc, allocBytes, PROT_READ | PROT_WRITE,
+					 MAP_ANON | MAP_PRIVATE | MAP_FIXED | MAP_POPULATE, -1, 0)
+				== MAP_FAILED)
+				perror("sqAllocateMemory mmap MAP_POPULATE");
+		}
+		else
+# endif
+		{
+			long i;
+			for (i = 0; i < allocBytes; i += pageSize)
+				alloc[i] = 0;
+		}
+	}
 	return (usqInt)alloc;
 }
 
@@ -127,6 +322,11 @@ sqAllocateMemorySegmentOfSizeAboveAllocatedSizeInto(sqInt size, void *minAddress
 	address = (char *)roundUpToPage((unsigned long)minAddress);
 	bytes = roundUpToPage(size);
 	delta = max(pageSize,1024*1024);
+	if (useHugePages) {
+		address = (char *)(((unsigned long)address + HugePageSize - 1) & ~(HugePageSize - 1));
+		bytes = (bytes + HugePageSize - 1) & ~(HugePageSize - 1);
+		delta = HugePageSize;
+	}
 
 	while ((unsigned long)(address + bytes) > (unsigned long)address) {
 		alloc = mmap(address, bytes, PROT_READ | PROT_WRITE,
@@ -136,7 +336,13 @@ sqAllocateMemorySegmentOfSizeAboveAllocatedSizeInto(sqInt size, void *minAddress
 			perror("sqAllocateMemorySegmentOfSizeAboveAllocatedSizeInto mmap");
 			return 0;
 		}
-		if (alloc >= address && alloc <= address + delta) {
+		if (alloc >= address && alloc <= address + delta
+		 && (!useHugePages || !((unsigned long)alloc & (HugePageSize - 1)))) {
+# if defined(MADV_HUGEPAGE)
+			if (useHugePages
+			 && madvise(alloc, bytes, MADV_HUGEPAGE) != 0)
+				perror("sqAllocateMemorySegmentOfSizeAboveAllocatedSizeInto madvise");
+# endif
 			*allocatedSizePointer = bytes;
 			return alloc;
 		}
@@ -160,6 +366,250 @@ sqDeallocateMemorySegmentAtOfSize(void *addr, sqInt sz)
 		perror("sqDeallocateMemorySegment... munmap");
 }
 
+/* Read count bytes of heap data from f into ptr, mapping the whole pages in
+ * that range from the file when -mmapimage is in effect and the file offset is
+ * congruent with ptr.  Answer the number of bytes read or mapped.
+ */
+size_t
+sqImageFileMapOrRead(void *ptr, size_t sz, size_t count, FILE *f)
+{
+	usqInt start = (usqInt)ptr, end = start + sz * count;
+	usqInt mapStart = roundUpToPage(start), mapEnd = roundDownToPage(end);
+	off_t offset;
+	struct stat sb;
+	size_t bytesRead;
+
+	if (!mmapImageFile
+	 || sz != 1
+	 || mapEnd <= mapStart
+	 || (offset = ftello(f)) < 0
+	 || ((start - offset) & (pageSize - 1))
+	 || fstat(fileno(f), &sb) != 0
+	 || offset + (off_t)count > sb.st_size) /* touching pages past EOF => SIGBUS */
+		return fread(ptr, sz, count, f);
+
+	if (mmap((void *)mapStart, mapEnd - mapStart, PROT_READ | PROT_WRITE,
+			 MAP_PRIVATE | MAP_FIXED, fileno(f), offset + (mapStart - start))
+		== MAP_FAILED) {
+		perror("sqImageFileMapOrRead mmap");
+		return fread(ptr, sz, count, f);
+	}
+	mappedImageDevice = sb.st_dev;
+	mappedImageInode = sb.st_ino;
+	imageFileMapped = 1;
+
+	bytesRead = fread(ptr, 1, mapStart - start, f);
+	if (bytesRead != mapStart - start)
+		return bytesRead;
+	if (fseeko(f, offset + (mapEnd - start), SEEK_SET) != 0)
+		return bytesRead;
+	bytesRead += mapEnd - mapStart;
+	return bytesRead + fread((void *)mapEnd, 1, end - mapEnd, f);
+}
+
+/* Answer how much to pad the header of an image being written so that heap
+ * data at dataOffset in the file is congruent with address in memory.
+ */
+usqInt
+sqImageFileHeaderPaddingFor(squeakFileOffsetType dataOffset, usqInt address)
+{
+	return mmapImageFile
+			? (address - dataOffset) & (pageSize - 1)
+			: 0;
+}
+
+/* Open an image file, first unlinking it if it is to be written and is the
+ * file the heap is mapped from.
+ */
+FILE *
+sqImageFileOpenOrUnlink(char *fileName, char *mode)
+{
+	struct stat sb;
+
+	if (imageFileMapped
+	 && mode[0] == 'w'
+	 && stat(fileName, &sb) == 0
+	 && sb.st_dev == mappedImageDevice
+	 && sb.st_ino == mappedImageInode
+	 && unlink(fileName) != 0)
+		perror("sqImageFileOpenOrUnlink unlink");
+	return fopen(fileName, mode);
+}
+
+/* Linux frees MADV_DONTNEED pages of private anonymous mappings at once, and
+ * RSS drops accordingly, whereas MADV_FREE pages are only reclaimed under
+ * memory pressure.  On Mac OS X MADV_DONTNEED does not release pages at all;
+ * MADV_FREE does.
+ */
+# if defined(__APPLE__) && defined(MADV_FREE)
+#	define DECOMMIT_ADVICE MADV_FREE
+# else
+#	define DECOMMIT_ADVICE MADV_DONTNEED
+# endif
+
+usqInt
+sqDecommitMemoryFromTo(usqInt startAddr, usqInt endAddr)
+{
+	usqInt start = roundUpToPage(startAddr);
+	usqInt end = roundDownToPage(endAddr);
+
+	if (end <= start)
+		return 0;
+	if (madvise((void *)start, end - start, DECOMMIT_ADVICE) != 0) {
+		perror("sqDecommitMemoryFromTo madvise");
+		return 0;
+	}
+	return end - start;
+}
+
+/* Answer how many bytes of [startAddr, endAddr) are backed by transparent huge
+ * pages, according to the AnonHugePages lines of /proc/self/smaps.  Mappings
+ * are attributed in proportion to their overlap with the range.
+ */
+usqInt
+sqHugePageBytesFromTo(usqInt startAddr, usqInt endAddr)
+{
+# if defined(__linux__)
+	FILE *smaps;
+	char line[256];
+	unsigned long mapStart = 0, mapEnd = 0, kb;
+	usqInt overlap = 0, total = 0;
+
+	if (!(smaps = fopen("/proc/self/smaps", "r")))
+		return 0;
+	while (fgets(line, sizeof(line), smaps)) {
+		if (sscanf(line, "%lx-%lx ", &mapStart, &mapEnd) == 2) {
+			usqInt lo = mapStart > startAddr ? mapStart : startAddr;
+			usqInt hi = mapEnd < endAddr ? mapEnd : endAddr;
+			overlap = hi > lo ? hi - lo : 0;
+		}
+		else if (overlap
+			  && !strncmp(line, "AnonHugePages:", 14)
+			  && sscanf(line + 14, "%lu", &kb) == 1)
+			total += (usqInt)((double)kb * 1024 * overlap / (mapEnd - mapStart));
+	}
+	fclose(smaps);
+	return total;
+# else
+	return 0;
+# endif
+}
+
+usqInt
+sqResidentBytesFromTo(usqInt startAddr, usqInt endAddr)
+{
+	unsigned char residency[1024];
+	usqInt start = roundDownToPage(startAddr);
+	usqInt end = roundUpToPage(endAddr);
+	usqInt resident = 0;
+	long i, numPages;
+
+	while (start < end) {
+		numPages = min((end - start) / pageSize, sizeof(residency));
+		if (mincore((void *)start, numPages * pageSize, (void *)residency) != 0)
+			return endAddr - startAddr;
+		for (i = 0; i < numPages; i++)
+			if (residency[i] & 1)
+				resident += pageSize;
+		start += numPages * pageSize;
+	}
+	return resident;
+}
+
+/* Dirty page tracking for the concurrent marker uses linux's soft-dirty bits:
+ * writing 4 to /proc/self/clear_refs clears them and bit 55 of a page's
+ * /proc/self/pagemap entry is set when the page is next written.  Not every
+ * kernel maintains them (it needs CONFIG_MEM_SOFT_DIRTY), so they are probed
+ * for once.  Clearing them clears them for the whole process, so anything
+ * else relying on them, e.g. CRIU or a profiler, is disturbed while the
+ * marker is in use.  The marker relies on
+ * stores becoming visible in order, so this is confined to x86.
+ */
+# if defined(__linux__) && (defined(__x86_64__) || defined(__i386__))
+#	define SoftDirtyBit (1ULL << 55)
+static int pagemapFile = -1;
+static int canTrackDirtyPages = -1;
+
+void
+sqClearDirtyPages(void)
+{
+	int clearRefs = open("/proc/self/clear_refs", O_WRONLY);
+
+	if (clearRefs >= 0) {
+		if (write(clearRefs, "4", 1) != 1)
+			canTrackDirtyPages = 0;
+		close(clearRefs);
+	}
+}
+
+usqInt
+sqDirtyPageSize(void) { return getpagesize(); }
+
+sqInt
+sqDirtyPagesFromToInto(usqInt startAddr, usqInt endAddr, unsigned char *dirty)
+{
+	unsigned long long entries[512];
+	usqInt page = startAddr / getpagesize();
+	usqInt endPage = (endAddr + getpagesize() - 1) / getpagesize();
+	long i, n;
+
+	if (pagemapFile < 0)
+		return 0;
+	while (page < endPage) {
+		n = min(endPage - page, sizeof(entries) / sizeof(entries[0]));
+		if (pread(pagemapFile, entries, n * sizeof(entries[0]),
+				  page * sizeof(entries[0])) != n * sizeof(entries[0]))
+			return 0;
+		for (i = 0; i < n; i++)
+			*dirty++ = (entries[i] & SoftDirtyBit) != 0;
+		page += n;
+	}
+	return 1;
+}
+
+sqInt
+sqCanTrackDirtyPages(void)
+{
+	unsigned char dirty;
+	char *probe;
+
+	if (canTrackDirtyPages >= 0)
+		return canTrackDirtyPages;
+	canTrackDirtyPages = 0;
+	if ((pagemapFile = open("/proc/self/pagemap", O_RDONLY)) < 0)
+		return 0;
+	if (posix_memalign((void **)&probe, getpagesize(), getpagesize()))
+		return 0;
+	probe[0] = 1;
+	canTrackDirtyPages = 1;
+	sqClearDirtyPages();
+	probe[0] = 2;
+	if (canTrackDirtyPages
+	 && !(sqDirtyPagesFromToInto((usqInt)probe, (usqInt)probe + 1, &dirty)
+		 && dirty))
+		canTrackDirtyPages = 0;
+	free(probe);
+	if (!canTrackDirtyPages) {
+		close(pagemapFile);
+		pagemapFile = -1;
+	}
+	return canTrackDirtyPages;
+}
+# else /* __linux__ && x86 */
+sqInt
+sqCanTrackDirtyPages(void) { return 0; }
+
+void
+sqClearDirtyPages(void) { }
+
+usqInt
+sqDirtyPageSize(void) { return getpagesize(); }
+
+sqInt
+sqDirtyPagesFromToInto(usqInt startAddr, usqInt endAddr, unsigned char *dirty)
+{ return 0; }
+# endif /* __linux__ && x86 */
+
 # if COGVM
 void
 sqMakeMemoryExecutableFromTo(unsigned long startAddr, unsigned long endAddr)
@@ -159,6 +159,21 @@ initThreadLocalThreadIndices(void)
 /* ioOSThreadIsAlive is defined in sqPlatformSpecific.h.
  */
 
+#else /* COGMTVM */
+/* This is for sqVirtualMachine.h's default ownVM implementation. */
+sqInt
+amInVMThread() { return ioOSThreadsEqual(ioCurrentOSThread(),getVMOSThread()); }
+#endif /* COGMTVM */
+
+#if COGMTVM || SPURVM
+# if !COGMTVM
+#	include <unistd.h>		/* for ioNumProcesors */
+#	if defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__)
+#		include <sys/types.h>	/* for ioNumProcesors */
+#		include <sys/sysctl.h>	/* for ioNumProcesors */
+#	endif
+# endif
+
 int
 ioNumProcessors(void)
 {
@@ -185,11 +200,244 @@ ioNumProcessors(void)
 	return 1;
 # endif
 }
-#else /* COGMTVM */
-/* This is for sqVirtualMachine.h's default ownVM implementation. */
-sqInt
-amInVMThread() { return ioOSThreadsEqual(ioCurrentOSThread(),getVMOSThread()); }
-#endif /* COGMTVM */
+#endif /* COGMTVM || SPURVM */
+
+#if SPURVM
+/* A small pool of helper threads for the parallel phases of the Spur GC.  The
+ * pool is created lazily on the first parallel phase, and grown if a later
+ * phase asks for more threads, as does swizzling at startup.  Each phase is a
+ * new generation; the VM thread publishes the work function, bumps the
+ * generation and runs work(0, arg) itself while helper i < numThreads runs
+ * work(i, arg).  It then waits until every such helper has finished before
+ * answering.
+ */
+# define MaxGCThreads 64
+
+static int numGCThreads = 1;
+static int numPoolThreads = 1; /* including the VM thread */
+static int gcPoolForked = 0;
+static int gcThreadsActive = 0;
+static int gcThreadsRunning = 0;
+static unsigned long gcGeneration = 0;
+static unsigned long gcGenerationAtStart[MaxGCThreads];
+static void (*gcWork)(sqInt, void *);
+static void *gcWorkArg;
+static pthread_mutex_t gcPoolMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gcPoolStart = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t gcPoolDone = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t gcWorkMutex = PTHREAD_MUTEX_INITIALIZER;
+
+int
+ioNumGCThreads(void) { return numGCThreads; }
+
+void
+ioSetNumGCThreads(int numThreads)
+{
+	numGCThreads = numThreads < 1
+					? 1
+					: numThreads > MaxGCThreads ? MaxGCThreads : numThreads;
+}
+
+static void *
+gcThreadLoop(void *indexAsPointer)
+{
+	sqInt index = (sqInt)indexAsPointer;
+	unsigned long generationDone = gcGenerationAtStart[index];
+
+	pthread_mutex_lock(&gcPoolMutex);
+	for (;;) {
+		while (gcGeneration == generationDone)
+			pthread_cond_wait(&gcPoolStart, &gcPoolMutex);
+		generationDone = gcGeneration;
+		if (index >= gcThreadsActive)
+			continue;
+		pthread_mutex_unlock(&gcPoolMutex);
+		gcWork(index, gcWorkArg);
+		pthread_mutex_lock(&gcPoolMutex);
+		if (--gcThreadsRunning == 0)
+			pthread_cond_signal(&gcPoolDone);
+	}
+	return 0;
+}
+
+/* Called only between phases, so a new helper need only skip the generations
+ * that have already been run.
+ */
+static void
+growGCThreadPool(int numThreads)
+{
+	pthread_t thread;
+	int err;
+
+	if (gcPoolForked)
+		return;
+	while (numPoolThreads < numThreads) {
+		gcGenerationAtStart[numPoolThreads] = gcGeneration;
+		if ((err = pthread_create(&thread, 0, gcThreadLoop,
+								  (void *)(sqInt)numPoolThreads))) {
+			fprintf(stderr, "ioGCThreadsDo: could only start %d gc threads (%s)\n",
+					numPoolThreads, strerror(err));
+			if (numGCThreads > numPoolThreads)
+				numGCThreads = numPoolThreads;
+			return;
+		}
+		numPoolThreads += 1;
+	}
+}
+
+void
+ioGCThreadsDo(void (*work)(sqInt, void *), void *arg)
+{
+	ioNumThreadsDo(numGCThreads, work, arg);
+}
+
+void
+ioNumThreadsDo(int numThreads, void (*work)(sqInt, void *), void *arg)
+{
+	if (numThreads > MaxGCThreads)
+		numThreads = MaxGCThreads;
+	if (numThreads > numPoolThreads)
+		growGCThreadPool(numThreads);
+	if (numThreads > numPoolThreads)
+		numThreads = numPoolThreads;
+	if (numThreads <= 1) {
+		work(0, arg);
+		return;
+	}
+	pthread_mutex_lock(&gcPoolMutex);
+	gcWork = work;
+	gcWorkArg = arg;
+	gcThreadsActive = numThreads;
+	gcThreadsRunning = numThreads - 1;
+	gcGeneration += 1;
+	pthread_cond_broadcast(&gcPoolStart);
+	pthread_mutex_unlock(&gcPoolMutex);
+
+	work(0, arg);
+
+	pthread_mutex_lock(&gcPoolMutex);
+	while (gcThreadsRunning > 0)
+		pthread_cond_wait(&gcPoolDone, &gcPoolMutex);
+	pthread_mutex_unlock(&gcPoolMutex);
+}
+
+/* A forked child has none of its parent's helpers, and should not start
+ * threads of its own, so it runs every phase on the one thread it has.
+ */
+static void
+forgetGCThreadPool(void)
+{
+	numGCThreads = numPoolThreads = 1;
+	gcPoolForked = 1;
+}
+
+void
+ioLockGCThreads(void) { pthread_mutex_lock(&gcWorkMutex); }
+
+void
+ioUnlockGCThreads(void) { pthread_mutex_unlock(&gcWorkMutex); }
+
+/* The concurrent marker runs on a thread of its own, started for each mark
+ * and joined when the VM wants its result.  Like the pool, a forked child
+ * does without.
+ */
+static pthread_t backgroundGCThread;
+static int backgroundGCThreadRunning = 0;
+static void (*backgroundGCWork)(void *);
+
+static void *
+backgroundGCThreadMain(void *arg)
+{
+	backgroundGCWork(arg);
+	return 0;
+}
+
+int
+ioStartBackgroundGCWork(void (*work)(void *), void *arg)
+{
+	if (gcPoolForked || backgroundGCThreadRunning)
+		return 0;
+	backgroundGCWork = work;
+	if (pthread_create(&backgroundGCThread, 0, backgroundGCThreadMain, arg))
+		return 0;
+	backgroundGCThreadRunning = 1;
+	return 1;
+}
+
+void
+ioWaitForBackgroundGCWork(void)
+{
+	if (backgroundGCThreadRunning) {
+		pthread_join(backgroundGCThread, 0);
+		backgroundGCThreadRunning = 0;
+	}
+}
+#endif /* SPURVM */
+
+/* Background snapshots.  The child writes the image and _exits; a detached
+ * thread in the parent waits for it and signals the image's semaphore.  If
+ * something else reaps the child first (e.g. a SIGCHLD handler) its status is
+ * unknown and is reported as 255.
+ */
+#include <sys/wait.h>
+#include <unistd.h>
+#include <errno.h>
+
+static volatile pid_t snapshotChild = 0;
+static volatile int snapshotStatus = 0;
+static sqInt snapshotSemaIndex = 0;
+
+static void *
+snapshotReaper(void *ignored)
+{
+	int status, err;
+
+	while ((err = waitpid(snapshotChild, &status, 0)) < 0 && errno == EINTR)
+		continue;
+	snapshotStatus = err < 0
+						? 255
+						: WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+	snapshotChild = 0;
+	signalSemaphoreWithIndex(snapshotSemaIndex);
+	return 0;
+}
+
+int
+ioForkForSnapshot(sqInt semaIndex)
+{
+	pthread_t reaper;
+	pid_t pid;
+
+	if (snapshotChild)
+		return -2;
+	/* don't let the child write out a copy of anything still buffered */
+	fflush(stdout);
+	fflush(stderr);
+	if ((pid = fork()) < 0) {
+		perror("ioForkForSnapshot fork");
+		return -1;
+	}
+	if (pid == 0) {
+#if SPURVM
+		forgetGCThreadPool();
+#endif
+		return 0;
+	}
+	snapshotStatus = -1;
+	snapshotSemaIndex = semaIndex;
+	snapshotChild = pid;
+	if (pthread_create(&reaper, 0, snapshotReaper, 0))
+		(void)snapshotReaper(0); /* wait here; the snapshot is still written */
+	else
+		pthread_detach(reaper);
+	return 1;
+}
+
+void
+ioExitSnapshotChild(int status) { _exit(status); }
+
+int
+ioBackgroundSnapshotStatus(void) { return snapshotStatus; }
 
 void
 ioInitThreads()
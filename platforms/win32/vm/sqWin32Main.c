@@ -1934,6 +1934,26 @@ parseVMArgument(int argc, char *argv[])
 		extern sqInt desiredCogCodeSize;
 		desiredCogCodeSize = strtobkm(argv[1]);	 
 		return 2; }
+# if COGGROWABLECODEZONE
+	else if (argc > 1 && !strcmp(argv[0], VMOPTION("maxcodesize"))) {
+		extern sqInt desiredMaxCogCodeSize;
+		desiredMaxCogCodeSize = strtobkm(argv[1]);
+		return 2; }
+	else if (!strncmp(argv[0], VMOPTION("maxcodesize:"), strlen(VMOPTION("maxcodesize:")))) {
+		extern sqInt desiredMaxCogCodeSize;
+		desiredMaxCogCodeSize = strtobkm(argv[0]+strlen(VMOPTION("maxcodesize:")));
+		return 1; }
+# endif
+# if COGCODECACHE
+	else if (argc > 1 && !strcmp(argv[0], VMOPTION("codecache"))) {
+		extern void setMachineCodeCacheFile(char *fileName);
+		setMachineCodeCacheFile(argv[1]);
+		return 2; }
+	else if (!strncmp(argv[0], VMOPTION("codecache:"), strlen(VMOPTION("codecache:")))) {
+		extern void setMachineCodeCacheFile(char *fileName);
+		setMachineCodeCacheFile(argv[0]+strlen(VMOPTION("codecache:")));
+		return 1; }
+# endif
 # define TLSLEN (sizeof(VMOPTION("trace"))-1)
 	else if (!strncmp(argv[0], VMOPTION("trace"), TLSLEN)) {
 		extern int traceFlags;
@@ -1977,6 +1997,16 @@ parseVMArgument(int argc, char *argv[])
 		extern sqInt minBackwardJumpCountForCompile;
 		minBackwardJumpCountForCompile = strtobkm(argv[0]+strlen(VMOPTION("cogminjumps:")));
 		return 1; }
+# if COGMAXPIC
+	else if (argc > 1 && !strcmp(argv[0], VMOPTION("maxpic"))) {
+		extern sqInt maxCPICCases;
+		maxCPICCases = atoi(argv[1]);
+		return 2; }
+	else if (!strncmp(argv[0], VMOPTION("maxpic:"), strlen(VMOPTION("maxpic:")))) {
+		extern sqInt maxCPICCases;
+		maxCPICCases = atoi(argv[0]+strlen(VMOPTION("maxpic:")));
+		return 1; }
+# endif
     else if (!strcmp(argv[0], VMOPTION("reportheadroom"))
           || !strcmp(argv[0], VMOPTION("rh"))) {
 		extern sqInt reportStackHeadroom;
@@ -1995,6 +2025,30 @@ parseVMArgument(int argc, char *argv[])
 		openScavengeLog();
 		return 1;
 	}
+# if SPURGCOPTIONS
+	else if (argc > 1 && !strcmp(argv[0], VMOPTION("gclog"))) {
+		extern void openGCLog(char *fileName);
+		openGCLog(argv[1]);
+		return 2;
+	}
+	else if (!strncmp(argv[0], VMOPTION("gclog:"), strlen(VMOPTION("gclog:")))) {
+		extern void openGCLog(char *fileName);
+		openGCLog(argv[0]+strlen(VMOPTION("gclog:")));
+		return 1;
+	}
+# endif /* SPURGCOPTIONS */
+# if SIZABLEMETHODCACHE
+	else if (argc > 1 && !strcmp(argv[0], VMOPTION("methodcache"))) {
+		extern usqInt methodCacheEntries;
+		methodCacheEntries = (usqInt) strtobkm(argv[1]);
+		return 2;
+	}
+	else if (!strncmp(argv[0], VMOPTION("methodcache:"), strlen(VMOPTION("methodcache:")))) {
+		extern usqInt methodCacheEntries;
+		methodCacheEntries = (usqInt) strtobkm(argv[0]+strlen(VMOPTION("methodcache:")));
+		return 1;
+	}
+# endif
 #endif
 
   /* NOTE: the following flags are "undocumented" */
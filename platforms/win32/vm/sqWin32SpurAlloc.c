@@ -194,6 +194,57 @@ sqDeallocateMemorySegmentAtOfSize(void *addr, sqInt sz)
 					sz, GetLastError());
 }
 
+/* MEM_RESET tells the system the pages' contents are no longer wanted, so
+ * they are discarded rather than paged out, but they stay committed;
+ * MEM_DECOMMIT would fault on the next access.  Hence all of a segment is
+ * reported as resident.
+ */
+usqInt
+sqDecommitMemoryFromTo(usqInt startAddr, usqInt endAddr)
+{
+	usqInt start = roundUpToPage(startAddr);
+	usqInt end = roundDownToPage(endAddr);
+
+	if (end <= start)
+		return 0;
+	if (!VirtualAlloc((void *)start, end - start, MEM_RESET, PAGE_READWRITE))
+		return 0;
+	return end - start;
+}
+
+usqInt
+sqResidentBytesFromTo(usqInt startAddr, usqInt endAddr)
+{
+	return endAddr - startAddr;
+}
+
+/* Large pages need the SeLockMemoryPrivilege and are not used. */
+usqInt
+sqHugePageBytesFromTo(usqInt startAddr, usqInt endAddr) { return 0; }
+
+/* Job object memory limits are not yet consulted. */
+usqInt
+sqMemoryLimit(void) { return 0; }
+
+sqInt
+sqMemoryIsNearLimit(void) { return 0; }
+
+/* GetWriteWatch needs the heap allocated with MEM_WRITE_WATCH, which it is
+ * not, so the concurrent marker is not used.
+ */
+sqInt
+sqCanTrackDirtyPages(void) { return 0; }
+
+void
+sqClearDirtyPages(void) { }
+
+usqInt
+sqDirtyPageSize(void) { return 4096; }
+
+sqInt
+sqDirtyPagesFromToInto(usqInt startAddr, usqInt endAddr, unsigned char *dirty)
+{ return 0; }
+
 # if COGVM
 void
 sqMakeMemoryExecutableFromTo(usqIntptr_t startAddr, usqIntptr_t endAddr)
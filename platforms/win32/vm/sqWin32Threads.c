@@ -181,14 +181,6 @@ ioReleaseOSThreadState(HANDLE thread)
 	(void)CloseHandle(thread);
 }
 
-int
-ioNumProcessors(void)
-{
-	char *nprocs = getenv("NUMBER_OF_PROCESSORS");
-
-	return nprocs ? atoi(nprocs) : 1;
-}
-
 int
 ioNewOSSemaphore(sqOSSemaphore *sem)
 {
@@ -225,6 +217,56 @@ sqInt
 amInVMThread() { return ioOSThreadsEqual(ioCurrentOSThread(),getVMOSThread()); }
 #endif /* COGMTVM */
 
+#if COGMTVM || SPURVM
+int
+ioNumProcessors(void)
+{
+	char *nprocs = getenv("NUMBER_OF_PROCESSORS");
+
+	return nprocs ? atoi(nprocs) : 1;
+}
+#endif /* COGMTVM || SPURVM */
+
+#if SPURVM
+/* The parallel phases of the Spur GC run serially on win32 for now. */
+int
+ioNumGCThreads(void) { return 1; }
+
+void
+ioSetNumGCThreads(int numThreads) { }
+
+void
+ioGCThreadsDo(void (*work)(sqInt, void *), void *arg) { work(0, arg); }
+
+void
+ioNumThreadsDo(int numThreads, void (*work)(sqInt, void *), void *arg)
+{ work(0, arg); }
+
+void
+ioLockGCThreads(void) { }
+
+void
+ioUnlockGCThreads(void) { }
+
+int
+ioStartBackgroundGCWork(void (*work)(void *), void *arg) { return 0; }
+
+void
+ioWaitForBackgroundGCWork(void) { }
+#endif /* SPURVM */
+
+/* There is no fork on win32, so snapshots are always written in the
+ * foreground.
+ */
+int
+ioForkForSnapshot(sqInt semaIndex) { return -1; }
+
+void
+ioExitSnapshotChild(int status) { ExitProcess(status); }
+
+int
+ioBackgroundSnapshotStatus(void) { return 0; }
+
 void
 ioInitThreads()
 {
@@ -3331,8 +3331,17 @@ int printUsage(int level)
 #endif
 #if COGVM
                    TEXT("\n\t") TEXT(VMOPTION("codesize:")) TEXT(" bytes \t(set machine-code memory size to bytes)")
+# if COGGROWABLECODEZONE
+                   TEXT("\n\t") TEXT(VMOPTION("maxcodesize:")) TEXT(" bytes \t(let machine-code memory grow up to bytes, at most 16m)")
+# endif
+# if COGCODECACHE
+                   TEXT("\n\t") TEXT(VMOPTION("codecache:")) TEXT(" file \t(compile the methods listed in file at start-up; rewrite it on snapshot and quit)")
+# endif
                    TEXT("\n\t") TEXT(VMOPTION("cogmaxlits:")) TEXT(" n \t\t(set max number of literals for methods to be compiled to machine code)")
                    TEXT("\n\t") TEXT(VMOPTION("cogminjumps:")) TEXT(" n \t(set min number of backward jumps for interpreted methods to be considered for compilation to machine code)")
+# if COGMAXPIC
+                   TEXT("\n\t") TEXT(VMOPTION("maxpic:")) TEXT(" n \t\t(set the maximum number of cases in a closed PIC, 2 to 32)")
+# endif
                    TEXT("\n\t") TEXT(VMOPTION("tracestores")) TEXT(" \t\t(assert-check stores for debug)")
                    TEXT("\n\t") TEXT(VMOPTION("reportheadroom")) TEXT(" \t(report unused stack headroom on exit)")
                    TEXT("\n\t") TEXT(VMOPTION("dpcso:")) TEXT(" bytes \t\t(stack offset for prim calls for debug)")
@@ -3340,6 +3349,12 @@ int printUsage(int level)
 #if SPURVM
                    TEXT("\n\t") TEXT(VMOPTION("maxoldspace:")) TEXT(" bytes \t(set max size of old space memory to bytes)")
                    TEXT("\n\t") TEXT(VMOPTION("logscavenge")) TEXT(" \t\t(log scavenging to scavenge.log)")
+# if SPURGCOPTIONS
+                   TEXT("\n\t") TEXT(VMOPTION("gclog:")) TEXT(" file \t\t(write a JSON record per GC to file, - for stderr)")
+# endif
+# if SIZABLEMETHODCACHE
+                   TEXT("\n\t") TEXT(VMOPTION("methodcache:")) TEXT(" n \t(size the interpreter's method cache to n entries)")
+# endif
 #endif
                    TEXT("\n") TEXT("Options begin with single -, but -- prefix is silently accepted")
                    TEXT("\n") TEXT("Options with arguments -opt:n are also accepted with separators -opt n")
@@ -25,6 +25,7 @@ extern void addCogMethodsToHeapMap(void);
 extern sqInt bytecodePCForstartBcpcin(sqInt mcpc, sqInt startbcpc, CogBlockMethod *cogMethod);
 extern void callCogCodePopReceiver(void);
 extern void callCogCodePopReceiverAndClassRegs(void);
+extern void cacheInOpenPICclassTagmethod(CogMethod *anOpenPIC, sqInt classTag, sqInt methodObj);
 extern sqInt ceCPICMissreceiver(CogMethod *cPIC, sqInt receiver);
 extern void ceFree(void*pointer);
 extern void* ceMalloc(size_t size);
@@ -34,6 +35,7 @@ extern sqInt checkIntegrityOfObjectReferencesInCode(sqInt gcModes);
 extern char * codeEntryFor(char *address);
 extern char * codeEntryNameFor(char *address);
 extern sqInt cogCodeBase(void);
+extern sqInt cogCodeZoneSize(void);
 extern sqInt cogCodeConstituents(sqInt withDetails);
 extern CogMethod * cogFullBlockMethodnumCopied(sqInt aMethodObj, sqInt numCopied);
 extern void cogitPostGCAction(sqInt gcMode);
@@ -72,9 +74,12 @@ extern void unlinkSendsOfisMNUSelector(sqInt selector, sqInt isMNUSelector);
 extern void unlinkSendsToFree(void);
 extern void unlinkSendsToandFreeIf(sqInt targetMethodObject, sqInt freeIfTrue);
 extern void addAllToYoungReferrers(void);
+extern void flushMegamorphicCaches(void);
 extern void freeMethod(CogMethod *cogMethod);
 extern CogMethod * methodFor(void *address);
+extern sqInt methodObjectsCompiledToMachineCodeIntolimit(sqInt *methodObjs, sqInt limit);
 extern sqInt methodsCompiledToMachineCodeInto(sqInt arrayObj);
+extern void noteUsageSampleFor(CogMethod *cogMethod);
 extern sqInt numMethods(void);
 extern sqInt numMethodsOfType(sqInt cogMethodType);
 extern void printCogMethods(void);
@@ -84,6 +89,7 @@ extern void printCogMethodsWithPrimitive(sqInt primIdx);
 extern void printCogMethodsWithSelector(sqInt selectorOop);
 extern void printCogYoungReferrers(void);
 extern sqInt printOpenPICList(void);
+extern void setMethodZoneGrowthLimit(sqInt anAddress);
 extern char * whereIsMaybeCodeThing(sqInt anOop);
 extern sqInt numRegArgs(void);
 extern sqInt genQuickReturnConst(void);
@@ -124,13 +130,17 @@ VM_EXPORT void (*ceUnlockVMOwner)(void);
 VM_EXPORT sqInt cFramePointerInUse;
 VM_EXPORT sqInt cmEntryOffset;
 VM_EXPORT sqInt cmNoCheckEntryOffset;
+VM_EXPORT void (*codeLoadHook)(usqInt, usqInt, char *);
 VM_EXPORT usqIntptr_t debugPrimCallStackOffset;
+VM_EXPORT sqInt maxCPICCases;
 VM_EXPORT sqInt missOffset;
 VM_EXPORT void (*realCECallCogCodePopReceiverAndClassRegs)(void);
 VM_EXPORT void (*realCECallCogCodePopReceiverArg0Regs)(void);
 VM_EXPORT void (*realCECallCogCodePopReceiverArg1Arg0Regs)(void);
 VM_EXPORT void (*realCECallCogCodePopReceiverReg)(void);
 VM_EXPORT void (*realCEEnterCogCodePopReceiverReg)(void);
+VM_EXPORT sqInt statCodeCompilations;
+VM_EXPORT sqInt statCodeEvictions;
 VM_EXPORT int traceFlags ;
 VM_EXPORT sqInt traceStores;
 
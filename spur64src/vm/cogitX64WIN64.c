@@ -196,16 +196,20 @@ char *__cogitBuildInfo = __buildInfo;
 #define MapEnd 0
 #define MaxCompiledPrimitiveIndex 555
 #define MaxCPICCases 6
+#define MaxCPICCasesLimit 32
 #define MaxMethodSize 65535
 #define MaxNegativeErrorCode -8
 #define MaxNumArgs 15
 #define MaxStackAllocSize 1572864
 #define MaxStackCheckOffset 0xFFF
 #define MaxX2NDisplacement 992
+#define MegamorphicCacheEntries 16
 #define MethodCacheClass 2
-#define MethodCacheMask 0xFFC
+#define MethodCacheClassTagShift 4
+#define MethodCacheEntrySize 4
 #define MethodCacheMethod 3
 #define MethodCacheSelector 1
+#define MethodCacheWays 4
 #define MethodIndex 3
 #define MethodTooBig -4
 #define MFMethodFlagHasContextFlag 1
@@ -519,6 +523,7 @@ static AbstractInstruction * NoDbgRegParms gCall(sqInt callTarget);
 static AbstractInstruction * NoDbgRegParms gCmpCqR(sqInt quickConstant, sqInt reg);
 extern void callCogCodePopReceiver(void);
 extern void callCogCodePopReceiverAndClassRegs(void);
+extern void cacheInOpenPICclassTagmethod(CogMethod *anOpenPIC, sqInt classTag, sqInt methodObj);
 extern sqInt ceCPICMissreceiver(CogMethod *cPIC, sqInt receiver);
 extern void ceFree(void*pointer);
 extern void* ceMalloc(size_t size);
@@ -535,6 +540,7 @@ extern char * codeEntryFor(char *address);
 extern char * codeEntryNameFor(char *address);
 extern sqInt cogCodeBase(void);
 extern sqInt cogCodeConstituents(sqInt withDetails);
+extern sqInt cogCodeZoneSize(void);
 static sqInt NoDbgRegParms cogExtendPICCaseNMethodtagisMNUCase(CogMethod *cPIC, sqInt caseNMethod, sqInt caseNTag, sqInt isMNUCase);
 extern CogMethod * cogFullBlockMethodnumCopied(sqInt aMethodObj, sqInt numCopied);
 extern void cogitPostGCAction(sqInt gcMode);
@@ -682,6 +688,8 @@ static sqInt NoDbgRegParms needsFrameNever(sqInt stackDelta);
 static sqInt NoDbgRegParms noAssertMethodClassAssociationOf(sqInt methodPointer);
 static sqInt noCogMethodsMaximallyMarked(void);
 static sqInt NoDbgRegParms noTargetsFreeInClosedPIC(CogMethod *cPIC);
+static void NoDbgRegParms noteCodeLoad(CogMethod *cogMethod);
+static void noteTrampolineLoads(void);
 static sqInt NoDbgRegParms outputInstructionsAt(sqInt startAddress);
 static sqInt NoDbgRegParms outputInstructionsForGeneratedRuntimeAt(sqInt startAddress);
 static AbstractInstruction * NoDbgRegParms gPushCw(sqInt wordConstant);
@@ -736,13 +744,17 @@ static usqInt NoDbgRegParms allocate(sqInt numBytes);
 static void clearCogCompiledCode(void);
 static void compactCompiledCode(void);
 static void NoDbgRegParms ensureInYoungReferrers(CogMethod *cogMethod);
+extern void flushMegamorphicCaches(void);
 static void followForwardedLiteralsInOpenPICList(void);
 extern void freeMethod(CogMethod *cogMethod);
 static void freeOlderMethodsForCompaction(void);
 static sqInt kosherYoungReferrers(void);
 static void NoDbgRegParms manageFromto(sqInt theStartAddress, sqInt theLimitAddress);
+static void maybeGrowMethodZone(void);
 extern CogMethod * methodFor(void *address);
+extern sqInt methodObjectsCompiledToMachineCodeIntolimit(sqInt *methodObjs, sqInt limit);
 extern sqInt methodsCompiledToMachineCodeInto(sqInt arrayObj);
+extern void noteUsageSampleFor(CogMethod *cogMethod);
 extern sqInt numMethods(void);
 extern sqInt numMethodsOfType(sqInt cogMethodType);
 static sqInt NoDbgRegParms occurrencesInYoungReferrers(CogMethod *cogMethod);
@@ -759,6 +771,7 @@ static sqInt pruneYoungReferrers(void);
 static sqInt relocateAndPruneYoungReferrers(void);
 static sqInt relocateMethodsPreCompaction(void);
 static sqInt NoDbgRegParms removeFromOpenPICList(CogMethod *anOpenPIC);
+extern void setMethodZoneGrowthLimit(sqInt anAddress);
 static void voidOpenPICList(void);
 static void voidYoungReferrersPostTenureAll(void);
 extern char * whereIsMaybeCodeThing(sqInt anOop);
@@ -1022,9 +1035,9 @@ static void compileGetErrorCode(void);
 static sqInt compileInterpreterPrimitive(void);
 static sqInt NoDbgRegParms compileInterpreterPrimitiveflags(void (*primitiveRoutine)(void), sqInt flags);
 static sqInt NoDbgRegParms compileMachineCodeInterpreterPrimitive(void (*primitiveRoutine)(void));
-static AbstractInstruction * NoDbgRegParms compileOpenPICMethodCacheProbeForwithShiftbaseRegOrNone(sqInt selector, sqInt shift, sqInt baseRegOrNone);
+static AbstractInstruction * NoDbgRegParms compileOpenPICMethodCacheProbeForinWaybaseRegOrNone(sqInt selector, sqInt way, sqInt baseRegOrNone);
 static void NoDbgRegParms compileOpenPICnumArgs(sqInt selector, sqInt numArgs);
-static AbstractInstruction * NoDbgRegParms compilePerformMethodCacheProbeForwithShiftbaseRegOrNone(sqInt selectorReg, sqInt shift, sqInt baseRegOrNone);
+static AbstractInstruction * NoDbgRegParms compilePerformMethodCacheProbeForinWaybaseRegOrNone(sqInt selectorReg, sqInt way, sqInt baseRegOrNone);
 static sqInt compilePrimitive(void);
 static sqInt extendedPushBytecode(void);
 static sqInt extendedStoreAndPopBytecode(void);
@@ -1332,6 +1345,7 @@ static sqInt closedPICSize;
 sqInt cmEntryOffset;
 sqInt cmNoCheckEntryOffset;
 static sqInt codeBase;
+void (*codeLoadHook)(usqInt, usqInt, char *) = 0;
 static sqInt codeModified;
 static sqInt cogConstituentIndex;
 static sqInt compactionInProgress;
@@ -1893,6 +1907,7 @@ static sqInt introspectionDataIndex;
 static int labelCounter;
 static sqInt lastSend;
 static usqInt limitAddress;
+sqInt maxCPICCases = MaxCPICCases /* 6 */;
 static sqInt maxLitIndex;
 static sqInt methodAbortTrampolines[4];
 static sqInt methodBytesFreedSinceLastCompaction;
@@ -1903,6 +1918,7 @@ static sqInt methodObj;
 static sqInt methodOrBlockNumArgs;
 static sqInt methodOrBlockNumTemps;
 static sqInt methodZoneBase;
+static usqInt methodZoneGrowthLimit;
 static usqIntptr_t minValidCallAddress;
 sqInt missOffset;
 static usqInt mzFreeStart;
@@ -1913,6 +1929,7 @@ static sqInt numExtB;
 static usqInt objectReferencesInRuntime[NumObjRefsInRuntime+1];
 static sqInt opcodeIndex;
 static CogMethod *openPICList = 0;
+static sqInt openPICMegamorphicCacheOffset;
 static sqInt openPICSize;
 static sqInt ordinarySendTrampolines[NumSendTrampolines];
 static sqInt picAbortTrampolines[4];
@@ -1942,6 +1959,8 @@ static SimStackEntry simStack[70];
 static sqInt simStackPtr;
 static AbstractInstruction * stackCheckLabel;
 static AbstractInstruction * stackOverflowCall;
+sqInt statCodeCompilations;
+sqInt statCodeEvictions;
 static sqInt superSendTrampolines[NumSendTrampolines];
 static sqInt tempOop;
 int traceFlags = 8 /* prim trace log on by default */;
@@ -2649,10 +2668,10 @@ static sqInt NoDbgRegParms
 addressOfEndOfCaseinCPIC(sqInt n, CogMethod *cPIC)
 {
 	assert((n >= 1)
-	 && (n <= MaxCPICCases));
+	 && (n <= maxCPICCases));
 	return (n == 1
 		? (((sqInt)cPIC)) + firstCPICCaseOffset
-		: ((((sqInt)cPIC)) + firstCPICCaseOffset) + (((MaxCPICCases + 1) - n) * cPICCaseSize));
+		: ((((sqInt)cPIC)) + firstCPICCaseOffset) + (((maxCPICCases + 1) - n) * cPICCaseSize));
 }
 
 	/* Cogit>>#alignUptoRoutineBoundary: */
@@ -3072,6 +3091,25 @@ callCogCodePopReceiverAndClassRegs(void)
 }
 
 
+/*	Enter methodObj as the target for classTag in anOpenPIC's megamorphic
+	cache, replacing whatever was cached for another class tag with the same
+	index. Called from ceSendFromInLineCacheMiss: when the PIC's probes have
+	failed. */
+
+	/* Cogit>>#cacheInOpenPIC:classTag:method: */
+void
+cacheInOpenPICclassTagmethod(CogMethod *anOpenPIC, sqInt classTag, sqInt methodObj)
+{
+    sqInt *cacheEntry;
+
+	assert(((anOpenPIC->cmType)) == CMOpenPIC);
+	assert(!(isYoung(methodObj)));
+	cacheEntry = ((sqInt *) (((((usqInt)anOpenPIC)) + openPICMegamorphicCacheOffset) + ((classTag & (MegamorphicCacheEntries - 1)) * (2 * BytesPerWord))));
+	cacheEntry[0] = classTag;
+	cacheEntry[1] = methodObj;
+}
+
+
 /*	Code entry closed PIC miss. A send has fallen
 	through a closed (finite) polymorphic inline cache.
 	Either extend it or patch the send site to an open PIC.
@@ -3097,7 +3135,7 @@ ceCPICMissreceiver(CogMethod *cPIC, sqInt receiver)
 	}
 	outerReturn = stackTop();
 	assert(!(((inlineCacheTagAt(backEnd, outerReturn)) == (picAbortDiscriminatorValue()))));
-	if (((cPIC->cPICNumCases)) < MaxCPICCases) {
+	if (((cPIC->cPICNumCases)) < maxCPICCases) {
 		/* begin lookup:for:methodAndErrorSelectorInto: */
 		selector = (cPIC->selector);
 		methodOrSelectorIndex = lookupOrdinaryreceiver(selector, receiver);
@@ -3144,7 +3182,7 @@ ceCPICMissreceiver(CogMethod *cPIC, sqInt receiver)
 	}
 	assert(outerReturn == (stackTop()));
 	cacheTag = inlineCacheTagForInstance(receiver);
-	if ((((cPIC->cPICNumCases)) >= MaxCPICCases)
+	if ((((cPIC->cPICNumCases)) >= maxCPICCases)
 	 || (((errorSelectorOrNil != null)
 	 && (errorSelectorOrNil != SelectorDoesNotUnderstand))
 	 || ((newTargetMethodOrNil == null)
@@ -3844,6 +3882,17 @@ cogCodeConstituents(sqInt withDetails)
 	return constituents;
 }
 
+/*	Answer the size of the code zone, trampolines included. It is the size
+	given at start-up unless the method zone has since grown. */
+
+	/* Cogit>>#cogCodeZoneSize */
+sqInt
+cogCodeZoneSize(void)
+{
+	return limitAddress - codeBase;
+}
+
+
 
 /*	Extend the cPIC with the supplied case. If caseNMethod is cogged dispatch
 	direct to
@@ -4004,7 +4053,7 @@ cogMethodDoesntLookKosher(CogMethod *cogMethod)
 		if (((cogMethod->blockSize)) != closedPICSize) {
 			return 0x1F;
 		}
-		if (!(((((cogMethod->cPICNumCases)) >= 1) && (((cogMethod->cPICNumCases)) <= MaxCPICCases)))) {
+		if (!(((((cogMethod->cPICNumCases)) >= 1) && (((cogMethod->cPICNumCases)) <= maxCPICCases)))) {
 			return 32;
 		}
 		if (((cogMethod->methodHeader)) != 0) {
@@ -4068,6 +4117,9 @@ cogMNUPICSelectorreceivermethodOperandnumArgs(sqInt selector, sqInt rcvr, sqInt
 	assert(closedPICSize == (roundUpLength(closedPICSize)));
 	flushICacheFromto(processor, ((usqInt)pic), (((usqInt)pic)) + closedPICSize);
 	/* begin maybeEnableSingleStep */
+	if (!(codeLoadHook == null)) {
+		noteCodeLoad(pic);
+	}
 	return pic;
 }
 
@@ -4097,7 +4149,7 @@ cogOpenPICSelectornumArgs(sqInt selector, sqInt numArgs)
 	(methodLabel->address = startAddress);
 	(methodLabel->dependent = null);
 	/* begin allocateOpcodes:bytecodes: */
-	numAbstractOpcodes = 100;
+	numAbstractOpcodes = 120;
 	opcodeSize = (sizeof(CogAbstractInstruction)) * numAbstractOpcodes;
 	fixupSize = (sizeof(CogBytecodeFixup)) * numAbstractOpcodes;
 	abstractOpcodes = alloca(opcodeSize + fixupSize);
@@ -4111,8 +4163,10 @@ cogOpenPICSelectornumArgs(sqInt selector, sqInt numArgs)
 	codeSize = generateInstructionsAt(startAddress + (sizeof(CogMethod)));
 	mapSize = generateMapAtstart((startAddress + openPICSize) - 1, startAddress + cmNoCheckEntryOffset);
 	assert((((entry->address)) - startAddress) == cmEntryOffset);
-	assert(((roundUpLength((sizeof(CogMethod)) + codeSize)) + (roundUpLength(mapSize))) <= openPICSize);
+	assert((roundUpLength((sizeof(CogMethod)) + codeSize)) <= openPICMegamorphicCacheOffset);
+	assert(((openPICMegamorphicCacheOffset + (MegamorphicCacheEntries * (2 * BytesPerWord))) + (roundUpLength(mapSize))) <= openPICSize);
 	end = outputInstructionsAt(startAddress + (sizeof(CogMethod)));
+	memset(((void *) (startAddress + openPICMegamorphicCacheOffset)), 0, MegamorphicCacheEntries * (2 * BytesPerWord));
 	/* begin fillInOPICHeader:numArgs:selector: */
 	pic = ((CogMethod *) startAddress);
 	(pic->cmType = CMOpenPIC);
@@ -4137,6 +4191,9 @@ cogOpenPICSelectornumArgs(sqInt selector, sqInt numArgs)
 	assert(openPICSize == (roundUpLength(openPICSize)));
 	flushICacheFromto(processor, ((usqInt)pic), (((usqInt)pic)) + openPICSize);
 	/* begin maybeEnableSingleStep */
+	if (!(codeLoadHook == null)) {
+		noteCodeLoad(pic);
+	}
 	return pic;
 }
 
@@ -4190,6 +4247,9 @@ cogPICSelectornumArgsCase0MethodCase1MethodtagisMNUCase(sqInt selector, sqInt nu
 	assert(closedPICSize == (roundUpLength(closedPICSize)));
 	flushICacheFromto(processor, ((usqInt)pic), (((usqInt)pic)) + closedPICSize);
 	/* begin maybeEnableSingleStep */
+	if (!(codeLoadHook == null)) {
+		noteCodeLoad(pic);
+	}
 	return pic;
 }
 
@@ -4567,6 +4627,7 @@ compactCogCompiledCode(void)
 	updateStackZoneReferencesToCompiledCodePreCompaction();
 	relocateMethodsPreCompaction();
 	compactCompiledCode();
+	maybeGrowMethodZone();
 	assert(allMethodsHaveCorrectHeader());
 	assert(kosherYoungReferrers());
 	stopsFromto(backEnd, freeStart(), (youngReferrers()) - 1);
@@ -5231,11 +5292,11 @@ cPICCompactAndIsNowEmpty(CogMethod *cPIC)
 {
     sqInt entryPoint;
     sqInt i;
-    sqInt methods[MaxCPICCases];
+    sqInt methods[MaxCPICCasesLimit];
     sqInt pc;
-    int tags[MaxCPICCases];
+    int tags[MaxCPICCasesLimit];
     CogMethod *targetMethod;
-    sqInt targets[MaxCPICCases];
+    sqInt targets[MaxCPICCasesLimit];
     sqInt used;
     sqInt valid;
 
@@ -5389,7 +5450,7 @@ cPICHasTarget(CogMethod *cPIC, CogMethod *targetMethod)
 	if (target == (jumpLongTargetBeforeFollowingAddress(backEnd, pc))) {
 		return 1;
 	}
-	for (i = 2; i <= MaxCPICCases; i += 1) {
+	for (i = 2; i <= maxCPICCases; i += 1) {
 		pc += cPICCaseSize;
 		if (target == (jumpLongTargetBeforeFollowingAddress(backEnd, pc))) {
 			return 1;
@@ -5616,7 +5677,7 @@ expectedClosedPICPrototype(CogMethod *cPIC)
 	if (!(asserta(entryPoint == ((cPICPrototypeCaseOffset()) + 13262352)))) {
 		errors += 2;
 	}
-	for (i = 1; i < MaxCPICCases; i += 1) {
+	for (i = 1; i < maxCPICCases; i += 1) {
 
 		/* verify information in case is as expected. */
 		pc += cPICCaseSize;
@@ -6302,10 +6363,14 @@ generateClosedPICPrototype(void)
     sqInt wordConstant1;
 
 
+	/* The prototype has at least two cases, from which the case size is derived. */
+	maxCPICCases = ((maxCPICCases < 2)
+		? 2
+		: ((maxCPICCases < MaxCPICCasesLimit) ? maxCPICCases : MaxCPICCasesLimit));
 	/* stack allocate the various collections so that they
 	   are effectively garbage collected on return. */
 	/* begin allocateOpcodes:bytecodes: */
-	numAbstractOpcodes = MaxCPICCases * 9;
+	numAbstractOpcodes = maxCPICCases * 9;
 	opcodeSize = (sizeof(CogAbstractInstruction)) * numAbstractOpcodes;
 	fixupSize = (sizeof(CogBytecodeFixup)) * numAbstractOpcodes;
 	abstractOpcodes = alloca(opcodeSize + fixupSize);
@@ -6329,8 +6394,8 @@ generateClosedPICPrototype(void)
 	jumpTarget1 = (((methodZoneBase + (youngReferrers())) / 2) - 13262352) + 13262352;
 	genoperand(JumpLong, jumpTarget1);
 	endCPICCase0 = genoperandoperand(Label, (labelCounter += 1), bytecodePC);
-	for (h = 1; h < MaxCPICCases; h += 1) {
-		if (h == (MaxCPICCases - 1)) {
+	for (h = 1; h < maxCPICCases; h += 1) {
+		if (h == (maxCPICCases - 1)) {
 			jmpTarget(jumpNext, genoperandoperand(Label, (labelCounter += 1), bytecodePC));
 		}
 		/* begin MoveUniqueCw:R: */
@@ -6363,7 +6428,7 @@ generateClosedPICPrototype(void)
 	firstCPICCaseOffset = ((endCPICCase0->address)) - methodZoneBase;
 	cPICEndOfCodeOffset = ((cPICEndOfCodeLabel->address)) - methodZoneBase;
 	cPICCaseSize = ((endCPICCase1->address)) - ((endCPICCase0->address));
-	cPICEndSize = closedPICSize - (((MaxCPICCases - 1) * cPICCaseSize) + firstCPICCaseOffset);
+	cPICEndSize = closedPICSize - (((maxCPICCases - 1) * cPICCaseSize) + firstCPICCaseOffset);
 	closedPICSize = roundUpLength(closedPICSize);
 	assert(((picInterpretAbort->address)) == (((methodLabel->address)) + (picInterpretAbortOffset())));
 	assert((expectedClosedPICPrototype(cPIC)) == 0);
@@ -6418,6 +6483,10 @@ generateCogFullBlock(void)
 		postCompileHook(method);
 		postCompileHook = null;
 	}
+	statCodeCompilations += 1;
+	if (!(codeLoadHook == null)) {
+		noteCodeLoad(method);
+	}
 	return method;
 }
 
@@ -6466,6 +6535,10 @@ generateCogMethod(sqInt selector)
 		postCompileHook(method);
 		postCompileHook = null;
 	}
+	statCodeCompilations += 1;
+	if (!(codeLoadHook == null)) {
+		noteCodeLoad(method);
+	}
 	return method;
 }
 
@@ -6557,7 +6630,7 @@ generateOpenPICPrototype(void)
     sqInt opcodeSize;
 
 	/* begin allocateOpcodes:bytecodes: */
-	numAbstractOpcodes = 100;
+	numAbstractOpcodes = 120;
 	opcodeSize = (sizeof(CogAbstractInstruction)) * numAbstractOpcodes;
 	fixupSize = (sizeof(CogBytecodeFixup)) * numAbstractOpcodes;
 	abstractOpcodes = alloca(opcodeSize + fixupSize);
@@ -6567,12 +6640,16 @@ generateOpenPICPrototype(void)
 	labelCounter = 0;
 	(methodLabel->address = methodZoneBase);
 	(methodLabel->dependent = null);
+
+	/* Any offset beyond a byte will do to size the megamorphic cache probe. */
+	openPICMegamorphicCacheOffset = 4096;
 	compileOpenPICnumArgs(specialSelector(0), 2 /* numRegArgs */);
 	computeMaximumSizes();
 	concretizeAt(methodLabel, methodZoneBase);
 	codeSize = generateInstructionsAt(methodZoneBase + (sizeof(CogMethod)));
 	mapSize = generateMapAtstart(null, methodZoneBase + cmNoCheckEntryOffset);
-	openPICSize = (roundUpLength((sizeof(CogMethod)) + codeSize)) + (roundUpLength(mapSize));
+	openPICMegamorphicCacheOffset = roundUpLength((sizeof(CogMethod)) + codeSize);
+	openPICSize = (openPICMegamorphicCacheOffset + (MegamorphicCacheEntries * (2 * BytesPerWord))) + (roundUpLength(mapSize));
 }
 
 
@@ -7232,6 +7309,9 @@ initializeCodeZoneFromupTo(sqInt startAddress, sqInt endAddress)
 	generateClosedPICPrototype();
 	manageFromto(methodZoneBase, endAddress);
 	generateOpenPICPrototype();
+	if (!(codeLoadHook == null)) {
+		noteTrampolineLoads();
+	}
 }
 
 
@@ -8768,6 +8848,36 @@ noTargetsFreeInClosedPIC(CogMethod *cPIC)
 }
 
 
+/*	Report cogMethod, just compiled or just moved by compaction, to
+	codeLoadHook, so that e.g. a profiler can map pcs in it to a method name. */
+
+	/* Cogit>>#noteCodeLoad: */
+static void NoDbgRegParms
+noteCodeLoad(CogMethod *cogMethod)
+{
+    char name[256];
+
+	nameOfCogMethodintosize(cogMethod, name, sizeof(name));
+	codeLoadHook(((usqInt)cogMethod), (cogMethod->blockSize), name);
+}
+
+
+/*	Report the trampolines and other run-time routines to codeLoadHook. The
+	trampoline table is in address order and ends with methodZoneBase, so each
+	routine extends up to the start of the next. */
+
+	/* Cogit>>#noteTrampolineLoads */
+static void
+noteTrampolineLoads(void)
+{
+    sqInt i;
+
+	for (i = 0; i <= (trampolineTableIndex - 3); i += 2) {
+		codeLoadHook(((usqInt)(trampolineAddresses[i + 1])), (trampolineAddresses[i + 3]) - (trampolineAddresses[i + 1]), trampolineAddresses[i]);
+	}
+}
+
+
 /*	Store the generated machine code, answering the last address */
 
 	/* Cogit>>#outputInstructionsAt: */
@@ -10300,6 +10410,9 @@ compactCompiledCode(void)
 			if (((dest->cmUsageCount)) > 0) {
 				(dest->cmUsageCount = ((dest->cmUsageCount)) / 2);
 			}
+			if (!(codeLoadHook == null)) {
+				noteCodeLoad(dest);
+			}
 			dest = ((CogMethod *) ((((usqInt)dest)) + bytes));
 		}
 		source = ((CogMethod *) ((((usqInt)source)) + bytes));
@@ -10320,6 +10433,24 @@ ensureInYoungReferrers(CogMethod *cogMethod)
 	}
 }
 
+
+/*	Empty the megamorphic caches of all open PICs. The caches refer to
+	methods, so they are flushed whenever the first-level method lookup cache
+	is, including before a full GC might move or free the methods. */
+
+	/* CogMethodZone>>#flushMegamorphicCaches */
+void
+flushMegamorphicCaches(void)
+{
+    CogMethod *openPIC;
+
+	openPIC = openPICList;
+	while (openPIC != null) {
+		memset(((void *) ((((usqInt)openPIC)) + openPICMegamorphicCacheOffset)), 0, MegamorphicCacheEntries * (2 * BytesPerWord));
+		openPIC = ((CogMethod *) ((openPIC->nextOpenPIC)));
+	}
+}
+
 	/* CogMethodZone>>#followForwardedLiteralsInOpenPICList */
 static void
 followForwardedLiteralsInOpenPICList(void)
@@ -10390,6 +10521,7 @@ freeOlderMethodsForCompaction(void)
 			 && (((cogMethod->cmUsageCount)) <= freeableUsage)) {
 				freeMethod(cogMethod);
 				freedSoFar += (cogMethod->blockSize);
+				statCodeEvictions += 1;
 			}
 			cogMethod = ((CogMethod *) (roundUpLength((((sqInt)cogMethod)) + ((cogMethod->blockSize)))));
 		}
@@ -10436,6 +10568,32 @@ manageFromto(sqInt theStartAddress, sqInt theLimitAddress)
 	methodCount = 0;
 }
 
+
+/*	If the method zone may grow and compaction has left less than a quarter
+	of it free, i.e. most of the code is in use, grow it by half its size, up
+	to methodZoneGrowthLimit, rather than evict hot code again at the next
+	compaction. The young referrers list occupies the end of the zone and so
+	moves up with its limit. */
+
+	/* CogMethodZone>>#maybeGrowMethodZone */
+static void
+maybeGrowMethodZone(void)
+{
+    usqInt delta;
+    usqInt zoneSize;
+
+	zoneSize = limitAddress - baseAddress;
+	if (!((methodZoneGrowthLimit > limitAddress)
+		 && (((limitAddress - (methodCount * BytesPerWord)) - mzFreeStart) < (zoneSize / 4)))) {
+		return;
+	}
+	delta = (((zoneSize / 2) < (methodZoneGrowthLimit - limitAddress)) ? (zoneSize / 2) : (methodZoneGrowthLimit - limitAddress));
+	delta = delta & (~(BytesPerWord - 1));
+	memmove(((void *) (youngReferrers + delta)), ((void *) youngReferrers), limitAddress - youngReferrers);
+	youngReferrers += delta;
+	limitAddress += delta;
+}
+
 	/* CogMethodZone>>#methodFor: */
 CogMethod *
 methodFor(void *address)
@@ -10460,6 +10618,32 @@ methodFor(void *address)
 	return 0;
 }
 
+
+/*	Fill methodObjs with up to limit of the CompiledMethods that have machine
+	code methods, excluding full blocks, and answer how many there are. */
+
+	/* CogMethodZone>>#methodObjectsCompiledToMachineCodeInto:limit: */
+sqInt
+methodObjectsCompiledToMachineCodeIntolimit(sqInt *methodObjs, sqInt limit)
+{
+    CogMethod *cogMethod;
+    sqInt methodIndex;
+
+	methodIndex = 0;
+	cogMethod = ((CogMethod *) baseAddress);
+	while ((cogMethod < (limitZony()))
+	 && (methodIndex < limit)) {
+		if ((((cogMethod->cmType)) == CMMethod)
+		 && (!((cogMethod->cpicHasMNUCaseOrCMIsFullBlock)))) {
+			methodObjs[methodIndex] = (cogMethod->methodObject);
+			methodIndex += 1;
+		}
+		/* begin methodAfter: */
+		cogMethod = ((CogMethod *) (roundUpLength((((sqInt)cogMethod)) + ((cogMethod->blockSize)))));
+	}
+	return methodIndex;
+}
+
 	/* CogMethodZone>>#methodsCompiledToMachineCodeInto: */
 sqInt
 methodsCompiledToMachineCodeInto(sqInt arrayObj)
@@ -10480,6 +10664,21 @@ methodsCompiledToMachineCodeInto(sqInt arrayObj)
 	return methodIndex;
 }
 
+
+/*	Count a sample of execution in cogMethod so that compaction evicts the
+	least run methods first. The count saturates below CMMaxUsageCount, which
+	marks methods active on the stack, and is halved by each compaction, so
+	it weights recent use. */
+
+	/* CogMethodZone>>#noteUsageSampleFor: */
+void
+noteUsageSampleFor(CogMethod *cogMethod)
+{
+	if (((cogMethod->cmUsageCount)) < (CMMaxUsageCount - 1)) {
+		(cogMethod->cmUsageCount = ((cogMethod->cmUsageCount)) + 1);
+	}
+}
+
 	/* CogMethodZone>>#numMethods */
 sqInt
 numMethods(void)
@@ -10879,6 +11078,19 @@ removeFromOpenPICList(CogMethod *anOpenPIC)
 	return 0;
 }
 
+
+/*	Allow the method zone to grow up to anAddress, the end of the memory
+	reserved for it, when compaction reclaims too little. */
+
+	/* CogMethodZone>>#setMethodZoneGrowthLimit: */
+void
+setMethodZoneGrowthLimit(sqInt anAddress)
+{
+	assert(anAddress >= limitAddress);
+	sqMakeMemoryExecutableFromTo(limitAddress, anAddress);
+	methodZoneGrowthLimit = anAddress;
+}
+
 	/* CogMethodZone>>#voidOpenPICList */
 static void
 voidOpenPICList(void)
@@ -17515,7 +17727,7 @@ static sqInt NoDbgRegParms
 maybeShiftClassTagRegisterForMethodCacheProbe(sqInt classTagReg)
 {
 	/* begin LogicalShiftLeftCq:R: */
-	genoperandoperand(LogicalShiftLeftCqR, 2, classTagReg);
+	genoperandoperand(LogicalShiftLeftCqR, MethodCacheClassTagShift, classTagReg);
 	return 0;
 }
 
@@ -23815,21 +24027,23 @@ compileMachineCodeInterpreterPrimitive(void (*primitiveRoutine)(void))
 }
 
 
-/*	Compile one method cache probe in an OpenPIC's lookup of selector.
+/*	Compile one method cache probe in an OpenPIC's lookup of selector, of
+	the given way of the selector's set.
 	Answer the jump taken if the selector probe fails.
 	The class tag of the receiver must be in SendNumArgsReg. ClassReg and
 	TempReg are used as scratch registers.
 	On a hit, the offset of the entry is in ClassReg. */
 
-	/* SimpleStackBasedCogit>>#compileOpenPICMethodCacheProbeFor:withShift:baseRegOrNone: */
+	/* SimpleStackBasedCogit>>#compileOpenPICMethodCacheProbeFor:inWay:baseRegOrNone: */
 static AbstractInstruction * NoDbgRegParms
-compileOpenPICMethodCacheProbeForwithShiftbaseRegOrNone(sqInt selector, sqInt shift, sqInt baseRegOrNone)
+compileOpenPICMethodCacheProbeForinWaybaseRegOrNone(sqInt selector, sqInt way, sqInt baseRegOrNone)
 {
     AbstractInstruction *anInstruction;
     AbstractInstruction *anInstruction1;
     AbstractInstruction *anInstruction2;
     AbstractInstruction *anInstruction3;
     AbstractInstruction *anInstruction4;
+    AbstractInstruction *anInstruction5;
     AbstractInstruction *jumpSelectorMiss;
     sqInt offset;
     sqInt offset1;
@@ -23838,13 +24052,14 @@ compileOpenPICMethodCacheProbeForwithShiftbaseRegOrNone(sqInt selector, sqInt sh
 	genoperandoperand(MoveRR, SendNumArgsReg, ClassReg);
 	maybeShiftClassTagRegisterForMethodCacheProbe(ClassReg);
 	annotateobjRef(checkLiteralforInstruction(selector, genoperandoperand(XorCwR, selector, ClassReg)), selector);
-	assert(shift <= (shiftForWord()));
-	if (shift < (shiftForWord())) {
-		/* begin LogicalShiftLeftCq:R: */
-		genoperandoperand(LogicalShiftLeftCqR, (shiftForWord()) - shift, ClassReg);
-	}
+	/* begin LogicalShiftLeftCq:R: */
+	genoperandoperand(LogicalShiftLeftCqR, shiftForWord(), ClassReg);
 	/* begin AndCq:R: */
-	anInstruction4 = genoperandoperand(AndCqR, ((sqInt)((usqInt)(MethodCacheMask) << (shiftForWord()))), ClassReg);
+	anInstruction4 = genoperandoperand(AndCqR, ((sqInt)((usqInt)((methodCacheMask())) << (shiftForWord()))), ClassReg);
+	if (way > 0) {
+		/* begin AddCq:R: */
+		anInstruction5 = genoperandoperand(AddCqR, ((sqInt)((usqInt)((way * MethodCacheEntrySize)) << (shiftForWord()))), ClassReg);
+	}
 	if (baseRegOrNone == NoReg) {
 		/* begin MoveMw:r:R: */
 		offset = (((usqInt)(methodCacheAddress()))) + (((sqInt)((usqInt)(MethodCacheSelector) << (shiftForWord()))));
@@ -23876,9 +24091,9 @@ compileOpenPICMethodCacheProbeForwithShiftbaseRegOrNone(sqInt selector, sqInt sh
 }
 
 
-/*	Compile the code for an open PIC. Perform a probe of the first-level
-	method lookup cache followed by a call of ceSendFromInLineCacheMiss: if
-	the probe fails. */
+/*	Compile the code for an open PIC. Perform a probe of the PIC's
+	megamorphic cache and then of the first-level method lookup cache,
+	followed by a call of ceSendFromInLineCacheMiss: if both probes fail. */
 
 	/* SimpleStackBasedCogit>>#compileOpenPIC:numArgs: */
 static void NoDbgRegParms
@@ -23887,10 +24102,15 @@ compileOpenPICnumArgs(sqInt selector, sqInt numArgs)
     AbstractInstruction *anInstruction;
     AbstractInstruction *anInstruction1;
     AbstractInstruction *anInstruction2;
+    AbstractInstruction *anInstruction3;
+    AbstractInstruction *anInstruction4;
+    AbstractInstruction *anInstruction5;
     sqInt cacheBaseReg;
     AbstractInstruction *itsAHit;
     AbstractInstruction *jumpBCMethod;
     AbstractInstruction *jumpClassMiss;
+    AbstractInstruction *jumpMegamorphicHit;
+    AbstractInstruction *jumpMegamorphicMiss;
     AbstractInstruction *jumpSelectorMiss;
     sqInt offset;
     sqInt quickConstant;
@@ -23900,6 +24120,29 @@ compileOpenPICnumArgs(sqInt selector, sqInt numArgs)
 	(((((AbstractInstruction *) methodLabel))->operands))[1] = 0;
 	compilePICAbort(numArgs);
 	entry = genGetClassTagOfintoscratchReg(ReceiverResultReg, SendNumArgsReg, TempReg);
+
+	/* First probe the PIC's own megamorphic cache, a table of class tag, method
+	   pairs, indexed by class tag, that follows the PIC's code. */
+	/* begin MoveR:R: */
+	genoperandoperand(MoveRR, SendNumArgsReg, ClassReg);
+	/* begin AndCq:R: */
+	anInstruction3 = genoperandoperand(AndCqR, MegamorphicCacheEntries - 1, ClassReg);
+	/* begin LogicalShiftLeftCq:R: */
+	genoperandoperand(LogicalShiftLeftCqR, (shiftForWord()) + 1, ClassReg);
+	addDependent(methodLabel, annotateAbsolutePCRef(checkLiteralforInstruction(((sqInt)methodLabel), genoperandoperand(MoveCwR, ((sqInt)methodLabel), TempReg))));
+	/* begin AddR:R: */
+	genoperandoperand(AddRR, TempReg, ClassReg);
+	/* begin MoveMw:r:R: */
+	anInstruction4 = genoperandoperandoperand(MoveMwrR, openPICMegamorphicCacheOffset, ClassReg, TempReg);
+	/* begin CmpR:R: */
+	genoperandoperand(CmpRR, SendNumArgsReg, TempReg);
+	/* begin JumpNonZero: */
+	jumpMegamorphicMiss = genConditionalBranchoperand(JumpNonZero, ((sqInt)0));
+	/* begin MoveMw:r:R: */
+	anInstruction5 = genoperandoperandoperand(MoveMwrR, openPICMegamorphicCacheOffset + BytesPerWord, ClassReg, SendNumArgsReg);
+	/* begin Jump: */
+	jumpMegamorphicHit = genoperand(Jump, ((sqInt)0));
+	jmpTarget(jumpMegamorphicMiss, genoperandoperand(Label, (labelCounter += 1), bytecodePC));
 	flag("lookupInMethodCacheSel:classTag:");
 	cacheBaseReg = NoReg;
 	if (!(isWithinMwOffsetRange(backEnd, methodCacheAddress()))) {
@@ -23909,7 +24152,7 @@ compileOpenPICnumArgs(sqInt selector, sqInt numArgs)
 		/* begin checkQuickConstant:forInstruction: */
 		anInstruction = genoperandoperand(MoveCqR, quickConstant, reg);
 	}
-	jumpSelectorMiss = compileOpenPICMethodCacheProbeForwithShiftbaseRegOrNone(selector, 0, cacheBaseReg);
+	jumpSelectorMiss = compileOpenPICMethodCacheProbeForinWaybaseRegOrNone(selector, 0, cacheBaseReg);
 	/* begin JumpNonZero: */
 	jumpClassMiss = genConditionalBranchoperand(JumpNonZero, ((sqInt)0));
 	/* begin MoveMw:r:R: */
@@ -23919,6 +24162,7 @@ compileOpenPICnumArgs(sqInt selector, sqInt numArgs)
 	/* begin checkQuickConstant:forInstruction: */
 	anInstruction1 = genoperandoperandoperand(MoveMwrR, offset, ClassReg, SendNumArgsReg);
 	itsAHit = anInstruction1;
+	jmpTarget(jumpMegamorphicHit, genoperandoperand(Label, (labelCounter += 1), bytecodePC));
 	genLoadSlotsourceRegdestReg(HeaderIndex, SendNumArgsReg, ClassReg);
 	jumpBCMethod = genJumpImmediate(ClassReg);
 	jmpTarget(jumpBCMethod, picInterpretAbort);
@@ -23927,11 +24171,15 @@ compileOpenPICnumArgs(sqInt selector, sqInt numArgs)
 	/* begin JumpR: */
 	genoperand(JumpR, ClassReg);
 	jmpTarget(jumpSelectorMiss, jmpTarget(jumpClassMiss, genoperandoperand(Label, (labelCounter += 1), bytecodePC)));
-	jumpSelectorMiss = compileOpenPICMethodCacheProbeForwithShiftbaseRegOrNone(selector, 1, cacheBaseReg);
+	jumpSelectorMiss = compileOpenPICMethodCacheProbeForinWaybaseRegOrNone(selector, 1, cacheBaseReg);
+	/* begin JumpZero: */
+	genConditionalBranchoperand(JumpZero, ((sqInt)itsAHit));
+	jmpTarget(jumpSelectorMiss, genoperandoperand(Label, (labelCounter += 1), bytecodePC));
+	jumpSelectorMiss = compileOpenPICMethodCacheProbeForinWaybaseRegOrNone(selector, 2, cacheBaseReg);
 	/* begin JumpZero: */
 	genConditionalBranchoperand(JumpZero, ((sqInt)itsAHit));
 	jmpTarget(jumpSelectorMiss, genoperandoperand(Label, (labelCounter += 1), bytecodePC));
-	jumpSelectorMiss = compileOpenPICMethodCacheProbeForwithShiftbaseRegOrNone(selector, 2, cacheBaseReg);
+	jumpSelectorMiss = compileOpenPICMethodCacheProbeForinWaybaseRegOrNone(selector, 3, cacheBaseReg);
 	/* begin JumpZero: */
 	genConditionalBranchoperand(JumpZero, ((sqInt)itsAHit));
 	jmpTarget(jumpSelectorMiss, genoperandoperand(Label, (labelCounter += 1), bytecodePC));
@@ -23943,17 +24191,19 @@ compileOpenPICnumArgs(sqInt selector, sqInt numArgs)
 
 
 /*	Compile one method cache probe in a perform: primitive's lookup of
-	selector. Answer the jump taken if the selector probe fails. */
+	selector, of the given way of the selector's set. Answer the jump taken
+	if the selector probe fails. */
 
-	/* SimpleStackBasedCogit>>#compilePerformMethodCacheProbeFor:withShift:baseRegOrNone: */
+	/* SimpleStackBasedCogit>>#compilePerformMethodCacheProbeFor:inWay:baseRegOrNone: */
 static AbstractInstruction * NoDbgRegParms
-compilePerformMethodCacheProbeForwithShiftbaseRegOrNone(sqInt selectorReg, sqInt shift, sqInt baseRegOrNone)
+compilePerformMethodCacheProbeForinWaybaseRegOrNone(sqInt selectorReg, sqInt way, sqInt baseRegOrNone)
 {
     AbstractInstruction *anInstruction;
     AbstractInstruction *anInstruction1;
     AbstractInstruction *anInstruction2;
     AbstractInstruction *anInstruction3;
     AbstractInstruction *anInstruction4;
+    AbstractInstruction *anInstruction5;
     AbstractInstruction *jumpSelectorMiss;
     sqInt offset;
     sqInt offset1;
@@ -23963,13 +24213,14 @@ compilePerformMethodCacheProbeForwithShiftbaseRegOrNone(sqInt selectorReg, sqInt
 	maybeShiftClassTagRegisterForMethodCacheProbe(ClassReg);
 	/* begin XorR:R: */
 	genoperandoperand(XorRR, selectorReg, ClassReg);
-	assert(shift <= (shiftForWord()));
-	if (shift < (shiftForWord())) {
-		/* begin LogicalShiftLeftCq:R: */
-		genoperandoperand(LogicalShiftLeftCqR, (shiftForWord()) - shift, ClassReg);
-	}
+	/* begin LogicalShiftLeftCq:R: */
+	genoperandoperand(LogicalShiftLeftCqR, shiftForWord(), ClassReg);
 	/* begin AndCq:R: */
-	anInstruction4 = genoperandoperand(AndCqR, ((sqInt)((usqInt)(MethodCacheMask) << (shiftForWord()))), ClassReg);
+	anInstruction4 = genoperandoperand(AndCqR, ((sqInt)((usqInt)((methodCacheMask())) << (shiftForWord()))), ClassReg);
+	if (way > 0) {
+		/* begin AddCq:R: */
+		anInstruction5 = genoperandoperand(AddCqR, ((sqInt)((usqInt)((way * MethodCacheEntrySize)) << (shiftForWord()))), ClassReg);
+	}
 	if (baseRegOrNone == NoReg) {
 		/* begin MoveMw:r:R: */
 		offset = (((usqInt)(methodCacheAddress()))) + (((sqInt)((usqInt)(MethodCacheSelector) << (shiftForWord()))));
@@ -24707,7 +24958,7 @@ genLookupForPerformNumArgs(sqInt numArgs)
 		/* begin checkQuickConstant:forInstruction: */
 		anInstruction = genoperandoperand(MoveCqR, quickConstant, reg);
 	}
-	jumpSelectorMiss = compilePerformMethodCacheProbeForwithShiftbaseRegOrNone(Arg0Reg, 0, cacheBaseReg);
+	jumpSelectorMiss = compilePerformMethodCacheProbeForinWaybaseRegOrNone(Arg0Reg, 0, cacheBaseReg);
 	/* begin JumpNonZero: */
 	jumpClassMiss = genConditionalBranchoperand(JumpNonZero, ((sqInt)0));
 	/* begin MoveMw:r:R: */
@@ -24727,11 +24978,15 @@ genLookupForPerformNumArgs(sqInt numArgs)
 	/* begin JumpR: */
 	genoperand(JumpR, ClassReg);
 	jmpTarget(jumpSelectorMiss, jmpTarget(jumpClassMiss, genoperandoperand(Label, (labelCounter += 1), bytecodePC)));
-	jumpSelectorMiss = compilePerformMethodCacheProbeForwithShiftbaseRegOrNone(Arg0Reg, 1, cacheBaseReg);
+	jumpSelectorMiss = compilePerformMethodCacheProbeForinWaybaseRegOrNone(Arg0Reg, 1, cacheBaseReg);
+	/* begin JumpZero: */
+	genConditionalBranchoperand(JumpZero, ((sqInt)itsAHit));
+	jmpTarget(jumpSelectorMiss, genoperandoperand(Label, (labelCounter += 1), bytecodePC));
+	jumpSelectorMiss = compilePerformMethodCacheProbeForinWaybaseRegOrNone(Arg0Reg, 2, cacheBaseReg);
 	/* begin JumpZero: */
 	genConditionalBranchoperand(JumpZero, ((sqInt)itsAHit));
 	jmpTarget(jumpSelectorMiss, genoperandoperand(Label, (labelCounter += 1), bytecodePC));
-	jumpSelectorMiss = compilePerformMethodCacheProbeForwithShiftbaseRegOrNone(Arg0Reg, 2, cacheBaseReg);
+	jumpSelectorMiss = compilePerformMethodCacheProbeForinWaybaseRegOrNone(Arg0Reg, 3, cacheBaseReg);
 	/* begin JumpZero: */
 	genConditionalBranchoperand(JumpZero, ((sqInt)itsAHit));
 	jmpTarget(jumpSelectorMiss, jmpTarget(jumpInterpret, genoperandoperand(Label, (labelCounter += 1), bytecodePC)));
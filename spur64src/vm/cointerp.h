@@ -76,6 +76,7 @@ extern sqInt marryFrameCopiesTemps(void);
 extern sqInt maxLookupNoMNUErrorCode(void);
 extern sqInt mcprimFunctionForPrimitiveIndex(sqInt primIndex);
 extern void * methodCacheAddress(void);
+extern sqInt methodCacheMask(void);
 extern sqInt methodHasCogMethod(sqInt aMethodOop);
 extern sqInt methodNeedsLargeContext(sqInt methodObj);
 extern sqInt methodShouldBeCogged(sqInt aMethodObj);
@@ -83,6 +84,7 @@ extern CogMethod * mframeHomeMethodExport(void);
 extern CogMethod * mframeHomeMethod(char *theFP);
 extern sqInt mMethodClass(void);
 extern void mnuCompilationBreakpointFor(sqInt selectorOop);
+extern void nameOfCogMethodintosize(CogMethod *cogMethod, char *buffer, sqInt bufferSize);
 extern usqInt newMethodAddress(void);
 extern usqInt nextProfileTickAddress(void);
 extern sqInt noAssertHeaderOf(sqInt methodPointer);
@@ -380,6 +382,7 @@ VM_EXPORT sqInt debugCallbackReturns;
 VM_EXPORT sqInt deferDisplayUpdates;
 VM_EXPORT sqInt desiredCogCodeSize;
 VM_EXPORT sqInt desiredEdenBytes;
+VM_EXPORT sqInt desiredMaxCogCodeSize;
 VM_EXPORT sqInt desiredNumStackPages;
 VM_EXPORT void * displayBits;
 VM_EXPORT int displayDepth;
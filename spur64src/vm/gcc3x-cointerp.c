@@ -33,6 +33,7 @@ char *__interpBuildInfo = __buildInfo;
 #include "cogmethod.h"
 #include "cointerp.h"
 #include "cogit.h"
+#include "sqAtomicOps.h"
 
 
 /* StackInterpreter class>>preambleCCode */
@@ -94,6 +95,7 @@ invalidCompactClassError(char *s) { /* Print a (compact) class index error messa
 
 /*** Constants ***/
 #define ActiveProcessIndex 1
+#define AllocationSampleBufferSize 4096
 #define AlternateHeaderHasPrimFlag 0x80000
 #define AlternateHeaderNumLiteralsMask 0x7FFF
 #define AltLongStoreBytecode 245
@@ -102,7 +104,6 @@ invalidCompactClassError(char *s) { /* Print a (compact) class index error messa
 #define BecamePointerObjectFlag 1
 #define BytecodeSetHasDirectedSuperSend 1
 #define BytecodeSetHasExtensions 1
-#define CacheProbeMax 3
 #define CharacterTable null
 #define CharacterValueIndex 0
 #define CheckAllocationFillerAfterPrimCall 32
@@ -149,6 +150,8 @@ invalidCompactClassError(char *s) { /* Print a (compact) class index error messa
 #define CMMethod 2
 #define CMOpenPIC 5
 #define COGMTVM 0
+#define CompactionMoveRatio 4
+#define ConcurrentMarkStackSize 0x10000
 #define ConstMinusOne 0xFFFFFFFFFFFFFFF9ULL
 #define ConstOne 9
 #define ConstTwo 17
@@ -214,25 +217,32 @@ invalidCompactClassError(char *s) { /* Print a (compact) class index error messa
 #define MarkObjectsForEnumerationPrimitives 0
 #define MarkOnTenure 5
 #define MarkStackRootIndex 0x1000
+#define MaxCardingBackoff 64
 #define MaxExternalPrimitiveTableSize 4096
 #define MaxJumpBuf 32
 #define MaxLiteralCountForCompile 60
 #define MaxNegativeErrorCode -8
+#define MaxPinnedBuffersInUse 256
+#define MaxPooledPinnedBuffers 16
 #define MaxPrimitiveIndex 575
 #define MaxQuickPrimitiveIndex 519
 #define MaxRTRefCount 7
+#define MaxReleasedPinnedBuffers 256
+#define MaxSurvivorAge 15
+#define MaxSwizzleChunks 256
 #define MessageArgumentsIndex 1
 #define MessageLookupClassIndex 2
 #define MessageSelectorIndex 0
 #define MethodArrayIndex 1
 #define MethodCacheClass 2
+#define MethodCacheClassTagShift 4
 #define MethodCacheEntries 0x400
 #define MethodCacheEntrySize 4
-#define MethodCacheMask 0xFFC
 #define MethodCacheMethod 3
 #define MethodCachePrimFunction 4
+#define MethodCacheMaxEntries 0x100000
 #define MethodCacheSelector 1
-#define MethodCacheSize 4096
+#define MethodCacheWays 4
 #define MethodDictionaryIndex 1
 #define MethodHeaderArgCountShift 27
 #define MethodHeaderFlagBitPosition 31
@@ -244,8 +254,13 @@ invalidCompactClassError(char *s) { /* Print a (compact) class index error messa
 #define MFMethodFlagsMask 0x7
 #define MFMethodMask -0x8
 #define MFrameSlots 5
+#define MicrosecondsFrom1901To1970 0x7BC61BCA8C000ULL
 #define MillisecondClockMask 0x1FFFFFFF
 #define MinBackwardJumpCountForCompile 40
+#define MinDecommitChunkBytes 65536
+#define MinPinnedBufferClass 6
+#define MinUsecsBetweenMemoryLimitGCs 1000000
+#define MinSlotsForCardMarking 0x400
 #define MournQueueRootIndex 4098
 #define MULTIPLEBYTECODESETS 1
 #define MyListIndex 3
@@ -262,6 +277,8 @@ invalidCompactClassError(char *s) { /* Print a (compact) class index error messa
 #define NSMethodCacheSelector 1
 #define NSMethodCacheSize 4096
 #define NSMethodCacheTargetMethod 5
+#define NumPinnedBufferClasses 15
+#define NumPinnedFreeLists 32
 #define ObjStackFixedSlots 4
 #define ObjStackFreex 2
 #define ObjStackLimit 0xFF8
@@ -270,6 +287,7 @@ invalidCompactClassError(char *s) { /* Print a (compact) class index error messa
 #define ObjStackPageSlots 0xFFC
 #define ObjStackTopx 0
 #define OldBecameNewFlag 4
+#define ParallelSwizzleThreshold 0x1000000
 #define PrimCallCollectsProfileSamples 16
 #define PrimCallMayCallBack 4
 #define PrimCallNeedsNewMethod 1
@@ -307,7 +325,12 @@ invalidCompactClassError(char *s) { /* Print a (compact) class index error messa
 #define ReceiverIndex 5
 #define RemapBufferSize 25
 #define RememberedSetRootIndex 4099
+#define RememberedSetScanChunkSize 64
+#define RememberedSetScanDeferred 0
+#define RememberedSetScanDropped 2
+#define RememberedSetScanRetained 1
 #define ReturnToInterpreter 1
+#define ScavengeGrayShareThreshold 64
 #define ScavengeInProgress 1
 #define SchedulerAssociation 3
 #define SelectorAboutToReturn 48
@@ -326,6 +349,7 @@ invalidCompactClassError(char *s) { /* Print a (compact) class index error messa
 #define SistaV1BytecodeSet 1
 #define SistaVM 0
 #define SlidingCompactionInProgress 2
+#define SlotsPerCard 128
 #define SmallContextSlots 22
 #define SPURVM 1
 #define SpecialSelectors 23
@@ -335,11 +359,13 @@ invalidCompactClassError(char *s) { /* Print a (compact) class index error messa
 #define StackPageUnreached 0
 #define StackPointerIndex 2
 #define SuperclassIndex 0
+#define SurvivorCopyBufferBytes 0x2000
 #define SuspendedContextIndex 1
 #define TempVectReadBarrier 0
 #define TenureByAge 1
 #define TenureByClass 2
 #define TenureToShrinkRT 3
+#define TenuredCopyBufferBytes 0x8000
 #define TheDisplay 14
 #define TheFinalizationSemaphore 41
 #define TheInputSemaphore null
@@ -385,6 +411,10 @@ typedef struct {
 	usqInt	eSurvivorBytes;
 	usqInt	eRememberedSetSize;
 	usqInt	eStatTenures;
+	usqInt	sOldSpaceBytes;
+	usqInt	sStatTenuredBytes;
+	usqInt	eOldSpaceBytes;
+	usqInt	eStatTenuredBytes;
  } SpurScavengeLogRecord;
 
 
@@ -395,6 +425,11 @@ typedef struct {
 	usqInt	containsPinned;
 	usqInt	savedSegSize;
 	usqInt	lastFreeObject;
+	usqInt	isLargeObjectSegment;
+	usqInt	isPinnedSegment;
+	usqInt	liveBytes;
+	usqInt	isEvacuated;
+	usqInt	pinnedForCompaction;
  } SpurSegmentInfo;
 
 
@@ -404,6 +439,34 @@ typedef struct {
  } SpurNewSpaceSpace;
 
 
+typedef struct {
+	usqInt	survivorStart;
+	usqInt	survivorLimit;
+	usqInt	tenuredStart;
+	usqInt	tenuredLimit;
+	sqInt *	grayStack;
+	sqInt	grayTop;
+	sqInt	grayCapacity;
+	sqInt *	deferred;
+	sqInt	numDeferred;
+	sqInt	deferredCapacity;
+	usqInt	statSurvivorCount;
+	usqInt	statTenures;
+	usqInt	statTenuredBytes;
+	usqInt	survivorBytesByAge[MaxSurvivorAge + 1];
+ } SpurScavengeWorker;
+
+
+typedef struct {
+	sqInt	freeListHeads[64];
+	sqInt	freeListTails[64];
+	sqInt *	chunks;
+	sqInt	numChunks;
+	sqInt	chunksCapacity;
+	usqInt	freeBytes;
+ } SpurSweepWorker;
+
+
 typedef struct {
 	usqInt	start;
 	usqInt	limit;
@@ -463,6 +526,7 @@ extern signed char accessorDepthForPrimitiveIndex(sqInt primIndex);
 static void NoDbgRegParms activateCoggedNewMethod(sqInt inInterpreter);
 static void activateNewMethod(void);
 static void NoDbgRegParms addNewMethodToCache(sqInt classObj);
+static void allocateMethodCache(void);
 extern usqInt argumentCountAddress(void);
 static CogMethod * NoDbgRegParms asCogHomeMethod(CogBlockMethod *aCogMethod);
 static void NoDbgRegParms assertValidExecutionPointersimbarline(usqInt lip, char *lifp, char *lisp, sqInt inInterpreter, sqInt ln);
@@ -510,6 +574,7 @@ extern void clearTraceLog(void);
 extern CogMethod * cogMethodOf(sqInt aMethodOop);
 static void commenceCogCompiledCodeCompaction(void);
 extern void compilationBreakpointFor(sqInt selectorOop);
+static void concurrentlyMarkStackPages(void);
 static sqInt NoDbgRegParms contextInstructionPointerframe(sqInt theIP, char *theFP);
 extern sqInt defaultNativeStackFrameSize(void);
 static sqInt NoDbgRegParms deferStackLimitSmashAroundwith(void (*functionSymbol)(sqInt), sqInt arg);
@@ -553,8 +618,10 @@ static sqInt NeverInline interpreterAllocationReserveBytes(void);
 static sqInt interpretMethodFromMachineCode(void);
 extern sqInt isCogMethodReference(sqInt methodHeader);
 static sqInt NoDbgRegParms isMachineCodeFrame(char *theFP);
+static void loadMachineCodeCache(void);
 extern sqInt lookupMNUreceiver(sqInt selector, sqInt rcvr);
 extern sqInt lookupOrdinaryreceiver(sqInt selector, sqInt rcvr);
+static usqLong NoDbgRegParms machineCodeCacheKeyOf(sqInt methodObj);
 static StackPage * NoDbgRegParms makeBaseFrameFor(sqInt aContext);
 static void mapPrimTraceLog(void);
 static void NeverInline mapStackPages(void);
@@ -569,6 +636,7 @@ extern sqInt maxLookupNoMNUErrorCode(void);
 static void NoDbgRegParms maybeFlagMethodAsInterpreted(sqInt aMethod);
 extern sqInt mcprimFunctionForPrimitiveIndex(sqInt primIndex);
 extern void * methodCacheAddress(void);
+extern sqInt methodCacheMask(void);
 extern sqInt methodHasCogMethod(sqInt aMethodOop);
 extern sqInt methodNeedsLargeContext(sqInt methodObj);
 extern sqInt methodShouldBeCogged(sqInt aMethodObj);
@@ -584,10 +652,13 @@ extern void mnuCompilationBreakpointFor(sqInt selectorOop);
 static sqInt NoDbgRegParms mnuMethodOrNilFor(sqInt rcvr);
 static char * NoDbgRegParms moveFramesInthroughtoPage(StackPage *oldPage, char *theFP, StackPage *newPage);
 static sqInt NoDbgRegParms mustMapMachineCodePCcontext(sqInt theIP, sqInt aOnceMarriedContext);
+extern void nameOfCogMethodintosize(CogMethod *cogMethod, char *buffer, sqInt bufferSize);
 extern usqInt newMethodAddress(void);
 static sqInt NoDbgRegParms newMethodInLookupCacheAtand(sqInt selector, sqInt classTag);
 extern usqInt nextProfileTickAddress(void);
 extern sqInt noAssertHeaderOf(sqInt methodPointer);
+static void NoDbgRegParms noteAllocationSamplebytes(sqInt classIndex, sqInt bytes);
+static void NoDbgRegParms parallelScavengeStackPageworker(StackPage *thePage, SpurScavengeWorker *worker);
 extern sqInt positive32BitIntegerFor(unsigned int integerValue);
 extern unsigned int positive32BitValueOf(sqInt oop);
 extern sqInt positive64BitIntegerFor(usqLong integerValue);
@@ -621,8 +692,10 @@ static sqInt NoDbgRegParms returnToExecutivepostContextSwitch(sqInt inInterprete
 static sqInt NoDbgRegParms returntoExecutive(sqInt returnValue, sqInt inInterpreter);
 static void NoDbgRegParms rewriteMethodCacheEntryForExternalPrimitiveToFunction(void (*localPrimAddress)(void));
 static sqInt NoDbgRegParms roomToPushNArgs(sqInt n);
+static void sampleMachineCodeUsage(void);
 EXPORT(sqInt) sendInvokeCallbackContext(VMCallbackContext *vmCallbackContext);
 EXPORT(sqInt) sendInvokeCallbackStackRegistersJmpbuf(sqInt thunkPtr, sqInt stackPtr, sqInt regsPtr, sqInt jmpBufPtr);
+extern void setMachineCodeCacheFile(char *fileName);
 static sqInt NoDbgRegParms shortPrintFrame(char *theFP);
 extern sqInt signed32BitIntegerFor(sqInt integerValue);
 extern int signed32BitValueOf(sqInt oop);
@@ -647,6 +720,8 @@ extern usqInt varBaseAddress(void);
 static sqInt NoDbgRegParms voidVMStateForSnapshotFlushingExternalPrimitivesIf(sqInt flushExtPrims);
 extern char * whereIs(sqInt anOop);
 static void NoDbgRegParms NeverInline widowOrForceToBytecodePC(sqInt ctxt);
+static void NoDbgRegParms NeverInline writeCodeZoneLogRecord(usqLong now);
+static void NeverInline writeMachineCodeCache(void);
 static sqInt NoDbgRegParms frameIsMarked(sqInt theFPInt);
 extern sqInt mcprimHashMultiply(sqInt receiverArg);
 static void primitiveClosureCopyWithCopiedValues(void);
@@ -691,6 +766,7 @@ EXPORT(void) primitiveAddLargeIntegers(void);
 static void primitiveAdoptInstance(void);
 EXPORT(void) primitiveAllInstances(void);
 EXPORT(void) primitiveAllObjects(void);
+EXPORT(sqInt) primitiveAllocationSamples(void);
 static void primitiveArctan(void);
 static void primitiveArrayBecome(void);
 static void primitiveArrayBecomeOneWay(void);
@@ -716,6 +792,7 @@ static void primitiveBytesLeft(void);
 static void primitiveCalloutToFFI(void);
 static void primitiveChangeClass(void);
 static void primitiveClass(void);
+EXPORT(sqInt) primitiveClassCensus(void);
 static void primitiveClearVMProfile(void);
 static void primitiveClipboardText(void);
 EXPORT(sqInt) primitiveClockLogAddresses(void);
@@ -809,6 +886,7 @@ EXPORT(void) primitiveLessThanLargeIntegers(void);
 static void primitiveListBuiltinModule(void);
 static void primitiveListExternalModule(void);
 static void primitiveLoadImageSegment(void);
+EXPORT(sqInt) primitiveLoadImageSegmentFromFile(void);
 static void primitiveLocalMicrosecondClock(void);
 static void primitiveLogN(void);
 static void primitiveLowSpaceSemaphore(void);
@@ -889,9 +967,12 @@ static void primitiveSmallFloatTimesTwoPower(void);
 static void primitiveSmallFloatTruncated(void);
 static void primitiveSomeInstance(void);
 static void primitiveSomeObject(void);
+EXPORT(sqInt) primitiveStartAllocationSampling(void);
+EXPORT(sqInt) primitiveStopAllocationSampling(void);
 static void primitiveSpecialObjectsOop(void);
 static void primitiveSquareRoot(void);
 static void primitiveStoreImageSegment(void);
+EXPORT(sqInt) primitiveStoreImageSegmentToFile(void);
 static void primitiveStringAt(void);
 static void primitiveStringAtPut(void);
 static void primitiveStringReplace(void);
@@ -962,42 +1043,77 @@ extern sqInt shortentoIndexableSize(sqInt objOop, sqInt indexableSize);
 static double NoDbgRegParms smallFloatValueOf(sqInt oop);
 extern usqInt smallObjectBytesForSlots(sqInt numSlots);
 static sqInt wordIndexableFormat(void);
+static void NoDbgRegParms addToCardedObjectsHash(sqInt index);
 static void NoDbgRegParms NeverInline addToEphemeronList(sqInt ephemeronCorpse);
 static void NoDbgRegParms NeverInline addToWeakList(sqInt weakCorpse);
 static sqInt allNewSpaceObjectsHaveZeroRTRefCount(void);
+static void allocateSurvivorAgeTables(void);
+static usqInt NoDbgRegParms allocateSurvivorBytesworker(usqInt bytes, SpurScavengeWorker *worker);
+static usqInt NoDbgRegParms allocateTenuredBytesworker(usqInt bytes, SpurScavengeWorker *worker);
 static sqInt allWeakSurvivorsOnWeakList(void);
+static sqInt NoDbgRegParms cardedObjectIndexOf(sqInt objOop);
+static sqInt NoDbgRegParms cardedObjectsHashSlotOf(sqInt objOop);
+static void cardLargeRememberedObjects(void);
 static void NeverInline computeRefCountToShrinkRT(void);
 static sqInt NoDbgRegParms copyAndForwardMourner(sqInt mourner);
 static sqInt NoDbgRegParms copyAndForward(sqInt survivor);
 static sqInt NoDbgRegParms NeverInline copyToOldSpacebytesformat(sqInt survivor, sqInt bytesInObject, sqInt formatOfSurvivor);
+static sqInt NoDbgRegParms ensureCardedObjectsCapacity(sqInt numEntries);
+static sqInt NoDbgRegParms ensureRememberedSetScanCapacity(sqInt numEntries);
+static sqInt NoDbgRegParms ensureScavengeWorkers(sqInt numWorkers);
 static usqInt NoDbgRegParms firstCorpse(sqInt headOfCorpseList);
+static void flushCardedObjects(void);
+static void NoDbgRegParms forgetCardedObject(sqInt objOop);
 static void growRememberedSet(void);
+static sqInt NoDbgRegParms isCardedObject(sqInt objOop);
 static sqInt NoDbgRegParms isInRememberedSet(sqInt objOop);
 static sqInt NoDbgRegParms isMaybeOldScavengeSurvivor(sqInt oop);
 static sqInt NoDbgRegParms isScavengeSurvivor(sqInt oop);
 static sqInt NoDbgRegParms isonWeaklingList(sqInt oop, sqInt listHead);
 static usqInt newSpaceCapacity(void);
 static sqInt noUnfiredEphemeronsAtEndOfRememberedSet(void);
+extern void openGCLog(char *fileName);
 extern void openScavengeLog(void);
+static sqInt NoDbgRegParms parallelCopyAndForwardworker(sqInt survivor, SpurScavengeWorker *worker);
+static void NoDbgRegParms parallelScavengeGrayStack(SpurScavengeWorker *worker);
+static sqInt NoDbgRegParms parallelScavengeReferentworker(sqInt referent, SpurScavengeWorker *worker);
+static sqInt NoDbgRegParms parallelScavengeReferentsOfnumSlotsworker(sqInt referrer, usqInt numSlots, SpurScavengeWorker *worker);
+static sqInt parallelScavengeRoots(void);
+static void parallelScavengeWorkerarg(sqInt workerIndex, void *unused);
 extern void printRememberedSet(void);
 static void processEphemerons(void);
 static void processWeaklings(void);
 static sqInt NoDbgRegParms processWeakSurvivor(sqInt weakObj);
+static void NoDbgRegParms pushScavengeDeferredObjectworker(sqInt survivor, SpurScavengeWorker *worker);
+static void NoDbgRegParms pushScavengeGrayObjectworker(sqInt objOop, SpurScavengeWorker *worker);
+static void rehashCardedObjects(void);
 extern sqInt remember(sqInt objOop);
+static void NoDbgRegParms removeFromCardedObjectsHash(sqInt objOop);
+static void scavengeCardedObjects(void);
 static void NoDbgRegParms scavengeFutureSurvivorSpaceStartingAt(sqInt initialAddress);
 static void scavengeLoop(void);
 static sqInt NoDbgRegParms scavengeReferentsOf(sqInt referrer);
+static sqInt NoDbgRegParms scavengeRememberedReferrerdestIndex(sqInt referrer, sqInt destIndex);
 static void NoDbgRegParms scavengeRememberedSetStartingAt(sqInt n);
 static float scavengerTenuringThreshold(void);
 static sqInt scavengeUnfiredEphemeronsOnEphemeronList(void);
+static sqInt survivorAgeHistogram(void);
+static void NoDbgRegParms NeverInline writeFullGCLogRecordrootMarkcompactionStart(usqLong gcMarkEndUsecs, usqLong rootMarkUsecs, usqLong compactionStartUsecs);
+static void NoDbgRegParms NeverInline writeIncrementalMarkLogRecordusecs(usqLong startUsecs, usqLong usecs);
+static void NoDbgRegParms NeverInline writeIncrementalSweepLogRecordusecs(usqLong startUsecs, usqLong usecs);
+static void NeverInline writeScavengeGCLogRecord(void);
 static void NeverInline writeScavengeLog(void);
+static void abortConcurrentMark(void);
 static sqInt NoDbgRegParms accessibleObjectAfter(sqInt objOop);
 static sqInt NoDbgRegParms NeverInline activeAndDeferredScan(sqInt anEphemeron);
+static void NoDbgRegParms addFreeChunkWithBytesatworker(usqInt bytes, sqInt address, SpurSweepWorker *worker);
 static void NoDbgRegParms addFreeSubTree(sqInt freeTree);
 extern sqInt addGCRoot(sqInt *varLoc);
 extern sqInt addressCouldBeObj(sqInt address);
 extern sqInt addressCouldBeOop(sqInt address);
 static sqInt NoDbgRegParms addToFreeListbytes(sqInt freeChunk, sqInt chunkBytes);
+static sqInt NoDbgRegParms addToPinnedFreeListbytes(sqInt freeChunk, usqInt chunkBytes);
+static sqInt NoDbgRegParms allocateFromPinnedFreeListsbytes(usqInt chunkBytes);
 static sqInt NoDbgRegParms allInstancesOf(sqInt aClass);
 static sqInt allObjects(void);
 static sqInt allObjectsUnmarked(void);
@@ -1005,6 +1121,8 @@ static sqInt allOldMarkedWeakObjectsOnWeaklingStack(void);
 static sqInt allocateLargestFreeChunk(void);
 static sqInt NoDbgRegParms allocateNewSpaceSlotsformatclassIndex(sqInt numSlots, sqInt formatField, sqInt classIndex);
 static sqInt NoDbgRegParms allocateOldSpaceChunkOfBytes(usqInt chunkBytes);
+extern sqInt allocatePinnedBuffer(sqInt byteSize);
+static sqInt NoDbgRegParms allocatePinnedChunkOfBytes(usqInt chunkBytes);
 extern sqInt allocatePinnedSlots(sqInt nSlots);
 static sqInt allocationUnit(void);
 static sqInt NoDbgRegParms allStrongSlotsOfWeaklingAreMarked(sqInt aWeakling);
@@ -1014,6 +1132,7 @@ static sqInt NoDbgRegParms NeverInline assertInnerValidFreeObject(sqInt objOop);
 static sqInt NoDbgRegParms becomeEffectFlagsFor(sqInt objOop);
 extern sqInt becomewith(sqInt array1, sqInt array2);
 static sqInt NoDbgRegParms becomewithtwoWaycopyHash(sqInt array1, sqInt array2, sqInt twoWayFlag, sqInt copyHashFlag);
+static void NeverInline beginIncrementalSweep(void);
 extern void beRootIfOld(sqInt oop);
 static sqInt bitsSetInFreeSpaceMaskForAllFreeLists(void);
 static sqInt bridgeSize(void);
@@ -1062,14 +1181,20 @@ static void clearLeakMapAndMapAccessibleFreeSpace(void);
 static sqInt NoDbgRegParms cloneInOldSpaceforPinning(sqInt objOop, sqInt forPinning);
 extern sqInt clone(sqInt objOop);
 extern sqInt compactClassIndexOf(sqInt objOop);
+static void NoDbgRegParms concurrentlyDefer(sqInt objOop);
+static void NoDbgRegParms concurrentlyMarkfrom(sqInt oop, sqInt referrer);
+static void NoDbgRegParms concurrentlyMarkReferentsOf(sqInt objOop);
+static void concurrentMarkWorker(void *unused);
 static sqInt NoDbgRegParms copyObjtoAddrstopAtsavedFirstFieldsindex(sqInt objOop, sqInt segAddr, sqInt endSeg, sqInt savedFirstFields, sqInt i);
 extern void countMarkedAndUnmarkdObjects(sqInt printFlags);
 static usqLong currentAllocatedBytes(void);
+static void NeverInline decommitFreeSpace(void);
 extern sqInt displayObject(void);
 static void NoDbgRegParms doScavenge(sqInt tenuringCriterion);
 extern sqInt eeInstantiateClassIndexformatnumSlots(sqInt knownClassIndex, sqInt objFormat, sqInt numSlots);
 static void NoDbgRegParms emptyObjStack(sqInt objStack);
 static sqInt NoDbgRegParms ensureRoomOnObjStackAt(sqInt objStackRootIndex);
+static sqInt NoDbgRegParms ensureSweepWorkers(sqInt numWorkers);
 static sqInt NoDbgRegParms enterIntoClassTable(sqInt aBehavior);
 static sqInt ephemeronFormat(void);
 static sqInt NoDbgRegParms existInstancesInNewSpaceOf(sqInt classObj);
@@ -1085,6 +1210,8 @@ extern sqInt fetchPointerofObject(sqInt fieldIndex, sqInt objOop);
 static sqInt findLargestFreeChunk(void);
 extern void findStringBeginningWith(char *aCString);
 extern void findString(char *aCString);
+static sqInt finishConcurrentMark(void);
+static void finishIncrementalSweep(void);
 static sqInt firstAccessibleObject(void);
 static void * NoDbgRegParms firstFixedFieldOfMaybeImmediate(sqInt oop);
 extern void * firstFixedField(sqInt objOop);
@@ -1120,6 +1247,8 @@ static sqInt imageSegmentVersion(void);
 extern sqInt immutableBitMask(void);
 #endif /* IMMUTABILITY */
 extern void incrementalGC(void);
+static void NoDbgRegParms NeverInline incrementalMarkStepFor(usqLong budgetUsecs);
+static void NoDbgRegParms NeverInline incrementalSweepStepForbytes(usqLong budgetUsecs, usqInt wantedBytes);
 extern sqInt indexOfin(sqInt anElement, sqInt anObject);
 static void NoDbgRegParms inFreeTreeReplacewith(sqInt treeNode, sqInt newNode);
 static sqInt NoDbgRegParms initialInstanceOf(sqInt classObj);
@@ -1131,6 +1260,7 @@ extern sqInt instanceSizeOf(sqInt classObj);
 static sqInt NoDbgRegParms instantiateClass(sqInt classObj);
 extern sqInt instSpecOfClassFormat(sqInt classFormat);
 static sqInt NoDbgRegParms instSpecOfClass(sqInt classPointer);
+static void invalidateConcurrentMark(void);
 static sqInt NoDbgRegParms isAnyPointerFormat(sqInt format);
 extern sqInt isArrayNonImm(sqInt oop);
 extern sqInt isArray(sqInt oop);
@@ -1223,6 +1353,7 @@ static void NoDbgRegParms NeverInline markObjects(sqInt objectsShouldBeUnmarkedA
 static void markWeaklingsAndMarkAndFireEphemerons(void);
 extern sqInt maybeMethodClassOfseemsToBeInstantiating(sqInt methodObj, sqInt format);
 extern sqInt maybeSplObj(sqInt index);
+static usqInt NoDbgRegParms mergeSweepWorkers(sqInt numWorkers);
 extern sqInt minSlotsForShortening(void);
 static sqInt NoDbgRegParms newHashBitsOf(sqInt objOop);
 static sqInt newObjectHash(void);
@@ -1234,7 +1365,9 @@ static sqInt NoDbgRegParms noCheckPushonObjStack(sqInt objOop, sqInt objStack);
 static sqInt NoDbgRegParms noFixupFollowFieldofObject(sqInt fieldIndex, sqInt anObject);
 static sqInt NoDbgRegParms noInlineFollowForwarded(sqInt objOop);
 static sqInt NoDbgRegParms noInlineObjectAfterlimit(sqInt objOop, sqInt limit);
+static void NoDbgRegParms noteAllocationSamplebytesmethodpc(sqInt classIndex, sqInt bytes, sqInt method, sqInt pc);
 extern sqInt nonIndexablePointerFormat(void);
+static void NoDbgRegParms noteLiveBytesof(sqInt numBytes, sqInt objOop);
 static sqInt noUnscannedEphemerons(void);
 static sqInt NoDbgRegParms numBytesOfBytes(sqInt objOop);
 extern sqInt numBytesOf(sqInt objOop);
@@ -1251,7 +1384,10 @@ extern sqInt obsoleteDontUseThisFetchWordofObject(sqInt fieldIndex, sqInt oop);
 static sqInt NoDbgRegParms okayOop(sqInt signedOop);
 extern sqInt oldSpaceObjectAfter(sqInt objOop);
 static void NoDbgRegParms NeverInline outOfPlaceBecomeandcopyHashFlag(sqInt obj1, sqInt obj2, sqInt copyHashFlag);
+static sqInt NoDbgRegParms parallelSweepSegmentsFrombudget(sqInt startObj, usqLong budgetUsecs);
 extern sqInt pinObject(sqInt objOop);
+static sqInt NoDbgRegParms pinnedBufferPoolIndexOf(sqInt buffer);
+static void poolReleasedPinnedBuffers(void);
 static sqInt NoDbgRegParms popObjStack(sqInt objStack);
 extern sqInt popRemappableOop(void);
 static void NoDbgRegParms postBecomeScanClassTable(sqInt effectsFlags);
@@ -1294,14 +1430,21 @@ static sqInt NoDbgRegParms pushOnUnscannedEphemeronsStack(sqInt anEphemeron);
 extern void pushRemappableOop(sqInt oop);
 static void NoDbgRegParms queueMourner(sqInt anEphemeronOrWeakArray);
 extern sqInt rawHashBitsOf(sqInt objOop);
+static void NoDbgRegParms recordConcurrentRescanOfat(sqInt objOop, usqInt pageStart);
+static void NoDbgRegParms recordConcurrentRescansIn(SpurSegmentInfo *segInfo);
+static void releaseConcurrentMark(void);
+extern sqInt releasePinnedBuffer(sqInt buffer);
 static sqInt NoDbgRegParms relocateObjStackForPlanningCompactor(sqInt objStack);
 extern sqInt removeGCRoot(sqInt *varLoc);
+static void NoDbgRegParms rescanConcurrentlyMarked(sqInt objOop);
+static void rescanConcurrentlyMarkedObjects(void);
 static sqInt NoDbgRegParms returnrestoringObjectsInsavedFirstFieldsandsavedHashes(sqInt errCode, sqInt firstArray, sqInt savedFirstFields, sqInt secondArray, sqInt savedHashes);
 static sqInt NoDbgRegParms returnrestoringObjectsInupTosavedFirstFields(sqInt errCode, sqInt firstArray, sqInt limitOrTag, sqInt savedFirstFields);
 static void NoDbgRegParms NeverInline reverseBytesIn32BitWordsIn(sqInt segmentWordArray);
 static void NoDbgRegParms runLeakCheckerForFreeSpace(sqInt gcModes);
 static void NoDbgRegParms runLeakCheckerFor(sqInt gcModes);
 static void NoDbgRegParms runLeakCheckerForexcludeUnmarkedObjsclassIndicesShouldBeValid(sqInt gcModes, sqInt excludeUnmarkedObjs, sqInt classIndicesShouldBeValid);
+static void NoDbgRegParms sampleAllocationbytes(sqInt objOop, sqInt bytes);
 static void NoDbgRegParms scavengingGCTenuringIf(sqInt tenuringCriterion);
 static sqInt NoDbgRegParms NeverInline setHeapBasememoryLimitendOfMemory(sqInt baseOfHeap, sqInt memLimit, sqInt memEnd);
 extern void shortPrintObjectsFromto(sqInt startAddress, sqInt endAddress);
@@ -1310,6 +1453,7 @@ static sqInt NoDbgRegParms sizeOfObjStack(sqInt objStack);
 static sqInt slidingCompactionInProgress(void);
 extern sqInt slotSizeOf(sqInt oop);
 extern sqInt splObj(sqInt index);
+static void startConcurrentMark(void);
 static usqInt NoDbgRegParms startOfObject(sqInt objOop);
 EXPORT(sqInt) statNumGCs(void);
 extern usqInt storeCheckBoundary(void);
@@ -1318,13 +1462,19 @@ extern sqInt storePointerUncheckedofObjectwithValue(sqInt fieldIndex, sqInt objO
 extern sqInt storePointerofObjectwithValue(sqInt fieldIndex, sqInt objOop, sqInt valuePointer);
 extern sqInt stringForCString(const char *aCString);
 static sqInt NoDbgRegParms sufficientSpaceAfterGC(sqInt numBytes);
+static void NoDbgRegParms sweepIncrementallyForbytes(usqLong budgetUsecs, usqInt wantedBytes);
+static void sweepSegmentsWorkerarg(sqInt workerIndex, void *unused);
 static sqInt NoDbgRegParms swizzleObjStackAt(sqInt objStackRootIndex);
+static sqInt NeverInline swizzleObjectsInParallel(void);
+static void swizzleObjectsWorkerarg(sqInt workerIndex, void *unused);
+static sqInt NeverInline takeClassCensus(void);
 extern void tenuringIncrementalGC(void);
 static sqInt NoDbgRegParms topOfObjStack(sqInt objStack);
 extern sqInt topRemappableOop(void);
 static sqInt totalFreeListBytes(void);
 extern sqInt trueObject(void);
 static sqInt NoDbgRegParms unlinkFreeChunkchunkBytes(sqInt freeChunk, sqInt chunkBytes);
+static sqInt NoDbgRegParms unlinkPinnedFreeChunkchunkBytes(sqInt freeChunk, usqInt chunkBytes);
 static sqInt NoDbgRegParms NeverInline unlinkSmallChunkindex(sqInt freeChunk, sqInt index);
 static void NoDbgRegParms unlinkSolitaryFreeTreeNode(sqInt freeTreeNode);
 extern sqInt unpinObject(sqInt objOop);
@@ -1336,27 +1486,40 @@ static sqInt NoDbgRegParms validFreeTreeChunk(sqInt chunk);
 static const char * NoDbgRegParms validFreeTreeChunkparent(sqInt chunk, sqInt parent);
 static sqInt validObjStacks(void);
 extern sqInt vmEndianness(void);
+static sqInt NoDbgRegParms canEvacuateSegment(SpurSegmentInfo *seg);
 static void NeverInline compact(void);
 static sqInt NeverInline copyAndUnmarkMobileObjects(void);
 static void NoDbgRegParms NeverInline copyAndUnmark(sqInt firstPass);
+static sqInt NoDbgRegParms evacuateSegment(SpurSegmentInfo *seg);
+static sqInt NeverInline evacuateSparseSegments(void);
+static void followForwardersInRoots(void);
 static void NoDbgRegParms freeFromupTonextObject(usqInt initialToFinger, usqInt limit, sqInt nextObject);
 static sqInt initializeScanCheckingForFullyCompactedHeap(void);
 static sqInt NoDbgRegParms isMobile(sqInt obj);
 static sqInt NoDbgRegParms isPostMobile(sqInt obj);
+static void pinLargeObjects(void);
 static sqInt NeverInline planCompactSavingForwarders(void);
 static void NoDbgRegParms reinitializeScanFrom(sqInt initialObject);
 extern sqInt remapObj(sqInt objOop);
 static sqInt savedFirstFieldsSpaceWasAllocated(void);
 static sqInt NoDbgRegParms scanForFirstFreeAndFirstMobileObjectFrom(sqInt initialObject);
 extern sqInt shouldRemapObj(sqInt objOop);
+static sqInt NeverInline shouldSweepInsteadOfCompacting(void);
+static void NeverInline sweepWithoutCompacting(void);
+static void NoDbgRegParms unevacuateSegment(SpurSegmentInfo *seg);
+static void NeverInline unmarkInitialImmobileObjects(void);
+static void unmarkInitialImmobileObjectsWorkerarg(sqInt workerIndex, void *unused);
+static void unpinLargeObjects(void);
 static void NeverInline updatePointers(void);
 static void NoDbgRegParms updatePointersInsavedFirstFieldPointer(sqInt obj, sqInt firstFieldPtr);
 static sqInt NoDbgRegParms useSegmentForSavedFirstFieldsSpace(sqInt spaceEstimate);
 static sqInt NoDbgRegParms validRelocationPlanInPass(sqInt onePass);
 static usqInt NoDbgRegParms segLimit(SpurSegmentInfo * self_in_segLimit);
+static SpurSegmentInfo * NoDbgRegParms addPinnedSegmentFor(usqInt chunkBytes);
 static SpurSegmentInfo * NoDbgRegParms addSegmentOfSize(sqInt ammount);
 static void NoDbgRegParms adjustSegmentSwizzlesBy(sqInt firstSegmentShift);
 static sqInt allBridgesMarked(void);
+static sqInt NoDbgRegParms allocateLargeObjectChunkOfBytes(usqInt chunkBytes);
 static void allocateOrExtendSegmentInfos(void);
 static sqInt NoDbgRegParms bridgeAt(sqInt segIndex);
 static sqInt NoDbgRegParms bridgeFor(SpurSegmentInfo *aSegment);
@@ -1364,7 +1527,12 @@ static void NoDbgRegParms bridgeFromto(SpurSegmentInfo *aSegment, SpurSegmentInf
 static void checkSegments(void);
 static void collapseSegmentsPostSwizzle(void);
 static void * NoDbgRegParms firstGapOfSizeAtLeast(sqInt size);
+static void forgetPinnedSegments(void);
+static void NeverInline freeDeadLargeObjectSegments(void);
+static void freeEmptyPinnedSegments(void);
+static void freeEvacuatedSegments(void);
 static sqInt NoDbgRegParms isEmptySegment(SpurSegmentInfo *seg);
+static sqInt NoDbgRegParms isInPinnedSegment(usqInt address);
 static sqInt NoDbgRegParms isInSegments(usqInt address);
 static sqInt NoDbgRegParms isValidSegmentBridge(sqInt objOop);
 static SpurSegmentInfo * NoDbgRegParms nextNonEmptySegmentAfter(sqInt i);
@@ -1377,6 +1545,8 @@ static sqInt NoDbgRegParms shrinkObjectMemory(usqInt delta);
 static sqInt someSegmentContainsPinned(void);
 static sqInt NoDbgRegParms swizzleObj(sqInt objOop);
 static usqInt totalBytesInSegments(void);
+static usqInt totalHugePageBytesInSegments(void);
+static usqInt totalResidentBytesInSegments(void);
 static sqInt NoDbgRegParms writeImageSegmentsToFile(sqImageFile aBinaryStream);
 static sqInt NoDbgRegParms writeSegmentnextSegmenttoFile(SpurSegmentInfo *segment, SpurSegmentInfo *nextSegment, sqImageFile aBinaryStream);
 extern sqInt activeProcess(void);
@@ -1449,6 +1619,7 @@ static char * NoDbgRegParms findSPOfon(char *theFP, StackPage *thePage);
 static sqInt NoDbgRegParms findUnwindThroughContext(sqInt homeContext);
 static void NoDbgRegParms flushMethodCacheForMethod(sqInt oldMethod);
 static void NoDbgRegParms followForwardedFrameContentsstackPointer(char *theFP, char *theSP);
+static void followForwardingPointersInAllocationSamples(void);
 extern sqInt forceInterruptCheck(void);
 static sqInt NoDbgRegParms frameContext(char *theFP);
 static char * NoDbgRegParms frameOfMarriedContext(sqInt aContext);
@@ -1508,13 +1679,16 @@ extern void loadInitialContext(void);
 extern void longPrintOop(sqInt oop);
 extern sqInt longStoreBytecodeForHeader(sqInt methodHeader);
 static sqInt NoDbgRegParms lookupInMethodCacheSelclassTag(sqInt selector, sqInt classTag);
+static sqInt NoDbgRegParms lookupInMethodCacheSetselclassTag(sqInt setIndex, sqInt selector, sqInt classTag);
 static sqInt NoDbgRegParms lookupMethodInClass(sqInt class);
 static sqInt NoDbgRegParms lookupMNUInClass(sqInt class);
 static sqInt NoDbgRegParms lookupOrdinaryNoMNUEtcInClass(sqInt class);
 extern sqInt lookupSelectorinClass(sqInt selector, sqInt class);
 static void NoDbgRegParms makeContextSnapshotSafe(sqInt ctxt);
 extern sqInt makePointwithxValueyValue(sqInt xValue, sqInt yValue);
+static void mapAllocationSamples(void);
 static void mapInterpreterOops(void);
+static void markAndTraceAllocationSamples(void);
 static sqInt NoDbgRegParms markAndTraceStackPages(sqInt fullGCFlag);
 static void markAndTraceUntracedReachableStackPages(void);
 static sqInt NoDbgRegParms marriedContextpointsTostackDeltaForCurrentFrame(sqInt spouseContext, sqInt anOop, sqInt stackDeltaForCurrentFrame);
@@ -1669,6 +1843,7 @@ static sqInt validStackPageBaseFrames(void);
 static void NoDbgRegParms voidLongRunningPrimitive(char *reason);
 static sqInt wakeHighestPriority(void);
 static sqInt NeverInline writeImageFileIO(void);
+static sqInt NeverInline writeImageFileInBackground(void);
 static sqInt NoDbgRegParms cloneContext(sqInt aContext);
 static sqInt NoDbgRegParms fieldOrSenderFPofContext(sqInt index, sqInt contextObj);
 static sqInt NoDbgRegParms fieldofFrame(sqInt index, char *theFP);
@@ -1749,6 +1924,90 @@ _iss sqInt rememberedSetSize;
 _iss sqInt classTableFirstPage;
 _iss unsigned char primTraceLogIndex;
 _iss sqInt * rememberedSet;
+_iss sqInt * rememberedSetScanList;
+_iss unsigned char * rememberedSetScanResults;
+_iss sqInt rememberedSetScanCapacity;
+_iss sqInt rememberedSetScanCount;
+_iss sqInt rememberedSetScanNext;
+_iss SpurScavengeWorker * scavengeWorkers;
+_iss sqInt scavengeWorkersCapacity;
+_iss sqInt scavengeWorkersStarted;
+_iss sqInt scavengeWorkersIdle;
+_iss sqInt * scavengeGrayPool;
+_iss sqInt scavengeGrayPoolCapacity;
+_iss sqInt scavengeGrayPoolCount;
+_iss sqInt scavengeStackPageNext;
+_iss sqInt stackPagesScavenged;
+_iss sqInt * cardedObjects;
+_iss unsigned char ** cardedObjectCards;
+_iss sqInt * cardedObjectNumCards;
+_iss sqInt cardedObjectsCapacity;
+_iss sqInt numCardedObjects;
+_iss sqInt * cardedObjectSkips;
+_iss sqInt * cardedObjectBackoffs;
+_iss sqInt * cardedObjectsHash;
+_iss sqInt cardedObjectsHashSize;
+_iss unsigned char * pastSpaceAges;
+_iss unsigned char * futureSpaceAges;
+_iss sqInt unmarkSegmentIndex;
+_iss SpurSweepWorker * sweepWorkers;
+_iss sqInt sweepWorkersCapacity;
+_iss sqInt sweepSegmentIndex;
+_iss sqInt sweepFirstSegmentIndex;
+_iss sqInt sweepStartObj;
+_iss usqLong sweepDeadlineUsecs;
+_iss sqInt statNonCompactingGCs;
+_iss sqInt liveBytesSegmentIndex;
+_iss sqInt numEvacuatedSegments;
+_iss sqInt numLargeObjectSegments;
+_iss sqInt numPinnedSegments;
+_iss usqInt totalFreePinnedSpace;
+_iss usqInt statPinnedBufferReuses;
+_iss sqInt numPinnedBuffersInUse;
+_iss sqInt numReleasedPinnedBuffers;
+_iss usqLong statTenuredBytes;
+_iss usqLong statDecommittedBytes;
+_iss sqInt memoryNearLimit;
+_iss usqLong lastMemoryLimitGCUsecs;
+_iss sqInt statMemoryLimitGCs;
+_iss sqInt allocationSampleInterval;
+_iss sqInt bytesUntilAllocationSample;
+_iss sqInt allocationSampleIndex;
+_iss sqInt numAllocationSamples;
+_iss usqInt * censusCounts;
+_iss usqInt * censusBytes;
+_iss sqInt censusCapacity;
+_iss sqInt censusNumClasses;
+_iss sqInt censusGCCount;
+_iss sqInt backgroundSnapshotSemaphoreIndex;
+_iss sqInt numSwizzleChunks;
+_iss sqInt swizzleChunkIndex;
+_iss sqInt compressImageHeapData;
+_iss usqInt sweepCursor;
+_iss usqLong statMaxIncrGCUsecs;
+_iss usqLong incrGCStepEndUsecs;
+_iss usqInt * concurrentMarkBitmap;
+_iss usqInt concurrentMarkBitmapStart;
+_iss usqInt concurrentMarkBitmapLimit;
+_iss sqInt * concurrentMarkStack;
+_iss sqInt concurrentMarkStackCapacity;
+_iss sqInt concurrentMarkStackTop;
+_iss sqInt * concurrentMarkDeferred;
+_iss sqInt concurrentMarkDeferredCapacity;
+_iss sqInt concurrentMarkDeferredCount;
+_iss sqInt * concurrentMarkRescans;
+_iss sqInt concurrentMarkRescansCapacity;
+_iss sqInt concurrentMarkRescansCount;
+_iss sqInt concurrentMarkInProgress;
+_iss volatile sqInt concurrentMarkFinished;
+_iss volatile sqInt concurrentMarkInvalidated;
+_iss sqInt concurrentMarkFailed;
+_iss sqInt concurrentMarkSteps;
+_iss usqLong concurrentMarkStartUsecs;
+_iss usqLong concurrentMarkEndUsecs;
+_iss sqInt statConcurrentMarks;
+_iss usqLong statConcurrentMarkUsecs;
+_iss usqLong statConcurrentRemarkUsecs;
 _iss SpurContiguousObjStack savedFirstFieldsSpace;
 _iss sqInt weaklingStack;
 _iss usqInt freeListsMask;
@@ -1798,6 +2057,8 @@ _iss sqInt cogCompiledCodeCompactionCalledFor;
 _iss sqInt gcPhaseInProgress;
 _iss sqInt pendingFinalizationSignals;
 _iss sqInt cogCodeSize;
+_iss sqInt cogCodeSizeLimit;
+_iss sqInt grownCogCodeSize;
 _iss sqInt metaAccessorDepth;
 _iss sqInt metaclassNumSlots;
 _iss sqInt numSegInfos;
@@ -1826,6 +2087,11 @@ _iss sqInt firstFieldOfRememberedSet;
 _iss sqInt firstSegmentSize;
 _iss usqInt lowSpaceThreshold;
 _iss FILE * scavengeLog;
+_iss FILE * gcLog;
+_iss char * machineCodeCacheFile;
+_iss char * gcCause;
+_iss usqInt gcLogBytesBefore;
+_iss usqLong gcLogTenuredBytesBefore;
 _iss sqInt shrinkThreshold;
 _iss usqLong statIOProcessEvents;
 _iss sqInt statScavenges;
@@ -1834,6 +2100,12 @@ _iss sqInt edenBytes;
 _iss sqInt imageHeaderFlags;
 _iss sqInt lastHash;
 _iss sqInt lastMethodCacheProbeWrite;
+_iss sqIntptr_t * methodCache;
+_iss sqInt methodCacheSetMask;
+_iss sqInt methodCacheSize;
+_iss usqLong statMethodCacheEvictions;
+_iss usqLong statMethodCacheHits;
+_iss usqLong statMethodCacheMisses;
 _iss sqInt longRunningPrimitiveCheckSequenceNumber;
 _iss usqInt memory;
 _iss sqInt rememberedSetRedZone;
@@ -1860,6 +2132,7 @@ _iss usqLong statMarkUsecs;
 _iss sqInt statMaxPageCountWhenMapping;
 _iss sqInt statPageCountWhenMappingSum;
 _iss usqLong statProcessSwitch;
+_iss usqLong statRootMarkUsecs;
 _iss usqLong statScavengeGCUsecs;
 _iss sqInt statShrinkMemory;
 _iss usqLong statStackOverflow;
@@ -1876,7 +2149,13 @@ _iss sqInt longRunningPrimitiveSignalUndelivered;
 _iss sqInt maxExtSemTabSizeSet;
 _iss sqInt refCountToShrinkRT;
 _iss sqInt signalLowSpace;
+_iss sqInt codeLogCompactionCount;
+_iss usqLong codeLogCompactionUsecs;
+_iss sqInt codeLogCompilations;
+_iss sqInt codeLogEvictions;
+_iss usqLong codeLogUsecs;
 _iss sqInt statCodeCompactionCount;
+_iss sqInt statMachineCodeCacheCompilations;
 _iss usqLong statCodeCompactionUsecs;
 _iss sqInt statMarkCount;
 _iss sqInt statRootTableCount;
@@ -1896,11 +2175,19 @@ _iss sqInt statRootTableOverflows;
 _iss sqInt tenuringClassIndex;
 _iss sqInt the2ndUnknownShort;
 _iss sqInt statIncrGCs;
-_iss sqIntptr_t methodCache[MethodCacheSize + 1 /* 4097 */];
 _iss sqInt traceLog[TraceBufferSize /* 768 */];
 _iss sqInt primTraceLog[256];
 _iss sqInt remapBuffer[RemapBufferSize + 1 /* 26 */];
 _iss sqInt *extraRoots[ExtraRootsSize + 1 /* 2049 */];
+_iss usqInt allocationSamples[(AllocationSampleBufferSize * 4) /* 16384 */];
+_iss usqInt swizzleChunkStarts[MaxSwizzleChunks + 1 /* 257 */];
+_iss usqInt survivorBytesByAge[MaxSurvivorAge + 1 /* 16 */];
+_iss usqLong statSurvivorBytesByAge[MaxSurvivorAge + 1 /* 16 */];
+_iss sqInt pinnedFreeLists[NumPinnedFreeLists /* 32 */];
+_iss sqInt pinnedBufferPool[NumPinnedBufferClasses /* 15 */];
+_iss sqInt pinnedBufferPoolCounts[NumPinnedBufferClasses /* 15 */];
+_iss sqInt pinnedBuffersInUse[MaxPinnedBuffersInUse /* 256 */];
+_iss sqInt releasedPinnedBuffers[MaxReleasedPinnedBuffers /* 256 */];
 _iss usqInt suspendedCallbacks[MaxJumpBuf + 1 /* 33 */];
 _iss usqInt suspendedMethods[MaxJumpBuf + 1 /* 33 */];
 _iss jmp_buf jmpBuf[MaxJumpBuf + 1 /* 33 */];
@@ -1950,8 +2237,17 @@ sqInt extraVMMemory;
 int displayWidth;
 int displayDepth;
 sqInt desiredCogCodeSize;
+sqInt desiredMaxCogCodeSize;
 int displayHeight;
 usqInt maxOldSpaceSize;
+sqInt useCardMarking;
+sqInt concurrentMarkEnabled;
+sqInt tenuringAge;
+sqInt compactionMoveRatio = CompactionMoveRatio /* 4 */;
+sqInt maxGCPauseUsecs;
+usqInt largeObjectThreshold;
+usqInt pinnedSegmentSize;
+usqInt methodCacheEntries;
 char * breakSelector;
 usqInt heapBase;
 sqInt inIOProcessEvents;
@@ -2648,6 +2944,7 @@ volatile int sendTrace;
 #define identityHashHalfWordMask() 0x3FFFFF
 #define immutableBitShift() 23
 #define indexablePointersFormat() 3
+#define isBeingCopiedObjectClassIndexPun() 9
 #define isForwardedObjectClassIndexPun() 8
 #define isFreeObjectClassIndexPun() 0
 #define lastClassIndexPun() 31
@@ -2741,6 +3038,9 @@ interpret(void)
 		initializeStacknumSlotspageSize(theStackMemory, stackPagesBytes / BytesPerWord, stackPageBytes / BytesPerWord);
 		assert((minimumUnusedHeadroom()) == stackPageBytes);
 		loadInitialContext();
+		if (!(GIV(machineCodeCacheFile) == null)) {
+			loadMachineCodeCache();
+		}
 		ioInitHeartbeat();
 		initialEnterSmalltalkExecutive();
 		return null;
@@ -5965,36 +6265,19 @@ interpret(void)
 						}
 					}
 					/* begin internalFindNewMethodOrdinary */
-					hash = GIV(messageSelector) ^ (((sqInt)((usqInt)(lkupClassTag) << 2)));
-
-					/* first probe */
-					probe = hash & MethodCacheMask;
-					if (((GIV(methodCache)[probe + MethodCacheSelector]) == GIV(messageSelector))
-					 && ((GIV(methodCache)[probe + MethodCacheClass]) == lkupClassTag)) {
-						GIV(newMethod) = GIV(methodCache)[probe + MethodCacheMethod];
-						primitiveFunctionPointer = ((void (*)()) (GIV(methodCache)[probe + MethodCachePrimFunction]));
-						ok = 1;
-						goto l776;
-					}
+					hash = GIV(messageSelector) ^ (((sqInt)((usqInt)(lkupClassTag) << MethodCacheClassTagShift)));
 
-					/* second probe */
-					probe = (((usqInt) hash) >> 1) & MethodCacheMask;
-					if (((GIV(methodCache)[probe + MethodCacheSelector]) == GIV(messageSelector))
-					 && ((GIV(methodCache)[probe + MethodCacheClass]) == lkupClassTag)) {
-						GIV(newMethod) = GIV(methodCache)[probe + MethodCacheMethod];
-						primitiveFunctionPointer = ((void (*)()) (GIV(methodCache)[probe + MethodCachePrimFunction]));
-						ok = 1;
-						goto l776;
-					}
-					probe = (((usqInt) hash) >> 2) & MethodCacheMask;
+					/* probe the most recently used entry of the set inline */
+					probe = hash & GIV(methodCacheSetMask);
 					if (((GIV(methodCache)[probe + MethodCacheSelector]) == GIV(messageSelector))
 					 && ((GIV(methodCache)[probe + MethodCacheClass]) == lkupClassTag)) {
 						GIV(newMethod) = GIV(methodCache)[probe + MethodCacheMethod];
 						primitiveFunctionPointer = ((void (*)()) (GIV(methodCache)[probe + MethodCachePrimFunction]));
+						GIV(statMethodCacheHits) += 1;
 						ok = 1;
 						goto l776;
 					}
-					ok = 0;
+					ok = lookupInMethodCacheSetselclassTag(probe, GIV(messageSelector), lkupClassTag);
 	l776:	/* end inlineLookupInMethodCacheSel:classTag: */;
 					if (ok) {
 						/* begin ifAppropriateCompileToNativeCode:selector: */
@@ -6883,6 +7166,9 @@ interpret(void)
 				}
 				long64Atput(newObj, (((((usqLong) size)) << (numSlotsFullShift())) + (2U << (formatShift()))) + ClassArrayCompactIndex);
 				GIV(freeStart) += numBytes;
+				if (GIV(allocationSampleInterval) > 0) {
+					sampleAllocationbytes(newObj, numBytes);
+				}
 				array = newObj;
 	l110:	/* end eeInstantiateSmallClassIndex:format:numSlots: */;
 				if (popValues) {
@@ -7115,6 +7401,14 @@ interpret(void)
 				}
 				long64Atput(newObj, (((((usqLong) numSlots)) << (numSlotsFullShift())) + (((sqInt)((usqInt)(objFormat) << (formatShift()))))) + ClassBlockClosureCompactIndex);
 				GIV(freeStart) += numBytes;
+				if (GIV(allocationSampleInterval) > 0) {
+					/* begin externalizeIPandSP */
+					assert((((usqInt)localIP)) != (ceReturnToInterpreterPC()));
+					GIV(instructionPointer) = oopForPointer(localIP);
+					GIV(stackPointer) = localSP;
+					GIV(framePointer) = localFP;
+					sampleAllocationbytes(newObj, numBytes);
+				}
 				newClosure1 = newObj;
 	l137:	/* end eeInstantiateSmallClassIndex:format:numSlots: */;
 				/* begin storePointerUnchecked:ofObject:withValue: */
@@ -9099,6 +9393,14 @@ interpret(void)
 					}
 					long64Atput(newObj, (((((usqLong) numSlots)) << (numSlotsFullShift())) + (((sqInt)((usqInt)(objFormat) << (formatShift()))))) + knownClassIndex);
 					GIV(freeStart) += numBytes;
+					if (GIV(allocationSampleInterval) > 0) {
+						/* begin externalizeIPandSP */
+						assert((((usqInt)localIP)) != (ceReturnToInterpreterPC()));
+						GIV(instructionPointer) = oopForPointer(localIP);
+						GIV(stackPointer) = localSP;
+						GIV(framePointer) = localFP;
+						sampleAllocationbytes(newObj, numBytes);
+					}
 					pt = newObj;
 	l273:	/* end eeInstantiateSmallClass:numSlots: */;
 					/* begin storePointerUnchecked:ofObject:withValue: */
@@ -11694,6 +11996,14 @@ interpret(void)
 					}
 					long64Atput(newObj, (((((usqLong) numSlots)) << (numSlotsFullShift())) + (((sqInt)((usqInt)(objFormat) << (formatShift()))))) + knownClassIndex);
 					GIV(freeStart) += numBytes;
+					if (GIV(allocationSampleInterval) > 0) {
+						/* begin externalizeIPandSP */
+						assert((((usqInt)localIP)) != (ceReturnToInterpreterPC()));
+						GIV(instructionPointer) = oopForPointer(localIP);
+						GIV(stackPointer) = localSP;
+						GIV(framePointer) = localFP;
+						sampleAllocationbytes(newObj, numBytes);
+					}
 					pt = newObj;
 	l504:	/* end eeInstantiateSmallClass:numSlots: */;
 					/* begin storePointerUnchecked:ofObject:withValue: */
@@ -12713,6 +13023,9 @@ interpret(void)
 				}
 				long64Atput(newObj, (((((usqLong) size)) << (numSlotsFullShift())) + (2U << (formatShift()))) + ClassArrayCompactIndex);
 				GIV(freeStart) += numBytes;
+				if (GIV(allocationSampleInterval) > 0) {
+					sampleAllocationbytes(newObj, numBytes);
+				}
 				array = newObj;
 	l629:	/* end eeInstantiateSmallClassIndex:format:numSlots: */;
 				if (popValues) {
@@ -13668,6 +13981,14 @@ interpret(void)
 				}
 				long64Atput(newObj, (((((usqLong) numSlots)) << (numSlotsFullShift())) + (((sqInt)((usqInt)(objFormat) << (formatShift()))))) + ClassFullBlockClosureCompactIndex);
 				GIV(freeStart) += numBytes;
+				if (GIV(allocationSampleInterval) > 0) {
+					/* begin externalizeIPandSP */
+					assert((((usqInt)localIP)) != (ceReturnToInterpreterPC()));
+					GIV(instructionPointer) = oopForPointer(localIP);
+					GIV(stackPointer) = localSP;
+					GIV(framePointer) = localFP;
+					sampleAllocationbytes(newObj, numBytes);
+				}
 				newClosure1 = newObj;
 	l708:	/* end eeInstantiateSmallClassIndex:format:numSlots: */;
 				/* begin storePointerUnchecked:ofObject:withValue: */
@@ -13786,6 +14107,14 @@ interpret(void)
 				}
 				long64Atput(newObj, (((((usqLong) numSlots)) << (numSlotsFullShift())) + (((sqInt)((usqInt)(objFormat) << (formatShift()))))) + ClassBlockClosureCompactIndex);
 				GIV(freeStart) += numBytes;
+				if (GIV(allocationSampleInterval) > 0) {
+					/* begin externalizeIPandSP */
+					assert((((usqInt)localIP)) != (ceReturnToInterpreterPC()));
+					GIV(instructionPointer) = oopForPointer(localIP);
+					GIV(stackPointer) = localSP;
+					GIV(framePointer) = localFP;
+					sampleAllocationbytes(newObj, numBytes);
+				}
 				newClosure1 = newObj;
 	l714:	/* end eeInstantiateSmallClassIndex:format:numSlots: */;
 				/* begin storePointerUnchecked:ofObject:withValue: */
@@ -14305,18 +14634,15 @@ addNewMethodToCache(sqInt classObj)
 {   DECL_MAYBE_SQ_GLOBAL_STRUCT
     sqInt classTag;
     sqInt err;
-    sqInt err1;
-    sqInt err2;
     sqInt firstBytecode;
     sqInt hash;
     sqInt hash1;
-    sqInt hash2;
-    sqInt hash3;
     sqInt header;
     sqInt methodHeader;
-    sqInt p;
     sqInt primitiveIndex;
     sqInt probe;
+    sqInt setIndex;
+    sqInt way;
 
 	if (!(((GIV(newMethod) & (tagMask())) == 0)
 		 && (((((usqInt) (longAt(GIV(newMethod)))) >> (formatShift())) & (formatMask())) >= (firstCompiledMethodFormat())))) {
@@ -14332,7 +14658,7 @@ addNewMethodToCache(sqInt classObj)
 						? -err
 						: (long32At(classObj + 4)) & (identityHashHalfWordMask()))
 				: -PrimErrBadReceiver));
-	hash = GIV(messageSelector) ^ (((sqInt)((usqInt)(classTag) << 2)));
+	hash = GIV(messageSelector) ^ (((sqInt)((usqInt)(classTag) << MethodCacheClassTagShift)));
 	if (((GIV(newMethod) & (tagMask())) == 0)
 	 && (((((usqInt) (longAt(GIV(newMethod)))) >> (formatShift())) & (formatMask())) >= (firstCompiledMethodFormat()))) {
 		/* begin primitiveIndexOfMethod:header: */
@@ -14363,50 +14689,34 @@ addNewMethodToCache(sqInt classObj)
 		 && (isForwarded(GIV(newMethod)))));
 		primitiveFunctionPointer = primitiveInvokeObjectAsMethod;
 	}
-	for (p = 0; p < CacheProbeMax; p += 1) {
-		probe = (((usqInt) hash) >> p) & MethodCacheMask;
-		if ((GIV(methodCache)[probe + MethodCacheSelector]) == 0) {
+	setIndex = hash & GIV(methodCacheSetMask);
 
-			/* Found an empty entry -- use it */
-			GIV(methodCache)[probe + MethodCacheSelector] = GIV(messageSelector);
-			GIV(methodCache)[probe + MethodCacheClass] = ((assert(addressCouldBeClassObj(classObj)),
-(((hash2 = (long32At(classObj + 4)) & (identityHashHalfWordMask()))) != 0
-		? hash2
-		: (objCouldBeClassObj(classObj)
-				? (((err1 = enterIntoClassTable(classObj))) != 0
-						? -err1
-						: (long32At(classObj + 4)) & (identityHashHalfWordMask()))
-				: -PrimErrBadReceiver))));
-			GIV(methodCache)[probe + MethodCacheMethod] = GIV(newMethod);
-			GIV(methodCache)[probe + MethodCachePrimFunction] = (((sqIntptr_t) primitiveFunctionPointer));
-
-			/* this for primitiveExternalMethod */
-			GIV(lastMethodCacheProbeWrite) = probe;
-			return;
-		}
+	/* Enter the method at the front of its set, shifting the entries in front
+	   of the first empty one back one, or, if there is no empty entry,
+	   evicting the least recently used (last) entry. */
+	way = 0;
+	while ((way < (MethodCacheWays - 1))
+	 && ((GIV(methodCache)[(setIndex + (way * MethodCacheEntrySize)) + MethodCacheSelector]) != 0)) {
+		way += 1;
 	}
-
-	/* first probe */
-	probe = hash & MethodCacheMask;
-	GIV(methodCache)[probe + MethodCacheSelector] = GIV(messageSelector);
-	GIV(methodCache)[probe + MethodCacheClass] = ((assert(addressCouldBeClassObj(classObj)),
-(((hash3 = (long32At(classObj + 4)) & (identityHashHalfWordMask()))) != 0
-		? hash3
-		: (objCouldBeClassObj(classObj)
-				? (((err2 = enterIntoClassTable(classObj))) != 0
-						? -err2
-						: (long32At(classObj + 4)) & (identityHashHalfWordMask()))
-				: -PrimErrBadReceiver))));
-	GIV(methodCache)[probe + MethodCacheMethod] = GIV(newMethod);
-	GIV(methodCache)[probe + MethodCachePrimFunction] = (((sqIntptr_t) primitiveFunctionPointer));
+	if ((GIV(methodCache)[(setIndex + (way * MethodCacheEntrySize)) + MethodCacheSelector]) != 0) {
+		GIV(statMethodCacheEvictions) += 1;
+	}
+	probe = setIndex + (way * MethodCacheEntrySize);
+	while (probe > setIndex) {
+		GIV(methodCache)[probe + MethodCacheSelector] = GIV(methodCache)[(probe - MethodCacheEntrySize) + MethodCacheSelector];
+		GIV(methodCache)[probe + MethodCacheClass] = GIV(methodCache)[(probe - MethodCacheEntrySize) + MethodCacheClass];
+		GIV(methodCache)[probe + MethodCacheMethod] = GIV(methodCache)[(probe - MethodCacheEntrySize) + MethodCacheMethod];
+		GIV(methodCache)[probe + MethodCachePrimFunction] = GIV(methodCache)[(probe - MethodCacheEntrySize) + MethodCachePrimFunction];
+		probe -= MethodCacheEntrySize;
+	}
+	GIV(methodCache)[setIndex + MethodCacheSelector] = GIV(messageSelector);
+	GIV(methodCache)[setIndex + MethodCacheClass] = classTag;
+	GIV(methodCache)[setIndex + MethodCacheMethod] = GIV(newMethod);
+	GIV(methodCache)[setIndex + MethodCachePrimFunction] = (((sqIntptr_t) primitiveFunctionPointer));
 
 	/* this for primitiveExternalMethod */
-	/* ...and zap the following entries */
-	GIV(lastMethodCacheProbeWrite) = probe;
-	for (p = 1; p < CacheProbeMax; p += 1) {
-		probe = (((usqInt) hash) >> p) & MethodCacheMask;
-		GIV(methodCache)[probe + MethodCacheSelector] = 0;
-	}
+	GIV(lastMethodCacheProbeWrite) = setIndex;
 }
 
 	/* CoInterpreter>>#argumentCountAddress */
@@ -15171,6 +15481,7 @@ ceCheckForInterrupts(void)
 {
     sqInt switched;
 
+	sampleMachineCodeUsage();
 	switched = checkForEventsMayContextSwitch(1);
 	returnToExecutivepostContextSwitch(0, switched);
 }
@@ -15958,6 +16269,14 @@ ceSendFromInLineCacheMiss(CogMethod *cogMethodOrPIC)
 	top = longAt(GIV(stackPointer));
 	GIV(stackPointer) += BytesPerWord;
 	GIV(instructionPointer) = top;
+	if ((((cogMethodOrPIC->cmType)) == CMOpenPIC)
+	 && (((GIV(newMethod) & (tagMask())) == 0)
+	 && ((((((usqInt) (longAt(GIV(newMethod)))) >> (formatShift())) & (formatMask())) >= (firstCompiledMethodFormat()))
+	 && (!(isYoung(GIV(newMethod))))))) {
+
+		/* the open PIC's probes missed; enter the method in its megamorphic cache */
+		cacheInOpenPICclassTagmethod(cogMethodOrPIC, classTag, GIV(newMethod));
+	}
 	if (((GIV(newMethod) & (tagMask())) == 0)
 	 && ((((((usqInt) (longAt(GIV(newMethod)))) >> (formatShift())) & (formatMask())) >= (firstCompiledMethodFormat()))
 	 && (isCogMethodReference(longAt((GIV(newMethod) + BaseHeaderSize) + (((sqInt)((usqInt)(HeaderIndex) << (shiftForWord()))))))))) {
@@ -16528,6 +16847,7 @@ ceStackOverflow(sqInt contextSwitchIfNotNil)
 	GIV(instructionPointer) = (((sqInt)cogMethod)) + ((cogMethod->stackCheckOffset));
 	assertValidExecutionPointersimbarline(GIV(instructionPointer), GIV(framePointer), GIV(stackPointer), 0, __LINE__);
 	GIV(method) = (GIV(newMethod) = (GIV(messageSelector) = GIV(nilObj)));
+	noteUsageSampleFor(asCogHomeMethod(cogMethod));
 	switched = handleStackOverflowOrEventAllowContextSwitch(contextSwitchIfNotNil != 0);
 	returnToExecutivepostContextSwitch(0, switched);
 	error("should not be reached");
@@ -16965,6 +17285,9 @@ commenceCogCompiledCodeCompaction(void)
 		(GIV(stackPage)->headSP = GIV(stackPointer));
 	}
 	assertValidStackedInstructionPointers(__LINE__);
+
+	/* cogCodeSize stays the configured size, the one saved in the image header */
+	GIV(grownCogCodeSize) = cogCodeZoneSize();
 	GIV(statCodeCompactionCount) += 1;
 	GIV(statCodeCompactionUsecs) += (ioUTCMicrosecondsNow()) - startTime;
 	if (checkForLeaks != 0) {
@@ -16981,6 +17304,76 @@ compilationBreakpointFor(sqInt selectorOop)
 	warning("compilation send break (heartbeat suppressed)");
 }
 
+/*	Mark the objects the stack pages refer to for the concurrent marker, as
+	markAndTraceStackPage: does for the full GC but without following
+	forwarders in place. Run just after a scavenge, which has written back
+	the current page's head pointers. */
+
+	/* CoInterpreter>>#concurrentlyMarkStackPages */
+static void
+concurrentlyMarkStackPages(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    CogBlockMethod *aCogMethod;
+    char *callerFP;
+    char *frameRcvrOffset;
+    CogMethod *homeMethod;
+    sqInt i;
+    char *theFP;
+    StackPage *thePage;
+    char *theSP;
+
+	for (i = 0; i < GIV(numStackPages); i += 1) {
+		/* begin stackPageAt: */
+		thePage = stackPageAtpages(i, GIV(pages));
+		if (!(isFree(thePage))) {
+			theSP = (thePage->headSP);
+
+			/* Skip the instruction pointer on top of stack of inactive pages. */
+			theFP = (thePage->headFP);
+			if (!(thePage == GIV(stackPage))) {
+				theSP += BytesPerWord;
+			}
+			while (1) {
+				frameRcvrOffset = ((((usqInt)(longAt(theFP + FoxMethod)))) < (startOfMemory())
+					? theFP + FoxMFReceiver
+					: theFP + FoxIFReceiver);
+				while (theSP <= frameRcvrOffset) {
+					concurrentlyMarkfrom(longAt(theSP), 0);
+					theSP += BytesPerWord;
+				}
+				if (((((usqInt)(longAt(theFP + FoxMethod)))) < (startOfMemory())
+					? ((longAt(theFP + FoxMethod)) & MFMethodFlagHasContextFlag) != 0
+					: (byteAt((theFP + FoxIFrameFlags) + 2)) != 0)) {
+					concurrentlyMarkfrom(longAt(theFP + FoxThisContext), 0);
+				}
+				if ((((usqInt)(longAt(theFP + FoxMethod)))) < (startOfMemory())) {
+					aCogMethod = ((CogBlockMethod *) ((longAt(theFP + FoxMethod)) & MFMethodMask));
+					/* begin asCogHomeMethod: */
+					homeMethod = (((aCogMethod->cmType)) == CMMethod
+						? ((CogMethod *) aCogMethod)
+						: ((aCogMethod->cpicHasMNUCaseOrCMIsFullBlock)
+								? ((CogMethod *) aCogMethod)
+								: ((CogMethod *) ((((usqInt)aCogMethod)) - ((aCogMethod->homeOffset))))));
+					concurrentlyMarkfrom((homeMethod->methodObject), 0);
+				}
+				else {
+					concurrentlyMarkfrom(longAt(theFP + FoxMethod), 0);
+				}
+				if (!(((callerFP = pointerForOop(longAt(theFP + FoxSavedFP)))) != 0)) break;
+				theSP = (theFP + FoxCallerSavedIP) + BytesPerWord;
+				theFP = callerFP;
+			}
+
+			/* caller ip is ceBaseReturnPC */
+			theSP = (theFP + FoxCallerSavedIP) + BytesPerWord;
+			while (theSP <= ((thePage->baseAddress))) {
+				concurrentlyMarkfrom(longAt(theSP), 0);
+				theSP += BytesPerWord;
+			}
+		}
+	}
+}
+
 
 /*	Answer a value to store in the InstructionPointer index of a context
 	object for theIP and theFP.
@@ -17702,13 +18095,14 @@ flushMethodCache(void)
 {   DECL_MAYBE_SQ_GLOBAL_STRUCT
     sqInt i;
 
-	for (i = 1; i <= MethodCacheSize; i += 1) {
+	for (i = 1; i <= GIV(methodCacheSize); i += 1) {
 		GIV(methodCache)[i] = 0;
 	}
 	
 	/* this for primitiveExternalMethod */
 	GIV(lastMethodCacheProbeWrite) = 0;
 	unlinkAllSends();
+	flushMegamorphicCaches();
 }
 
 	/* CoInterpreter>>#followForwardedFieldsInCurrentMethod */
@@ -18484,6 +18878,105 @@ isMachineCodeFrame(char *theFP)
 }
 
 
+/*	Compile to machine code the methods whose keys are in the machine code
+	cache file written by the previous run, so that a restarted VM need not
+	interpret its way back to a warm code zone. Sends link to the new methods
+	through the usual inline cache misses. Stop once the code zone is full
+	rather than compact it, since that would only free what was just compiled. */
+
+	/* CoInterpreter>>#loadMachineCodeCache */
+static void
+loadMachineCodeCache(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    FILE *file;
+    usqInt followingWord;
+    usqInt followingWordAddress;
+    sqInt i;
+    usqLong key;
+    unsigned long long fileKey;
+    usqLong *keys;
+    sqInt methodHeader;
+    usqInt numKeys;
+    sqInt objOop;
+    usqInt tableMask;
+    int version;
+
+	file = fopen(GIV(machineCodeCacheFile), "r");
+	if (file == null) {
+		return;
+	}
+	if (!(((fscanf(file, "cogcodecache %d\n", (&version))) == 1)
+		 && (version == 1))) {
+		fclose(file);
+		return;
+	}
+	numKeys = 0;
+	while ((fscanf(file, "%llx", (&fileKey))) == 1) {
+		numKeys += 1;
+	}
+	tableMask = 1;
+	while (tableMask < (numKeys * 2)) {
+		tableMask = tableMask * 2;
+	}
+	keys = calloc(tableMask, sizeof(usqLong));
+	tableMask -= 1;
+	if (keys == null) {
+		fclose(file);
+		return;
+	}
+	fseek(file, 0, SEEK_SET);
+	fscanf(file, "cogcodecache %d\n", (&version));
+	while ((fscanf(file, "%llx", (&fileKey))) == 1) {
+		i = fileKey & tableMask;
+		while (!(((keys[i]) == 0)
+			 || ((keys[i]) == fileKey))) {
+			i = (i + 1) & tableMask;
+		}
+		keys[i] = fileKey;
+	}
+	fclose(file);
+	/* begin allOldSpaceObjectsDo: */
+	objOop = GIV(nilObj);
+	while (oopisLessThan(objOop, GIV(endOfMemory))) {
+		if ((isEnumerableObject(objOop))
+		 && (((((usqInt) (longAt(objOop))) >> (formatShift())) & (formatMask())) >= (firstCompiledMethodFormat()))) {
+			methodHeader = longAt((objOop + BaseHeaderSize) + (((sqInt)((usqInt)(HeaderIndex) << (shiftForWord())))));
+			if (((methodHeader & (smallIntegerTag())) != 0)
+			 && ((methodWithHeaderShouldBeCogged(methodHeader))
+			 && (((key = machineCodeCacheKeyOf(objOop))) != 0))) {
+				i = key & tableMask;
+				while (!(((keys[i]) == 0)
+					 || ((keys[i]) == key))) {
+					i = (i + 1) & tableMask;
+				}
+				if ((keys[i]) == key) {
+					if (!((cogselector(objOop, maybeSelectorOfMethod(objOop))) == null)) {
+						GIV(statMachineCodeCacheCompilations) += 1;
+					}
+					if (GIV(cogCompiledCodeCompactionCalledFor)) {
+						GIV(cogCompiledCodeCompactionCalledFor) = 0;
+						break;
+					}
+				}
+			}
+		}
+		/* begin objectAfter:limit: */
+		followingWordAddress = addressAfter(objOop);
+		if (oopisGreaterThanOrEqualTo(followingWordAddress, GIV(endOfMemory))) {
+			objOop = GIV(endOfMemory);
+			goto l1;
+		}
+		flag("endianness");
+		followingWord = longAt(followingWordAddress);
+		objOop = ((((usqInt) followingWord) >> (numSlotsFullShift())) == (numSlotsMask())
+			? followingWordAddress + BaseHeaderSize
+			: followingWordAddress);
+	l1:	/* end objectAfter:limit: */;
+	}
+	free(keys);
+}
+
+
 /*	Lookup selector in rcvr, without doing MNU processing, and answer either a
 	method or an error code if the message was not understood. Used to
 	populate closed PICs. */
@@ -18551,6 +19044,48 @@ lookupOrdinaryreceiver(sqInt selector, sqInt rcvr)
 }
 
 
+/*	Answer the key under which methodObj is kept in the machine code cache,
+	a 64-bit FNV-1a hash of its selector and bytecodes, or 0 if it has none.
+	CompiledBlocks have none; they are compiled when their closures are. */
+
+	/* CoInterpreter>>#machineCodeCacheKeyOf: */
+static usqLong NoDbgRegParms
+machineCodeCacheKeyOf(sqInt methodObj)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    usqLong hash;
+    sqInt i;
+    sqInt numBytes;
+    sqInt selector;
+    sqInt ultimateLiteral;
+
+	if ((literalCountOf(methodObj)) < 2) {
+		return 0;
+	}
+	/* begin literal:ofMethod: */
+	ultimateLiteral = longAt((methodObj + BaseHeaderSize) + (((sqInt)((usqInt)((((literalCountOf(methodObj)) - 1) + LiteralStart)) << (shiftForWord())))));
+	if (((ultimateLiteral & (tagMask())) == 0)
+	 && (((((usqInt) (longAt(ultimateLiteral))) >> (formatShift())) & (formatMask())) >= (firstCompiledMethodFormat()))) {
+		return 0;
+	}
+	selector = maybeSelectorOfMethod(methodObj);
+	if (selector == 0) {
+		return 0;
+	}
+	hash = 14695981039346656037ULL;
+	numBytes = numBytesOfBytes(selector);
+	for (i = 0; i < numBytes; i += 1) {
+		hash = (hash ^ (byteAt((selector + BaseHeaderSize) + i))) * 1099511628211ULL;
+	}
+	numBytes = numBytesOf(methodObj);
+	for (i = startPCOfMethod(methodObj); i < numBytes; i += 1) {
+		hash = (hash ^ (byteAt((methodObj + BaseHeaderSize) + i))) * 1099511628211ULL;
+	}
+	return (hash == 0
+		? 1
+		: hash);
+}
+
+
 /*	<Integer> */
 /*	Marry aContext with the base frame of a new stack page. Build the base
 	frame to reflect the context's state. Answer the new page. Override to
@@ -18915,6 +19450,96 @@ mapStackPages(void)
 }
 
 
+/*	The parallel analogue of the scan of a single page in mapStackPages,
+	scavenging the oops in thePage's frames with
+	parallelScavengeReferent:worker:. Each page is scanned by the one thread
+	that claims it; see parallelScavengeWorker:arg:. */
+
+	/* CoInterpreter>>#parallelScavengeStackPage:worker: */
+static void NoDbgRegParms
+parallelScavengeStackPageworker(StackPage *thePage, SpurScavengeWorker *worker)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    char *callerFP;
+    char *frameRcvrOffset;
+    sqInt newMethod;
+    sqInt oop;
+    char *theFP;
+    sqInt theIP;
+    char *theIPPtr;
+    char *theSP;
+
+	theIP = 0;
+	assert(ifCurrentStackPageHasValidHeadPointers(thePage));
+	theSP = (thePage->headSP);
+
+	/* Skip the instruction pointer on top of stack of inactive pages. */
+	theFP = (thePage->headFP);
+	if (thePage == GIV(stackPage)) {
+		theIPPtr = (((((usqInt)(longAt(theFP + FoxMethod)))) < (startOfMemory()))
+		 || ((longAt(theFP + FoxIFSavedIP)) == 0)
+			? 0
+			: theFP + FoxIFSavedIP);
+	}
+	else {
+		theIPPtr = theSP;
+		theSP += BytesPerWord;
+	}
+	while (1) {
+		assert(addressIsInPage(thePage, theFP));
+		assert(addressIsInPage(thePage, theSP));
+		assert((theIPPtr == 0)
+		 || (addressIsInPage(thePage, theIPPtr)));
+		frameRcvrOffset = ((((usqInt)(longAt(theFP + FoxMethod)))) < (startOfMemory())
+			? theFP + FoxMFReceiver
+			: theFP + FoxIFReceiver);
+		while (theSP <= frameRcvrOffset) {
+			oop = longAt(theSP);
+			if ((oop & (tagMask())) == 0) {
+				longAtput(theSP, parallelScavengeReferentworker(oop, worker));
+			}
+			theSP += BytesPerWord;
+		}
+		if (((((usqInt)(longAt(theFP + FoxMethod)))) < (startOfMemory())
+			? ((longAt(theFP + FoxMethod)) & MFMethodFlagHasContextFlag) != 0
+			: (byteAt((theFP + FoxIFrameFlags) + 2)) != 0)) {
+			longAtput(theFP + FoxThisContext, parallelScavengeReferentworker(longAt(theFP + FoxThisContext), worker));
+		}
+		if (!((((usqInt)(longAt(theFP + FoxMethod)))) < (startOfMemory()))) {
+			newMethod = parallelScavengeReferentworker(longAt(theFP + FoxMethod), worker);
+			if (newMethod != (longAt(theFP + FoxMethod))) {
+				if (theIPPtr != 0) {
+					theIP = longAt(theIPPtr);
+					if (theIP == (ceReturnToInterpreterPC())) {
+						assert((iframeSavedIP(theFP)) > (iframeMethod(theFP)));
+						theIPPtr = theFP + FoxIFSavedIP;
+						theIP = longAt(theIPPtr);
+					}
+					else {
+						assert(theIP > (iframeMethod(theFP)));
+					}
+					theIP -= longAt(theFP + FoxMethod);
+				}
+				longAtput(theFP + FoxMethod, newMethod);
+				if (theIPPtr != 0) {
+					longAtput(theIPPtr, theIP + newMethod);
+				}
+			}
+		}
+		if (!(((callerFP = pointerForOop(longAt(theFP + FoxSavedFP)))) != 0)) break;
+		theSP = ((theIPPtr = theFP + FoxCallerSavedIP)) + BytesPerWord;
+		theFP = callerFP;
+	}
+	theSP = (theFP + FoxCallerSavedIP) + BytesPerWord;
+	while (theSP <= ((thePage->baseAddress))) {
+		oop = longAt(theSP);
+		if ((oop & (tagMask())) == 0) {
+			longAtput(theSP, parallelScavengeReferentworker(oop, worker));
+		}
+		theSP += BytesPerWord;
+	}
+}
+
+
 /*	The trace log is a circular buffer of pairs of entries. If there is
 	an entry at traceLogIndex - 3 \\ TraceBufferSize it has entries.
 	If there is something at traceLogIndex it has wrapped. */
@@ -19231,6 +19856,13 @@ methodCacheAddress(void)
 	return GIV(methodCache);
 }
 
+	/* CoInterpreter>>#methodCacheMask */
+sqInt
+methodCacheMask(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+	return GIV(methodCacheSetMask);
+}
+
 	/* CoInterpreter>>#methodHasCogMethod: */
 sqInt
 methodHasCogMethod(sqInt aMethodOop)
@@ -19777,6 +20409,86 @@ mustMapMachineCodePCcontext(sqInt theIP, sqInt aOnceMarriedContext)
 	return (((usqInt)(bcpc + 1) << 3) | 1);
 }
 
+
+/*	Write into buffer a C string naming cogMethod, Class>>selector for a
+	method, [] in Class>>selector for a full block, and ClosedPIC selector or
+	OpenPIC selector for a PIC, for tools such as perf that symbolize machine
+	code. Only reads the heap, so it may be used during code compaction. */
+
+	/* CoInterpreter>>#nameOfCogMethod:into:size: */
+void
+nameOfCogMethodintosize(CogMethod *cogMethod, char *buffer, sqInt bufferSize)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt classObj;
+    sqInt depth;
+    sqInt homeMethod;
+    char *metaSuffix;
+    sqInt nameLength;
+    sqInt nameOop;
+    char *prefix;
+    sqInt selector;
+    sqInt selectorLength;
+
+	selector = (cogMethod->selector);
+	nameOop = null;
+	metaSuffix = "";
+	if (((cogMethod->cmType)) == CMMethod) {
+		prefix = "";
+		homeMethod = (cogMethod->methodObject);
+		if ((((CogBlockMethod *) cogMethod)->cpicHasMNUCaseOrCMIsFullBlock)) {
+
+			/* a full block's outer code is its last literal */
+			prefix = "[] in ";
+			for (depth = 0; (depth < 16) && (((literalCountOf(homeMethod)) > 0) && (isOopCompiledMethod(ultimateLiteralOf(homeMethod)))); depth += 1) {
+				homeMethod = ultimateLiteralOf(homeMethod);
+			}
+			selector = maybeSelectorOfMethod(homeMethod);
+		}
+		if ((selector == null)
+		 || (selector == GIV(nilObj))) {
+			selector = maybeSelectorOfMethod(homeMethod);
+		}
+		classObj = safeMethodClassOf(homeMethod);
+		if (addressCouldBeClassObj(classObj)) {
+			if ((numSlotsOf(classObj)) == GIV(metaclassNumSlots)) {
+				classObj = fetchPointerofObject(GIV(thisClassIndex), classObj);
+				metaSuffix = " class";
+			}
+			if ((addressCouldBeClassObj(classObj))
+			 && ((numSlotsOf(classObj)) > GIV(classNameIndex))) {
+				nameOop = fetchPointerofObject(GIV(classNameIndex), classObj);
+			}
+		}
+	}
+	else {
+		prefix = (((cogMethod->cmType)) == CMOpenPIC
+			? "OpenPIC "
+			: "ClosedPIC ");
+	}
+	if (!((nameOop != null)
+		 && (((nameOop & (tagMask())) == 0)
+		 && (isBytes(nameOop))))) {
+		nameOop = null;
+	}
+	nameLength = (nameOop == null
+		? 1
+		: numBytesOf(nameOop));
+	if (!((selector != null)
+		 && (((selector & (tagMask())) == 0)
+		 && (isBytes(selector))))) {
+		selector = null;
+	}
+	selectorLength = (selector == null
+		? 1
+		: numBytesOf(selector));
+	if (((cogMethod->cmType)) == CMMethod) {
+		snprintf(buffer, bufferSize, "%s%.*s%s>>%.*s", prefix, (int) nameLength, (nameOop == null ? "?" : (char *) (nameOop + BaseHeaderSize)), metaSuffix, (int) selectorLength, (selector == null ? "?" : (char *) (selector + BaseHeaderSize)));
+	}
+	else {
+		snprintf(buffer, bufferSize, "%s%.*s", prefix, (int) selectorLength, (selector == null ? "?" : (char *) (selector + BaseHeaderSize)));
+	}
+}
+
 	/* CoInterpreter>>#newMethodAddress */
 usqInt
 newMethodAddress(void)
@@ -19793,12 +20505,12 @@ static sqInt NoDbgRegParms
 newMethodInLookupCacheAtand(sqInt selector, sqInt classTag)
 {   DECL_MAYBE_SQ_GLOBAL_STRUCT
     sqInt hash;
-    sqInt p;
     sqInt probe;
+    sqInt way;
 
-	hash = selector ^ (((sqInt)((usqInt)(classTag) << 2)));
-	for (p = 0; p < CacheProbeMax; p += 1) {
-		probe = (((usqInt) hash) >> p) & MethodCacheMask;
+	hash = selector ^ (((sqInt)((usqInt)(classTag) << MethodCacheClassTagShift)));
+	for (way = 0; way < MethodCacheWays; way += 1) {
+		probe = (hash & GIV(methodCacheSetMask)) + (way * MethodCacheEntrySize);
 		if (((GIV(methodCache)[probe + MethodCacheSelector]) == selector)
 		 && (((GIV(methodCache)[probe + MethodCacheClass]) == classTag)
 		 && ((GIV(methodCache)[probe + MethodCacheMethod]) == GIV(newMethod)))) {
@@ -19835,6 +20547,66 @@ noAssertHeaderOf(sqInt methodPointer)
 }
 
 
+/*	Note an allocation sample made while the current frame is running, along
+	with the frame's method and the bytecode pc it had reached, encoded as
+	contextInstructionPointer:frame: encodes it. The pc is known only if
+	instructionPointer is in the frame's method or machine code, as it is in
+	primitives; it is not in, e.g., run-time routines called from machine
+	code, and such samples have a pc of 0. */
+
+	/* CoInterpreter>>#noteAllocationSample:bytes: */
+static void NoDbgRegParms
+noteAllocationSamplebytes(sqInt classIndex, sqInt bytes)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt bcpc;
+    CogBlockMethod *cogMethod;
+    CogMethod *homeMethod;
+    sqInt ip;
+    sqInt method;
+    sqInt pc;
+
+	if ((GIV(stackPage) == 0)
+	 || (GIV(framePointer) == 0)) {
+		noteAllocationSamplebytesmethodpc(classIndex, bytes, 0, 0);
+		return;
+	}
+	ip = GIV(instructionPointer);
+	pc = 0;
+	if ((((usqInt)(longAt(GIV(framePointer) + FoxMethod)))) < (startOfMemory())) {
+		cogMethod = ((CogBlockMethod *) ((longAt(GIV(framePointer) + FoxMethod)) & MFMethodMask));
+		homeMethod = mframeHomeMethod(GIV(framePointer));
+		method = (homeMethod->methodObject);
+		if ((ip > (((sqInt)cogMethod)))
+		 && (ip < ((((sqInt)homeMethod)) + ((homeMethod->blockSize))))) {
+			if (((cogMethod->cmType)) == CMBlock) {
+				bcpc = bytecodePCForstartBcpcin(ip, (cogMethod->startpc), cogMethod);
+			}
+			else {
+
+				/* map pcs in primitive code to the initial pc, as mustMapMachineCodePC:context: does */
+				bcpc = ((ip - (((sqInt)cogMethod))) < ((cogMethod->stackCheckOffset))
+					? startPCOfMethod(method)
+					: bytecodePCForstartBcpcin(ip, startPCOfMethod(method), cogMethod));
+			}
+			if (bcpc > 0) {
+				pc = bcpc + 1;
+			}
+		}
+	}
+	else {
+		method = longAt(GIV(framePointer) + FoxMethod);
+		if (ip == (ceReturnToInterpreterPC())) {
+			ip = longAt(GIV(framePointer) + FoxIFSavedIP);
+		}
+		if ((ip > method)
+		 && (ip < (addressAfter(method)))) {
+			pc = ((ip - method) - BaseHeaderSize) + 2;
+		}
+	}
+	noteAllocationSamplebytesmethodpc(classIndex, bytes, method, pc);
+}
+
+
 /*	integerValue is interpreted as POSITIVE, e.g. as the result of Bitmap>at:.
 	N.B. Returning in each arm separately enables Slang inlining.
 	/Don't/ return the ifTrue:ifFalse: unless Slang inlining of conditionals
@@ -19927,6 +20699,9 @@ positive64BitIntegerFor(usqLong integerValue)
 	}
 	long64Atput(newObj, (((((usqLong) numSlots)) << (numSlotsFullShift())) + (((sqInt)((usqInt)(objFormat) << (formatShift()))))) + ClassLargePositiveIntegerCompactIndex);
 	GIV(freeStart) += numBytes;
+	if (GIV(allocationSampleInterval) > 0) {
+		sampleAllocationbytes(newObj, numBytes);
+	}
 	newLargeInteger = newObj;
 	l1:	/* end eeInstantiateSmallClassIndex:format:numSlots: */;
 	long64Atput((newLargeInteger + BaseHeaderSize) + (0U << 3), SQ_SWAP_8_BYTES_IF_BIGENDIAN(integerValue));
@@ -20616,7 +21391,7 @@ printMethodCacheFor(sqInt thing)
     sqIntptr_t s;
 
 	n = 0;
-	for (i = 0; i < MethodCacheSize; i += MethodCacheEntrySize) {
+	for (i = 0; i < GIV(methodCacheSize); i += MethodCacheEntrySize) {
 		s = GIV(methodCache)[i + MethodCacheSelector];
 		c = GIV(methodCache)[i + MethodCacheClass];
 		m = GIV(methodCache)[i + MethodCacheMethod];
@@ -20929,6 +21704,7 @@ readImageFromFileHeapSizeStartingAt(sqImageFile f, usqInt desiredHeapSize, squea
 
 	/* guess (Class instVarIndexFor: 'name' ifAbsent: []) - 1 */
 	GIV(classNameIndex) = 6;
+	allocateMethodCache();
 	swapBytes = checkImageVersionFromstartingAt(f, imageOffset);
 
 	/* record header start position */
@@ -21001,7 +21777,7 @@ readImageFromFileHeapSizeStartingAt(sqImageFile f, usqInt desiredHeapSize, squea
 	/* begin setImageHeaderFlagsFrom: */
 
 	/* so as to preserve unrecognised flags. */
-	GIV(imageHeaderFlags) = headerFlags;
+	GIV(imageHeaderFlags) = headerFlags & (~256);
 	GIV(fullScreenFlag) = headerFlags & 1;
 	GIV(imageFloatsBigEndian) = ((headerFlags & 2) == 0
 		? 1
@@ -21009,6 +21785,7 @@ readImageFromFileHeapSizeStartingAt(sqImageFile f, usqInt desiredHeapSize, squea
 	GIV(flagInterpretedMethods) = (headerFlags & 8) != 0;
 	GIV(preemptionYields) = (headerFlags & 16) == 0;
 	GIV(newFinalization) = (headerFlags & 64) != 0;
+	GIV(compressImageHeapData) = (headerFlags & 256) != 0;
 	/* begin getWord32FromFile:swap: */
 	w6 = 0;
 	sqImageFileRead((&w6), sizeof(int), 1, f);
@@ -21038,6 +21815,12 @@ readImageFromFileHeapSizeStartingAt(sqImageFile f, usqInt desiredHeapSize, squea
 	if (GIV(cogCodeSize) > (maxCogCodeSize())) {
 		GIV(cogCodeSize) = maxCogCodeSize();
 	}
+
+	/* the code zone may grow up to cogCodeSizeLimit; reserve that much */
+	GIV(cogCodeSizeLimit) = ((desiredMaxCogCodeSize < (maxCogCodeSize())) ? desiredMaxCogCodeSize : (maxCogCodeSize()));
+	if (GIV(cogCodeSizeLimit) < GIV(cogCodeSize)) {
+		GIV(cogCodeSizeLimit) = GIV(cogCodeSize);
+	}
 	/* begin getWord32FromFile:swap: */
 	w8 = 0;
 	sqImageFileRead((&w8), sizeof(int), 1, f);
@@ -21084,7 +21867,7 @@ readImageFromFileHeapSizeStartingAt(sqImageFile f, usqInt desiredHeapSize, squea
 	allocationReserve = interpreterAllocationReserveBytes();
 
 	/* no need to include the stackZone; this is alloca'ed */
-	minimumMemory = ((GIV(cogCodeSize) + dataSize) + GIV(edenBytes)) + allocationReserve;
+	minimumMemory = ((GIV(cogCodeSizeLimit) + dataSize) + GIV(edenBytes)) + allocationReserve;
 	/* begin getLongFromFile:swap: */
 	w = 0;
 	sqImageFileRead((&w), sizeof(w), 1, f);
@@ -21124,13 +21907,17 @@ readImageFromFileHeapSizeStartingAt(sqImageFile f, usqInt desiredHeapSize, squea
 	headroom = headroom1;
 	l2:	/* end initialHeadroom:givenFreeOldSpaceInImage: */;
 	/* begin roundUpHeapSize: */
-	heapSize1 = (((GIV(cogCodeSize) + dataSize) + headroom) + GIV(edenBytes)) + ((headroom > allocationReserve
+	heapSize1 = (((GIV(cogCodeSizeLimit) + dataSize) + headroom) + GIV(edenBytes)) + ((headroom > allocationReserve
 	? 0
 	: allocationReserve));
 	bit = (((highBit(heapSize1)) - 1) * 3) / 4;
 	heapSize = (heapSize1 & ((1ULL << bit) - 1)
 		? (((heapSize1 | ((1ULL << bit) - 1)) - ((1ULL << bit) - 1))) + (1ULL << bit)
 		: heapSize1);
+
+	/* tell the platform where memory would have to start for old space to start
+	   where it did when the image was saved, in which case it needn't be swizzled */
+	sqImageFileNoteSavedMemoryBase(((oldBaseAddr - allocationReserve) - GIV(edenBytes)) - GIV(cogCodeSizeLimit));
 	/* begin memory: */
 	aValue = ((usqInt)(pointerForOop(allocateMemoryMinimumImageFileHeaderSize(heapSize, minimumMemory, f, headerSize))));
 	GIV(memory) = aValue;
@@ -21139,12 +21926,14 @@ readImageFromFileHeapSizeStartingAt(sqImageFile f, usqInt desiredHeapSize, squea
 	}
 
 	/* position file after the header */
-	heapBase = setHeapBasememoryLimitendOfMemory((memory()) + GIV(cogCodeSize), (memory()) + heapSize, ((memory()) + GIV(cogCodeSize)) + dataSize);
+	heapBase = setHeapBasememoryLimitendOfMemory((memory()) + GIV(cogCodeSizeLimit), (memory()) + heapSize, ((memory()) + GIV(cogCodeSizeLimit)) + dataSize);
+	printLoadPhaseTime("allocated the heap");
 	sqImageFileSeek(f, headerStart + headerSize);
 	bytesRead = readHeapFromImageFiledataBytes(f, dataSize);
 	if (bytesRead != dataSize) {
 		unableToReadImageError();
 	}
+	printLoadPhaseTime("read the heap");
 	ensureImageFormatIsUpToDate(swapBytes);
 	bytesToShift = GIV(oldSpaceStart) - oldBaseAddr;
 	/* begin initializeInterpreter: */
@@ -21241,6 +22030,10 @@ readImageFromFileHeapSizeStartingAt(sqImageFile f, usqInt desiredHeapSize, squea
 	sHEAFn = ioLoadFunctionFrom("secHasEnvironmentAccess", "SecurityPlugin");
 	/* begin initializeCodeGenerator */
 	initializeCodeZoneFromupTo(memory(), (memory()) + GIV(cogCodeSize));
+	GIV(grownCogCodeSize) = GIV(cogCodeSize);
+	if (GIV(cogCodeSizeLimit) > GIV(cogCodeSize)) {
+		setMethodZoneGrowthLimit((memory()) + GIV(cogCodeSizeLimit));
+	}
 	return dataSize;
 }
 
@@ -21481,6 +22274,20 @@ roomToPushNArgs(sqInt n)
 }
 
 
+/*	Credit the machine code method running in the current frame with a use.
+	Called on interrupt checks, which the heartbeat drives, so the usage
+	counts the code zone evicts by approximate recent execution time. */
+
+	/* CoInterpreter>>#sampleMachineCodeUsage */
+static void
+sampleMachineCodeUsage(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+	if (isMachineCodeFrame(GIV(framePointer))) {
+		noteUsageSampleFor(mframeHomeMethod(GIV(framePointer)));
+	}
+}
+
+
 /*	Send the calllback message to Alien class with the supplied arg(s). Use
 	either the 1 arg
 	invokeCallbackContext: or the 4 arg invokeCallback:stack:registers:jmpbuf:
@@ -21972,6 +22779,17 @@ sendInvokeCallbackStackRegistersJmpbuf(sqInt thunkPtr, sqInt stackPtr, sqInt reg
 	return 1;
 }
 
+
+/*	Keep the machine code cache in the named file. The methods listed in it
+	are compiled at start-up, and it is rewritten on snapshot and on quit. */
+
+	/* CoInterpreter>>#setMachineCodeCacheFile: */
+void
+setMachineCodeCacheFile(char *fileName)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+	GIV(machineCodeCacheFile) = strdup(fileName);
+}
+
 	/* CoInterpreter>>#shortPrintFrame: */
 static sqInt NoDbgRegParms
 shortPrintFrame(char *theFP)
@@ -22126,6 +22944,9 @@ signed64BitIntegerFor(sqLong integerValue)
 	}
 	long64Atput(newObj, (((((usqLong) numSlots)) << (numSlotsFullShift())) + (((sqInt)((usqInt)(objFormat) << (formatShift()))))) + largeClass);
 	GIV(freeStart) += numBytes;
+	if (GIV(allocationSampleInterval) > 0) {
+		sampleAllocationbytes(newObj, numBytes);
+	}
 	newLargeInteger = newObj;
 	l1:	/* end eeInstantiateSmallClassIndex:format:numSlots: */;
 	
@@ -23173,6 +23994,60 @@ widowOrForceToBytecodePC(sqInt ctxt)
 	}
 }
 
+
+/*	Write a code zone record to the GC log covering the minute since the last
+	one. The first call just starts the clock. */
+
+	/* CoInterpreter>>#writeCodeZoneLogRecord: */
+static void NoDbgRegParms NeverInline
+writeCodeZoneLogRecord(usqLong now)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+	if (GIV(codeLogUsecs) != 0) {
+		fprintf(GIV(gcLog), "{\"event\":\"codeZone\",\"unixUsecs\":%llu,\"usecs\":%llu,\"compilations\":%llu,\"evictions\":%llu,\"compactions\":%llu,\"compactionUsecs\":%llu,\"zoneBytes\":%llu,\"zoneLimitBytes\":%llu}\n", ((unsigned long long) (now - MicrosecondsFrom1901To1970)), ((unsigned long long) (now - GIV(codeLogUsecs))), ((unsigned long long) (statCodeCompilations - GIV(codeLogCompilations))), ((unsigned long long) (statCodeEvictions - GIV(codeLogEvictions))), ((unsigned long long) (GIV(statCodeCompactionCount) - GIV(codeLogCompactionCount))), ((unsigned long long) (GIV(statCodeCompactionUsecs) - GIV(codeLogCompactionUsecs))), ((unsigned long long) GIV(grownCogCodeSize)), ((unsigned long long) GIV(cogCodeSizeLimit)));
+		fflush(GIV(gcLog));
+	}
+	GIV(codeLogUsecs) = now;
+	GIV(codeLogCompilations) = statCodeCompilations;
+	GIV(codeLogEvictions) = statCodeEvictions;
+	GIV(codeLogCompactionCount) = GIV(statCodeCompactionCount);
+	GIV(codeLogCompactionUsecs) = GIV(statCodeCompactionUsecs);
+}
+
+
+/*	Write the keys of the methods now in machine code to the machine code
+	cache file, for loadMachineCodeCache to compile in the next run. Full
+	blocks, PICs and the inline cache state are not saved; all are rebuilt
+	as the compiled methods are run. */
+
+	/* CoInterpreter>>#writeMachineCodeCache */
+static void NeverInline
+writeMachineCodeCache(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    FILE *file;
+    sqInt i;
+    usqLong key;
+    sqInt *methodObjs;
+    sqInt numMethods;
+
+	numMethods = numMethodsOfType(CMMethod);
+	methodObjs = malloc((numMethods + 1) * (sizeof(sqInt)));
+	if (methodObjs == null) {
+		return;
+	}
+	numMethods = methodObjectsCompiledToMachineCodeIntolimit(methodObjs, numMethods);
+	file = fopen(GIV(machineCodeCacheFile), "w");
+	if (!(file == null)) {
+		fprintf(file, "cogcodecache %d\n", 1);
+		for (i = 0; i < numMethods; i += 1) {
+			if (((key = machineCodeCacheKeyOf(methodObjs[i]))) != 0) {
+				fprintf(file, "%016llx\n", ((unsigned long long) key));
+			}
+		}
+		fclose(file);
+	}
+	free(methodObjs);
+}
+
 	/* CoInterpreterPrimitives>>#frameIsMarked: */
 static sqInt NoDbgRegParms
 frameIsMarked(sqInt theFPInt)
@@ -23504,7 +24379,7 @@ primitiveFlushCacheBySelector(void)
 
 	selector = longAt(GIV(stackPointer));
 	probe = 0;
-	for (i = 1; i <= MethodCacheEntries; i += 1) {
+	for (i = 1; i <= methodCacheEntries; i += 1) {
 		if ((GIV(methodCache)[probe + MethodCacheSelector]) == selector) {
 			GIV(methodCache)[probe + MethodCacheSelector] = 0;
 		}
@@ -23514,6 +24389,7 @@ primitiveFlushCacheBySelector(void)
 	 || (selector == (fetchPointerofObject(17 * 2, splObj(SpecialSelectors))))) {
 	}
 	unlinkSendsOfisMNUSelector(selector, selector == (longAt((GIV(specialObjectsOop) + BaseHeaderSize) + (((sqInt)((usqInt)(SelectorDoesNotUnderstand) << (shiftForWord())))))));
+	flushMegamorphicCaches();
 }
 
 	/* CoInterpreterPrimitives>>#primitiveFunctionPointerAddress */
@@ -25708,6 +26584,64 @@ primitiveAllObjects(void)
 	primitive is specific to floats. eem 2/13/2017
  */
 
+/*	Primitive. Answer the allocation samples taken since sampling was started
+	or the samples were last answered, oldest first, as an Array of four
+	elements per sample, the class, the byte size, the method that made the
+	allocation and the pc it had reached, and empty the sample buffer. A class
+	that has since been collected is answered as nil, as is a method or pc
+	that is not known. Objects machine code allocates inline are not sampled.
+	See also primitiveStartAllocationSampling. */
+
+	/* InterpreterPrimitives>>#primitiveAllocationSamples */
+EXPORT(sqInt)
+primitiveAllocationSamples(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt classObj;
+    sqInt i;
+    sqInt index;
+    sqInt interval;
+    sqInt method;
+    sqInt pc;
+    sqInt samples;
+    char *sp;
+
+	if (GIV(argumentCount) != 0) {
+		return (GIV(primFailCode) = PrimErrBadNumArgs);
+	}
+
+	/* don't let the result, if allocated in old space, add a sample to those being answered */
+	interval = GIV(allocationSampleInterval);
+	GIV(allocationSampleInterval) = 0;
+	samples = instantiateClassindexableSize(longAt((GIV(specialObjectsOop) + BaseHeaderSize) + (((sqInt)((usqInt)(ClassArray) << (shiftForWord()))))), 4 * GIV(numAllocationSamples));
+	GIV(allocationSampleInterval) = interval;
+	if (!(samples)) {
+		return (GIV(primFailCode) = PrimErrNoMemory);
+	}
+	index = ((GIV(allocationSampleIndex) - GIV(numAllocationSamples)) + AllocationSampleBufferSize) % AllocationSampleBufferSize;
+	for (i = 0; i < GIV(numAllocationSamples); i += 1) {
+		classObj = classAtIndex(GIV(allocationSamples)[4 * index]);
+		storePointerofObjectwithValue(4 * i, samples, (classObj == null
+			? GIV(nilObj)
+			: classObj));
+		storePointerUncheckedofObjectwithValue((4 * i) + 1, samples, (((usqInt)(GIV(allocationSamples)[(4 * index) + 1]) << 3) | 1));
+		method = GIV(allocationSamples)[(4 * index) + 2];
+		storePointerofObjectwithValue((4 * i) + 2, samples, (method == 0
+			? GIV(nilObj)
+			: method));
+		pc = GIV(allocationSamples)[(4 * index) + 3];
+		storePointerUncheckedofObjectwithValue((4 * i) + 3, samples, (pc == 0
+			? GIV(nilObj)
+			: (((usqInt)pc << 3) | 1)));
+		index = (index + 1) % AllocationSampleBufferSize;
+	}
+	GIV(numAllocationSamples) = 0;
+	/* begin pop:thenPush: */
+	longAtput((sp = GIV(stackPointer) + ((1 - 1) * BytesPerWord)), samples);
+	GIV(stackPointer) = sp;
+	return 0;
+}
+
+
 	/* InterpreterPrimitives>>#primitiveArctan */
 static void
 primitiveArctan(void)
@@ -27507,6 +28441,52 @@ primitiveClass(void)
 	}
 }
 
+/*	Primitive. Answer a census of the heap as an Array of triples of a class,
+	the number of its instances and the bytes they occupy, for every class
+	with instances. The census is taken in a single pass over the heap and
+	is cached until the next garbage collection, so that tools that ask for
+	many classes' instance counts don't each scan the heap. */
+
+	/* InterpreterPrimitives>>#primitiveClassCensus */
+EXPORT(sqInt)
+primitiveClassCensus(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt census;
+    sqInt classIndex;
+    sqInt classObj;
+    sqInt i;
+    sqInt numClasses;
+    char *sp;
+
+	if (GIV(argumentCount) != 0) {
+		return (GIV(primFailCode) = PrimErrBadNumArgs);
+	}
+	numClasses = takeClassCensus();
+	if (numClasses < 0) {
+		return (GIV(primFailCode) = PrimErrNoCMemory);
+	}
+	census = instantiateClassindexableSize(longAt((GIV(specialObjectsOop) + BaseHeaderSize) + (((sqInt)((usqInt)(ClassArray) << (shiftForWord()))))), 3 * numClasses);
+	if (!(census)) {
+		return (GIV(primFailCode) = PrimErrNoMemory);
+	}
+	i = 0;
+	for (classIndex = 0; classIndex < GIV(censusCapacity); classIndex += 1) {
+		if (GIV(censusCounts)[classIndex] > 0) {
+			classObj = classAtIndex(classIndex);
+			storePointerofObjectwithValue(i, census, (classObj == null
+				? GIV(nilObj)
+				: classObj));
+			storePointerofObjectwithValue(i + 1, census, positive64BitIntegerFor(GIV(censusCounts)[classIndex]));
+			storePointerofObjectwithValue(i + 2, census, positive64BitIntegerFor(GIV(censusBytes)[classIndex]));
+			i += 3;
+		}
+	}
+	/* begin pop:thenPush: */
+	longAtput((sp = GIV(stackPointer) + ((1 - 1) * BytesPerWord)), census);
+	GIV(stackPointer) = sp;
+	return 0;
+}
+
 
 /*	Primitive. Void the VM profile histograms. */
 
@@ -27601,6 +28581,9 @@ primitiveClipboardText(void)
 		assert((numBytes1 % (allocationUnit())) == 0);
 		assert((newObj % (allocationUnit())) == 0);
 		GIV(freeStart) += numBytes1;
+		if (GIV(allocationSampleInterval) > 0) {
+			sampleAllocationbytes(newObj, numBytes1);
+		}
 		s = newObj;
 	l4:	/* end allocateBytes:classIndex: */;
 		if (!(s)) {
@@ -32437,6 +33420,9 @@ primitiveGetWindowSize(void)
 	}
 	long64Atput(newObj, (((((usqLong) numSlots)) << (numSlotsFullShift())) + (((sqInt)((usqInt)(objFormat) << (formatShift()))))) + knownClassIndex);
 	GIV(freeStart) += numBytes;
+	if (GIV(allocationSampleInterval) > 0) {
+		sampleAllocationbytes(newObj, numBytes);
+	}
 	pointResult = newObj;
 	l3:	/* end eeInstantiateSmallClass:numSlots: */;
 	/* begin storePointerUnchecked:ofObject:withValue: */
@@ -33840,6 +34826,93 @@ primitiveLoadImageSegment(void)
 }
 
 
+/*	Primitive. Load an image segment written by
+	primitiveStoreImageSegmentToFile from the named file. Called from
+	Smalltalk as...
+	<imageSegment> loadSegmentFromFile: fileName outPointers: anArray.
+	
+	The file is read straight into a WordArray allocated in old space, and the
+	segment is then loaded in place from it as primitiveLoadImageSegment
+	does, so the segment data is copied exactly once, from the file into the
+	heap, rather than into a ByteArray, then a WordArray, and then the
+	loaded objects. On success answer the array of roots. If the file can't
+	be read or the segment can't be loaded the WordArray is shortened to
+	nothing, as primitiveStoreImageSegmentToFile shortens its WordArray, so
+	that a large segment does not occupy the heap until the next full GC. */
+
+	/* InterpreterPrimitives>>#primitiveLoadImageSegmentFromFile */
+EXPORT(sqInt)
+primitiveLoadImageSegmentFromFile(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    size_t bytesRead;
+    FILE *f;
+    char *fileName;
+    sqInt fileSize;
+    usqInt numBytes;
+    sqInt numSlots;
+    sqInt outPointerArray;
+    sqInt result;
+    sqInt segmentWordArray;
+    char *sp;
+
+	if (GIV(argumentCount) != 2) {
+		return (GIV(primFailCode) = PrimErrBadNumArgs);
+	}
+	outPointerArray = longAt(GIV(stackPointer));
+	if (!(((outPointerArray & (tagMask())) == 0)
+		 && (((((usqInt) (longAt(outPointerArray))) >> (formatShift())) & (formatMask())) == 2 /* arrayFormat */))) {
+		return (GIV(primFailCode) = PrimErrBadArgument);
+	}
+	fileName = cStringOrNullFor(longAt(GIV(stackPointer) + (1 * BytesPerWord)));
+	if (fileName == null) {
+		if (!GIV(primFailCode)) {
+			GIV(primFailCode) = PrimErrBadArgument;
+		}
+		return 0;
+	}
+	f = fopen(fileName, "rb");
+	free(fileName);
+	if (f == null) {
+		return (GIV(primFailCode) = PrimErrOSError);
+	}
+	if ((fseek(f, 0, SEEK_END) != 0)
+	 || (((fileSize = ftell(f))) < 0)
+	 || (fseek(f, 0, SEEK_SET) != 0)) {
+		fclose(f);
+		return (GIV(primFailCode) = PrimErrOSError);
+	}
+	if ((fileSize < 8 /* allocationUnit */)
+	 || ((fileSize % 8 /* allocationUnit */) != 0)) {
+		fclose(f);
+		return (GIV(primFailCode) = PrimErrInappropriate);
+	}
+	numSlots = fileSize / BytesPerOop;
+	numBytes = (numSlots >= (numSlotsMask())
+		? (BaseHeaderSize + BaseHeaderSize) + fileSize
+		: BaseHeaderSize + fileSize);
+	segmentWordArray = allocateSlotsInOldSpacebytesformatclassIndex(numSlots, numBytes, firstLongFormat(), thirtyTwoBitLongsClassIndexPun());
+	if (!(segmentWordArray)) {
+		fclose(f);
+		return (GIV(primFailCode) = PrimErrNoMemory);
+	}
+	bytesRead = fread(((void *) (segmentWordArray + BaseHeaderSize)), 1, fileSize, f);
+	fclose(f);
+	if (bytesRead != fileSize) {
+		shortentoIndexableSize(segmentWordArray, 0);
+		return (GIV(primFailCode) = PrimErrOSError);
+	}
+	result = loadImageSegmentFromoutPointers(segmentWordArray, outPointerArray);
+	if (!(oopisGreaterThan(result, segmentWordArray))) {
+		shortentoIndexableSize(segmentWordArray, 0);
+		return (GIV(primFailCode) = result);
+	}
+	/* begin pop:thenPush: */
+	longAtput((sp = GIV(stackPointer) + ((3 - 1) * BytesPerWord)), result);
+	GIV(stackPointer) = sp;
+	return 0;
+}
+
+
 /*	Return the value of the microsecond clock in the local timezone as an
 	integer. This is the number of microseconds since the Smalltalk epoch,
 	1901/1/1 12:00am.
@@ -33980,6 +35053,9 @@ primitiveMakePoint(void)
 	}
 	long64Atput(newObj, (((((usqLong) numSlots)) << (numSlotsFullShift())) + (((sqInt)((usqInt)(objFormat) << (formatShift()))))) + knownClassIndex);
 	GIV(freeStart) += numBytes;
+	if (GIV(allocationSampleInterval) > 0) {
+		sampleAllocationbytes(newObj, numBytes);
+	}
 	pt = newObj;
 	l2:	/* end eeInstantiateSmallClass:numSlots: */;
 	assert(!(isOopForwarded(pt)));
@@ -34227,6 +35303,9 @@ primitiveMousePoint(void)
 	}
 	long64Atput(newObj, (((((usqLong) numSlots)) << (numSlotsFullShift())) + (((sqInt)((usqInt)(objFormat) << (formatShift()))))) + knownClassIndex);
 	GIV(freeStart) += numBytes;
+	if (GIV(allocationSampleInterval) > 0) {
+		sampleAllocationbytes(newObj, numBytes);
+	}
 	pointResult = newObj;
 	l3:	/* end eeInstantiateSmallClass:numSlots: */;
 	/* begin storePointerUnchecked:ofObject:withValue: */
@@ -34488,6 +35567,9 @@ primitiveNewMethod(void)
 		assert((numBytes % (allocationUnit())) == 0);
 		assert((newObj1 % (allocationUnit())) == 0);
 		GIV(freeStart) += numBytes;
+		if (GIV(allocationSampleInterval) > 0) {
+			sampleAllocationbytes(newObj1, numBytes);
+		}
 		newObj = newObj1;
 	l4:	/* end allocateSlots:format:classIndex: */;
 	}
@@ -34936,6 +36018,8 @@ primitivePathToUsing(void)
     sqInt stackp;
     sqInt stackSize;
 
+	finishIncrementalSweep();
+	abortConcurrentMark();
 	err = 0;
 	/* begin externalWriteBackHeadFramePointers */
 	assert((GIV(framePointer) - GIV(stackPointer)) < (LargeContextSlots * BytesPerOop));
@@ -35595,6 +36679,9 @@ primitiveProfileStart(void)
 static void
 primitiveQuit(void)
 {   DECL_MAYBE_SQ_GLOBAL_STRUCT
+	if (!(GIV(machineCodeCacheFile) == null)) {
+		writeMachineCodeCache();
+	}
 	ioExitWithErrorCode((GIV(argumentCount) == 1
 		? ((longAt(GIV(stackPointer))) >> 3)
 		: 0));
@@ -36212,6 +37299,9 @@ primitiveScreenSize(void)
 	}
 	long64Atput(newObj, (((((usqLong) numSlots)) << (numSlotsFullShift())) + (((sqInt)((usqInt)(objFormat) << (formatShift()))))) + knownClassIndex);
 	GIV(freeStart) += numBytes;
+	if (GIV(allocationSampleInterval) > 0) {
+		sampleAllocationbytes(newObj, numBytes);
+	}
 	pointResult = newObj;
 	l3:	/* end eeInstantiateSmallClass:numSlots: */;
 	/* begin storePointerUnchecked:ofObject:withValue: */
@@ -38396,6 +39486,52 @@ primitiveSquareRoot(void)
 }
 
 
+/*	Primitive. Start sampling allocations, taking the object containing every
+	Nth byte allocated, where N is the argument, a positive SmallInteger. Any
+	samples not yet answered are discarded. While sampling, each allocation
+	the interpreter and run-time make costs a countdown; while stopped, a
+	test. Objects machine code allocates inline are not sampled.
+	See also primitiveAllocationSamples and primitiveStopAllocationSampling. */
+
+	/* InterpreterPrimitives>>#primitiveStartAllocationSampling */
+EXPORT(sqInt)
+primitiveStartAllocationSampling(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt interval;
+
+	if (GIV(argumentCount) != 1) {
+		return (GIV(primFailCode) = PrimErrBadNumArgs);
+	}
+	interval = longAt(GIV(stackPointer) + (0 * BytesPerWord));
+	if (!((((interval) & 7) == 1)
+		 && ((interval >> 3) > 0))) {
+		return (GIV(primFailCode) = PrimErrBadArgument);
+	}
+	GIV(allocationSampleInterval) = (interval >> 3);
+	GIV(bytesUntilAllocationSample) = GIV(allocationSampleInterval);
+	GIV(allocationSampleIndex) = (GIV(numAllocationSamples) = 0);
+	/* begin pop: */
+	GIV(stackPointer) += 1 * BytesPerWord;
+	return 0;
+}
+
+
+/*	Primitive. Stop sampling allocations. The samples taken so far remain to
+	be answered by primitiveAllocationSamples. */
+
+	/* InterpreterPrimitives>>#primitiveStopAllocationSampling */
+EXPORT(sqInt)
+primitiveStopAllocationSampling(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+	if (GIV(argumentCount) != 0) {
+		return (GIV(primFailCode) = PrimErrBadNumArgs);
+	}
+	GIV(allocationSampleInterval) = 0;
+	return 0;
+}
+
+
+
 /*	This primitive is called from Squeak as...
 	<imageSegment> storeSegmentFor: arrayOfRoots into: aWordArray outPointers:
 	anArray. 
@@ -38468,6 +39604,83 @@ primitiveStoreImageSegment(void)
 	}
 }
 
+
+/*	Primitive. Store an image segment as primitiveStoreImageSegment does and
+	write it straight from the segmentWordArray to the named file. Called from
+	Smalltalk as...
+	<imageSegment> storeSegmentFor: arrayOfRoots into: aWordArray
+	outPointers: anArray toFile: fileName.
+	
+	Once written, the segmentWordArray is shortened to its version stamp,
+	returning the space the segment occupied to free memory, so that a large
+	segment is neither copied into a ByteArray to be written nor kept in the
+	heap afterwards. If the file can't be written the primitive fails with
+	PrimErrOSError, leaving the segment in the segmentWordArray and the
+	outPointers filled in as primitiveStoreImageSegment would. */
+
+	/* InterpreterPrimitives>>#primitiveStoreImageSegmentToFile */
+EXPORT(sqInt)
+primitiveStoreImageSegmentToFile(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt arrayOfRoots;
+    size_t bytesWritten;
+    sqInt ecode;
+    FILE *f;
+    char *fileName;
+    sqInt outPointerArray;
+    sqInt segmentBytes;
+    sqInt segmentWordArray;
+
+	if (GIV(argumentCount) != 4) {
+		return (GIV(primFailCode) = PrimErrBadNumArgs);
+	}
+	outPointerArray = longAt(GIV(stackPointer) + (1 * BytesPerWord));
+	segmentWordArray = longAt(GIV(stackPointer) + (2 * BytesPerWord));
+
+	/* Essential type checks */
+	arrayOfRoots = longAt(GIV(stackPointer) + (3 * BytesPerWord));
+	if (!((((arrayOfRoots & (tagMask())) == 0)
+		 && (((((usqInt) (longAt(arrayOfRoots))) >> (formatShift())) & (formatMask())) == 2 /* arrayFormat */))
+		 && ((((outPointerArray & (tagMask())) == 0)
+		 && (((((usqInt) (longAt(outPointerArray))) >> (formatShift())) & (formatMask())) == 2 /* arrayFormat */))
+		 && (((segmentWordArray & (tagMask())) == 0)
+		 && (((((((usqInt) (longAt(segmentWordArray))) >> (formatShift())) & (formatMask())) >= (firstLongFormat())) && (((((usqInt) (longAt(segmentWordArray))) >> (formatShift())) & (formatMask())) <= ((firstShortFormat()) - 1)))))))) {
+		return (GIV(primFailCode) = PrimErrBadArgument);
+	}
+	fileName = cStringOrNullFor(longAt(GIV(stackPointer)));
+	if (fileName == null) {
+		if (!GIV(primFailCode)) {
+			GIV(primFailCode) = PrimErrBadArgument;
+		}
+		return 0;
+	}
+	ecode = storeImageSegmentIntooutPointersroots(segmentWordArray, outPointerArray, arrayOfRoots);
+	if (ecode != PrimNoErr) {
+		free(fileName);
+		return (GIV(primFailCode) = ecode);
+	}
+
+	/* the store scavenges, so a young segmentWordArray may since have been tenured */
+	if (isForwarded(segmentWordArray)) {
+		segmentWordArray = followForwarded(segmentWordArray);
+	}
+	f = fopen(fileName, "wb");
+	free(fileName);
+	if (f == null) {
+		return (GIV(primFailCode) = PrimErrOSError);
+	}
+	segmentBytes = numBytesOf(segmentWordArray);
+	bytesWritten = fwrite(((void *) (segmentWordArray + BaseHeaderSize)), 1, segmentBytes, f);
+	if ((fclose(f) != 0)
+	 || (bytesWritten != segmentBytes)) {
+		return (GIV(primFailCode) = PrimErrOSError);
+	}
+	shortentoIndexableSize(segmentWordArray, 2);
+	/* begin pop: */
+	GIV(stackPointer) += 4 * BytesPerWord;
+	return 0;
+}
+
 	/* InterpreterPrimitives>>#primitiveStringAt */
 static void
 primitiveStringAt(void)
@@ -40394,6 +41607,15 @@ allocateSlotsForPinningInOldSpacebytesformatclassIndex(sqInt numSlots, usqInt to
     sqInt node;
     sqInt prev;
 
+	if ((pinnedSegmentSize > 0)
+	 || (GIV(numPinnedSegments) > 0)) {
+
+		/* keep pinned objects together, away from objects compaction can move */
+		chunk = allocatePinnedChunkOfBytes(totalBytes);
+		if (!(chunk == null)) {
+			goto l27;
+		}
+	}
 	/* begin allocateOldSpaceChunkOfBytes:suchThat: */
 
 	/* be optimistic (& don't wait for the write) */
@@ -40741,6 +41963,9 @@ allocateSlotsForPinningInOldSpacebytesformatclassIndex(sqInt numSlots, usqInt to
 		if (((checkForLeaks & (GCModeFreeSpace | GCModeNewSpace)) == (GCModeFreeSpace | GCModeNewSpace))) {
 			runLeakCheckerForFreeSpace(GCModeFreeSpace);
 		}
+		if (GIV(allocationSampleInterval) > 0) {
+			sampleAllocationbytes(chunk + BaseHeaderSize, totalBytes);
+		}
 		return chunk + BaseHeaderSize;
 	}
 	longAtput(chunk, ((((((usqLong) numSlots)) << (numSlotsFullShift())) + (((sqInt)((usqInt)(formatField) << (formatShift()))))) + classIndex) | (1U << (pinnedBitShift())));
@@ -40750,6 +41975,9 @@ allocateSlotsForPinningInOldSpacebytesformatclassIndex(sqInt numSlots, usqInt to
 	if (((checkForLeaks & (GCModeFreeSpace | GCModeNewSpace)) == (GCModeFreeSpace | GCModeNewSpace))) {
 		runLeakCheckerForFreeSpace(GCModeFreeSpace);
 	}
+	if (GIV(allocationSampleInterval) > 0) {
+		sampleAllocationbytes(chunk, totalBytes);
+	}
 	return chunk;
 }
 
@@ -40764,9 +41992,18 @@ allocateSlotsInOldSpacebytesformatclassIndex(sqInt numSlots, usqInt totalBytes,
 {   DECL_MAYBE_SQ_GLOBAL_STRUCT
     sqInt chunk;
 
-	chunk = allocateOldSpaceChunkOfBytes(totalBytes);
+	chunk = null;
+	if ((largeObjectThreshold > 0)
+	 && (totalBytes >= largeObjectThreshold)) {
+
+		/* large objects get a segment of their own, which the compactor leaves in place */
+		chunk = allocateLargeObjectChunkOfBytes(totalBytes);
+	}
 	if (!(chunk)) {
-		return null;
+		chunk = allocateOldSpaceChunkOfBytes(totalBytes);
+		if (!(chunk)) {
+			return null;
+		}
 	}
 	if (numSlots >= (numSlotsMask())) {
 
@@ -40779,6 +42016,9 @@ allocateSlotsInOldSpacebytesformatclassIndex(sqInt numSlots, usqInt totalBytes,
 		if (((checkForLeaks & (GCModeFreeSpace | GCModeNewSpace)) == (GCModeFreeSpace | GCModeNewSpace))) {
 			runLeakCheckerForFreeSpace(GCModeFreeSpace);
 		}
+		if (GIV(allocationSampleInterval) > 0) {
+			sampleAllocationbytes(chunk + BaseHeaderSize, totalBytes);
+		}
 		return chunk + BaseHeaderSize;
 	}
 	longAtput(chunk, (((((usqLong) numSlots)) << (numSlotsFullShift())) + (((sqInt)((usqInt)(formatField) << (formatShift()))))) + classIndex);
@@ -40788,6 +42028,9 @@ allocateSlotsInOldSpacebytesformatclassIndex(sqInt numSlots, usqInt totalBytes,
 	if (((checkForLeaks & (GCModeFreeSpace | GCModeNewSpace)) == (GCModeFreeSpace | GCModeNewSpace))) {
 		runLeakCheckerForFreeSpace(GCModeFreeSpace);
 	}
+	if (GIV(allocationSampleInterval) > 0) {
+		sampleAllocationbytes(chunk, totalBytes);
+	}
 	return chunk;
 }
 
@@ -41208,6 +42451,9 @@ floatObjectOf(double aFloat)
 	}
 	long64Atput(newObj, (((((usqLong) numSlots)) << (numSlotsFullShift())) + (((sqInt)((usqInt)(objFormat) << (formatShift()))))) + ClassFloatCompactIndex);
 	GIV(freeStart) += numBytes;
+	if (GIV(allocationSampleInterval) > 0) {
+		sampleAllocationbytes(newObj, numBytes);
+	}
 	newFloatObj = newObj;
 	l2:	/* end eeInstantiateSmallClassIndex:format:numSlots: */;
 	storeFloatAtfrom(newFloatObj + BaseHeaderSize, aFloat);
@@ -41454,6 +42700,9 @@ instantiateClassindexableSize(sqInt classObj, usqInt nElements)
 		assert((numBytes % (allocationUnit())) == 0);
 		assert((newObj1 % (allocationUnit())) == 0);
 		GIV(freeStart) += numBytes;
+		if (GIV(allocationSampleInterval) > 0) {
+			sampleAllocationbytes(newObj1, numBytes);
+		}
 		newObj = newObj1;
 	l6:	/* end allocateSlots:format:classIndex: */;
 	}
@@ -41672,6 +42921,9 @@ shortentoIndexableSize(sqInt objOop, sqInt indexableSize)
 		return 0;
 	}
 	if (delta <= 8 /* allocationUnit */) {
+		if (oopisGreaterThanOrEqualTo(objOop, GIV(oldSpaceStart))) {
+			invalidateConcurrentMark();
+		}
 		/* begin allocateSlots:format:classIndex: */
 		formatField = (((usqInt) (longAt(objOop))) >> (formatShift())) & (formatMask());
 		classIndex1 = (longAt(objOop)) & (classIndexMask());
@@ -41768,7 +43020,11 @@ shortentoIndexableSize(sqInt objOop, sqInt indexableSize)
 	}
 	freeChunk = initFreeChunkWithBytesat(delta, addressAfter(objOop));
 	assert((addressAfter(freeChunk)) <= GIV(endOfMemory));
-	if (oopisGreaterThanOrEqualToandLessThan(objOop, GIV(oldSpaceStart), GIV(endOfMemory))) {
+
+	/* The concurrent marker may be scanning objOop at its old size, so while
+	   it runs the tail is left as a filler rather than made free. */
+	if ((oopisGreaterThanOrEqualToandLessThan(objOop, GIV(oldSpaceStart), GIV(endOfMemory)))
+	 && (!GIV(concurrentMarkInProgress))) {
 		GIV(totalFreeOldSpace) += delta;
 		addToFreeListbytes(freeChunk, delta);
 	}
@@ -41839,6 +43095,28 @@ wordIndexableFormat(void)
 	return sixtyFourBitIndexableFormat();
 }
 
+/*	Enter the carded object at index in the carded object tables into the
+	hash from carded objects to their indices, by which isCardedObject: and
+	forgetCardedObject: find them without searching the tables. The hash is
+	open, with linear probing; an entry holds an index plus one, zero being
+	empty. */
+
+	/* SpurGenerationScavenger>>#addToCardedObjectsHash: */
+static void NoDbgRegParms
+addToCardedObjectsHash(sqInt index)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    usqInt obj;
+    sqInt slot;
+
+	obj = GIV(cardedObjects)[index];
+	/* begin cardedObjectsHashStartFor: */
+	slot = ((obj >> 3) ^ (obj >> 17)) & (GIV(cardedObjectsHashSize) - 1);
+	while ((GIV(cardedObjectsHash)[slot]) != 0) {
+		slot = (slot + 1) & (GIV(cardedObjectsHashSize) - 1);
+	}
+	GIV(cardedObjectsHash)[slot] = index + 1;
+}
+
 
 /*	ephemeronCorpse is the corpse of an ephemeron that was copied and
 	forwarded. Later on its surviving copy must be scanned to nil weak
@@ -41972,6 +43250,140 @@ allNewSpaceObjectsHaveZeroRTRefCount(void)
 	return 1;
 }
 
+
+/*	Allocate the survivor age tables, one byte per allocation unit of each
+	survivor space, holding the number of scavenges survived by the object
+	whose oop is at that unit. If they cannot be allocated ages are not
+	tracked and all survivors are treated as being of age 0. */
+
+	/* SpurGenerationScavenger>>#allocateSurvivorAgeTables */
+static void
+allocateSurvivorAgeTables(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    usqInt numUnits;
+
+	numUnits = (((GIV(pastSpace).limit)) - ((GIV(pastSpace).start))) / 8 /* allocationUnit */;
+	GIV(pastSpaceAges) = calloc(numUnits, 1);
+	GIV(futureSpaceAges) = calloc(numUnits, 1);
+	if ((GIV(pastSpaceAges) == null)
+	 || (GIV(futureSpaceAges) == null)) {
+		free(GIV(pastSpaceAges));
+		free(GIV(futureSpaceAges));
+		GIV(pastSpaceAges) = (GIV(futureSpaceAges) = null);
+	}
+}
+
+/*	Answer the start of bytes for a survivor copied by a parallel scavenge
+	thread, taking it from the thread's survivor buffer, which is refilled from
+	futureSurvivorStart under the GC thread lock, or 0 if future space is full,
+	in which case the survivor is tenured. Survivors too large to share a
+	buffer are given space of their own. A buffer is never left with a
+	remainder too small to be filled; see parallelScavengeRoots. */
+
+	/* SpurGenerationScavenger>>#allocateSurvivorBytes:worker: */
+static usqInt NoDbgRegParms
+allocateSurvivorBytesworker(usqInt bytes, SpurScavengeWorker *worker)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    usqInt chunkBytes;
+    sqInt classIndex;
+    sqInt filler;
+    usqInt start;
+
+	start = (worker->survivorStart);
+	if (((start + bytes) == ((worker->survivorLimit)))
+	 || (((start + bytes) + BaseHeaderSize) < ((worker->survivorLimit)))) {
+		(worker->survivorStart = start + bytes);
+		return start;
+	}
+	if (bytes > (SurvivorCopyBufferBytes / 4)) {
+		ioLockGCThreads();
+		start = GIV(futureSurvivorStart);
+		if ((start + bytes) <= ((GIV(futureSpace).limit))) {
+			GIV(futureSurvivorStart) = start + bytes;
+		}
+		else {
+			start = 0;
+		}
+		ioUnlockGCThreads();
+		return start;
+	}
+	if (((worker->survivorLimit)) > ((worker->survivorStart))) {
+		filler = initFreeChunkWithBytesat(((worker->survivorLimit)) - ((worker->survivorStart)), (worker->survivorStart));
+		/* begin set:classIndexTo:formatTo: */
+		classIndex = sixtyFourBitLongsClassIndexPun();
+		longAtput(filler, ((longAt(filler)) & (~(usqIntptr_t)((((sqInt)((usqInt)((formatMask())) << (formatShift())))) + (classIndexMask())))) + (classIndex + (((sqInt)((usqInt)((firstLongFormat())) << (formatShift()))))));
+	}
+	(worker->survivorStart = ((worker->survivorLimit = 0)));
+	ioLockGCThreads();
+	start = GIV(futureSurvivorStart);
+	chunkBytes = ((SurvivorCopyBufferBytes < (((GIV(futureSpace).limit)) - start)) ? SurvivorCopyBufferBytes : (((GIV(futureSpace).limit)) - start));
+	if ((chunkBytes - bytes) == BaseHeaderSize) {
+		chunkBytes -= BaseHeaderSize;
+	}
+	if (chunkBytes < bytes) {
+		ioUnlockGCThreads();
+		return 0;
+	}
+	GIV(futureSurvivorStart) = start + chunkBytes;
+	ioUnlockGCThreads();
+	(worker->survivorStart = start + bytes);
+	(worker->survivorLimit = start + chunkBytes);
+	return start;
+}
+
+
+/*	Answer the start of bytes for a survivor tenured by a parallel scavenge
+	thread, taking it from the thread's tenured buffer, which is refilled from
+	the free lists under the GC thread lock. As in copyToOldSpace:bytes:format:
+	old space is grown if need be. The remainder of a buffer being replaced is
+	freed. */
+
+	/* SpurGenerationScavenger>>#allocateTenuredBytes:worker: */
+static usqInt NoDbgRegParms
+allocateTenuredBytesworker(usqInt bytes, SpurScavengeWorker *worker)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    usqInt chunkBytes;
+    usqInt remainder;
+    usqInt start;
+
+	start = (worker->tenuredStart);
+	if (((start + bytes) == ((worker->tenuredLimit)))
+	 || (((start + bytes) + BaseHeaderSize) < ((worker->tenuredLimit)))) {
+		(worker->tenuredStart = start + bytes);
+		return start;
+	}
+	chunkBytes = (bytes > (TenuredCopyBufferBytes / 4)
+		? bytes
+		: TenuredCopyBufferBytes);
+	ioLockGCThreads();
+	if ((chunkBytes != bytes)
+	 && ((remainder = ((worker->tenuredLimit)) - ((worker->tenuredStart))) > 0)) {
+		/* begin addFreeChunkWithBytes:at: */
+		GIV(totalFreeOldSpace) += remainder;
+		freeChunkWithBytesat(remainder, (worker->tenuredStart));
+		(worker->tenuredStart = ((worker->tenuredLimit = 0)));
+	}
+	start = allocateOldSpaceChunkOfBytes(chunkBytes);
+	if ((!start)
+	 && (chunkBytes != bytes)) {
+		chunkBytes = bytes;
+		start = allocateOldSpaceChunkOfBytes(chunkBytes);
+	}
+	if (!start) {
+		growOldSpaceByAtLeast(0);
+		start = allocateOldSpaceChunkOfBytes(chunkBytes);
+		if (!start) {
+			error("out of memory");
+		}
+	}
+	ioUnlockGCThreads();
+	if (chunkBytes != bytes) {
+		(worker->tenuredStart = start + bytes);
+		(worker->tenuredLimit = start + chunkBytes);
+	}
+	return start;
+}
+
 	/* SpurGenerationScavenger>>#allWeakSurvivorsOnWeakList */
 static sqInt
 allWeakSurvivorsOnWeakList(void)
@@ -42018,7 +43430,122 @@ allWeakSurvivorsOnWeakList(void)
 	return 1;
 }
 
+/*	Answer the index of objOop in the carded object tables, or -1 if it has
+	none. */
 
+	/* SpurGenerationScavenger>>#cardedObjectIndexOf: */
+static sqInt NoDbgRegParms
+cardedObjectIndexOf(sqInt objOop)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt slot;
+
+	slot = cardedObjectsHashSlotOf(objOop);
+	return (slot < 0
+		? -1
+		: (GIV(cardedObjectsHash)[slot]) - 1);
+}
+
+
+/*	Answer the slot of objOop in the carded objects hash, or -1 if it is not
+	there. */
+
+	/* SpurGenerationScavenger>>#cardedObjectsHashSlotOf: */
+static sqInt NoDbgRegParms
+cardedObjectsHashSlotOf(sqInt objOop)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt entry;
+    sqInt slot;
+
+	if (GIV(cardedObjectsHashSize) == 0) {
+		return -1;
+	}
+	/* begin cardedObjectsHashStartFor: */
+	slot = ((((usqInt) objOop) >> 3) ^ (((usqInt) objOop) >> 17)) & (GIV(cardedObjectsHashSize) - 1);
+	while (((entry = GIV(cardedObjectsHash)[slot])) != 0) {
+		if ((GIV(cardedObjects)[entry - 1]) == objOop) {
+			return slot;
+		}
+		slot = (slot + 1) & (GIV(cardedObjectsHashSize) - 1);
+	}
+	return -1;
+}
+
+
+
+/*	With card marking, move large remembered pointer objects out of the
+	remembered set once a scavenge is complete, noting which of their cards
+	(runs of SlotsPerCard slots) still refer to new space. Subsequent
+	scavenges scan only those cards. Storing a new object into a carded
+	object remembers it again, since its remembered bit is clear, in which
+	case it is scanned in full. An object stored into while carded is not
+	carded again until it has been left in the remembered set for a number
+	of scavenges that doubles each time this happens (see
+	scavengeCardedObjects), so that objects stored into every cycle are not
+	scanned in full and carded afresh at every scavenge. */
+
+	/* SpurGenerationScavenger>>#cardLargeRememberedObjects */
+static void
+cardLargeRememberedObjects(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    unsigned char *cards;
+    sqInt entry;
+    sqInt i;
+    sqInt index;
+    sqInt numCards;
+    usqInt numSlots;
+    sqInt obj;
+    sqInt referent;
+
+	index = 0;
+	while (index < GIV(rememberedSetSize)) {
+		obj = GIV(rememberedSet)[index];
+		cards = null;
+		if (((((usqInt) (longAt(obj))) >> (formatShift())) & (formatMask())) <= 2 /* arrayFormat */) {
+			numSlots = numSlotsOf(obj);
+			if (numSlots >= MinSlotsForCardMarking) {
+				numCards = (numSlots + (SlotsPerCard - 1)) / SlotsPerCard;
+				entry = (GIV(numCardedObjects) > 0
+					? cardedObjectIndexOf(obj)
+					: -1);
+				if (entry >= 0) {
+					if ((GIV(cardedObjectSkips)[entry]) == 0) {
+						cards = calloc(numCards, 1);
+					}
+				}
+				else {
+					if ((ensureCardedObjectsCapacity(GIV(numCardedObjects) + 1))
+					 && (((cards = calloc(numCards, 1))) != null)) {
+						entry = GIV(numCardedObjects);
+						GIV(cardedObjects)[entry] = obj;
+						GIV(cardedObjectSkips)[entry] = 0;
+						GIV(cardedObjectBackoffs)[entry] = 0;
+						GIV(numCardedObjects) += 1;
+						addToCardedObjectsHash(entry);
+					}
+				}
+			}
+		}
+		if (cards == null) {
+			index += 1;
+		}
+		else {
+			for (i = 0; i < numSlots; i += 1) {
+				referent = longAt((obj + BaseHeaderSize) + (((sqInt)((usqInt)(i) << (shiftForWord())))));
+				if (((referent & (tagMask())) == 0)
+				 && ((oopisLessThan(referent, GIV(newSpaceLimit)))
+				 && (oopisGreaterThanOrEqualTo(referent, GIV(newSpaceStart))))) {
+					cards[i / SlotsPerCard] = 1;
+				}
+			}
+			GIV(cardedObjectCards)[entry] = cards;
+			GIV(cardedObjectNumCards)[entry] = numCards;
+			/* begin setIsRememberedOf:to: */
+			longAtput(obj, (longAt(obj)) & (~(usqIntptr_t)(1U << (rememberedBitShift()))));
+			GIV(rememberedSetSize) -= 1;
+			GIV(rememberedSet)[index] = (GIV(rememberedSet)[GIV(rememberedSetSize)]);
+		}
+	}
+}
 /*	Some time in every scavenger's life there may come a time when someone
 	writes code that stresses
 	the remembered table. One might conclude that if the remembered table is
@@ -42140,6 +43667,7 @@ computeRefCountToShrinkRT(void)
 static sqInt NoDbgRegParms
 copyAndForwardMourner(sqInt mourner)
 {   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt age;
     usqInt bytesInObj;
     sqInt classIndex;
     sqInt format;
@@ -42182,6 +43710,14 @@ copyAndForwardMourner(sqInt mourner)
 			longAtput(newStart + (mourner - startOfSurvivor), header);
 		}
 		newLocation = newStart + (mourner - startOfSurvivor);
+		if (GIV(futureSpaceAges) != null) {
+			/* begin survivorAgeOf: */
+			age = ((mourner >= ((GIV(pastSpace).start)))
+			 && (mourner < ((GIV(pastSpace).limit)))
+				? GIV(pastSpaceAges)[(mourner - ((GIV(pastSpace).start))) / 8 /* allocationUnit */]
+				: 0);
+			GIV(futureSpaceAges)[(newLocation - ((GIV(futureSpace).start))) / 8 /* allocationUnit */] = (age < MaxSurvivorAge ? age + 1 : MaxSurvivorAge);
+		}
 	}
 	/* begin forwardSurvivor:to: */
 	assert(isInNewSpace(mourner));
@@ -42210,6 +43746,7 @@ copyAndForwardMourner(sqInt mourner)
 static sqInt NoDbgRegParms
 copyAndForward(sqInt survivor)
 {   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt age;
     usqInt bytesInObj;
     sqInt classIndex;
     sqInt format;
@@ -42223,12 +43760,21 @@ copyAndForward(sqInt survivor)
 	 || (isInPastSpace(survivor)));
 	bytesInObj = bytesInObject(survivor);
 	format = (((usqInt) (longAt(survivor))) >> (formatShift())) & (formatMask());
+	/* begin survivorAgeOf: */
+	age = ((GIV(pastSpaceAges) != null)
+	 && ((survivor >= ((GIV(pastSpace).start)))
+	 && (survivor < ((GIV(pastSpace).limit))))
+		? GIV(pastSpaceAges)[(survivor - ((GIV(pastSpace).start))) / 8 /* allocationUnit */]
+		: 0);
+	GIV(survivorBytesByAge)[age] += bytesInObj;
 
 	/* Allow Slang to inline. */
 	
 	switch (GIV(tenureCriterion)) {
 	case TenureByAge:
-		tenure = survivor < GIV(tenureThreshold);
+		tenure = (tenuringAge > 0
+			? age >= tenuringAge
+			: survivor < GIV(tenureThreshold));
 
 		break;
 	case TenureByClass:
@@ -42268,6 +43814,9 @@ copyAndForward(sqInt survivor)
 			longAtput(newStart + (survivor - startOfSurvivor), header);
 		}
 		newLocation = newStart + (survivor - startOfSurvivor);
+		if (GIV(futureSpaceAges) != null) {
+			GIV(futureSpaceAges)[(newLocation - ((GIV(futureSpace).start))) / 8 /* allocationUnit */] = (age < MaxSurvivorAge ? age + 1 : MaxSurvivorAge);
+		}
 	}
 	/* begin forwardSurvivor:to: */
 	assert(isInNewSpace(survivor));
@@ -42342,9 +43891,11 @@ copyToOldSpacebytesformat(sqInt survivor, sqInt bytesInObject, sqInt formatOfSur
 			/* begin setIsMarkedOf:to: */
 			assert(!(isFreeObject(newOop)));
 			longAtput(newOop, (longAt(newOop)) | (1ULL << (markedBitFullShift())));
+			noteLiveBytesof(bytesInObject, newOop);
 		}
 	}
 	GIV(statTenures) = nTenures + 1;
+	GIV(statTenuredBytes) += bytesInObject;
 	if ((formatOfSurvivor <= 5 /* lastPointerFormat */)
 	 || (formatOfSurvivor >= (firstCompiledMethodFormat()))) {
 
@@ -42367,6 +43918,143 @@ copyToOldSpacebytesformat(sqInt survivor, sqInt bytesInObject, sqInt formatOfSur
 	return newOop;
 }
 
+/*	Ensure the carded object tables, and their hash, can hold numEntries.
+	Answer false if they could not be grown, in which case large objects stay
+	in the remembered set. The hash is kept at most half full. */
+
+	/* SpurGenerationScavenger>>#ensureCardedObjectsCapacity: */
+static sqInt NoDbgRegParms
+ensureCardedObjectsCapacity(sqInt numEntries)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt *backoffs;
+    unsigned char **cards;
+    sqInt capacity;
+    sqInt *hash;
+    sqInt hashSize;
+    sqInt *numCards;
+    sqInt *objects;
+    sqInt *skips;
+
+	if (numEntries <= GIV(cardedObjectsCapacity)) {
+		return 1;
+	}
+	capacity = (numEntries * 2 < 64 ? 64 : numEntries * 2);
+	objects = realloc(GIV(cardedObjects), capacity * BytesPerOop);
+	if (objects == null) {
+		return 0;
+	}
+	GIV(cardedObjects) = objects;
+	cards = realloc(GIV(cardedObjectCards), capacity * sizeof(unsigned char *));
+	if (cards == null) {
+		return 0;
+	}
+	GIV(cardedObjectCards) = cards;
+	numCards = realloc(GIV(cardedObjectNumCards), capacity * BytesPerOop);
+	if (numCards == null) {
+		return 0;
+	}
+	GIV(cardedObjectNumCards) = numCards;
+	skips = realloc(GIV(cardedObjectSkips), capacity * BytesPerOop);
+	if (skips == null) {
+		return 0;
+	}
+	GIV(cardedObjectSkips) = skips;
+	backoffs = realloc(GIV(cardedObjectBackoffs), capacity * BytesPerOop);
+	if (backoffs == null) {
+		return 0;
+	}
+	GIV(cardedObjectBackoffs) = backoffs;
+	hashSize = 128;
+	while (hashSize < (capacity * 2)) {
+		hashSize = hashSize * 2;
+	}
+	hash = malloc(hashSize * BytesPerOop);
+	if (hash == null) {
+		return 0;
+	}
+	free(GIV(cardedObjectsHash));
+	GIV(cardedObjectsHash) = hash;
+	GIV(cardedObjectsHashSize) = hashSize;
+	GIV(cardedObjectsCapacity) = capacity;
+	rehashCardedObjects();
+	return 1;
+}
+
+/*	Ensure the parallel remembered set scan list and results can hold
+	numEntries. Answer false if they could not be allocated, in which case
+	the remembered set is scanned serially. */
+
+	/* SpurGenerationScavenger>>#ensureRememberedSetScanCapacity: */
+static sqInt NoDbgRegParms
+ensureRememberedSetScanCapacity(sqInt numEntries)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt capacity;
+    sqInt *list;
+    unsigned char *results;
+
+	if (numEntries <= GIV(rememberedSetScanCapacity)) {
+		return 1;
+	}
+	capacity = numEntries * 2;
+	list = realloc(GIV(rememberedSetScanList), capacity * BytesPerOop);
+	if (list == null) {
+		return 0;
+	}
+	GIV(rememberedSetScanList) = list;
+	results = realloc(GIV(rememberedSetScanResults), capacity);
+	if (results == null) {
+		return 0;
+	}
+	GIV(rememberedSetScanResults) = results;
+	GIV(rememberedSetScanCapacity) = capacity;
+	return 1;
+}
+
+/*	Ensure there is a SpurScavengeWorker, with its gray stack and deferred
+	list, for each of numWorkers GC threads, and reset each for a scavenge.
+	Answer false if they could not be allocated, in which case the scavenge
+	runs serially. */
+
+	/* SpurGenerationScavenger>>#ensureScavengeWorkers: */
+static sqInt NoDbgRegParms
+ensureScavengeWorkers(sqInt numWorkers)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt i;
+    SpurScavengeWorker *worker;
+    SpurScavengeWorker *workers;
+
+	if (numWorkers > GIV(scavengeWorkersCapacity)) {
+		workers = realloc(GIV(scavengeWorkers), numWorkers * sizeof(SpurScavengeWorker));
+		if (workers == null) {
+			return 0;
+		}
+		memset(workers + GIV(scavengeWorkersCapacity), 0, (numWorkers - GIV(scavengeWorkersCapacity)) * sizeof(SpurScavengeWorker));
+		GIV(scavengeWorkers) = workers;
+		GIV(scavengeWorkersCapacity) = numWorkers;
+	}
+	for (i = 0; i < numWorkers; i += 1) {
+		worker = (&(GIV(scavengeWorkers)[i]));
+		if (((worker->grayStack)) == null) {
+			if (((worker->grayStack = malloc((ScavengeGrayShareThreshold * 4) * BytesPerOop))) == null) {
+				return 0;
+			}
+			(worker->grayCapacity = ScavengeGrayShareThreshold * 4);
+		}
+		if (((worker->deferred)) == null) {
+			if (((worker->deferred = malloc(ScavengeGrayShareThreshold * BytesPerOop))) == null) {
+				return 0;
+			}
+			(worker->deferredCapacity = ScavengeGrayShareThreshold);
+		}
+		(worker->survivorStart = ((worker->survivorLimit = 0)));
+		(worker->tenuredStart = ((worker->tenuredLimit = 0)));
+		(worker->grayTop = ((worker->numDeferred = 0)));
+		(worker->statSurvivorCount = ((worker->statTenures = ((worker->statTenuredBytes = 0)))));
+		memset((worker->survivorBytesByAge), 0, sizeof((worker->survivorBytesByAge)));
+	}
+	return 1;
+}
+
 	/* SpurGenerationScavenger>>#firstCorpse: */
 static usqInt NoDbgRegParms
 firstCorpse(sqInt headOfCorpseList)
@@ -42375,6 +44063,57 @@ firstCorpse(sqInt headOfCorpseList)
 	return (((sqInt)((usqInt)((headOfCorpseList - 1)) << 3 /* shiftForAllocationUnit */))) + GIV(newSpaceStart);
 }
 
+
+/*	Put the carded objects back in the remembered set. This is done before
+	anything that may move or replace old objects, i.e. full GCs and become,
+	both of which maintain the remembered set but know nothing of cards. */
+
+	/* SpurGenerationScavenger>>#flushCardedObjects */
+static void
+flushCardedObjects(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt i;
+    sqInt obj;
+
+	for (i = 0; i < GIV(numCardedObjects); i += 1) {
+		obj = GIV(cardedObjects)[i];
+		if (!((((longAt(obj)) & ((classIndexMask()) - (isForwardedObjectClassIndexPun()))) == 0)
+			 || (((((usqInt) (longAt(obj))) >> (rememberedBitShift())) & 1) != 0))) {
+			remember(obj);
+		}
+		free(GIV(cardedObjectCards)[i]);
+	}
+	GIV(numCardedObjects) = 0;
+	rehashCardedObjects();
+}
+
+
+/*	Remove objOop, which is being freed, from the carded objects. */
+
+	/* SpurGenerationScavenger>>#forgetCardedObject: */
+static void NoDbgRegParms
+forgetCardedObject(sqInt objOop)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt i;
+    sqInt last;
+
+	i = cardedObjectIndexOf(objOop);
+	if (i < 0) {
+		return;
+	}
+	removeFromCardedObjectsHash(objOop);
+	free(GIV(cardedObjectCards)[i]);
+	last = (GIV(numCardedObjects) -= 1);
+	if (i < last) {
+		GIV(cardedObjects)[i] = (GIV(cardedObjects)[last]);
+		GIV(cardedObjectCards)[i] = (GIV(cardedObjectCards)[last]);
+		GIV(cardedObjectNumCards)[i] = (GIV(cardedObjectNumCards)[last]);
+		GIV(cardedObjectSkips)[i] = (GIV(cardedObjectSkips)[last]);
+		GIV(cardedObjectBackoffs)[i] = (GIV(cardedObjectBackoffs)[last]);
+		GIV(cardedObjectsHash)[cardedObjectsHashSlotOf(GIV(cardedObjects)[i])] = i + 1;
+	}
+}
+
 	/* SpurGenerationScavenger>>#growRememberedSet */
 static void
 growRememberedSet(void)
@@ -42472,9 +44211,11 @@ growRememberedSet(void)
 		/* begin setIsMarkedOf:to: */
 		assert(!(isFreeObject(newObj)));
 		longAtput(newObj, (longAt(newObj)) | (1ULL << (markedBitFullShift())));
+		noteLiveBytesof(bytesInObject(newObj), newObj);
 		/* begin setIsMarkedOf:to: */
 		assert(!(isFreeObject(obj)));
 		longAtput(obj, (longAt(obj)) & (~(usqIntptr_t)(1ULL << (markedBitFullShift()))));
+		noteLiveBytesof(-(bytesInObject(obj)), obj);
 	}
 	freeObject(obj);
 	GIV(rememberedSet) = base;
@@ -42489,6 +44230,17 @@ growRememberedSet(void)
 	GIV(rememberedSetRedZone) = ((((GIV(rememberedSetLimit) * 3) / 4) < fudge) ? fudge : ((GIV(rememberedSetLimit) * 3) / 4));
 }
 
+	/* SpurGenerationScavenger>>#isCardedObject: */
+static sqInt NoDbgRegParms
+isCardedObject(sqInt objOop)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt i;
+
+	i = cardedObjectIndexOf(objOop);
+	return (i >= 0)
+	 && ((GIV(cardedObjectCards)[i]) != null);
+}
+
 	/* SpurGenerationScavenger>>#isInRememberedSet: */
 static sqInt NoDbgRegParms
 isInRememberedSet(sqInt objOop)
@@ -42650,6 +44402,458 @@ openScavengeLog(void)
 }
 
 
+
+/*	The parallel analogue of copyAndForward:. Claim survivor by swapping its
+	header for one with the being-copied pun, so that exactly one thread
+	copies it, into that thread's survivor or tenured buffer. Publish the copy
+	by storing the forwarding pointer, fencing, and only then storing the
+	forwarded header; a thread that loses the race waits for the forwarded
+	header and answers the forwarding pointer. Pointer objects whose referents
+	can be scanned without regard to their class are pushed on the thread's
+	gray stack. Contexts, weaklings, ephemerons and methods are deferred to
+	the VM thread, which has to maintain the weakList and ephemeronList and
+	the stack pages' trace flags. */
+
+	/* SpurGenerationScavenger>>#parallelCopyAndForward:worker: */
+static sqInt NoDbgRegParms
+parallelCopyAndForwardworker(sqInt survivor, SpurScavengeWorker *worker)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt age;
+    usqInt bytesInObj;
+    sqInt classIndex;
+    sqInt format;
+    sqInt header;
+    sqInt newLocation;
+    usqInt newStart;
+    usqInt startOfSurvivor;
+    sqInt tenure;
+
+	assert((isInEden(survivor))
+	 || (isInPastSpace(survivor)));
+	while (1) {
+		header = longAt(survivor);
+		if ((header & ((classIndexMask()) - (isForwardedObjectClassIndexPun()))) == 0) {
+			sqLowLevelMFence();
+			/* begin fetchPointer:ofMaybeForwardedObject: */
+			return longAt((survivor + BaseHeaderSize) + (0U << (shiftForWord())));
+		}
+		if ((header & (classIndexMask())) == (isBeingCopiedObjectClassIndexPun())) {
+			sqLowLevelMFence();
+		}
+		else {
+			if (sqCompareAndSwap((*((sqInt *) survivor)), header, (header & (~(usqIntptr_t)(classIndexMask()))) + (isBeingCopiedObjectClassIndexPun()))) break;
+		}
+	}
+	bytesInObj = bytesInObject(survivor);
+	format = (((usqInt) header) >> (formatShift())) & (formatMask());
+	/* begin survivorAgeOf: */
+	age = ((GIV(pastSpaceAges) != null)
+	 && ((survivor >= ((GIV(pastSpace).start)))
+	 && (survivor < ((GIV(pastSpace).limit))))
+		? GIV(pastSpaceAges)[(survivor - ((GIV(pastSpace).start))) / 8 /* allocationUnit */]
+		: 0);
+	(worker->survivorBytesByAge)[age] += bytesInObj;
+	tenure = (GIV(tenureCriterion) == TenureByAge
+		? (tenuringAge > 0
+				? age >= tenuringAge
+				: survivor < GIV(tenureThreshold))
+		: (header & (classIndexMask())) == GIV(tenuringClassIndex));
+	startOfSurvivor = ((byteAt(survivor + 7)) == (numSlotsMask())
+		? survivor - BaseHeaderSize
+		: survivor);
+	newStart = (tenure
+		? 0
+		: allocateSurvivorBytesworker(bytesInObj, worker));
+	if (newStart) {
+		(worker->statSurvivorCount += 1);
+	}
+	else {
+		newStart = allocateTenuredBytesworker(bytesInObj, worker);
+		(worker->statTenures += 1);
+		(worker->statTenuredBytes += bytesInObj);
+	}
+	memcpy(((void *)newStart), ((void *)startOfSurvivor), bytesInObj);
+	newLocation = newStart + (survivor - startOfSurvivor);
+	longAtput(newLocation, header);
+	if ((GIV(futureSpaceAges) != null)
+	 && (oopisGreaterThanOrEqualToandLessThan(newLocation, ((GIV(futureSpace).start)), ((GIV(futureSpace).limit))))) {
+		GIV(futureSpaceAges)[(newLocation - ((GIV(futureSpace).start))) / 8 /* allocationUnit */] = (age < MaxSurvivorAge ? age + 1 : MaxSurvivorAge);
+	}
+	/* begin forwardSurvivor:to: */
+	longAtput((survivor + BaseHeaderSize) + (0U << (shiftForWord())), newLocation);
+	sqLowLevelMFence();
+	/* begin set:classIndexTo:formatTo: */
+	classIndex = isForwardedObjectClassIndexPun();
+	longAtput(survivor, (header & (~(usqIntptr_t)((((sqInt)((usqInt)((formatMask())) << (formatShift())))) + (classIndexMask())))) + (classIndex + (7U << (formatShift()))));
+	if ((format <= 2 /* arrayFormat */)
+	 || ((format == (indexablePointersFormat()))
+	 && ((header & (classIndexMask())) != ClassMethodContextCompactIndex))) {
+		pushScavengeGrayObjectworker(newLocation, worker);
+	}
+	else {
+		if ((format <= 5 /* lastPointerFormat */)
+		 || (format >= (firstCompiledMethodFormat()))) {
+			pushScavengeDeferredObjectworker(survivor, worker);
+		}
+	}
+	return newLocation;
+}
+
+
+/*	Scavenge the referents of the objects on worker's gray stack until it is
+	empty. Whenever the shared pool has run dry give it half of the stack, so
+	that idle threads have something to do. Tenured objects that still refer
+	to new space are remembered. */
+
+	/* SpurGenerationScavenger>>#parallelScavengeGrayStack: */
+static void NoDbgRegParms
+parallelScavengeGrayStack(SpurScavengeWorker *worker)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt numShared;
+    usqInt numSlots;
+    usqInt numSlots1;
+    sqInt obj;
+    sqInt *pool;
+
+	while (((worker->grayTop)) > 0) {
+		if ((((worker->grayTop)) > ScavengeGrayShareThreshold)
+		 && (GIV(scavengeGrayPoolCount) == 0)) {
+			ioLockGCThreads();
+			numShared = ((worker->grayTop)) / 2;
+			if ((GIV(scavengeGrayPoolCount) + numShared) > GIV(scavengeGrayPoolCapacity)) {
+				pool = realloc(GIV(scavengeGrayPool), ((GIV(scavengeGrayPoolCount) + numShared) * 2) * BytesPerOop);
+				if (pool != null) {
+					GIV(scavengeGrayPool) = pool;
+					GIV(scavengeGrayPoolCapacity) = (GIV(scavengeGrayPoolCount) + numShared) * 2;
+				}
+			}
+			if ((GIV(scavengeGrayPoolCount) + numShared) <= GIV(scavengeGrayPoolCapacity)) {
+				(worker->grayTop -= numShared);
+				memcpy(GIV(scavengeGrayPool) + GIV(scavengeGrayPoolCount), ((worker->grayStack)) + ((worker->grayTop)), numShared * BytesPerOop);
+				GIV(scavengeGrayPoolCount) += numShared;
+			}
+			ioUnlockGCThreads();
+		}
+		obj = ((worker->grayStack))[(worker->grayTop -= 1)];
+		/* begin numSlotsOf: */
+		numSlots1 = byteAt(obj + 7);
+		numSlots = (numSlots1 == (numSlotsMask())
+			? ((usqInt) (((usqInt)(((sqInt)((usqInt)((longAt(obj - BaseHeaderSize))) << 8)))))) >> 8
+			: numSlots1);
+		if ((parallelScavengeReferentsOfnumSlotsworker(obj, numSlots, worker))
+		 && (!((oopisLessThan(obj, GIV(newSpaceLimit)))
+		 && (oopisGreaterThanOrEqualTo(obj, GIV(newSpaceStart)))))) {
+			ioLockGCThreads();
+			remember(obj);
+			ioUnlockGCThreads();
+		}
+	}
+}
+
+
+/*	The parallel analogue of the referent handling in scavengeReferentsOf:.
+	Answer the location of referent once scavenged, following forwarders and
+	copying young objects not yet in future space. During the parallel phase
+	any pointer into future space is to a survivor that has been copied, so
+	the test is against the whole of future space; futureSurvivorStart lags
+	behind the other threads' copying. */
+
+	/* SpurGenerationScavenger>>#parallelScavengeReferent:worker: */
+static sqInt NoDbgRegParms
+parallelScavengeReferentworker(sqInt referent, SpurScavengeWorker *worker)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt target;
+
+	target = referent;
+	while (((target & (tagMask())) == 0)
+	 && (((longAt(target)) & ((classIndexMask()) - (isForwardedObjectClassIndexPun()))) == 0)) {
+		sqLowLevelMFence();
+		/* begin fetchPointer:ofMaybeForwardedObject: */
+		target = longAt((target + BaseHeaderSize) + (0U << (shiftForWord())));
+	}
+	if (((target & (tagMask())) == 0)
+	 && ((oopisLessThan(target, GIV(newSpaceLimit)))
+	 && ((oopisGreaterThanOrEqualTo(target, GIV(newSpaceStart)))
+	 && (!(oopisGreaterThanOrEqualToandLessThan(target, ((GIV(futureSpace).start)), ((GIV(futureSpace).limit)))))))) {
+		return parallelCopyAndForwardworker(target, worker);
+	}
+	return target;
+}
+
+
+/*	Scavenge the first numSlots referents of referrer, a pointer object owned
+	by this thread, answering whether it still refers to new space. */
+
+	/* SpurGenerationScavenger>>#parallelScavengeReferentsOf:numSlots:worker: */
+static sqInt NoDbgRegParms
+parallelScavengeReferentsOfnumSlotsworker(sqInt referrer, usqInt numSlots, SpurScavengeWorker *worker)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt foundNewReferent;
+    usqInt i;
+    sqInt newLocation;
+    sqInt referent;
+
+	foundNewReferent = 0;
+	for (i = 0; i < numSlots; i += 1) {
+		referent = longAt((referrer + BaseHeaderSize) + (((sqInt)((usqInt)(i) << (shiftForWord())))));
+		if ((referent & (tagMask())) == 0) {
+			newLocation = parallelScavengeReferentworker(referent, worker);
+			if (newLocation != referent) {
+				longAtput((referrer + BaseHeaderSize) + (((sqInt)((usqInt)(i) << (shiftForWord())))), newLocation);
+			}
+			if (((newLocation & (tagMask())) == 0)
+			 && ((oopisLessThan(newLocation, GIV(newSpaceLimit)))
+			 && (oopisGreaterThanOrEqualTo(newLocation, GIV(newSpaceStart))))) {
+				foundNewReferent = 1;
+			}
+		}
+	}
+	return foundNewReferent;
+}
+
+
+/*	Scavenge the remembered set, the stack pages and everything reachable
+	from them with ioNumGCThreads() threads; see parallelScavengeWorker:arg:.
+	Each thread copies into its own buffers in future space and old space and
+	forwards with a compare and swap of the header, so no lock is held while
+	copying. When the threads are done, fill or free what remains of their
+	buffers, sum their statistics, and, on the VM thread, compact the
+	remembered set and scavenge the remembered objects and survivors the
+	threads deferred. Answer the address in future space up to which
+	survivors have been scanned, from which scavengeLoop continues. Entries
+	remembered by the threads have been scanned and so precede
+	previousRememberedSetSize; those remembered here follow it. */
+
+	/* SpurGenerationScavenger>>#parallelScavengeRoots */
+static sqInt
+parallelScavengeRoots(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt age;
+    sqInt classIndex;
+    sqInt corpse;
+    sqInt destIndex;
+    sqInt field;
+    sqInt filler;
+    sqInt fmt;
+    sqInt i;
+    sqInt j;
+    sqInt newLocation;
+    sqInt numEntries;
+    sqInt numLivePages;
+    sqInt numWorkers;
+    usqInt p;
+    sqInt phaseEnd;
+    sqInt referrer;
+    usqInt remainder;
+    sqInt scannedLimit;
+    StackPage *thePage;
+    SpurScavengeWorker *worker;
+
+	numEntries = GIV(rememberedSetSize);
+	GIV(rememberedSetScanCount) = numEntries;
+	GIV(rememberedSetScanNext) = 0;
+	if (numEntries > 0) {
+		memcpy(GIV(rememberedSetScanList), GIV(rememberedSet), numEntries * BytesPerOop);
+	}
+	GIV(scavengeStackPageNext) = 0;
+	GIV(scavengeWorkersStarted) = (GIV(scavengeWorkersIdle) = 0);
+	GIV(scavengeGrayPoolCount) = 0;
+	numWorkers = ioNumGCThreads();
+	ioGCThreadsDo(parallelScavengeWorkerarg, 0);
+	GIV(stackPagesScavenged) = 1;
+	for (i = 0; i < numWorkers; i += 1) {
+		worker = (&(GIV(scavengeWorkers)[i]));
+		if (((worker->survivorLimit)) > ((worker->survivorStart))) {
+			filler = initFreeChunkWithBytesat(((worker->survivorLimit)) - ((worker->survivorStart)), (worker->survivorStart));
+			/* begin set:classIndexTo:formatTo: */
+			classIndex = sixtyFourBitLongsClassIndexPun();
+			longAtput(filler, ((longAt(filler)) & (~(usqIntptr_t)((((sqInt)((usqInt)((formatMask())) << (formatShift())))) + (classIndexMask())))) + (classIndex + (((sqInt)((usqInt)((firstLongFormat())) << (formatShift()))))));
+		}
+		if (((remainder = ((worker->tenuredLimit)) - ((worker->tenuredStart)))) > 0) {
+			/* begin addFreeChunkWithBytes:at: */
+			GIV(totalFreeOldSpace) += remainder;
+			freeChunkWithBytesat(remainder, (worker->tenuredStart));
+		}
+		GIV(statSurvivorCount) += (worker->statSurvivorCount);
+		GIV(statTenures) += (worker->statTenures);
+		GIV(statTenuredBytes) += (worker->statTenuredBytes);
+		for (age = 0; age <= MaxSurvivorAge; age += 1) {
+			GIV(survivorBytesByAge)[age] += ((worker->survivorBytesByAge))[age];
+		}
+	}
+	numLivePages = 0;
+	for (i = 0; i < GIV(numStackPages); i += 1) {
+		/* begin stackPageAt: */
+		thePage = stackPageAtpages(i, GIV(pages));
+		if (!(((thePage->baseFP)) == 0)) {
+			numLivePages += 1;
+		}
+	}
+	/* begin recordLivePagesOnMapping: */
+	GIV(statNumMaps) += 1;
+	GIV(statPageCountWhenMappingSum) += numLivePages;
+	GIV(statMaxPageCountWhenMapping) = ((GIV(statMaxPageCountWhenMapping) < numLivePages) ? numLivePages : GIV(statMaxPageCountWhenMapping));
+	scannedLimit = GIV(futureSurvivorStart);
+	phaseEnd = GIV(rememberedSetSize);
+	destIndex = 0;
+	for (i = 0; i < numEntries; i += 1) {
+		referrer = GIV(rememberedSetScanList)[i];
+		if ((GIV(rememberedSetScanResults)[i]) == RememberedSetScanRetained) {
+			GIV(rememberedSet)[destIndex] = referrer;
+			destIndex += 1;
+		}
+		else {
+			if ((GIV(rememberedSetScanResults)[i]) == RememberedSetScanDropped) {
+				/* begin setIsRememberedOf:to: */
+				longAtput(referrer, (longAt(referrer)) & (~(usqIntptr_t)(1U << (rememberedBitShift()))));
+			}
+			else {
+				destIndex = scavengeRememberedReferrerdestIndex(referrer, destIndex);
+			}
+		}
+	}
+	memmove(GIV(rememberedSet) + destIndex, GIV(rememberedSet) + numEntries, (GIV(rememberedSetSize) - numEntries) * BytesPerOop);
+	GIV(previousRememberedSetSize) = destIndex + (phaseEnd - numEntries);
+	GIV(rememberedSetSize) = destIndex + (GIV(rememberedSetSize) - numEntries);
+	for (i = 0; i < numWorkers; i += 1) {
+		worker = (&(GIV(scavengeWorkers)[i]));
+		for (j = 0; j < ((worker->numDeferred)); j += 1) {
+			corpse = ((worker->deferred))[j];
+			/* begin fetchPointer:ofMaybeForwardedObject: */
+			newLocation = longAt((corpse + BaseHeaderSize) + (0U << (shiftForWord())));
+			fmt = (((usqInt) (longAt(newLocation))) >> (formatShift())) & (formatMask());
+			if (fmt == (weakArrayFormat())) {
+				addToWeakList(corpse);
+			}
+			if ((fmt == 5 /* ephemeronFormat */)
+			 && (!(isScavengeSurvivor(longAt((newLocation + BaseHeaderSize) + (0U << (shiftForWord()))))))) {
+				addToEphemeronList(corpse);
+			}
+			if (oopisLessThan(newLocation, GIV(newSpaceLimit))) {
+				((void) (scavengeReferentsOf(newLocation)));
+			}
+			else {
+
+				/* As in copyToOldSpace:bytes:format:, a quick scan for young referents. */
+				for (p = BaseHeaderSize; p < (bytesInObject(newLocation) - (newLocation - (((byteAt(newLocation + 7)) == (numSlotsMask())
+	? newLocation - BaseHeaderSize
+	: newLocation)))); p += BytesPerWord) {
+					field = longAt(newLocation + p);
+					if (((field & (tagMask())) == 0)
+					 && ((oopisLessThan(field, GIV(newSpaceLimit)))
+					 && (oopisGreaterThanOrEqualTo(field, GIV(newSpaceStart))))) {
+						remember(newLocation);
+						break;
+					}
+				}
+			}
+		}
+	}
+	return scannedLimit;
+}
+
+
+/*	The work of each GC thread in a parallel scavenge. Claim chunks of the
+	remembered set scan list, and then stack pages, until both are exhausted,
+	recording whether each remembered object is to be retained, dropped or
+	deferred to the VM thread, and draining the gray stack of the survivors
+	copied after each. Then share work through scavengeGrayPool until every
+	thread that has started is idle and the pool is empty. A thread that
+	starts late finds nothing left to claim and finishes at once. */
+
+	/* SpurGenerationScavenger>>#parallelScavengeWorker:arg: */
+static void
+parallelScavengeWorkerarg(sqInt workerIndex, void *unused)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt fmt;
+    sqInt i;
+    sqInt limit;
+    sqInt numTaken;
+    usqInt numSlots;
+    usqInt numSlots1;
+    sqInt pageIndex;
+    sqInt referrer;
+    sqInt *stack;
+    sqInt start;
+    StackPage *thePage;
+    SpurScavengeWorker *worker;
+
+	worker = (&(GIV(scavengeWorkers)[workerIndex]));
+	ioLockGCThreads();
+	GIV(scavengeWorkersStarted) += 1;
+	ioUnlockGCThreads();
+	while (1) {
+		ioLockGCThreads();
+		start = GIV(rememberedSetScanNext);
+		GIV(rememberedSetScanNext) = start + RememberedSetScanChunkSize;
+		ioUnlockGCThreads();
+		if (start >= GIV(rememberedSetScanCount)) break;
+		limit = (((start + RememberedSetScanChunkSize) < GIV(rememberedSetScanCount)) ? (start + RememberedSetScanChunkSize) : GIV(rememberedSetScanCount));
+		for (i = start; i < limit; i += 1) {
+			referrer = GIV(rememberedSetScanList)[i];
+			fmt = (((usqInt) (longAt(referrer))) >> (formatShift())) & (formatMask());
+			if ((fmt <= 2 /* arrayFormat */)
+			 || ((fmt == (indexablePointersFormat()))
+			 && (((longAt(referrer)) & (classIndexMask())) != ClassMethodContextCompactIndex))) {
+				/* begin numSlotsOf: */
+				numSlots1 = byteAt(referrer + 7);
+				numSlots = (numSlots1 == (numSlotsMask())
+					? ((usqInt) (((usqInt)(((sqInt)((usqInt)((longAt(referrer - BaseHeaderSize))) << 8)))))) >> 8
+					: numSlots1);
+				GIV(rememberedSetScanResults)[i] = (parallelScavengeReferentsOfnumSlotsworker(referrer, numSlots, worker)
+					? RememberedSetScanRetained
+					: RememberedSetScanDropped);
+			}
+			else {
+				GIV(rememberedSetScanResults)[i] = RememberedSetScanDeferred;
+			}
+		}
+		parallelScavengeGrayStack(worker);
+	}
+	while (1) {
+		ioLockGCThreads();
+		pageIndex = GIV(scavengeStackPageNext);
+		GIV(scavengeStackPageNext) = pageIndex + 1;
+		ioUnlockGCThreads();
+		if (pageIndex >= GIV(numStackPages)) break;
+		/* begin stackPageAt: */
+		thePage = stackPageAtpages(pageIndex, GIV(pages));
+		if (!(((thePage->baseFP)) == 0)) {
+			parallelScavengeStackPageworker(thePage, worker);
+			parallelScavengeGrayStack(worker);
+		}
+	}
+	while (1) {
+		parallelScavengeGrayStack(worker);
+		ioLockGCThreads();
+		GIV(scavengeWorkersIdle) += 1;
+		while (GIV(scavengeGrayPoolCount) == 0) {
+			if (GIV(scavengeWorkersIdle) == GIV(scavengeWorkersStarted)) {
+				ioUnlockGCThreads();
+				return;
+			}
+			ioUnlockGCThreads();
+			sqLowLevelYield();
+			ioLockGCThreads();
+		}
+		numTaken = ((GIV(scavengeGrayPoolCount) < ScavengeGrayShareThreshold) ? GIV(scavengeGrayPoolCount) : ScavengeGrayShareThreshold);
+		if (((worker->grayCapacity)) < numTaken) {
+			stack = realloc((worker->grayStack), numTaken * BytesPerOop);
+			if (stack == null) {
+				error("out of memory");
+			}
+			(worker->grayStack = stack);
+			(worker->grayCapacity = numTaken);
+		}
+		GIV(scavengeGrayPoolCount) -= numTaken;
+		memcpy((worker->grayStack), GIV(scavengeGrayPool) + GIV(scavengeGrayPoolCount), numTaken * BytesPerOop);
+		(worker->grayTop = numTaken);
+		GIV(scavengeWorkersIdle) -= 1;
+		ioUnlockGCThreads();
+	}
+}
+
+
 /*	Print the objects in the remembered set. */
 
 	/* SpurGenerationScavenger>>#printRememberedSet */
@@ -43000,6 +45204,61 @@ processWeakSurvivor(sqInt weakObj)
 }
 
 
+/*	Defer the scavenge of the survivor whose corpse is survivor to the VM
+	thread; see parallelScavengeRoots. */
+
+	/* SpurGenerationScavenger>>#pushScavengeDeferredObject:worker: */
+static void NoDbgRegParms
+pushScavengeDeferredObjectworker(sqInt survivor, SpurScavengeWorker *worker)
+{
+    sqInt *deferred;
+
+	if (((worker->numDeferred)) >= ((worker->deferredCapacity))) {
+		deferred = realloc((worker->deferred), (((worker->deferredCapacity)) * 2) * BytesPerOop);
+		if (deferred == null) {
+			error("out of memory");
+		}
+		(worker->deferred = deferred);
+		(worker->deferredCapacity = ((worker->deferredCapacity)) * 2);
+	}
+	((worker->deferred))[(worker->numDeferred)] = survivor;
+	(worker->numDeferred += 1);
+}
+
+	/* SpurGenerationScavenger>>#pushScavengeGrayObject:worker: */
+static void NoDbgRegParms
+pushScavengeGrayObjectworker(sqInt objOop, SpurScavengeWorker *worker)
+{
+    sqInt *stack;
+
+	if (((worker->grayTop)) >= ((worker->grayCapacity))) {
+		stack = realloc((worker->grayStack), (((worker->grayCapacity)) * 2) * BytesPerOop);
+		if (stack == null) {
+			error("out of memory");
+		}
+		(worker->grayStack = stack);
+		(worker->grayCapacity = ((worker->grayCapacity)) * 2);
+	}
+	((worker->grayStack))[(worker->grayTop)] = objOop;
+	(worker->grayTop += 1);
+}
+
+/*	Rebuild the carded objects hash from the carded object tables, after
+	they have been grown or compacted. */
+
+	/* SpurGenerationScavenger>>#rehashCardedObjects */
+static void
+rehashCardedObjects(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt i;
+
+	memset(GIV(cardedObjectsHash), 0, GIV(cardedObjectsHashSize) * BytesPerOop);
+	for (i = 0; i < GIV(numCardedObjects); i += 1) {
+		addToCardedObjectsHash(i);
+	}
+}
+
+
 /*	Add the argument to the remembered set and set its isRemembered bit to
 	true. Answer the argument for the benefit of the Cogit. */
 
@@ -43025,6 +45284,163 @@ remember(sqInt objOop)
 	return objOop;
 }
 
+/*	Remove objOop from the carded objects hash, moving later entries of its
+	probe sequence back into the gap so that lookups need no tombstones. */
+
+	/* SpurGenerationScavenger>>#removeFromCardedObjectsHash: */
+static void NoDbgRegParms
+removeFromCardedObjectsHash(sqInt objOop)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt gap;
+    usqInt obj;
+    sqInt slot;
+    sqInt start;
+
+	gap = cardedObjectsHashSlotOf(objOop);
+	if (gap < 0) {
+		return;
+	}
+	slot = gap;
+	while (1) {
+		slot = (slot + 1) & (GIV(cardedObjectsHashSize) - 1);
+		if ((GIV(cardedObjectsHash)[slot]) == 0) {
+			GIV(cardedObjectsHash)[gap] = 0;
+			return;
+		}
+		obj = GIV(cardedObjects)[(GIV(cardedObjectsHash)[slot]) - 1];
+		/* begin cardedObjectsHashStartFor: */
+		start = ((obj >> 3) ^ (obj >> 17)) & (GIV(cardedObjectsHashSize) - 1);
+		if (!((gap <= slot)
+				? (gap < start) && (start <= slot)
+				: (gap < start) || (start <= slot))) {
+			GIV(cardedObjectsHash)[gap] = (GIV(cardedObjectsHash)[slot]);
+			gap = slot;
+		}
+	}
+}
+
+
+/*	Scavenge the dirty cards of the carded objects, i.e. those that referred
+	to new space at the end of the previous scavenge, recomputing each card
+	as it is scanned. Those that no longer refer to new space are dropped.
+	Objects that have been remembered since, i.e. stored into, are scanned in
+	full from the remembered set; their cards are dropped, but their entries
+	are kept, counting down the scavenges before cardLargeRememberedObjects
+	may card them again. */
+
+	/* SpurGenerationScavenger>>#scavengeCardedObjects */
+static void
+scavengeCardedObjects(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt backoff;
+    sqInt card;
+    unsigned char *cards;
+    sqInt destIndex;
+    sqInt i;
+    sqInt keep;
+    sqInt limit;
+    sqInt newLocation;
+    sqInt numCards;
+    usqInt numSlots;
+    sqInt obj;
+    sqInt referent;
+    sqInt referent1;
+    sqInt refersToNewSpace;
+    sqInt sourceIndex;
+
+	destIndex = 0;
+	for (sourceIndex = 0; sourceIndex < GIV(numCardedObjects); sourceIndex += 1) {
+		obj = GIV(cardedObjects)[sourceIndex];
+		cards = GIV(cardedObjectCards)[sourceIndex];
+		backoff = GIV(cardedObjectBackoffs)[sourceIndex];
+		refersToNewSpace = 0;
+		keep = 0;
+		if (((longAt(obj)) & ((classIndexMask()) - (isForwardedObjectClassIndexPun()))) == 0) {
+			free(cards);
+			cards = null;
+		}
+		else if (((((usqInt) (longAt(obj))) >> (rememberedBitShift())) & 1) != 0) {
+			if (cards == null) {
+				if ((GIV(cardedObjectSkips)[sourceIndex]) > 0) {
+					GIV(cardedObjectSkips)[sourceIndex] -= 1;
+				}
+			}
+			else {
+
+				/* stored into while carded */
+				free(cards);
+				cards = null;
+				backoff = (backoff == 0
+					? 1
+					: (((backoff * 2) < MaxCardingBackoff) ? (backoff * 2) : MaxCardingBackoff));
+				GIV(cardedObjectSkips)[sourceIndex] = backoff;
+			}
+			keep = 1;
+		}
+		else if (cards != null) {
+
+			/* the object may have been shortened since it was carded. */
+			numSlots = numSlotsOf(obj);
+			numCards = (numSlots + (SlotsPerCard - 1)) / SlotsPerCard;
+			if (numCards > (GIV(cardedObjectNumCards)[sourceIndex])) {
+				numCards = GIV(cardedObjectNumCards)[sourceIndex];
+			}
+			for (card = 0; card < numCards; card += 1) {
+				if (cards[card]) {
+					cards[card] = 0;
+					limit = ((((card + 1) * SlotsPerCard) < numSlots) ? ((card + 1) * SlotsPerCard) : numSlots);
+					for (i = card * SlotsPerCard; i < limit; i += 1) {
+						referent = longAt((obj + BaseHeaderSize) + (((sqInt)((usqInt)(i) << (shiftForWord())))));
+						if ((referent & (tagMask())) == 0) {
+							if (((longAt(referent)) & ((classIndexMask()) - (isForwardedObjectClassIndexPun()))) == 0) {
+								/* begin followForwarded: */
+								referent1 = longAt((referent + BaseHeaderSize) + (0U << (shiftForWord())));
+								while (((referent1 & (tagMask())) == 0)
+								 && (((longAt(referent1)) & ((classIndexMask()) - (isForwardedObjectClassIndexPun()))) == 0)) {
+									referent1 = longAt((referent1 + BaseHeaderSize) + (0U << (shiftForWord())));
+								}
+								referent = referent1;
+							}
+							if ((oopisLessThan(referent, GIV(newSpaceLimit)))
+							 && (oopisGreaterThanOrEqualTo(referent, GIV(newSpaceStart)))) {
+								newLocation = (oopisGreaterThanOrEqualToandLessThan(referent, ((futureSpace()).start), futureSurvivorStart())
+									? referent
+									: copyAndForward(referent));
+								if (((newLocation & (tagMask())) == 0)
+								 && (oopisLessThan(newLocation, GIV(newSpaceLimit)))) {
+									cards[card] = 1;
+									refersToNewSpace = 1;
+								}
+								referent = newLocation;
+							}
+							longAtput((obj + BaseHeaderSize) + (((sqInt)((usqInt)(i) << (shiftForWord())))), referent);
+						}
+					}
+				}
+			}
+		}
+		if (refersToNewSpace) {
+
+			/* not stored into since it was carded */
+			backoff = backoff / 2;
+			keep = 1;
+		}
+		if (keep) {
+			GIV(cardedObjects)[destIndex] = obj;
+			GIV(cardedObjectCards)[destIndex] = cards;
+			GIV(cardedObjectNumCards)[destIndex] = (GIV(cardedObjectNumCards)[sourceIndex]);
+			GIV(cardedObjectSkips)[destIndex] = (GIV(cardedObjectSkips)[sourceIndex]);
+			GIV(cardedObjectBackoffs)[destIndex] = backoff;
+			destIndex += 1;
+		}
+		else {
+			free(cards);
+		}
+	}
+	GIV(numCardedObjects) = destIndex;
+	rehashCardedObjects();
+}
+
 
 /*	scavengeFutureSurvivorSpaceStartingAt: does a depth-first traversal of the
 	new objects starting at the one at initialAddress in futureSurvivorSpace. */
@@ -43119,12 +45535,24 @@ scavengeLoop(void)
 		(thePage->trace = StackPageUnreached);
 	}
 	while(1) {
+		if (firstTime
+		 && ((ioNumGCThreads() > 1)
+		 && (((GIV(tenureCriterion) == TenureByAge)
+		 || (GIV(tenureCriterion) == TenureByClass))
+		 && ((ensureRememberedSetScanCapacity(GIV(rememberedSetSize)))
+		 && (ensureScavengeWorkers(ioNumGCThreads())))))) {
+			previousFutureSurvivorStart = parallelScavengeRoots();
+		}
 		scavengeRememberedSetStartingAt(GIV(previousRememberedSetSize));
 		GIV(previousRememberedSetSize) = GIV(rememberedSetSize);
 		if (firstTime) {
 			mapInterpreterOops();
+			GIV(stackPagesScavenged) = 0;
 			mapMournQueue();
 			mapExtraRoots();
+			if (GIV(numCardedObjects) > 0) {
+				scavengeCardedObjects();
+			}
 			firstTime = 0;
 		}
 		if ((GIV(previousRememberedSetSize) == GIV(rememberedSetSize))
@@ -43296,6 +45724,42 @@ scavengeReferentsOf(sqInt referrer)
 }
 
 
+/*	Scavenge referrer, an entry in the remembered set, answering the index
+	following its position in the compacted set. Any potential firing
+	ephemerons should not be scanned yet. Move any to the front of the set to
+	save time in later scanning. Referrers that no longer refer to new space
+	are removed from the set. */
+
+	/* SpurGenerationScavenger>>#scavengeRememberedReferrer:destIndex: */
+static sqInt NoDbgRegParms
+scavengeRememberedReferrerdestIndex(sqInt referrer, sqInt destIndex)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt format;
+
+	if (((assert(isNonImmediate(referrer)),
+	/* begin isEphemeronFormat: */
+	(format = (((usqInt) (longAt(referrer))) >> (formatShift())) & (formatMask())),
+	format == 5 /* ephemeronFormat */))
+	 && (!(isScavengeSurvivor((assert((isNonImmediate(referrer))
+		 && (isObjEphemeron(referrer))),
+	/* begin fetchPointer:ofObject: */
+	longAt((referrer + BaseHeaderSize) + (0U << (shiftForWord())))))))) {
+		assert(destIndex >= GIV(numRememberedEphemerons));
+		GIV(rememberedSet)[destIndex] = (GIV(rememberedSet)[GIV(numRememberedEphemerons)]);
+		GIV(rememberedSet)[GIV(numRememberedEphemerons)] = referrer;
+		GIV(numRememberedEphemerons) += 1;
+		return destIndex + 1;
+	}
+	if (scavengeReferentsOf(referrer)) {
+		GIV(rememberedSet)[destIndex] = referrer;
+		return destIndex + 1;
+	}
+	/* begin setIsRememberedOf:to: */
+	longAtput(referrer, (longAt(referrer)) & (~(usqIntptr_t)(1U << (rememberedBitShift()))));
+	return destIndex;
+}
+
+
 /*	scavengeRememberedSetStartingAt: n traverses objects in the remembered
 	set starting at the nth one. If the object does not refer to any new
 	objects, it
@@ -43309,8 +45773,6 @@ static void NoDbgRegParms
 scavengeRememberedSetStartingAt(sqInt n)
 {   DECL_MAYBE_SQ_GLOBAL_STRUCT
     sqInt destIndex;
-    sqInt format;
-    sqInt referrer;
     sqInt sourceIndex;
 
 	sourceIndex = (destIndex = n);
@@ -43318,34 +45780,7 @@ scavengeRememberedSetStartingAt(sqInt n)
 
 		/* *Don't* follow forwarding pointers here. oldSpace objects may refer
 		   to these roots, and so they can't be removed in the scavenge. */
-
-		/* Any potential firing ephemerons should not be scanned yet.
-		   Move any to the front of the set to save time in later scanning. */
-		referrer = GIV(rememberedSet)[sourceIndex];
-		if (((assert(isNonImmediate(referrer)),
-		/* begin isEphemeronFormat: */
-		(format = (((usqInt) (longAt(referrer))) >> (formatShift())) & (formatMask())),
-		format == 5 /* ephemeronFormat */))
-		 && (!(isScavengeSurvivor((assert((isNonImmediate(referrer))
-			 && (isObjEphemeron(referrer))),
-		/* begin fetchPointer:ofObject: */
-		longAt((referrer + BaseHeaderSize) + (0U << (shiftForWord())))))))) {
-			assert(destIndex >= GIV(numRememberedEphemerons));
-			GIV(rememberedSet)[destIndex] = (GIV(rememberedSet)[GIV(numRememberedEphemerons)]);
-			GIV(rememberedSet)[GIV(numRememberedEphemerons)] = referrer;
-			GIV(numRememberedEphemerons) += 1;
-			destIndex += 1;
-		}
-		else {
-			if (scavengeReferentsOf(referrer)) {
-				GIV(rememberedSet)[destIndex] = referrer;
-				destIndex += 1;
-			}
-			else {
-				/* begin setIsRememberedOf:to: */
-				longAtput(referrer, (longAt(referrer)) & (~(usqIntptr_t)(1U << (rememberedBitShift()))));
-			}
-		}
+		destIndex = scavengeRememberedReferrerdestIndex(GIV(rememberedSet)[sourceIndex], destIndex);
 		sourceIndex += 1;
 	}
 	GIV(rememberedSetSize) = destIndex;
@@ -43431,12 +45866,50 @@ scavengeUnfiredEphemeronsOnEphemeronList(void)
 }
 
 
+/*	Answer an Array of the total bytes that have survived a scavenge since
+	startup, indexed by the number of scavenges survived before it, the
+	last element counting those of age MaxSurvivorAge and older. */
+
+	/* SpurGenerationScavenger>>#survivorAgeHistogram */
+static sqInt
+survivorAgeHistogram(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt age;
+    sqInt histogram;
+
+	histogram = instantiateClassindexableSize(splObj(ClassArray), MaxSurvivorAge + 1);
+	if (histogram == null) {
+		return GIV(nilObj);
+	}
+	for (age = 0; age <= MaxSurvivorAge; age += 1) {
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		assert(!(isOopForwarded(histogram)));
+		longAtput((histogram + BaseHeaderSize) + (((sqInt)((usqInt)(age) << (shiftForWord())))), (((usqInt)(GIV(statSurvivorBytesByAge)[age]) << 3) | 1));
+	}
+	return histogram;
+}
+
+
+/*	Write a scavenge record to the GC log, from the scavenge log record. */
+
+	/* SpurGenerationScavenger>>#writeScavengeGCLogRecord */
+static void NeverInline
+writeScavengeGCLogRecord(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+	fprintf(GIV(gcLog), "{\"event\":\"scavenge\",\"n\":%llu,\"cause\":\"%s\",\"unixUsecs\":%llu,\"usecs\":%llu,\"edenBytes\":%llu,\"pastBytes\":%llu,\"survivorBytes\":%llu,\"tenuredObjects\":%llu,\"tenuredBytes\":%llu,\"remSetBefore\":%llu,\"remSetAfter\":%llu,\"oldSpaceBytesBefore\":%llu,\"oldSpaceBytesAfter\":%llu}\n", ((unsigned long long) GIV(statScavenges)), (GIV(gcCause) == null
+		? "other"
+		: GIV(gcCause)), ((unsigned long long) (GIV(gcStartUsecs) - MicrosecondsFrom1901To1970)), ((unsigned long long) GIV(statSGCDeltaUsecs)), ((unsigned long long) (GIV(scavengeLogRecord).sEdenBytes)), ((unsigned long long) (GIV(scavengeLogRecord).sPastBytes)), ((unsigned long long) (GIV(scavengeLogRecord).eSurvivorBytes)), ((unsigned long long) (((GIV(scavengeLogRecord).eStatTenures)) - ((GIV(scavengeLogRecord).sStatTenures)))), ((unsigned long long) (((GIV(scavengeLogRecord).eStatTenuredBytes)) - ((GIV(scavengeLogRecord).sStatTenuredBytes)))), ((unsigned long long) (GIV(scavengeLogRecord).sRememberedSetSize)), ((unsigned long long) (GIV(scavengeLogRecord).eRememberedSetSize)), ((unsigned long long) (GIV(scavengeLogRecord).sOldSpaceBytes)), ((unsigned long long) (GIV(scavengeLogRecord).eOldSpaceBytes)));
+	fflush(GIV(gcLog));
+}
+
+
 /*	Output the entire record. */
 
 	/* SpurGenerationScavenger>>#writeScavengeLog */
 static void NeverInline
 writeScavengeLog(void)
 {   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt age;
     static char *policyNames[] = {"", "by age", "by class", "to shrink rt", "don't tenure", "mark on tenure"};
 
 	fprintf(GIV(scavengeLog), "scavenge %" PRIdSQINT " eden bytes: 0x%" PRIxSQINT "/%" PRIdSQINT " past bytes: 0x%" PRIxSQINT "/%" PRIdSQINT "\n\trem set: %" PRIdSQINT " redzone: %" PRIdSQINT " size: %" PRIdSQINT "\n", GIV(statScavenges), (GIV(scavengeLogRecord).sEdenBytes), (GIV(scavengeLogRecord).sEdenBytes), (GIV(scavengeLogRecord).sPastBytes), (GIV(scavengeLogRecord).sPastBytes), (GIV(scavengeLogRecord).sRememberedSetSize), (GIV(scavengeLogRecord).sRememberedSetRedZone), (GIV(scavengeLogRecord).sRememberedSetLimit));
@@ -43444,9 +45917,34 @@ writeScavengeLog(void)
 		? "\ttenure below 0x%" PRIxSQINT "/%" PRIdSQINT " %s refct %" PRIdSQINT "\n"
 		: "\ttenure below 0x%" PRIxSQINT "/%" PRIdSQINT " %s\n"), (GIV(scavengeLogRecord).tTenureThreshold), (GIV(scavengeLogRecord).tTenureThreshold), policyNames[(GIV(scavengeLogRecord).tTenureCriterion)], (GIV(scavengeLogRecord).tRefCountToShrinkRT));
 	fprintf(GIV(scavengeLog), "\tsurvivor bytes: 0x%" PRIxSQINT "/%" PRIdSQINT " rem set: %" PRIdSQINT " tenured: %" PRIdSQINT " usecs: %" PRIdSQINT "\n", (GIV(scavengeLogRecord).eSurvivorBytes), (GIV(scavengeLogRecord).eSurvivorBytes), (GIV(scavengeLogRecord).eRememberedSetSize), ((GIV(scavengeLogRecord).eStatTenures)) - ((GIV(scavengeLogRecord).sStatTenures)), ((unsigned long)GIV(statSGCDeltaUsecs)));
+	fprintf(GIV(scavengeLog), "\tsurvivor bytes by age:");
+	for (age = 0; age <= MaxSurvivorAge; age += 1) {
+		fprintf(GIV(scavengeLog), " %" PRIdSQINT, GIV(survivorBytesByAge)[age]);
+	}
+	fprintf(GIV(scavengeLog), "\n");
 	fflush(GIV(scavengeLog));
 }
 
+/*	Give up the concurrent mark in progress, if any, because the mutator is
+	about to use the mark bits itself or to move objects wholesale. The
+	marker writes nothing but its own bitmap and stacks, so once it has
+	stopped there is nothing in the heap to undo. */
+
+	/* SpurMemoryManager>>#abortConcurrentMark */
+static void
+abortConcurrentMark(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+	if (!GIV(concurrentMarkInProgress)) {
+		return;
+	}
+	invalidateConcurrentMark();
+	if (!GIV(concurrentMarkSteps)) {
+		ioWaitForBackgroundGCWork();
+	}
+	GIV(concurrentMarkInProgress) = 0;
+	releaseConcurrentMark();
+}
+
 
 /*	Answer the accessible object following the given object or 
 	free chunk in the heap. Return nil when heap is exhausted.
@@ -43578,6 +46076,56 @@ activeAndDeferredScan(sqInt anEphemeron)
 	return pushOnUnscannedEphemeronsStack(anEphemeron);
 }
 
+/*	Make a free chunk of bytes at address for a parallel sweep thread. Small
+	chunks outside pinned segments go on the thread's own free lists, which
+	mergeSweepWorkers: splices onto the real ones; the rest are noted, to be
+	added to the free tree or the pinned free lists once the threads are
+	done. */
+
+	/* SpurMemoryManager>>#addFreeChunkWithBytes:at:worker: */
+static void NoDbgRegParms
+addFreeChunkWithBytesatworker(usqInt bytes, sqInt address, SpurSweepWorker *worker)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt *chunks;
+    sqInt freeChunk;
+    sqInt head;
+    sqInt index;
+
+	freeChunk = initFreeChunkWithBytesat(bytes, address);
+	(worker->freeBytes = ((worker->freeBytes)) + bytes);
+	index = bytes / 8 /* allocationUnit */;
+	if ((index < 64 /* numFreeLists */)
+	 && (!((GIV(numPinnedSegments) > 0)
+	 && (isInPinnedSegment(freeChunk))))) {
+		head = (worker->freeListHeads)[index];
+		longAtput((freeChunk + BaseHeaderSize) + (0U << (shiftForWord())), head);
+		if (bytes > (BaseHeaderSize + 8 /* allocationUnit */)) {
+			longAtput((freeChunk + BaseHeaderSize) + (1U << (shiftForWord())), 0);
+			if (head != 0) {
+				longAtput((head + BaseHeaderSize) + (1U << (shiftForWord())), freeChunk);
+			}
+		}
+		if (head == 0) {
+			(worker->freeListTails)[index] = freeChunk;
+		}
+		(worker->freeListHeads)[index] = freeChunk;
+		return;
+	}
+	if (((worker->numChunks)) >= ((worker->chunksCapacity))) {
+		chunks = realloc((worker->chunks), ((((worker->chunksCapacity)) * 2 < 256 ? 256 : ((worker->chunksCapacity)) * 2)) * BytesPerOop);
+		if (chunks == null) {
+
+			/* leave it off the free lists; the next sweep will find it again */
+			(worker->freeBytes = ((worker->freeBytes)) - bytes);
+			return;
+		}
+		(worker->chunks = chunks);
+		(worker->chunksCapacity = (((worker->chunksCapacity)) * 2 < 256 ? 256 : ((worker->chunksCapacity)) * 2));
+	}
+	(worker->chunks)[(worker->numChunks)] = freeChunk;
+	(worker->numChunks = ((worker->numChunks)) + 1);
+}
+
 
 /*	Add a freeChunk sub tree back into the large free chunk tree.
 	This is for allocateOldSpaceChunkOf[Exactly]Bytes:[suchThat:]. */
@@ -43708,6 +46256,17 @@ addToFreeListbytes(sqInt freeChunk, sqInt chunkBytes)
 
 	assert(isFreeObject(freeChunk));
 	assert(chunkBytes == (bytesInObject(freeChunk)));
+	if ((GIV(sweepCursor) != 0)
+	 && (oopisGreaterThanOrEqualTo(freeChunk, GIV(sweepCursor)))) {
+
+		/* not yet swept; the incremental sweep will add it, and count it, when it gets here */
+		GIV(totalFreeOldSpace) -= chunkBytes;
+		return 0;
+	}
+	if ((GIV(numPinnedSegments) > 0)
+	 && (isInPinnedSegment(freeChunk))) {
+		return addToPinnedFreeListbytes(freeChunk, chunkBytes);
+	}
 	index = chunkBytes / 8 /* allocationUnit */;
 	if (index < 64 /* numFreeLists */) {
 		/* begin setNextFreeChunkOf:withValue:chunkBytes: */
@@ -43832,6 +46391,37 @@ addToFreeListbytes(sqInt freeChunk, sqInt chunkBytes)
 }
 
 
+/*	Add a free chunk in a pinned segment to the pinned free lists, which are
+	kept apart from the general free lists so that only pinned objects are
+	allocated in pinned segments. List i holds chunks of between 2^i and
+	2^(i+1) allocation units, the last list everything larger. The lists
+	are singly linked through the first slot. The chunk's caller has counted
+	it in totalFreeOldSpace; count it in totalFreePinnedSpace instead. */
+
+	/* SpurMemoryManager>>#addToPinnedFreeList:bytes: */
+static sqInt NoDbgRegParms
+addToPinnedFreeListbytes(sqInt freeChunk, usqInt chunkBytes)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt index;
+    usqInt units;
+
+	assert(isFreeObject(freeChunk));
+	assert(isInPinnedSegment(freeChunk));
+	/* begin pinnedFreeListIndexFor: */
+	index = 0;
+	units = chunkBytes / 8 /* allocationUnit */;
+	while (((units = units >> 1) > 0)
+	 && (index < (NumPinnedFreeLists - 1))) {
+		index += 1;
+	}
+	longAtput((freeChunk + BaseHeaderSize) + (0U << (shiftForWord())), GIV(pinnedFreeLists)[index]);
+	GIV(pinnedFreeLists)[index] = freeChunk;
+	GIV(totalFreeOldSpace) -= chunkBytes;
+	GIV(totalFreePinnedSpace) += chunkBytes;
+	return 0;
+}
+
+
 /*	Attempt to answer an array of all objects, excluding those that may
 	be garbage collected as a side effect of allocating the result array.
 	If no memory is available answer the number of instances as a
@@ -43904,6 +46494,7 @@ allInstancesOf(sqInt aClass)
     sqInt smallObj;
     usqInt start;
 
+	finishIncrementalSweep();
 	classIndex = (long32At(aClass + 4)) & (identityHashHalfWordMask());
 	if (classIndex == 0) {
 		/* begin allocateSlots:format:classIndex: */
@@ -44259,6 +46850,9 @@ allInstancesOf(sqInt aClass)
 		assert((numBytes1 % (allocationUnit())) == 0);
 		assert((newObj1 % (allocationUnit())) == 0);
 		GIV(freeStart) += numBytes1;
+		if (GIV(allocationSampleInterval) > 0) {
+			sampleAllocationbytes(newObj1, numBytes1);
+		}
 		smallObj = newObj1;
 	l6:	/* end allocateSlots:format:classIndex: */;
 		for (i = 0; i < count; i += 1) {
@@ -44339,6 +46933,7 @@ allObjects(void)
     usqInt ptr;
     usqInt start;
 
+	finishIncrementalSweep();
 	
 	/* N.B. Does /not/ update totalFreeOldSpace */
 	freeChunk = allocateLargestFreeChunk();
@@ -44655,6 +47250,63 @@ allOldMarkedWeakObjectsOnWeaklingStack(void)
 }
 
 
+/*	Answer the start of a chunk of chunkBytes taken from the pinned free
+	lists, or nil if none fits. Search the list for chunkBytes' size class
+	first fit, and then the first chunk that fits in each larger class,
+	leaving the remainder, if any, on the pinned free lists. */
+
+	/* SpurMemoryManager>>#allocateFromPinnedFreeLists: */
+static sqInt NoDbgRegParms
+allocateFromPinnedFreeListsbytes(usqInt chunkBytes)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt chunk;
+    usqInt chunkSize;
+    sqInt index;
+    sqInt next;
+    sqInt prev;
+    usqInt start;
+    usqInt units;
+
+	/* begin pinnedFreeListIndexFor: */
+	index = 0;
+	units = chunkBytes / 8 /* allocationUnit */;
+	while (((units = units >> 1) > 0)
+	 && (index < (NumPinnedFreeLists - 1))) {
+		index += 1;
+	}
+	for (; index < NumPinnedFreeLists; index += 1) {
+		prev = 0;
+		chunk = GIV(pinnedFreeLists)[index];
+		while (chunk != 0) {
+			chunkSize = bytesInObject(chunk);
+			next = longAt((chunk + BaseHeaderSize) + (0U << (shiftForWord())));
+			if ((chunkSize == chunkBytes)
+			 || (chunkSize >= (chunkBytes + (2 * 8 /* allocationUnit */)))) {
+				if (prev == 0) {
+					GIV(pinnedFreeLists)[index] = next;
+				}
+				else {
+					longAtput((prev + BaseHeaderSize) + (0U << (shiftForWord())), next);
+				}
+				GIV(totalFreePinnedSpace) -= chunkSize;
+				start = ((byteAt(chunk + 7)) == (numSlotsMask())
+					? chunk - BaseHeaderSize
+					: chunk);
+				if (chunkSize > chunkBytes) {
+					/* begin addFreeChunkWithBytes:at: */
+					GIV(totalFreeOldSpace) += chunkSize - chunkBytes;
+					freeChunkWithBytesat(chunkSize - chunkBytes, start + chunkBytes);
+				}
+				return start;
+			}
+			prev = chunk;
+			chunk = next;
+		}
+	}
+	return null;
+}
+
+
 /*	Answer the largest free chunk in the free lists. */
 /*	would like to use ifNotNil: but the ^next inside the ^blah ifNotNil:
 	confused Slang
@@ -44755,6 +47407,9 @@ allocateNewSpaceSlotsformatclassIndex(sqInt numSlots, sqInt formatField, sqInt c
 	assert((numBytes % (allocationUnit())) == 0);
 	assert((newObj % (allocationUnit())) == 0);
 	GIV(freeStart) += numBytes;
+	if (GIV(allocationSampleInterval) > 0) {
+		sampleAllocationbytes(newObj, numBytes);
+	}
 	return newObj;
 }
 
@@ -44938,6 +47593,12 @@ allocateOldSpaceChunkOfBytes(usqInt chunkBytes)
 
 		/* optimism was unfounded */
 		GIV(totalFreeOldSpace) += chunkBytes;
+		if (GIV(sweepCursor) != 0) {
+
+			/* the incremental sweep has yet to put all free space on the free lists */
+			incrementalSweepStepForbytes(0, chunkBytes);
+			return allocateOldSpaceChunkOfBytes(chunkBytes);
+		}
 		return null;
 	}
 	assert((nodeBytes == chunkBytes)
@@ -44984,6 +47645,103 @@ allocateOldSpaceChunkOfBytes(usqInt chunkBytes)
 		: chunk);
 }
 
+
+/*	Answer a pinned ByteArray of at least byteSize bytes for a plugin to use
+	as a buffer, or nil if there is no room. Buffers of up to 1Mb are sized
+	to a power of two bytes, and are taken from the pool of released buffers
+	if there is one of the right size, without going through the allocator.
+	The contents are zero. Until it is handed back by releasePinnedBuffer:
+	the buffer is a root, so the plugin need not keep it reachable from the
+	image; hence at most MaxPinnedBuffersInUse may be held at once. */
+
+	/* SpurMemoryManager>>#allocatePinnedBuffer: */
+sqInt
+allocatePinnedBuffer(sqInt byteSize)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt buffer;
+    usqInt bufferBytes;
+    sqInt classIndex;
+    sqInt index;
+    usqInt numSlots;
+    usqInt p;
+
+	if ((byteSize <= 0)
+	 || (GIV(numPinnedBuffersInUse) >= MaxPinnedBuffersInUse)) {
+		return null;
+	}
+	index = 0;
+	while (((1ULL << (index + MinPinnedBufferClass)) < byteSize)
+	 && (index < NumPinnedBufferClasses)) {
+		index += 1;
+	}
+	if (index < NumPinnedBufferClasses) {
+		bufferBytes = 1ULL << (index + MinPinnedBufferClass);
+		buffer = GIV(pinnedBufferPool)[index];
+		if (buffer != 0) {
+			GIV(pinnedBufferPool)[index] = (longAt((buffer + BaseHeaderSize) + (0U << (shiftForWord()))));
+			GIV(pinnedBufferPoolCounts)[index] -= 1;
+			GIV(statPinnedBufferReuses) += 1;
+			memset(((void *) (buffer + BaseHeaderSize)), 0, bufferBytes);
+			GIV(pinnedBuffersInUse)[GIV(numPinnedBuffersInUse)] = buffer;
+			GIV(numPinnedBuffersInUse) += 1;
+			return buffer;
+		}
+	}
+	else {
+		bufferBytes = byteSize;
+	}
+	numSlots = (bufferBytes + (BytesPerOop - 1)) / BytesPerOop;
+	/* begin rawHashBitsOf: */
+	classIndex = (long32At((classByteArray()) + 4)) & (identityHashHalfWordMask());
+	buffer = allocateSlotsForPinningInOldSpacebytesformatclassIndex(numSlots, (((sqInt)((usqInt)(numSlots) << (shiftForWord())))) + ((numSlots >= (numSlotsMask())
+	? BaseHeaderSize + BaseHeaderSize
+	: BaseHeaderSize)), (firstByteFormat()) + ((numSlots * BytesPerOop) - bufferBytes), classIndex);
+	if (!(buffer == null)) {
+		/* begin fillObj:numSlots:with: */
+		for (p = (((usqInt)(buffer + BaseHeaderSize))); p <= (((usqInt)(((buffer + BaseHeaderSize) + (numSlots * BytesPerOop)) - 1))); p += 8 /* allocationUnit */) {
+			longAtput(p, 0);
+		}
+		GIV(pinnedBuffersInUse)[GIV(numPinnedBuffersInUse)] = buffer;
+		GIV(numPinnedBuffersInUse) += 1;
+	}
+	return buffer;
+}
+
+
+/*	Answer the start of a chunk of chunkBytes in a pinned segment, or nil.
+	If the pinned free lists have nothing that fits, finish any incremental
+	sweep, which may find some, and failing that add a new pinned segment of
+	pinnedSegmentSize bytes, or larger if need be. Segments are not added
+	while the GC is running. */
+
+	/* SpurMemoryManager>>#allocatePinnedChunkOfBytes: */
+static sqInt NoDbgRegParms
+allocatePinnedChunkOfBytes(usqInt chunkBytes)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt chunk;
+
+	chunk = allocateFromPinnedFreeListsbytes(chunkBytes);
+	if (!(chunk == null)) {
+		return chunk;
+	}
+	if (GIV(sweepCursor) != 0) {
+		finishIncrementalSweep();
+		chunk = allocateFromPinnedFreeListsbytes(chunkBytes);
+		if (!(chunk == null)) {
+			return chunk;
+		}
+	}
+	if ((pinnedSegmentSize == 0)
+	 || ((GIV(gcPhaseInProgress) != 0)
+	 || (GIV(marking)))) {
+		return null;
+	}
+	if ((addPinnedSegmentFor(chunkBytes)) == null) {
+		return null;
+	}
+	return allocateFromPinnedFreeListsbytes(chunkBytes);
+}
+
 	/* SpurMemoryManager>>#allocatePinnedSlots: */
 sqInt
 allocatePinnedSlots(sqInt nSlots)
@@ -45287,6 +48045,10 @@ becomewithtwoWaycopyHash(sqInt array1, sqInt array2, sqInt twoWayFlag, sqInt cop
 		 && ((numSlotsOf(array1)) == (numSlotsOf(array2))))) {
 		return PrimErrBadArgument;
 	}
+	if (GIV(numCardedObjects) > 0) {
+		flushCardedObjects();
+	}
+	invalidateConcurrentMark();
 	/* begin containsOnlyValidBecomeObjects:and:twoWay:copyHash: */
 	fmt = (((usqInt) (longAt(array1))) >> (formatShift())) & (formatMask());
 	assert(fmt != (forwardedFormat()));
@@ -45665,6 +48427,79 @@ becomewithtwoWaycopyHash(sqInt array1, sqInt array2, sqInt twoWayFlag, sqInt cop
 }
 
 
+/*	Start sweeping old space incrementally, for full GCs when there is a
+	pause target. Empty the free lists, which the sweep refills, unmark the
+	survivors in new space, and sweep for as much of the pause target as
+	marking has left. The rest of old space is swept a step at a time by
+	incrementalSweepStepFor:bytes:, from checkForEventsMayContextSwitch and
+	whenever an allocation finds no free chunk. */
+
+	/* SpurMemoryManager>>#beginIncrementalSweep */
+static void NeverInline
+beginIncrementalSweep(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt address;
+    usqLong elapsedUsecs;
+    sqInt followingWord1;
+    usqInt followingWordAddress1;
+    sqInt i;
+    sqInt iLimiT;
+    usqInt numSlots;
+    sqInt objOop1;
+    sqInt prevObj1;
+    sqInt prevPrevObj1;
+
+	/* begin resetFreeListHeads */
+	GIV(freeListsMask) = 0;
+	for (i = 0, iLimiT = (64 /* numFreeLists */ - 1); i <= iLimiT; i += 1) {
+		GIV(freeLists)[i] = 0;
+	}
+	for (i = 0; i < NumPinnedFreeLists; i += 1) {
+		GIV(pinnedFreeLists)[i] = 0;
+	}
+	GIV(totalFreePinnedSpace) = 0;
+	/* begin totalFreeOldSpace: */
+	GIV(totalFreeOldSpace) = 0;
+	/* begin unmarkSurvivingObjectsForCompact */
+	prevPrevObj1 = (prevObj1 = null);
+	/* begin objectStartingAt: */
+	address = ((pastSpace()).start);
+	numSlots = byteAt(address + 7);
+	objOop1 = (numSlots == (numSlotsMask())
+		? address + BaseHeaderSize
+		: address);
+	while (oopisLessThan(objOop1, GIV(pastSpaceStart))) {
+		assert(isEnumerableObjectNoAssert(objOop1));
+		if (((((usqInt) (longAt(objOop1))) >> (markedBitFullShift())) & 1) != 0) {
+			/* begin setIsMarkedOf:to: */
+			assert(!(isFreeObject(objOop1)));
+			longAtput(objOop1, (longAt(objOop1)) & (~(usqIntptr_t)(1ULL << (markedBitFullShift()))));
+		}
+		prevPrevObj1 = prevObj1;
+		prevObj1 = objOop1;
+		/* begin objectAfter:limit: */
+		followingWordAddress1 = addressAfter(objOop1);
+		if (oopisGreaterThanOrEqualTo(followingWordAddress1, GIV(pastSpaceStart))) {
+			objOop1 = GIV(pastSpaceStart);
+			goto l2;
+		}
+		flag("endianness");
+		followingWord1 = longAt(followingWordAddress1);
+		objOop1 = ((((usqInt) followingWord1) >> (numSlotsFullShift())) == (numSlotsMask())
+			? followingWordAddress1 + BaseHeaderSize
+			: followingWordAddress1);
+	l2:	/* end objectAfter:limit: */;
+	}
+	GIV(sweepCursor) = GIV(nilObj);
+	GIV(statNonCompactingGCs) += 1;
+	elapsedUsecs = ioUTCMicrosecondsNow() - GIV(gcStartUsecs);
+	if (elapsedUsecs < maxGCPauseUsecs) {
+		sweepIncrementallyForbytes(maxGCPauseUsecs - elapsedUsecs, 0);
+	}
+	GIV(gcSweepEndUsecs) = ioUTCMicrosecondsNow();
+}
+
+
 /*	If this object is old, mark it as a root (because a new object
 	may be stored into it). */
 
@@ -46133,6 +48968,7 @@ checkHeapIntegrityclassIndicesShouldBeValid(sqInt excludeUnmarkedObjs, sqInt cla
     sqInt prevPrevObj1;
     sqInt ri;
 
+	finishIncrementalSweep();
 	ok = 1;
 	numRememberedObjectsInHeap = 0;
 	for (i = 0, iLimiT = (64 /* numFreeLists */ - 1); i <= iLimiT; i += 1) {
@@ -46513,7 +49349,8 @@ checkHeapIntegrityclassIndicesShouldBeValid(sqInt excludeUnmarkedObjs, sqInt cla
 					}
 				}
 				if (containsYoung) {
-					if (!(((((usqInt) (longAt(objOop1))) >> (rememberedBitShift())) & 1) != 0)) {
+					if (!((((((usqInt) (longAt(objOop1))) >> (rememberedBitShift())) & 1) != 0)
+						 || (isCardedObject(objOop1)))) {
 						print("unremembered object ");
 						printHex(objOop1);
 						print(" contains young oop(s)");
@@ -47316,7 +50153,9 @@ cloneInOldSpaceforPinning(sqInt objOop, sqInt forPinning)
 			}
 			if (((assert(isNonImmediate(objOop)),
 			oopisLessThan(objOop, GIV(newSpaceLimit))))
-			 || (((((usqInt) (longAt(objOop))) >> (rememberedBitShift())) & 1) != 0)) {
+			 || ((((((usqInt) (longAt(objOop))) >> (rememberedBitShift())) & 1) != 0)
+			 || ((GIV(numCardedObjects) > 0)
+			 && (isCardedObject(objOop))))) {
 				remember(newObj);
 			}
 		}
@@ -47414,6 +50253,9 @@ clone(sqInt objOop)
 		assert((numBytes % (allocationUnit())) == 0);
 		assert((newObj1 % (allocationUnit())) == 0);
 		GIV(freeStart) += numBytes;
+		if (GIV(allocationSampleInterval) > 0) {
+			sampleAllocationbytes(newObj1, numBytes);
+		}
 		newObj = newObj1;
 	l5:	/* end allocateSlots:format:classIndex: */;
 	}
@@ -47477,7 +50319,9 @@ clone(sqInt objOop)
 			oopisGreaterThanOrEqualTo(newObj, GIV(oldSpaceStart))))
 			 && (((assert(isNonImmediate(objOop)),
 			oopisLessThan(objOop, GIV(newSpaceLimit))))
-			 || (((((usqInt) (longAt(objOop))) >> (rememberedBitShift())) & 1) != 0))) {
+			 || ((((((usqInt) (longAt(objOop))) >> (rememberedBitShift())) & 1) != 0)
+			 || ((GIV(numCardedObjects) > 0)
+			 && (isCardedObject(objOop)))))) {
 				remember(newObj);
 			}
 		}
@@ -47493,6 +50337,168 @@ compactClassIndexOf(sqInt objOop)
 	return (longAt(objOop)) & (classIndexMask());
 }
 
+/*	Leave objOop for the remark to trace in full; see concurrentlyMark:from:.
+	If there is no room the mark fails, and the next full GC marks with the
+	world stopped. */
+
+	/* SpurMemoryManager>>#concurrentlyDefer: */
+static void NoDbgRegParms
+concurrentlyDefer(sqInt objOop)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt *deferred;
+
+	if (GIV(concurrentMarkDeferredCount) >= GIV(concurrentMarkDeferredCapacity)) {
+		deferred = realloc(GIV(concurrentMarkDeferred), (GIV(concurrentMarkDeferredCapacity) * 2) * BytesPerOop);
+		if (deferred == null) {
+			GIV(concurrentMarkFailed) = (GIV(concurrentMarkInvalidated) = 1);
+			return;
+		}
+		GIV(concurrentMarkDeferred) = deferred;
+		GIV(concurrentMarkDeferredCapacity) = GIV(concurrentMarkDeferredCapacity) * 2;
+	}
+	GIV(concurrentMarkDeferred)[GIV(concurrentMarkDeferredCount)] = objOop;
+	GIV(concurrentMarkDeferredCount) += 1;
+}
+
+/*	Mark oop in the concurrent mark's bitmap and push it on the concurrent
+	mark stack, if it is an old object the marker has yet to reach. This
+	runs on the marker thread, and on the VM thread for the roots before the
+	marker starts. It writes nothing in the heap, so the pages the mutator
+	writes are exactly those the remark must revisit. A forwarder is
+	followed, and its referrer deferred so that the remark fixes the field.
+	Weaklings, ephemerons, contexts and jitted methods are marked but
+	deferred, since only a mark with the world stopped can scan them. */
+
+	/* SpurMemoryManager>>#concurrentlyMark:from: */
+static void NoDbgRegParms
+concurrentlyMarkfrom(sqInt oop, sqInt referrer)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    usqInt bit;
+    usqInt bitIndex;
+    sqInt fmt;
+    sqInt header;
+    sqInt *stack;
+
+	if ((oop & (tagMask()))
+	 || ((((usqInt) oop)) < GIV(concurrentMarkBitmapStart))
+	 || ((((usqInt) oop)) >= GIV(concurrentMarkBitmapLimit))) {
+		return;
+	}
+	header = longAt(oop);
+	if ((header & ((classIndexMask()) - (isForwardedObjectClassIndexPun()))) == 0) {
+		if (referrer != 0) {
+			concurrentlyDefer(referrer);
+		}
+		concurrentlyMarkfrom(longAt((oop + BaseHeaderSize) + (0U << (shiftForWord()))), 0);
+		return;
+	}
+	if ((header & (classIndexMask())) <= (lastClassIndexPun())) {
+		return;
+	}
+	bitIndex = (((usqInt) oop) - GIV(concurrentMarkBitmapStart)) >> 3;
+	bit = 1ULL << (bitIndex & 0x3F);
+	if (((GIV(concurrentMarkBitmap)[bitIndex >> 6]) & bit) != 0) {
+		return;
+	}
+	GIV(concurrentMarkBitmap)[bitIndex >> 6] = (GIV(concurrentMarkBitmap)[bitIndex >> 6]) | bit;
+	fmt = (((usqInt) header) >> (formatShift())) & (formatMask());
+	if ((fmt == (weakArrayFormat()))
+	 || ((fmt == 5 /* ephemeronFormat */)
+	 || (((header & (classIndexMask())) == ClassMethodContextCompactIndex)
+	 || ((fmt >= (firstCompiledMethodFormat()))
+	 && (!(((longAt((oop + BaseHeaderSize) + (((sqInt)((usqInt)(HeaderIndex) << (shiftForWord())))))) & 7) == 1)))))) {
+		concurrentlyDefer(oop);
+		return;
+	}
+	if (GIV(concurrentMarkStackTop) >= GIV(concurrentMarkStackCapacity)) {
+		stack = realloc(GIV(concurrentMarkStack), (GIV(concurrentMarkStackCapacity) * 2) * BytesPerOop);
+		if (stack == null) {
+			GIV(concurrentMarkFailed) = (GIV(concurrentMarkInvalidated) = 1);
+			return;
+		}
+		GIV(concurrentMarkStack) = stack;
+		GIV(concurrentMarkStackCapacity) = GIV(concurrentMarkStackCapacity) * 2;
+	}
+	GIV(concurrentMarkStack)[GIV(concurrentMarkStackTop)] = oop;
+	GIV(concurrentMarkStackTop) += 1;
+}
+
+/*	Mark the class and the referents of objOop, an object the concurrent
+	marker has reached; see concurrentlyMark:from:. The class is found
+	through the class table, as in markAndTraceClassOf:. An object whose
+	class cannot be marked here, because it is young or forwarded or
+	objOop has a duplicate class index, is deferred to the remark, whose
+	markAndTraceClassOf: deals with it. */
+
+	/* SpurMemoryManager>>#concurrentlyMarkReferentsOf: */
+static void NoDbgRegParms
+concurrentlyMarkReferentsOf(sqInt objOop)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt classIndex;
+    sqInt classObj;
+    sqInt classTablePage;
+    sqInt fmt;
+    sqInt header;
+    usqInt i;
+    sqInt methodHeader;
+    usqInt numPointerSlots;
+
+	header = longAt(objOop);
+	classIndex = header & (classIndexMask());
+	classTablePage = longAt((GIV(hiddenRootsObj) + BaseHeaderSize) + (((sqInt)((usqInt)((((usqInt) classIndex) >> (classTableMajorIndexShift()))) << (shiftForWord())))));
+	classObj = (classTablePage == GIV(nilObj)
+		? GIV(nilObj)
+		: longAt((classTablePage + BaseHeaderSize) + (((sqInt)((usqInt)((classIndex & ((1U << (classTableMajorIndexShift())) - 1))) << (shiftForWord()))))));
+	if ((classObj == GIV(nilObj))
+	 || (((((usqInt) classObj)) < GIV(concurrentMarkBitmapStart))
+	 || (((((usqInt) classObj)) >= GIV(concurrentMarkBitmapLimit))
+	 || ((((longAt(classObj)) & ((classIndexMask()) - (isForwardedObjectClassIndexPun()))) == 0)
+	 || (((long32At(classObj + 4)) & (identityHashHalfWordMask())) != classIndex))))) {
+		concurrentlyDefer(objOop);
+	}
+	else {
+		concurrentlyMarkfrom(classObj, 0);
+	}
+	fmt = (((usqInt) header) >> (formatShift())) & (formatMask());
+	if (fmt >= (firstCompiledMethodFormat())) {
+
+		/* it may have been jitted since it was reached */
+		methodHeader = longAt((objOop + BaseHeaderSize) + (((sqInt)((usqInt)(HeaderIndex) << (shiftForWord())))));
+		if (!(((methodHeader) & 7) == 1)) {
+			concurrentlyDefer(objOop);
+			return;
+		}
+		numPointerSlots = (((methodHeader >> 3)) & AlternateHeaderNumLiteralsMask) + LiteralStart;
+	}
+	else {
+		if (fmt >= (sixtyFourBitIndexableFormat())) {
+			return;
+		}
+		numPointerSlots = numSlotsOfAny(objOop);
+	}
+	for (i = 0; i < numPointerSlots; i += 1) {
+		concurrentlyMarkfrom(longAt((objOop + BaseHeaderSize) + (((sqInt)((usqInt)(i) << (shiftForWord()))))), objOop);
+	}
+}
+
+/*	The body of the concurrent marker's thread; see startConcurrentMark.
+	Trace from the objects on the concurrent mark stack until it is empty or
+	the mark has been invalidated, then note that the marker is done. */
+
+	/* SpurMemoryManager>>#concurrentMarkWorker: */
+static void
+concurrentMarkWorker(void *unused)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+	while ((GIV(concurrentMarkStackTop) > 0)
+	 && (!GIV(concurrentMarkInvalidated))) {
+		GIV(concurrentMarkStackTop) -= 1;
+		concurrentlyMarkReferentsOf(GIV(concurrentMarkStack)[GIV(concurrentMarkStackTop)]);
+	}
+	GIV(concurrentMarkEndUsecs) = ioUTCMicrosecondsNow();
+	sqLowLevelMFence();
+	GIV(concurrentMarkFinished) = 1;
+}
+
 
 /*	This is part of storeImageSegmentInto:outPointers:roots:.
 	Copy objOop into the segment beginning at segAddr, and forward it to the
@@ -47820,6 +50826,126 @@ currentAllocatedBytes(void)
 	return (GIV(statAllocatedBytes) + (GIV(freeStart) - (((eden()).start)))) + (use - GIV(oldSpaceUsePriorToScavenge));
 }
 
+/*	Once a full GC leaves more than shrinkThreshold bytes free, give the
+	pages of large free chunks back to the OS. Keep committed as much free
+	space as the heap may grow by before the next full GC is due, i.e.
+	heapGrowthToSizeGCRatio times the live heap but at least growHeadroom,
+	and decommit the rest from the highest chunks down, since the compactor
+	leaves free space at the top of the heap. When memory use is near the
+	process's limit keep only growHeadroom, whatever is free. The chunks stay on the free
+	lists; only the pages beyond their list links are released, and the OS
+	supplies fresh ones when they are allocated from again. */
+
+	/* SpurMemoryManager>>#decommitFreeSpace */
+static void NeverInline
+decommitFreeSpace(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    usqInt bytes;
+    usqInt decommittable;
+    sqInt followingWord;
+    sqInt followingWord1;
+    usqInt followingWordAddress;
+    usqInt followingWordAddress1;
+    usqInt keep;
+    sqInt objOop;
+    sqInt objOop1;
+    sqInt prevObj;
+    sqInt prevObj1;
+    sqInt prevPrevObj;
+    sqInt prevPrevObj1;
+    usqInt skip;
+    usqInt start;
+
+	if (((GIV(totalFreeOldSpace) <= GIV(shrinkThreshold))
+	 && (!GIV(memoryNearLimit)))
+	 || (checkAllocFiller)) {
+		return;
+	}
+	keep = (GIV(memoryNearLimit)
+		? GIV(growHeadroom)
+		: ((usqInt) (GIV(heapGrowthToSizeGCRatio) * GIV(heapSizeAtPreviousGC))));
+	if (keep < GIV(growHeadroom)) {
+		keep = GIV(growHeadroom);
+	}
+	if (GIV(totalFreeOldSpace) <= keep) {
+		return;
+	}
+	decommittable = 0;
+	/* begin allOldSpaceEntitiesFrom:do: */
+	assert(isOldObject(GIV(nilObj)));
+	prevPrevObj = (prevObj = null);
+	objOop = GIV(nilObj);
+	while (1) {
+		assert((objOop % (allocationUnit())) == 0);
+		if (!(oopisLessThan(objOop, GIV(endOfMemory)))) break;
+		assert((long64At(objOop)) != 0);
+		if ((((longAt(objOop)) & (classIndexMask())) == (isFreeObjectClassIndexPun()))
+		 && ((bytesInObject(objOop)) >= MinDecommitChunkBytes)) {
+			decommittable += bytesInObject(objOop);
+		}
+		prevPrevObj = prevObj;
+		prevObj = objOop;
+		/* begin objectAfter:limit: */
+		followingWordAddress = addressAfter(objOop);
+		if (oopisGreaterThanOrEqualTo(followingWordAddress, GIV(endOfMemory))) {
+			objOop = GIV(endOfMemory);
+			goto l1;
+		}
+		flag("endianness");
+		followingWord = longAt(followingWordAddress);
+		objOop = ((((usqInt) followingWord) >> (numSlotsFullShift())) == (numSlotsMask())
+			? followingWordAddress + BaseHeaderSize
+			: followingWordAddress);
+	l1:	/* end objectAfter:limit: */;
+	}
+	if (decommittable <= (GIV(totalFreeOldSpace) - keep)) {
+		skip = 0;
+	}
+	else {
+		skip = decommittable - (GIV(totalFreeOldSpace) - keep);
+	}
+	/* begin allOldSpaceEntitiesFrom:do: */
+	assert(isOldObject(GIV(nilObj)));
+	prevPrevObj1 = (prevObj1 = null);
+	objOop1 = GIV(nilObj);
+	while (1) {
+		assert((objOop1 % (allocationUnit())) == 0);
+		if (!(oopisLessThan(objOop1, GIV(endOfMemory)))) break;
+		assert((long64At(objOop1)) != 0);
+		if ((((longAt(objOop1)) & (classIndexMask())) == (isFreeObjectClassIndexPun()))
+		 && ((bytesInObject(objOop1)) >= MinDecommitChunkBytes)) {
+			bytes = bytesInObject(objOop1);
+			if (skip >= bytes) {
+				skip -= bytes;
+			}
+			else {
+
+				/* leave the header and the free list and tree links in place */
+				start = (objOop1 + BaseHeaderSize) + (5 /* freeChunkLargerIndex + 1 */ * BytesPerOop);
+				if (skip > (start - objOop1)) {
+					start = objOop1 + skip;
+				}
+				skip = 0;
+				GIV(statDecommittedBytes) += sqDecommitMemoryFromTo(start, addressAfter(objOop1));
+			}
+		}
+		prevPrevObj1 = prevObj1;
+		prevObj1 = objOop1;
+		/* begin objectAfter:limit: */
+		followingWordAddress1 = addressAfter(objOop1);
+		if (oopisGreaterThanOrEqualTo(followingWordAddress1, GIV(endOfMemory))) {
+			objOop1 = GIV(endOfMemory);
+			goto l2;
+		}
+		flag("endianness");
+		followingWord1 = longAt(followingWordAddress1);
+		objOop1 = ((((usqInt) followingWord1) >> (numSlotsFullShift())) == (numSlotsMask())
+			? followingWordAddress1 + BaseHeaderSize
+			: followingWordAddress1);
+	l2:	/* end objectAfter:limit: */;
+	}
+}
+
 	/* SpurMemoryManager>>#displayObject */
 sqInt
 displayObject(void)
@@ -47837,11 +50963,13 @@ displayObject(void)
 static void NoDbgRegParms
 doScavenge(sqInt tenuringCriterion)
 {   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt age;
     SpurNewSpaceSpace *aNewSpace;
     float fractionSurvived;
     sqInt oldStart;
     sqInt p;
     SpurNewSpaceSpace temp;
+    unsigned char *tempAges;
     usqInt use;
 
 	/* begin doAllocationAccountingForScavenge */
@@ -47858,6 +50986,20 @@ doScavenge(sqInt tenuringCriterion)
 	(GIV(scavengeLogRecord).sRememberedSetRedZone = GIV(rememberedSetRedZone));
 	(GIV(scavengeLogRecord).sRememberedSetLimit = GIV(rememberedSetLimit));
 	(GIV(scavengeLogRecord).sStatTenures = GIV(statTenures));
+	(GIV(scavengeLogRecord).sOldSpaceBytes = (GIV(totalHeapSizeIncludingBridges) - (GIV(numSegments) * (2 * BaseHeaderSize))) - GIV(totalFreeOldSpace));
+	(GIV(scavengeLogRecord).sStatTenuredBytes = GIV(statTenuredBytes));
+	if (tenuringAge > MaxSurvivorAge) {
+
+		/* ages saturate at MaxSurvivorAge, so an older tenuring age set by
+		   -tenuringage would never be reached */
+		tenuringAge = MaxSurvivorAge;
+	}
+	if (GIV(pastSpaceAges) == null) {
+		allocateSurvivorAgeTables();
+	}
+	for (age = 0; age <= MaxSurvivorAge; age += 1) {
+		GIV(survivorBytesByAge)[age] = 0;
+	}
 	/* begin strategizeToLimitRememberedTable */
 	if ((GIV(tenureCriterion) == TenureByAge)
 	 && (GIV(rememberedSetSize) >= GIV(rememberedSetRedZone))) {
@@ -47873,6 +51015,10 @@ doScavenge(sqInt tenuringCriterion)
 	(GIV(scavengeLogRecord).tRefCountToShrinkRT = GIV(refCountToShrinkRT));
 	scavengeLoop();
 	processWeaklings();
+	if (useCardMarking
+	 && (tenuringCriterion != MarkOnTenure)) {
+		cardLargeRememberedObjects();
+	}
 	/* begin computeTenuringThreshold */
 	fractionSurvived = (((GIV(futureSpace).limit)) == ((GIV(futureSpace).start))
 		? 0.0
@@ -47884,10 +51030,18 @@ doScavenge(sqInt tenuringCriterion)
 	temp = GIV(pastSpace);
 	GIV(pastSpace) = GIV(futureSpace);
 	GIV(futureSpace) = temp;
+	tempAges = GIV(pastSpaceAges);
+	GIV(pastSpaceAges) = GIV(futureSpaceAges);
+	GIV(futureSpaceAges) = tempAges;
 	/* begin logEndScavenge */
 	(GIV(scavengeLogRecord).eSurvivorBytes = GIV(futureSurvivorStart) - ((GIV(pastSpace).start)));
 	(GIV(scavengeLogRecord).eRememberedSetSize = GIV(rememberedSetSize));
 	(GIV(scavengeLogRecord).eStatTenures = GIV(statTenures));
+	(GIV(scavengeLogRecord).eOldSpaceBytes = (GIV(totalHeapSizeIncludingBridges) - (GIV(numSegments) * (2 * BaseHeaderSize))) - GIV(totalFreeOldSpace));
+	(GIV(scavengeLogRecord).eStatTenuredBytes = GIV(statTenuredBytes));
+	for (age = 0; age <= MaxSurvivorAge; age += 1) {
+		GIV(statSurvivorBytesByAge)[age] += GIV(survivorBytesByAge)[age];
+	}
 	/* begin initFutureSpaceStart */
 	oldStart = GIV(futureSurvivorStart);
 	GIV(futureSurvivorStart) = (GIV(futureSpace).start);
@@ -48021,6 +51175,7 @@ ensureRoomOnObjStackAt(sqInt objStackRootIndex)
 				/* begin setIsMarkedOf:to: */
 				assert(!(isFreeObject(freeOrNewPage)));
 				longAtput(freeOrNewPage, (longAt(freeOrNewPage)) | (1ULL << (markedBitFullShift())));
+				noteLiveBytesof(bytesInObject(freeOrNewPage), freeOrNewPage);
 			}
 		}
 		/* begin storePointer:ofObjStack:withValue: */
@@ -48086,6 +51241,37 @@ ensureRoomOnObjStackAt(sqInt objStackRootIndex)
 	return stackOrNil;
 }
 
+/*	Ensure there are numWorkers parallel sweep threads' free lists, and
+	empty them. Answer false if they could not be allocated, in which case
+	the sweep is serial. */
+
+	/* SpurMemoryManager>>#ensureSweepWorkers: */
+static sqInt NoDbgRegParms
+ensureSweepWorkers(sqInt numWorkers)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt i;
+    SpurSweepWorker *worker;
+    SpurSweepWorker *workers;
+
+	if (numWorkers > GIV(sweepWorkersCapacity)) {
+		workers = realloc(GIV(sweepWorkers), numWorkers * sizeof(SpurSweepWorker));
+		if (workers == null) {
+			return 0;
+		}
+		memset(workers + GIV(sweepWorkersCapacity), 0, (numWorkers - GIV(sweepWorkersCapacity)) * sizeof(SpurSweepWorker));
+		GIV(sweepWorkers) = workers;
+		GIV(sweepWorkersCapacity) = numWorkers;
+	}
+	for (i = 0; i < numWorkers; i += 1) {
+		worker = (&(GIV(sweepWorkers)[i]));
+		memset((worker->freeListHeads), 0, sizeof((worker->freeListHeads)));
+		memset((worker->freeListTails), 0, sizeof((worker->freeListTails)));
+		(worker->numChunks = 0);
+		(worker->freeBytes = 0);
+	}
+	return 1;
+}
+
 
 /*	Enter aBehavior into the class table and answer 0. Otherwise answer a
 	primitive failure code. */
@@ -48429,6 +51615,87 @@ findLargestFreeChunk(void)
 	return treeNode;
 }
 
+/*	Wait for the concurrent marker, or finish a mark being made in steps,
+	and, unless its mark was invalidated or failed, make its marks the
+	starting point of the mark with the world stopped, answering whether
+	they can be used. Before its bitmap's marks
+	are copied into the object headers, the objects it reached on the pages
+	the mutator has written since it began are recorded for
+	rescanConcurrentlyMarkedObjects; see recordConcurrentRescansIn:. The
+	objects it deferred are left unmarked, for the remark to trace in full. */
+
+	/* SpurMemoryManager>>#finishConcurrentMark */
+static sqInt
+finishConcurrentMark(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    usqInt bits;
+    sqInt i;
+    usqInt numWords;
+    sqInt objOop;
+    usqInt word;
+
+	if (GIV(concurrentMarkSteps)) {
+
+		/* mark what the steps have yet to, with the world stopped */
+		concurrentMarkWorker(0);
+	}
+	else {
+		ioWaitForBackgroundGCWork();
+	}
+	GIV(concurrentMarkInProgress) = 0;
+	for (i = 0; (i < GIV(numSegments))
+		 && (!(GIV(concurrentMarkInvalidated)
+		 || (GIV(concurrentMarkFailed)))); i += 1) {
+		recordConcurrentRescansIn((&(GIV(segments)[i])));
+	}
+	if (GIV(concurrentMarkInvalidated)
+	 || (GIV(concurrentMarkFailed))) {
+		releaseConcurrentMark();
+		return 0;
+	}
+	numWords = (((GIV(concurrentMarkBitmapLimit) - GIV(concurrentMarkBitmapStart)) >> 3) / 64) + 1;
+	for (word = 0; word < numWords; word += 1) {
+		bits = GIV(concurrentMarkBitmap)[word];
+		objOop = GIV(concurrentMarkBitmapStart) + ((word * 64) << 3);
+		while (bits != 0) {
+			if (((bits & 1) != 0)
+			 && ((((longAt(objOop)) & (classIndexMask())) > (lastClassIndexPun())))) {
+				/* begin setIsMarkedOf:to: */
+				longAtput(objOop, (longAt(objOop)) | (1ULL << (markedBitFullShift())));
+				noteLiveBytesof(bytesInObject(objOop), objOop);
+			}
+			bits = bits >> 1;
+			objOop += 8 /* allocationUnit */;
+		}
+	}
+	for (i = 0; i < GIV(concurrentMarkDeferredCount); i += 1) {
+		objOop = GIV(concurrentMarkDeferred)[i];
+		if (((((usqInt) (longAt(objOop))) >> (markedBitFullShift())) & 1) != 0) {
+			noteLiveBytesof(-(bytesInObject(objOop)), objOop);
+		}
+		/* begin setIsMarkedOf:to: */
+		longAtput(objOop, (longAt(objOop)) & (~(usqIntptr_t)(1ULL << (markedBitFullShift()))));
+	}
+	GIV(statConcurrentMarks) += 1;
+	GIV(statConcurrentMarkUsecs) += GIV(concurrentMarkEndUsecs) - GIV(concurrentMarkStartUsecs);
+	return 1;
+}
+
+
+/*	Sweep the rest of old space if an incremental sweep is under way. Called
+	before anything that enumerates the heap or depends on mark bits, since
+	until it is swept old space holds dead objects whose referents may have
+	been freed, and live objects that are still marked. */
+
+	/* SpurMemoryManager>>#finishIncrementalSweep */
+static void
+finishIncrementalSweep(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+	if (GIV(sweepCursor) != 0) {
+		incrementalSweepStepForbytes(0, 0);
+	}
+}
+
 
 /*	Print the oops of all string-like things that start with the same
 	characters as aCString
@@ -48722,11 +51989,13 @@ firstAccessibleObject(void)
 {   DECL_MAYBE_SQ_GLOBAL_STRUCT
     sqInt savedTenuringThreshold;
 
+	finishIncrementalSweep();
 	assert(GIV(nilObj) == GIV(oldSpaceStart));
 	/* begin flushNewSpace */
 	savedTenuringThreshold = GIV(tenureThreshold);
 	/* begin setRawTenuringThreshold: */
 	GIV(tenureThreshold) = GIV(newSpaceLimit);
+	GIV(gcCause) = "enumeration";
 	scavengingGCTenuringIf(TenureByAge);
 	/* begin setRawTenuringThreshold: */
 	GIV(tenureThreshold) = savedTenuringThreshold;
@@ -49147,12 +52416,16 @@ freeObject(sqInt objOop)
     sqInt address;
     usqInt bytes;
     usqInt chunkBytes;
+    sqInt classIndex;
     sqInt index;
     sqInt next;
     usqInt numSlots;
     usqInt start;
 
 	assert(isInOldSpace(objOop));
+	if (GIV(numCardedObjects) > 0) {
+		forgetCardedObject(objOop);
+	}
 	if (((((usqInt) (longAt(objOop))) >> (rememberedBitShift())) & 1) != 0) {
 		/* begin forgetObject: */
 		assert(GIV(rememberedSetSize) > 0);
@@ -49174,6 +52447,16 @@ freeObject(sqInt objOop)
 		GIV(rememberedSetSize) -= 1;
 		assert(GIV(rememberedSetSize) >= 0);
 	}
+	if (GIV(concurrentMarkInProgress)
+	 && ((((longAt(objOop)) & (classIndexMask())) != (isFreeObjectClassIndexPun())))) {
+
+		/* The concurrent marker may yet read objOop, so it must not be reused
+		   before the remark; leave it as a filler for the next GC to reclaim. */
+		/* begin set:classIndexTo:formatTo: */
+		classIndex = sixtyFourBitLongsClassIndexPun();
+		longAtput(objOop, ((longAt(objOop)) & (~(usqIntptr_t)((((sqInt)((usqInt)((formatMask())) << (formatShift())))) + (classIndexMask())))) + (classIndex + (((sqInt)((usqInt)((firstLongFormat())) << (formatShift()))))));
+		return objOop;
+	}
 	bytes = bytesInObject(objOop);
 	start = ((byteAt(objOop + 7)) == (numSlotsMask())
 		? objOop - BaseHeaderSize
@@ -49184,7 +52467,9 @@ freeObject(sqInt objOop)
 	next = (numSlots == (numSlotsMask())
 		? address + BaseHeaderSize
 		: address);
-	if (((longAt(next)) & (classIndexMask())) == (isFreeObjectClassIndexPun())) {
+	if ((((longAt(next)) & (classIndexMask())) == (isFreeObjectClassIndexPun()))
+	 && ((GIV(sweepCursor) == 0)
+	 || (oopisLessThan(next, GIV(sweepCursor))))) {
 		/* begin detachFreeObject: */
 		chunkBytes = bytesInObject(next);
 		GIV(totalFreeOldSpace) -= chunkBytes;
@@ -49213,17 +52498,35 @@ fullGC(void)
     usqInt numSlots;
     sqInt obj;
     sqInt objOop;
+    usqLong rootMarkUsecs;
 
+	finishIncrementalSweep();
+	for (i = 0; i < NumPinnedBufferClasses; i += 1) {
+
+		/* pooled buffers are referenced from nowhere else, and so are collected */
+		GIV(pinnedBufferPool)[i] = 0;
+		GIV(pinnedBufferPoolCounts)[i] = 0;
+	}
 	GIV(needGCFlag) = 0;
 	GIV(gcStartUsecs) = ioUTCMicrosecondsNow();
 	GIV(statMarkCount) = 0;
+	GIV(gcLogBytesBefore) = (GIV(totalHeapSizeIncludingBridges) - (GIV(numSegments) * (2 * BaseHeaderSize))) - GIV(totalFreeOldSpace);
+	GIV(gcLogTenuredBytesBefore) = GIV(statTenuredBytes);
 	preGCAction(GCModeFull);
+	for (i = 0; i < GIV(numSegments); i += 1) {
+		((GIV(segments)[i]).liveBytes = 0);
+	}
+	GIV(liveBytesSegmentIndex) = 0;
 	/* begin globalGarbageCollect */
 	assert(validObjStacks());
 	assert(isEmptyObjStack(GIV(markStack)));
 	assert(isEmptyObjStack(GIV(weaklingStack)));
 	markObjects(1);
+	poolReleasedPinnedBuffers();
 	gcMarkEndUsecs = ioUTCMicrosecondsNow();
+	if (GIV(numCardedObjects) > 0) {
+		flushCardedObjects();
+	}
 	/* begin forgetUnmarkedRememberedObjects */
 	index = 0;
 	while (index < GIV(rememberedSetSize)) {
@@ -49241,8 +52544,13 @@ fullGC(void)
 		}
 	}
 	assert(GIV(rememberedSetSize) >= 0);
+	rootMarkUsecs = ioUTCMicrosecondsNow() - gcMarkEndUsecs;
+	GIV(statRootMarkUsecs) += rootMarkUsecs;
 	doScavenge(MarkOnTenure);
 	runLeakCheckerForexcludeUnmarkedObjsclassIndicesShouldBeValid(GCModeFull, 1, 1);
+	if (GIV(numLargeObjectSegments) > 0) {
+		freeDeadLargeObjectSegments();
+	}
 	compactionStartUsecs = ioUTCMicrosecondsNow();
 	/* begin prepareForGlobalSweep */
 	GIV(sweepIndex) = 0;
@@ -49257,22 +52565,55 @@ fullGC(void)
 		: address);
 	assert(!(isFreeObject(objOop)));
 	longAtput(objOop, (longAt(objOop)) | (1ULL << (markedBitFullShift())));
-	compact();
-	/* begin attemptToShrink */
-	if ((GIV(totalFreeOldSpace) > GIV(shrinkThreshold))
-	 && ((GIV(totalFreeOldSpace) > GIV(growHeadroom))
-	 && (shrinkObjectMemory((((GIV(totalFreeOldSpace) - GIV(growHeadroom)) < GIV(growHeadroom)) ? GIV(growHeadroom) : (GIV(totalFreeOldSpace) - GIV(growHeadroom))))))) {
-		GIV(statShrinkMemory) += 1;
+	GIV(gcSweepEndUsecs) = 0;
+	if (GIV(biasForGC)
+	 && (maxGCPauseUsecs > 0)) {
+
+		/* sliding compaction can't be done in steps, so with a pause target sweep instead, incrementally */
+		beginIncrementalSweep();
+	}
+	else {
+		if (GIV(biasForGC)
+		 && (shouldSweepInsteadOfCompacting())) {
+			sweepWithoutCompacting();
+		}
+		else {
+			compact();
+		}
+	}
+	if (GIV(numPinnedSegments) > 0) {
+		if (GIV(biasForGC)) {
+			if (GIV(sweepCursor) == 0) {
+				freeEmptyPinnedSegments();
+			}
+		}
+		else {
+			forgetPinnedSegments();
+		}
+	}
+	if (GIV(sweepCursor) == 0) {
+		/* begin attemptToShrink */
+		if ((GIV(totalFreeOldSpace) > GIV(shrinkThreshold))
+		 && ((GIV(totalFreeOldSpace) > GIV(growHeadroom))
+		 && (shrinkObjectMemory((((GIV(totalFreeOldSpace) - GIV(growHeadroom)) < GIV(growHeadroom)) ? GIV(growHeadroom) : (GIV(totalFreeOldSpace) - GIV(growHeadroom))))))) {
+			GIV(statShrinkMemory) += 1;
+		}
 	}
 	/* begin setHeapSizeAtPreviousGC */
 	GIV(heapSizeAtPreviousGC) = (GIV(totalHeapSizeIncludingBridges) - (GIV(numSegments) * (2 * BaseHeaderSize))) - GIV(totalFreeOldSpace);
 	/* begin resetAllocationAccountingAfterGC */
 	GIV(oldSpaceUsePriorToScavenge) = (GIV(totalHeapSizeIncludingBridges) - (GIV(numSegments) * (2 * BaseHeaderSize))) - GIV(totalFreeOldSpace);
+	if (GIV(sweepCursor) == 0) {
+		decommitFreeSpace();
+	}
 	assert(validObjStacks());
 	assert(isEmptyObjStack(GIV(markStack)));
 	assert(isEmptyObjStack(GIV(weaklingStack)));
-	assert(allObjectsUnmarked());
-	runLeakCheckerFor(GCModeFull);
+	assert((GIV(sweepCursor) != 0)
+	 || (allObjectsUnmarked()));
+	if (GIV(sweepCursor) == 0) {
+		runLeakCheckerFor(GCModeFull);
+	}
 	postGCAction(GCModeFull);
 	GIV(statGCEndUsecs) = ioUTCMicrosecondsNow();
 	/* begin updateFullGCStats */
@@ -49283,6 +52624,10 @@ fullGC(void)
 		GIV(statSweepUsecs) += GIV(gcSweepEndUsecs) - compactionStartUsecs;
 	}
 	GIV(statMarkUsecs) += gcMarkEndUsecs - GIV(gcStartUsecs);
+	if (!(GIV(gcLog) == null)) {
+		writeFullGCLogRecordrootMarkcompactionStart(gcMarkEndUsecs, rootMarkUsecs, compactionStartUsecs);
+	}
+	GIV(gcCause) = null;
 	return ((GIV(freeLists)[0]) != 0
 		? bytesInObject(findLargestFreeChunk())
 		: 0);
@@ -49505,6 +52850,99 @@ incrementalGC(void)
 	error("shouldNotImplement");
 }
 
+
+/*	Run a step of a mark being made in steps, rather than on a thread of its
+	own, because there is a pause target; see startConcurrentMark. Trace from
+	the concurrent mark stack as concurrentMarkWorker: does, for at most
+	budgetUsecs, and account for the step as an incremental GC. The mark is
+	made exactly as the concurrent marker makes it, so it needs nothing more
+	from the mutator between steps than the concurrent mark needs while it
+	runs. */
+
+	/* SpurMemoryManager>>#incrementalMarkStepFor: */
+static void NoDbgRegParms NeverInline
+incrementalMarkStepFor(usqLong budgetUsecs)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt count;
+    sqInt done;
+    usqLong startUsecs;
+    usqLong usecs;
+
+	assert(GIV(concurrentMarkSteps));
+	startUsecs = ioUTCMicrosecondsNow();
+	count = 0;
+	done = 0;
+	while ((!done)
+	 && ((GIV(concurrentMarkStackTop) > 0)
+	 && (!GIV(concurrentMarkInvalidated)))) {
+		GIV(concurrentMarkStackTop) -= 1;
+		concurrentlyMarkReferentsOf(GIV(concurrentMarkStack)[GIV(concurrentMarkStackTop)]);
+		if (((((count += 1)) % 256) == 0)
+		 && ((ioUTCMicrosecondsNow() - startUsecs) >= budgetUsecs)) {
+			done = 1;
+		}
+	}
+	GIV(incrGCStepEndUsecs) = ioUTCMicrosecondsNow();
+	if ((GIV(concurrentMarkStackTop) == 0)
+	 || (GIV(concurrentMarkInvalidated))) {
+		GIV(concurrentMarkEndUsecs) = GIV(incrGCStepEndUsecs);
+		GIV(concurrentMarkFinished) = 1;
+	}
+	usecs = GIV(incrGCStepEndUsecs) - startUsecs;
+	/* begin noteIncrementalGCStepUsecs: */
+	GIV(statIncrGCs) += 1;
+	GIV(statIncrGCUsecs) += usecs;
+	GIV(statIGCDeltaUsecs) = usecs;
+	if (usecs > GIV(statMaxIncrGCUsecs)) {
+		GIV(statMaxIncrGCUsecs) = usecs;
+	}
+	if (!(GIV(gcLog) == null)) {
+		writeIncrementalMarkLogRecordusecs(startUsecs, usecs);
+	}
+}
+
+
+/*	Run a step of the incremental sweep, as sweepIncrementallyFor:bytes:,
+	and account for it as an incremental GC. Once all of old space has been
+	swept, give back empty segments and decommit free space as fullGC does
+	after a sweep, unless the step was taken within a scavenge. */
+
+	/* SpurMemoryManager>>#incrementalSweepStepFor:bytes: */
+static void NoDbgRegParms NeverInline
+incrementalSweepStepForbytes(usqLong budgetUsecs, usqInt wantedBytes)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    usqLong startUsecs;
+    usqLong usecs;
+
+	startUsecs = ioUTCMicrosecondsNow();
+	sweepIncrementallyForbytes(budgetUsecs, wantedBytes);
+	if ((GIV(sweepCursor) == 0)
+	 && (GIV(gcPhaseInProgress) == 0)) {
+		if (GIV(numPinnedSegments) > 0) {
+			freeEmptyPinnedSegments();
+		}
+		/* begin attemptToShrink */
+		if ((GIV(totalFreeOldSpace) > GIV(shrinkThreshold))
+		 && ((GIV(totalFreeOldSpace) > GIV(growHeadroom))
+		 && (shrinkObjectMemory((((GIV(totalFreeOldSpace) - GIV(growHeadroom)) < GIV(growHeadroom)) ? GIV(growHeadroom) : (GIV(totalFreeOldSpace) - GIV(growHeadroom))))))) {
+			GIV(statShrinkMemory) += 1;
+		}
+		decommitFreeSpace();
+	}
+	GIV(incrGCStepEndUsecs) = ioUTCMicrosecondsNow();
+	usecs = GIV(incrGCStepEndUsecs) - startUsecs;
+	/* begin noteIncrementalGCStepUsecs: */
+	GIV(statIncrGCs) += 1;
+	GIV(statIncrGCUsecs) += usecs;
+	GIV(statIGCDeltaUsecs) = usecs;
+	if (usecs > GIV(statMaxIncrGCUsecs)) {
+		GIV(statMaxIncrGCUsecs) = usecs;
+	}
+	if (!(GIV(gcLog) == null)) {
+		writeIncrementalSweepLogRecordusecs(startUsecs, usecs);
+	}
+}
+
 	/* SpurMemoryManager>>#indexOf:in: */
 sqInt
 indexOfin(sqInt anElement, sqInt anObject)
@@ -49662,6 +53100,7 @@ initialInstanceOf(sqInt classObj)
     sqInt prevPrevObj;
     sqInt prevPrevObj1;
 
+	finishIncrementalSweep();
 	classIndex = (long32At(classObj + 4)) & (identityHashHalfWordMask());
 	if (classIndex == 0) {
 		return null;
@@ -49675,6 +53114,7 @@ initialInstanceOf(sqInt classObj)
 	}
 	/* begin tenuringClassIndex: */
 	GIV(tenuringClassIndex) = classIndex1;
+	GIV(gcCause) = "enumeration";
 	scavengingGCTenuringIf(TenureByClass);
 	assert(!(existInstancesInNewSpaceOf(classObj)));
 	l1:	/* end flushNewSpaceInstancesOf: */;
@@ -49882,62 +53322,65 @@ initializeObjectMemory(sqInt bytesToShift)
 	l11:	/* end countNumClassPagesPreSwizzle: */;
 	if ((bytesToShift != 0)
 	 || ((numSegments()) > 1)) {
-		/* begin objectStartingAt: */
-		numSlots = byteAt(GIV(oldSpaceStart) + 7);
-		obj = (numSlots == (numSlotsMask())
-			? GIV(oldSpaceStart) + BaseHeaderSize
-			: GIV(oldSpaceStart));
-		while (oopisLessThan(obj, GIV(freeOldSpaceStart))) {
-			classIndex1 = (longAt(obj)) & (classIndexMask());
-			if (classIndex1 >= (isForwardedObjectClassIndexPun())) {
-				/* begin swizzleFieldsOfObject: */
-				fieldAddr = obj + (lastPointerOfWhileSwizzling(obj));
-				while (oopisGreaterThanOrEqualTo(fieldAddr, obj + BaseHeaderSize)) {
-					fieldOop = longAt(fieldAddr);
-					if ((fieldOop & (tagMask())) == 0) {
-						longAtput(fieldAddr, swizzleObj(fieldOop));
+		if (!(swizzleObjectsInParallel())) {
+			/* begin objectStartingAt: */
+			numSlots = byteAt(GIV(oldSpaceStart) + 7);
+			obj = (numSlots == (numSlotsMask())
+				? GIV(oldSpaceStart) + BaseHeaderSize
+				: GIV(oldSpaceStart));
+			while (oopisLessThan(obj, GIV(freeOldSpaceStart))) {
+				classIndex1 = (longAt(obj)) & (classIndexMask());
+				if (classIndex1 >= (isForwardedObjectClassIndexPun())) {
+					/* begin swizzleFieldsOfObject: */
+					fieldAddr = obj + (lastPointerOfWhileSwizzling(obj));
+					while (oopisGreaterThanOrEqualTo(fieldAddr, obj + BaseHeaderSize)) {
+						fieldOop = longAt(fieldAddr);
+						if ((fieldOop & (tagMask())) == 0) {
+							longAtput(fieldAddr, swizzleObj(fieldOop));
+						}
+						fieldAddr -= BytesPerOop;
 					}
-					fieldAddr -= BytesPerOop;
 				}
-			}
-			else {
-				if (classIndex1 == (isFreeObjectClassIndexPun())) {
-					/* begin swizzleFieldsOfFreeChunk: */
-					fieldIndex3 = 0 /* freeChunkNextIndex */;
-					field = longAt((obj + BaseHeaderSize) + (((sqInt)((usqInt)(fieldIndex3) << (shiftForWord())))));
-					if (field != 0) {
-						/* begin storePointerNoAssert:ofFreeChunk:withValue: */
-						fieldIndex4 = 0 /* freeChunkNextIndex */;
-						valuePointer = swizzleObj(field);
-						longAtput((obj + BaseHeaderSize) + (((sqInt)((usqInt)(fieldIndex4) << (shiftForWord())))), valuePointer);
-					}
-					chunkBytes = bytesInObject(obj);
-					if (chunkBytes >= (64 /* numFreeLists */ * 8 /* allocationUnit */)) {
-						for (index = 2 /* freeChunkParentIndex */, indexLimiT = 4 /* freeChunkLargerIndex */; index <= indexLimiT; index += 1) {
-							/* begin fetchPointer:ofFreeChunk: */
-							field = longAt((obj + BaseHeaderSize) + (((sqInt)((usqInt)(index) << (shiftForWord())))));
-							if (field != 0) {
-								/* begin storePointerNoAssert:ofFreeChunk:withValue: */
-								valuePointer2 = swizzleObj(field);
-								longAtput((obj + BaseHeaderSize) + (((sqInt)((usqInt)(index) << (shiftForWord())))), valuePointer2);
+				else {
+					if (classIndex1 == (isFreeObjectClassIndexPun())) {
+						/* begin swizzleFieldsOfFreeChunk: */
+						fieldIndex3 = 0 /* freeChunkNextIndex */;
+						field = longAt((obj + BaseHeaderSize) + (((sqInt)((usqInt)(fieldIndex3) << (shiftForWord())))));
+						if (field != 0) {
+							/* begin storePointerNoAssert:ofFreeChunk:withValue: */
+							fieldIndex4 = 0 /* freeChunkNextIndex */;
+							valuePointer = swizzleObj(field);
+							longAtput((obj + BaseHeaderSize) + (((sqInt)((usqInt)(fieldIndex4) << (shiftForWord())))), valuePointer);
+						}
+						chunkBytes = bytesInObject(obj);
+						if (chunkBytes >= (64 /* numFreeLists */ * 8 /* allocationUnit */)) {
+							for (index = 2 /* freeChunkParentIndex */, indexLimiT = 4 /* freeChunkLargerIndex */; index <= indexLimiT; index += 1) {
+								/* begin fetchPointer:ofFreeChunk: */
+								field = longAt((obj + BaseHeaderSize) + (((sqInt)((usqInt)(index) << (shiftForWord())))));
+								if (field != 0) {
+									/* begin storePointerNoAssert:ofFreeChunk:withValue: */
+									valuePointer2 = swizzleObj(field);
+									longAtput((obj + BaseHeaderSize) + (((sqInt)((usqInt)(index) << (shiftForWord())))), valuePointer2);
+								}
 							}
 						}
 					}
 				}
+				/* begin objectAfter:limit: */
+				followingWordAddress = addressAfter(obj);
+				if (oopisGreaterThanOrEqualTo(followingWordAddress, GIV(endOfMemory))) {
+					obj = GIV(endOfMemory);
+					goto l14;
+				}
+				flag("endianness");
+				followingWord = longAt(followingWordAddress);
+				obj = ((((usqInt) followingWord) >> (numSlotsFullShift())) == (numSlotsMask())
+					? followingWordAddress + BaseHeaderSize
+					: followingWordAddress);
+		l14:	/* end objectAfter:limit: */;
 			}
-			/* begin objectAfter:limit: */
-			followingWordAddress = addressAfter(obj);
-			if (oopisGreaterThanOrEqualTo(followingWordAddress, GIV(endOfMemory))) {
-				obj = GIV(endOfMemory);
-				goto l14;
-			}
-			flag("endianness");
-			followingWord = longAt(followingWordAddress);
-			obj = ((((usqInt) followingWord) >> (numSlotsFullShift())) == (numSlotsMask())
-				? followingWordAddress + BaseHeaderSize
-				: followingWordAddress);
-	l14:	/* end objectAfter:limit: */;
 		}
+		printLoadPhaseTime("swizzled the heap");
 	}
 
 	/* heavily used special objects */
@@ -50330,6 +53773,9 @@ instantiateClass(sqInt classObj)
 	assert((numBytes % (allocationUnit())) == 0);
 	assert((newObj1 % (allocationUnit())) == 0);
 	GIV(freeStart) += numBytes;
+	if (GIV(allocationSampleInterval) > 0) {
+		sampleAllocationbytes(newObj1, numBytes);
+	}
 	newObj = newObj1;
 	l4:	/* end allocateSlots:format:classIndex: */;
 	if (!(newObj == null)) {
@@ -50365,6 +53811,21 @@ instSpecOfClass(sqInt classPointer)
 	return (((usqInt) classFormat) >> (fixedFieldsFieldWidth())) & (formatMask());
 }
 
+/*	Tell the concurrent marker, if there is one, that the mutator is about
+	to move or exchange objects, after which its marks cannot be trusted. It
+	stops soon after, and the next full GC marks with the world stopped.
+	Until it has been waited for no object is freed; see freeObject:. */
+
+	/* SpurMemoryManager>>#invalidateConcurrentMark */
+static void
+invalidateConcurrentMark(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+	if (GIV(concurrentMarkInProgress)) {
+		GIV(concurrentMarkInvalidated) = 1;
+		sqLowLevelMFence();
+	}
+}
+
 
 /*	the inverse of isPureBitsFormat: */
 
@@ -51540,6 +55001,8 @@ loadImageSegmentFromoutPointers(sqInt segmentWordArray, sqInt outPointerArray)
     sqInt segmentStart;
     sqInt segVersion;
 
+	finishIncrementalSweep();
+	abortConcurrentMark();
 	/* begin numSlotsOf: */
 	assert((classIndexOf(segmentWordArray)) > (isForwardedObjectClassIndexPun()));
 	numSlots = byteAt(segmentWordArray + 7);
@@ -51774,6 +55237,9 @@ loadImageSegmentFromoutPointers(sqInt segmentWordArray, sqInt outPointerArray)
 	assert((numBytes % (allocationUnit())) == 0);
 	assert((newObj % (allocationUnit())) == 0);
 	GIV(freeStart) += numBytes;
+	if (GIV(allocationSampleInterval) > 0) {
+		sampleAllocationbytes(newObj, numBytes);
+	}
 	loadedObjectsArray = newObj;
 	l8:	/* end allocateSlots:format:classIndex: */;
 	if (!(loadedObjectsArray)) {
@@ -52634,6 +56100,7 @@ markAndTraceClassOf(sqInt objOop)
 		/* begin setIsMarkedOf:to: */
 		assert(!(isFreeObject(classObj)));
 		longAtput(classObj, (longAt(classObj)) | (1ULL << (markedBitFullShift())));
+		noteLiveBytesof(bytesInObject(classObj), classObj);
 		markAndTraceClassOf(classObj);
 		/* begin push:onObjStack: */
 		objStack = GIV(markStack);
@@ -52676,6 +56143,7 @@ markAndTraceObjStackandContents(sqInt stackOrNil, sqInt markAndTraceContents)
 	/* begin setIsMarkedOf:to: */
 	assert(!(isFreeObject(stackOrNil)));
 	longAtput(stackOrNil, (longAt(stackOrNil)) | (1ULL << (markedBitFullShift())));
+	noteLiveBytesof(bytesInObject(stackOrNil), stackOrNil);
 	assert((numSlotsOfAny(stackOrNil)) == ObjStackPageSlots);
 	/* begin fetchPointer:ofObject: */
 	field = longAt((stackOrNil + BaseHeaderSize) + (((sqInt)((usqInt)(ObjStackNextx) << (shiftForWord())))));
@@ -52690,6 +56158,7 @@ markAndTraceObjStackandContents(sqInt stackOrNil, sqInt markAndTraceContents)
 		/* begin setIsMarkedOf:to: */
 		assert(!(isFreeObject(field)));
 		longAtput(field, (longAt(field)) | (1ULL << (markedBitFullShift())));
+		noteLiveBytesof(bytesInObject(field), field);
 	}
 	if (!markAndTraceContents) {
 		return;
@@ -52761,6 +56230,7 @@ markAndTrace(sqInt objOop)
 	/* begin setIsMarkedOf:to: */
 	assert(!(isFreeObject(objOop)));
 	longAtput(objOop, (longAt(objOop)) | (1ULL << (markedBitFullShift())));
+	noteLiveBytesof(bytesInObject(objOop), objOop);
 	format1 = (((usqInt) (longAt(objOop))) >> (formatShift())) & (formatMask());
 	if ((format1 >= (sixtyFourBitIndexableFormat()))
 	 && (format1 < (firstCompiledMethodFormat()))) {
@@ -52907,6 +56377,7 @@ markAndTrace(sqInt objOop)
 					/* begin setIsMarkedOf:to: */
 					assert(!(isFreeObject(field)));
 					longAtput(field, (longAt(field)) | (1ULL << (markedBitFullShift())));
+					noteLiveBytesof(bytesInObject(field), field);
 					format11 = (((usqInt) (longAt(field))) >> (formatShift())) & (formatMask());
 					if ((format11 >= (sixtyFourBitIndexableFormat()))
 					 && (format11 < (firstCompiledMethodFormat()))) {
@@ -53025,6 +56496,7 @@ markAndTrace(sqInt objOop)
 					/* begin setIsMarkedOf:to: */
 					assert(!(isFreeObject(field)));
 					longAtput(field, (longAt(field)) | (1ULL << (markedBitFullShift())));
+					noteLiveBytesof(bytesInObject(field), field);
 					format11 = (((usqInt) (longAt(field))) >> (formatShift())) & (formatMask());
 					if ((format11 >= (sixtyFourBitIndexableFormat()))
 					 && (format11 < (firstCompiledMethodFormat()))) {
@@ -53184,6 +56656,7 @@ markObjects(sqInt objectsShouldBeUnmarkedAndUnmarkedClassesShouldBeExpunged)
     sqInt i2;
     sqInt i3;
     sqInt i4;
+    sqInt i5;
     sqInt iLimiT;
     sqInt j;
     sqInt jLimiT;
@@ -53198,13 +56671,25 @@ markObjects(sqInt objectsShouldBeUnmarkedAndUnmarkedClassesShouldBeExpunged)
     sqInt referent2;
     sqInt referent3;
     sqInt referent4;
+    sqInt remarking;
+    usqLong remarkStartUsecs;
+    usqLong rootMarkStartUsecs;
     sqInt sizeOfUnusedEden;
     StackPage *thePage;
 
 	runLeakCheckerFor(GCModeFull);
+
+	/* If old space has been marked in the background the marks it left are
+	   kept, and this mark is the remark that completes them; see
+	   startConcurrentMark. */
+	remarkStartUsecs = ioUTCMicrosecondsNow();
+	remarking = objectsShouldBeUnmarkedAndUnmarkedClassesShouldBeExpunged
+	 && (GIV(concurrentMarkInProgress)
+	 && (finishConcurrentMark()));
 	/* begin shutDownIncrementalGC: */
 	if (objectsShouldBeUnmarkedAndUnmarkedClassesShouldBeExpunged) {
-		assert(allObjectsUnmarked());
+		assert(remarking
+		 || (allObjectsUnmarked()));
 	}
 	/* begin initializeUnscannedEphemerons */
 	largestFree = findLargestFreeChunk();
@@ -53249,6 +56734,9 @@ markObjects(sqInt objectsShouldBeUnmarkedAndUnmarkedClassesShouldBeExpunged)
 		thePage = stackPageAtpages(i1, GIV(pages));
 		(thePage->trace = StackPageUnreached);
 	}
+	if (remarking) {
+		rescanConcurrentlyMarkedObjects();
+	}
 	/* begin markAndTraceHiddenRoots */
 	markAndTraceObjStackandContents(GIV(markStack), 0);
 	markAndTraceObjStackandContents(GIV(weaklingStack), 0);
@@ -53257,11 +56745,13 @@ markObjects(sqInt objectsShouldBeUnmarkedAndUnmarkedClassesShouldBeExpunged)
 	objOop1 = longAt((GIV(hiddenRootsObj) + BaseHeaderSize) + (((sqInt)((usqInt)(RememberedSetRootIndex) << (shiftForWord())))));
 	assert(!(isFreeObject(objOop1)));
 	longAtput(objOop1, (longAt(objOop1)) | (1ULL << (markedBitFullShift())));
+	noteLiveBytesof(bytesInObject(objOop1), objOop1);
 	/* begin setIsMarkedOf:to: */
 	assert((firstIndexableField(oldSpaceObjectAfter(GIV(trueObj)))) == GIV(freeLists));
 	objOop2 = oldSpaceObjectAfter(GIV(trueObj));
 	assert(!(isFreeObject(objOop2)));
 	longAtput(objOop2, (longAt(objOop2)) | (1ULL << (markedBitFullShift())));
+	noteLiveBytesof(bytesInObject(objOop2), objOop2);
 	if (isWeakFormat((((usqInt) (longAt(GIV(classTableFirstPage)))) >> (formatShift())) & (formatMask()))) {
 		markAndTrace(GIV(hiddenRootsObj));
 		goto l2;
@@ -53269,12 +56759,14 @@ markObjects(sqInt objectsShouldBeUnmarkedAndUnmarkedClassesShouldBeExpunged)
 	/* begin setIsMarkedOf:to: */
 	assert(!(isFreeObject(GIV(hiddenRootsObj))));
 	longAtput(GIV(hiddenRootsObj), (longAt(GIV(hiddenRootsObj))) | (1ULL << (markedBitFullShift())));
+	noteLiveBytesof(bytesInObject(GIV(hiddenRootsObj)), GIV(hiddenRootsObj));
 	markAndTrace(GIV(classTableFirstPage));
 	for (i2 = 1; i2 < GIV(numClassTablePages); i2 += 1) {
 		/* begin setIsMarkedOf:to: */
 		objOop = longAt((GIV(hiddenRootsObj) + BaseHeaderSize) + (((sqInt)((usqInt)(i2) << (shiftForWord())))));
 		assert(!(isFreeObject(objOop)));
 		longAtput(objOop, (longAt(objOop)) | (1ULL << (markedBitFullShift())));
+		noteLiveBytesof(bytesInObject(objOop), objOop);
 	}
 	l2:	/* end markAndTraceHiddenRoots */;
 	/* begin markAndTraceExtraRoots */
@@ -53286,8 +56778,13 @@ markObjects(sqInt objectsShouldBeUnmarkedAndUnmarkedClassesShouldBeExpunged)
 			markAndTrace(oop);
 		}
 	}
+	/* begin markAndTracePinnedBuffersInUse */
+	for (i5 = 0; i5 < GIV(numPinnedBuffersInUse); i5 += 1) {
+		markAndTrace(GIV(pinnedBuffersInUse)[i5]);
+	}
 	assert(validClassTableRootPages());
 	/* begin markAndTraceInterpreterOops: */
+	rootMarkStartUsecs = ioUTCMicrosecondsNow();
 	markAndTraceStackPages(1);
 	markAndTraceTraceLog();
 	markAndTracePrimTraceLog();
@@ -53336,6 +56833,7 @@ markObjects(sqInt objectsShouldBeUnmarkedAndUnmarkedClassesShouldBeExpunged)
 	markAndTrace(GIV(profileProcess));
 	markAndTrace(GIV(profileMethod));
 	markAndTrace(GIV(profileSemaphore));
+	markAndTraceAllocationSamples();
 	sqLowLevelMFence();
 	if ((GIV(longRunningPrimitiveCheckMethod) != null)
 	 && (GIV(longRunningPrimitiveCheckSequenceNumber) != GIV(statCheckForEvents))) {
@@ -53390,6 +56888,7 @@ markObjects(sqInt objectsShouldBeUnmarkedAndUnmarkedClassesShouldBeExpunged)
 			markAndTrace(oop1);
 		}
 	}
+	GIV(statRootMarkUsecs) += ioUTCMicrosecondsNow() - rootMarkStartUsecs;
 	assert(validObjStacks());
 	markWeaklingsAndMarkAndFireEphemerons();
 	assert(validObjStacks());
@@ -53427,6 +56926,9 @@ markObjects(sqInt objectsShouldBeUnmarkedAndUnmarkedClassesShouldBeExpunged)
 	assert(GIV(classTableIndex) >= (1U << (classTableMajorIndexShift())));
 	nilUnmarkedWeaklingSlots();
 	GIV(marking) = 0;
+	if (remarking) {
+		GIV(statConcurrentRemarkUsecs) += ioUTCMicrosecondsNow() - remarkStartUsecs;
+	}
 }
 
 
@@ -53644,6 +57146,52 @@ maybeSplObj(sqInt index)
 		: 0);
 }
 
+/*	Add the free chunks found by the parallel sweep threads to the free
+	lists, splicing each thread's small free lists onto the real ones and
+	adding the chunks it noted one by one. Answer the bytes freed. Run after
+	sweepCursor has been set past the segments swept, since
+	addToFreeList:bytes: ignores chunks beyond it. */
+
+	/* SpurMemoryManager>>#mergeSweepWorkers: */
+static usqInt NoDbgRegParms
+mergeSweepWorkers(sqInt numWorkers)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt chunk;
+    usqInt freed;
+    sqInt head;
+    sqInt i;
+    sqInt index;
+    sqInt next;
+    sqInt tail;
+    SpurSweepWorker *worker;
+
+	freed = 0;
+	for (i = 0; i < numWorkers; i += 1) {
+		worker = (&(GIV(sweepWorkers)[i]));
+		GIV(totalFreeOldSpace) += (worker->freeBytes);
+		freed += (worker->freeBytes);
+		for (index = 1; index < 64 /* numFreeLists */; index += 1) {
+			head = (worker->freeListHeads)[index];
+			if (head != 0) {
+				tail = (worker->freeListTails)[index];
+				next = GIV(freeLists)[index];
+				longAtput((tail + BaseHeaderSize) + (0U << (shiftForWord())), next);
+				if ((next != 0)
+				 && ((index * 8 /* allocationUnit */) > (BaseHeaderSize + 8 /* allocationUnit */))) {
+					longAtput((next + BaseHeaderSize) + (1U << (shiftForWord())), tail);
+				}
+				GIV(freeLists)[index] = head;
+				GIV(freeListsMask) = GIV(freeListsMask) | (1ULL << index);
+			}
+		}
+		for (index = 0; index < ((worker->numChunks)); index += 1) {
+			chunk = (worker->chunks)[index];
+			addToFreeListbytes(chunk, bytesInObject(chunk));
+		}
+	}
+	return freed;
+}
+
 
 /*	Answer the minimum number of additional slots to allocate in an object to
 	always be able to shorten it.
@@ -53923,6 +57471,58 @@ nonIndexablePointerFormat(void)
 	return 1;
 }
 
+
+/*	Put a sample in the allocationSamples ring buffer, four words per sample,
+	overwriting the oldest sample when it is full. method is the method that
+	made the allocation and pc the one-relative bytecode pc it had reached,
+	either being 0 if not known. The methods are roots; see
+	markAndTraceAllocationSamples and mapAllocationSamples. */
+
+	/* SpurMemoryManager>>#noteAllocationSample:bytes:method:pc: */
+static void NoDbgRegParms
+noteAllocationSamplebytesmethodpc(sqInt classIndex, sqInt bytes, sqInt method, sqInt pc)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+	GIV(allocationSamples)[4 * GIV(allocationSampleIndex)] = classIndex;
+	GIV(allocationSamples)[(4 * GIV(allocationSampleIndex)) + 1] = bytes;
+	GIV(allocationSamples)[(4 * GIV(allocationSampleIndex)) + 2] = method;
+	GIV(allocationSamples)[(4 * GIV(allocationSampleIndex)) + 3] = pc;
+	GIV(allocationSampleIndex) = (GIV(allocationSampleIndex) + 1) % AllocationSampleBufferSize;
+	if (GIV(numAllocationSamples) < AllocationSampleBufferSize) {
+		GIV(numAllocationSamples) += 1;
+	}
+}
+
+/*	Add numBytes to the live bytes of the old space segment containing
+	objOop, which shouldSweepInsteadOfCompacting and evacuateSparseSegments
+	use to weigh the segments without walking them. Marking mostly moves on
+	to objects near the last, so try the segment found last first. */
+
+	/* SpurMemoryManager>>#noteLiveBytes:of: */
+static void NoDbgRegParms
+noteLiveBytesof(sqInt numBytes, sqInt objOop)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt i;
+    SpurSegmentInfo *seg;
+
+	if (oopisLessThan(objOop, GIV(oldSpaceStart))) {
+		return;
+	}
+	i = GIV(liveBytesSegmentIndex);
+	if (!((i < GIV(numSegments))
+		 && ((objOop >= (((GIV(segments)[i]).segStart)))
+		 && (objOop < ((((GIV(segments)[i]).segSize)) + (((GIV(segments)[i]).segStart))))))) {
+		/* begin segmentIndexContainingObj: */
+		for (i = (GIV(numSegments) - 1); i > 0; i += -1) {
+			if (objOop >= (((GIV(segments)[i]).segStart))) {
+				break;
+			}
+		}
+		GIV(liveBytesSegmentIndex) = i;
+	}
+	seg = (&(GIV(segments)[i]));
+	(seg->liveBytes = ((seg->liveBytes)) + numBytes);
+}
+
 	/* SpurMemoryManager>>#noUnscannedEphemerons */
 static sqInt
 noUnscannedEphemerons(void)
@@ -54426,6 +58026,8 @@ objectsReachableFromRoots(sqInt arrayOfRoots)
     sqInt referent;
     usqInt start;
 
+	finishIncrementalSweep();
+	abortConcurrentMark();
 
 	/* & hence start & ptr are too; limit is also because of addressAfter: */
 	assert(isArray(arrayOfRoots));
@@ -54789,6 +58391,21 @@ oldSpaceObjectAfter(sqInt objOop)
 }
 
 
+/*	Open the GC telemetry log, to which a record is written, as a single line
+	of JSON, for each scavenge, full GC and incremental sweep step. A file
+	name of - writes to stderr. The log is opened for appending, so it may
+	be a named pipe read by a monitoring process. */
+
+	/* SpurMemoryManager>>#openGCLog: */
+void
+openGCLog(char *fileName)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+	GIV(gcLog) = (strcmp(fileName, "-") == 0
+		? stderr
+		: fopen(fileName, "a"));
+}
+
+
 /*	in an effort to fix a compiler bug with two-way become post r3427 */
 /*	Allocate two new objects, n1 & n2. Copy the contents appropriately.
 	Convert obj1 and obj2 into forwarding objects pointing to n2 and n1
@@ -54923,6 +58540,35 @@ outOfPlaceBecomeandcopyHashFlag(sqInt obj1, sqInt obj2, sqInt copyHashFlag)
 	}
 }
 
+/*	Sweep the segments from the one containing startObj, which is where the
+	sweep starts within it, with the GC threads, each claiming the next
+	segment in turn, until all are swept or, if budgetUsecs is non-zero, it
+	has elapsed. Segments are claimed in order and swept whole, so those
+	swept always follow on from startObj. Answer the index of the first
+	segment left unswept, or numSegments if none. The chunks freed are left
+	on the threads' free lists for mergeSweepWorkers:. */
+
+	/* SpurMemoryManager>>#parallelSweepSegmentsFrom:budget: */
+static sqInt NoDbgRegParms
+parallelSweepSegmentsFrombudget(sqInt startObj, usqLong budgetUsecs)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt i;
+
+	/* begin segmentIndexContainingObj: */
+	for (i = (GIV(numSegments) - 1); i > 0; i += -1) {
+		if (startObj >= (((GIV(segments)[i]).segStart))) {
+			break;
+		}
+	}
+	GIV(sweepFirstSegmentIndex) = (GIV(sweepSegmentIndex) = i);
+	GIV(sweepStartObj) = startObj;
+	GIV(sweepDeadlineUsecs) = (budgetUsecs == 0
+		? 0
+		: ioUTCMicrosecondsNow() + budgetUsecs);
+	ioGCThreadsDo(sweepSegmentsWorkerarg, 0);
+	return GIV(sweepSegmentIndex);
+}
+
 
 /*	Attempt to pin objOop, which must not be immediate.
 	If the attempt succeeds answer objOop's (possibly moved) oop.
@@ -54957,7 +58603,8 @@ pinObject(sqInt objOop)
 		}
 		seg = null;
 	l1:	/* end segmentContainingObj: */;
-		if ((seg->containsPinned)) {
+		if (((seg->containsPinned))
+		 || ((seg->isLargeObjectSegment))) {
 			/* begin setIsPinnedOf:to: */
 			longAtput(objOop, (longAt(objOop)) | (1U << (pinnedBitShift())));
 			return objOop;
@@ -54971,6 +58618,9 @@ pinObject(sqInt objOop)
 	}
 	oldClone = cloneInOldSpaceforPinning(objOop, 1);
 	if (oldClone != 0) {
+		if (oopisGreaterThanOrEqualTo(objOop, GIV(oldSpaceStart))) {
+			invalidateConcurrentMark();
+		}
 		GIV(becomeEffectsFlags) = becomeEffectFlagsFor(objOop);
 		/* begin setIsPinnedOf:to: */
 		longAtput(oldClone, (longAt(oldClone)) | (1U << (pinnedBitShift())));
@@ -55032,6 +58682,66 @@ pinObject(sqInt objOop)
 	return oldClone;
 }
 
+
+/*	Answer the index of the pool for buffer if it is a pinned ByteArray of
+	one of the pooled sizes, otherwise -1. */
+
+	/* SpurMemoryManager>>#pinnedBufferPoolIndexOf: */
+static sqInt NoDbgRegParms
+pinnedBufferPoolIndexOf(sqInt buffer)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    usqInt bufferBytes;
+    sqInt index;
+
+	if (!(((buffer & (tagMask())) == 0)
+		 && ((oopisGreaterThanOrEqualTo(buffer, GIV(oldSpaceStart)))
+		 && ((((((usqInt) (longAt(buffer))) >> (pinnedBitShift())) & 1) != 0)
+		 && (((((usqInt) (longAt(buffer))) >> (formatShift())) & (formatMask())) == (firstByteFormat())))))) {
+		return -1;
+	}
+	if (((longAt(buffer)) & (classIndexMask())) != ((long32At((classByteArray()) + 4)) & (identityHashHalfWordMask()))) {
+		return -1;
+	}
+	bufferBytes = (numSlotsOf(buffer)) * BytesPerOop;
+	for (index = 0; index < NumPinnedBufferClasses; index += 1) {
+		if ((1ULL << (index + MinPinnedBufferClass)) == bufferBytes) {
+			return index;
+		}
+	}
+	return -1;
+}
+
+
+/*	Called by fullGC between marking and sweeping. Pool those buffers handed
+	back by releasePinnedBuffer: since the last full GC that the mark did
+	not reach, marking them so the sweep keeps them. Those it did reach are
+	still referenced from the image and are dropped; it owns them now. */
+
+	/* SpurMemoryManager>>#poolReleasedPinnedBuffers */
+static void
+poolReleasedPinnedBuffers(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt buffer;
+    sqInt i;
+    sqInt index;
+
+	for (i = 0; i < GIV(numReleasedPinnedBuffers); i += 1) {
+		buffer = GIV(releasedPinnedBuffers)[i];
+		index = pinnedBufferPoolIndexOf(buffer);
+		if ((index >= 0)
+		 && ((!(((((usqInt) (longAt(buffer))) >> (markedBitFullShift())) & 1) != 0))
+		 && (GIV(pinnedBufferPoolCounts)[index] < MaxPooledPinnedBuffers))) {
+			/* begin setIsMarkedOf:to: */
+			longAtput(buffer, (longAt(buffer)) | (1ULL << (markedBitFullShift())));
+			noteLiveBytesof(bytesInObject(buffer), buffer);
+			longAtput((buffer + BaseHeaderSize) + (0U << (shiftForWord())), GIV(pinnedBufferPool)[index]);
+			GIV(pinnedBufferPool)[index] = buffer;
+			GIV(pinnedBufferPoolCounts)[index] += 1;
+		}
+	}
+	GIV(numReleasedPinnedBuffers) = 0;
+}
+
 	/* SpurMemoryManager>>#popObjStack: */
 static sqInt NoDbgRegParms
 popObjStack(sqInt objStack)
@@ -57534,6 +61244,180 @@ rawHashBitsOf(sqInt objOop)
 	return (long32At(objOop + 4)) & (identityHashHalfWordMask());
 }
 
+/*	Record objOop for rescanConcurrentlyMarkedObjects to trace again, in full
+	if pageStart is 0, otherwise only those of its slots on the page starting
+	at pageStart. */
+
+	/* SpurMemoryManager>>#recordConcurrentRescanOf:at: */
+static void NoDbgRegParms
+recordConcurrentRescanOfat(sqInt objOop, usqInt pageStart)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt *rescans;
+
+	if (GIV(concurrentMarkRescansCount) >= GIV(concurrentMarkRescansCapacity)) {
+		rescans = realloc(GIV(concurrentMarkRescans), ((GIV(concurrentMarkRescansCapacity) * 2) * 2) * BytesPerOop);
+		if (rescans == null) {
+			GIV(concurrentMarkFailed) = 1;
+			return;
+		}
+		GIV(concurrentMarkRescans) = rescans;
+		GIV(concurrentMarkRescansCapacity) = GIV(concurrentMarkRescansCapacity) * 2;
+	}
+	GIV(concurrentMarkRescans)[GIV(concurrentMarkRescansCount) * 2] = objOop;
+	GIV(concurrentMarkRescans)[(GIV(concurrentMarkRescansCount) * 2) + 1] = pageStart;
+	GIV(concurrentMarkRescansCount) += 1;
+}
+
+/*	Record for the remark each object the concurrent marker reached that
+	lies on a page of the segment the OS says has been written since the
+	marker began. Such objects are traced again in full, except for large
+	arrays, only whose written pages are. Each walk over written pages starts
+	at the last marked object before them, which is found from the bitmap,
+	or else at the start of the segment. Objects the marker did not reach
+	need no rescan; if they are live the remark reaches them anyway. */
+
+	/* SpurMemoryManager>>#recordConcurrentRescansIn: */
+static void NoDbgRegParms
+recordConcurrentRescansIn(SpurSegmentInfo *segInfo)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    usqInt bitIndex;
+    unsigned char *dirty;
+    usqInt firstBitIndex;
+    sqInt fmt;
+    usqInt limit;
+    usqInt numPages;
+    sqInt objOop;
+    usqInt pageBase;
+    usqInt pageEnd;
+    usqInt pageIndex;
+    usqInt pageSize;
+    usqInt pageStart;
+    sqInt previous;
+
+	if (((segInfo->segStart)) >= GIV(concurrentMarkBitmapLimit)) {
+		return;
+	}
+	limit = (((segInfo->segStart)) + ((segInfo->segSize))) - (2 * BaseHeaderSize);
+	if (limit > GIV(concurrentMarkBitmapLimit)) {
+		limit = GIV(concurrentMarkBitmapLimit);
+	}
+	pageSize = sqDirtyPageSize();
+	pageBase = ((segInfo->segStart)) & (~(pageSize - 1));
+	numPages = ((limit - pageBase) + (pageSize - 1)) / pageSize;
+	if (((dirty = malloc(numPages))) == null) {
+		GIV(concurrentMarkFailed) = 1;
+		return;
+	}
+	if (!(sqDirtyPagesFromToInto((segInfo->segStart), limit, dirty))) {
+		memset(dirty, 1, numPages);
+	}
+	firstBitIndex = (((segInfo->segStart)) - GIV(concurrentMarkBitmapStart)) >> 3;
+	objOop = 0;
+	previous = 0;
+	for (pageIndex = 0; pageIndex < numPages; pageIndex += 1) {
+		if (!((dirty[pageIndex]) == 0)) {
+			pageStart = pageBase + (pageIndex * pageSize);
+			pageEnd = pageStart + pageSize;
+			if ((objOop == 0)
+			 || ((((usqInt) objOop) + pageSize) < pageStart)) {
+
+				/* find the last marked object before the page, skipping empty words of the bitmap */
+				bitIndex = (((pageStart > ((segInfo->segStart)) ? pageStart : ((segInfo->segStart)))) - GIV(concurrentMarkBitmapStart)) >> 3;
+				objOop = 0;
+				while ((objOop == 0)
+				 && (bitIndex > firstBitIndex)) {
+					bitIndex -= 1;
+					if ((((bitIndex & 0x3F) == 0x3F))
+					 && ((GIV(concurrentMarkBitmap)[bitIndex >> 6]) == 0)) {
+						bitIndex = (bitIndex > (firstBitIndex + 0x3F)
+							? bitIndex - 0x3F
+							: firstBitIndex);
+					}
+					else {
+						if (((GIV(concurrentMarkBitmap)[bitIndex >> 6]) & (1ULL << (bitIndex & 0x3F))) != 0) {
+							objOop = GIV(concurrentMarkBitmapStart) + (bitIndex << 3);
+						}
+					}
+				}
+				if (objOop == 0) {
+					objOop = objectStartingAt((segInfo->segStart));
+				}
+			}
+			while ((((usqInt) objOop) < pageEnd)
+			 && (((usqInt) objOop) < limit)) {
+				bitIndex = (((usqInt) objOop) - GIV(concurrentMarkBitmapStart)) >> 3;
+				if ((((GIV(concurrentMarkBitmap)[bitIndex >> 6]) & (1ULL << (bitIndex & 0x3F))) != 0)
+				 && ((addressAfter(objOop)) > pageStart)) {
+					fmt = (((usqInt) (longAt(objOop))) >> (formatShift())) & (formatMask());
+					if ((((fmt == 2 /* arrayFormat */)
+					 || ((fmt == (indexablePointersFormat()))
+					 && (((longAt(objOop)) & (classIndexMask())) != ClassMethodContextCompactIndex))))
+					 && (((addressAfter(objOop)) - objOop) > pageSize)) {
+						recordConcurrentRescanOfat(objOop, pageStart);
+					}
+					else {
+						if (objOop != previous) {
+							recordConcurrentRescanOfat(objOop, 0);
+							previous = objOop;
+						}
+					}
+				}
+				objOop = objectStartingAt(addressAfter(objOop));
+			}
+		}
+	}
+	free(dirty);
+}
+
+/*	Free the concurrent marker's bitmap and stacks. */
+
+	/* SpurMemoryManager>>#releaseConcurrentMark */
+static void
+releaseConcurrentMark(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+	free(GIV(concurrentMarkBitmap));
+	free(GIV(concurrentMarkStack));
+	free(GIV(concurrentMarkDeferred));
+	free(GIV(concurrentMarkRescans));
+	GIV(concurrentMarkBitmap) = null;
+	GIV(concurrentMarkStack) = (GIV(concurrentMarkDeferred) = (GIV(concurrentMarkRescans) = null));
+	GIV(concurrentMarkStackCapacity) = (GIV(concurrentMarkDeferredCapacity) = (GIV(concurrentMarkRescansCapacity) = 0));
+	GIV(concurrentMarkStackTop) = (GIV(concurrentMarkDeferredCount) = (GIV(concurrentMarkRescansCount) = 0));
+}
+
+
+/*	Hand a buffer answered by allocatePinnedBuffer: back, saying the plugin
+	has done with it. It is no longer a root. Since the image may still refer
+	to it, e.g. if the plugin answered it, it is not pooled here but noted,
+	and pooled by the next full GC only if that finds it unreferenced; see
+	poolReleasedPinnedBuffers. Answer whether it was noted for pooling; if
+	not, e.g. because it is not of a pooled size, it is simply left for the
+	GC. */
+
+	/* SpurMemoryManager>>#releasePinnedBuffer: */
+sqInt
+releasePinnedBuffer(sqInt buffer)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt i;
+
+	for (i = 0; i < GIV(numPinnedBuffersInUse); i += 1) {
+		if (GIV(pinnedBuffersInUse)[i] == buffer) {
+			GIV(numPinnedBuffersInUse) -= 1;
+			GIV(pinnedBuffersInUse)[i] = (GIV(pinnedBuffersInUse)[GIV(numPinnedBuffersInUse)]);
+			i = GIV(numPinnedBuffersInUse);
+		}
+	}
+	if ((pinnedBufferPoolIndexOf(buffer)) < 0) {
+		return 0;
+	}
+	if (GIV(numReleasedPinnedBuffers) >= MaxReleasedPinnedBuffers) {
+		return 0;
+	}
+	GIV(releasedPinnedBuffers)[GIV(numReleasedPinnedBuffers)] = buffer;
+	GIV(numReleasedPinnedBuffers) += 1;
+	return 1;
+}
+
 
 /*	Relocate all objStack pages that comprise objStack. */
 
@@ -57651,6 +61535,94 @@ removeGCRoot(sqInt *varLoc)
 	return 0;
 }
 
+/*	If the concurrent marker marked objOop, trace it again in full. Weaklings
+	and ephemerons are always deferred, so any mark they have was set by the
+	remark, which has traced them as they need. */
+
+	/* SpurMemoryManager>>#rescanConcurrentlyMarked: */
+static void NoDbgRegParms
+rescanConcurrentlyMarked(sqInt objOop)
+{
+    sqInt fmt;
+
+	if (((((usqInt) (longAt(objOop))) >> (markedBitFullShift())) & 1) != 0) {
+		fmt = (((usqInt) (longAt(objOop))) >> (formatShift())) & (formatMask());
+		if ((fmt != (weakArrayFormat()))
+		 && (fmt != 5 /* ephemeronFormat */)) {
+			/* begin setIsMarkedOf:to: */
+			longAtput(objOop, (longAt(objOop)) & (~(usqIntptr_t)(1ULL << (markedBitFullShift()))));
+			markAndTrace(objOop);
+		}
+	}
+}
+
+/*	The part of the remark that makes up for the mutator having run during
+	the concurrent mark. Trace again from the objects the marker reached that
+	the mutator may have stored into since (see finishConcurrentMark), and
+	from those remembered or carded, whose young referents the marker did not
+	follow, and then from the objects the marker deferred. */
+
+	/* SpurMemoryManager>>#rescanConcurrentlyMarkedObjects */
+static void
+rescanConcurrentlyMarkedObjects(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt field;
+    sqInt i;
+    usqInt limit;
+    sqInt objOop;
+    usqInt pageSize;
+    usqInt pageStart;
+    usqInt slot;
+
+	for (i = 0; i < GIV(rememberedSetSize); i += 1) {
+		rescanConcurrentlyMarked(GIV(rememberedSet)[i]);
+	}
+	for (i = 0; i < GIV(numCardedObjects); i += 1) {
+		rescanConcurrentlyMarked(GIV(cardedObjects)[i]);
+	}
+	pageSize = sqDirtyPageSize();
+	for (i = 0; i < GIV(concurrentMarkRescansCount); i += 1) {
+		objOop = GIV(concurrentMarkRescans)[i * 2];
+		pageStart = GIV(concurrentMarkRescans)[(i * 2) + 1];
+		if (pageStart == 0) {
+			rescanConcurrentlyMarked(objOop);
+		}
+		else {
+			if (((((usqInt) (longAt(objOop))) >> (markedBitFullShift())) & 1) != 0) {
+				if ((((usqInt) objOop) >= pageStart)
+				 && (((usqInt) objOop) < (pageStart + pageSize))) {
+					markAndTraceClassOf(objOop);
+				}
+				slot = ((objOop + BaseHeaderSize) > pageStart
+					? objOop + BaseHeaderSize
+					: pageStart);
+				limit = ((addressAfter(objOop)) < (pageStart + pageSize)
+					? addressAfter(objOop)
+					: pageStart + pageSize);
+				while (slot < limit) {
+					field = longAt(slot);
+					if ((field & (tagMask())) == 0) {
+						if (((longAt(field)) & ((classIndexMask()) - (isForwardedObjectClassIndexPun()))) == 0) {
+							field = fixFollowedFieldofObjectwithInitialValue((slot - (objOop + BaseHeaderSize)) >> (shiftForWord()), objOop, field);
+						}
+						if (!(field & (tagMask()))) {
+							markAndTrace(field);
+						}
+					}
+					slot += BytesPerOop;
+				}
+			}
+		}
+	}
+	for (i = 0; i < GIV(concurrentMarkDeferredCount); i += 1) {
+		objOop = GIV(concurrentMarkDeferred)[i];
+		if (((longAt(objOop)) & (classIndexMask())) > (lastClassIndexPun())) {
+			markAndTrace(objOop);
+		}
+	}
+	releaseConcurrentMark();
+}
+
 
 /*	This is part of storeImageSegmentInto:outPointers:roots:. */
 
@@ -57829,6 +61801,34 @@ runLeakCheckerForexcludeUnmarkedObjsclassIndicesShouldBeValid(sqInt gcModes, sqI
 }
 
 
+/*	Count the bytes of a newly allocated object down to the next sample,
+	taking the object as a sample if it contains the sampled byte. Callers
+	externalize the frame before sampling, so its method and pc say where
+	the allocation was made. Allocations the GC makes for itself are not
+	counted. */
+
+	/* SpurMemoryManager>>#sampleAllocation:bytes: */
+static void NoDbgRegParms
+sampleAllocationbytes(sqInt objOop, sqInt bytes)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt classIndex;
+
+	if (GIV(gcPhaseInProgress) != 0) {
+		return;
+	}
+	if ((GIV(bytesUntilAllocationSample) -= bytes) > 0) {
+		return;
+	}
+	while (GIV(bytesUntilAllocationSample) <= 0) {
+		GIV(bytesUntilAllocationSample) += GIV(allocationSampleInterval);
+	}
+	classIndex = (longAt(objOop)) & (classIndexMask());
+	if (classIndex > (lastClassIndexPun())) {
+		noteAllocationSamplebytes(classIndex, bytes);
+	}
+}
+
+
 /*	Run the scavenger. */
 
 	/* SpurMemoryManager>>#scavengingGCTenuringIf: */
@@ -57874,7 +61874,7 @@ scavengingGCTenuringIf(sqInt tenuringCriterion)
 	preGCAction(GCModeNewSpace);
 	/* begin flushMethodCacheFrom:to: */
 	probe = 0;
-	for (i = 1; i <= MethodCacheEntries; i += 1) {
+	for (i = 1; i <= methodCacheEntries; i += 1) {
 		if (!((GIV(methodCache)[probe + MethodCacheSelector]) == 0)) {
 			if ((((oopisGreaterThanOrEqualTo(GIV(methodCache)[probe + MethodCacheSelector], GIV(newSpaceStart)))
 			 && (oopisLessThan(GIV(methodCache)[probe + MethodCacheSelector], GIV(newSpaceLimit))))
@@ -57899,6 +61899,10 @@ scavengingGCTenuringIf(sqInt tenuringCriterion)
 	if (!(GIV(scavengeLog) == null)) {
 		writeScavengeLog();
 	}
+	if (!(GIV(gcLog) == null)) {
+		writeScavengeGCLogRecord();
+	}
+	GIV(gcCause) = null;
 	postGCAction(GCModeNewSpace);
 	runLeakCheckerFor(GCModeNewSpace);
 	/* begin checkFreeSpace: */
@@ -58098,6 +62102,70 @@ splObj(sqInt index)
 	return longAt((GIV(specialObjectsOop) + BaseHeaderSize) + (((sqInt)((usqInt)(index) << (shiftForWord())))));
 }
 
+/*	Begin marking old space on a thread of its own, so that the pause of the
+	next full GC is only that of a remark; see markObjects:. The marker
+	starts from the special objects, the extra roots and the stack pages,
+	the remark from all the roots. This needs the OS to say which pages the
+	mutator has written while the marker ran, since that is where it may
+	have stored references the marker missed. If there is a pause target
+	but no background marking, or no thread for it, mark in steps instead;
+	see incrementalMarkStepFor:. */
+
+	/* SpurMemoryManager>>#startConcurrentMark */
+static void
+startConcurrentMark(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt i;
+    sqInt oop;
+
+	if (!(sqCanTrackDirtyPages())) {
+		return;
+	}
+	GIV(concurrentMarkBitmapStart) = GIV(oldSpaceStart);
+	GIV(concurrentMarkBitmapLimit) = GIV(endOfMemory);
+	GIV(concurrentMarkBitmap) = calloc((((GIV(concurrentMarkBitmapLimit) - GIV(concurrentMarkBitmapStart)) >> 3) / 64) + 1, sizeof(usqInt));
+	GIV(concurrentMarkStack) = malloc(ConcurrentMarkStackSize * BytesPerOop);
+	GIV(concurrentMarkDeferred) = malloc((ConcurrentMarkStackSize / 16) * BytesPerOop);
+	GIV(concurrentMarkRescans) = malloc(((ConcurrentMarkStackSize / 16) * 2) * BytesPerOop);
+	if ((GIV(concurrentMarkBitmap) == null)
+	 || ((GIV(concurrentMarkStack) == null)
+	 || ((GIV(concurrentMarkDeferred) == null)
+	 || (GIV(concurrentMarkRescans) == null)))) {
+		releaseConcurrentMark();
+		return;
+	}
+	GIV(concurrentMarkStackCapacity) = ConcurrentMarkStackSize;
+	GIV(concurrentMarkDeferredCapacity) = (GIV(concurrentMarkRescansCapacity) = ConcurrentMarkStackSize / 16);
+	GIV(concurrentMarkFailed) = (GIV(concurrentMarkInvalidated) = (GIV(concurrentMarkFinished) = 0));
+	sqClearDirtyPages();
+	concurrentlyMarkfrom(GIV(specialObjectsOop), 0);
+	for (i = 1; i <= GIV(extraRootCount); i += 1) {
+		oop = (GIV(extraRoots)[i])[0];
+		if (!((oop & (tagMask()))
+			 || (((longAt(oop)) & (classIndexMask())) == (isFreeObjectClassIndexPun())))) {
+			concurrentlyMarkfrom(oop, 0);
+		}
+	}
+	concurrentlyMarkStackPages();
+	if (GIV(concurrentMarkFailed)) {
+		releaseConcurrentMark();
+		return;
+	}
+	GIV(concurrentMarkStartUsecs) = ioUTCMicrosecondsNow();
+	GIV(concurrentMarkInProgress) = 1;
+	GIV(concurrentMarkSteps) = 0;
+	if (!(concurrentMarkEnabled
+		 && (ioStartBackgroundGCWork(concurrentMarkWorker, 0)))) {
+		if (maxGCPauseUsecs > 0) {
+			GIV(concurrentMarkSteps) = 1;
+		}
+		else {
+			GIV(concurrentMarkInProgress) = 0;
+			releaseConcurrentMark();
+		}
+	}
+}
+
 
 /*	Answer the start of objOop, which is either the address of the overflow
 	size word, or objOop itself, depending on the size of the object. This may
@@ -58242,6 +62310,7 @@ storeImageSegmentIntooutPointersroots(sqInt segmentWordArrayArg, sqInt outPointe
 	}
 	runLeakCheckerFor(GCModeImageSegment);
 	/* begin scavengingGC */
+	GIV(gcCause) = "imageSegment";
 	scavengingGCTenuringIf(TenureByAge);
 	if (((longAt(segmentWordArrayArg)) & ((classIndexMask()) - (isForwardedObjectClassIndexPun()))) == 0) {
 		/* begin followForwarded: */
@@ -58370,6 +62439,9 @@ storeImageSegmentIntooutPointersroots(sqInt segmentWordArrayArg, sqInt outPointe
 	assert((numBytes % (allocationUnit())) == 0);
 	assert((newObj % (allocationUnit())) == 0);
 	GIV(freeStart) += numBytes;
+	if (GIV(allocationSampleInterval) > 0) {
+		sampleAllocationbytes(newObj, numBytes);
+	}
 	savedFirstFields = newObj;
 	l17:	/* end allocateSlots:format:classIndex: */;
 	/* begin allocateSlots:format:classIndex: */
@@ -58413,6 +62485,9 @@ storeImageSegmentIntooutPointersroots(sqInt segmentWordArrayArg, sqInt outPointe
 	assert((numBytes1 % (allocationUnit())) == 0);
 	assert((newObj1 % (allocationUnit())) == 0);
 	GIV(freeStart) += numBytes1;
+	if (GIV(allocationSampleInterval) > 0) {
+		sampleAllocationbytes(newObj1, numBytes1);
+	}
 	savedOutHashes = newObj1;
 	l19:	/* end allocateSlots:format:classIndex: */;
 	if ((savedFirstFields == null)
@@ -58571,6 +62646,9 @@ stringForCString(const char *aCString)
 	assert((numBytes % (allocationUnit())) == 0);
 	assert((newObj % (allocationUnit())) == 0);
 	GIV(freeStart) += numBytes;
+	if (GIV(allocationSampleInterval) > 0) {
+		sampleAllocationbytes(newObj, numBytes);
+	}
 	newString = newObj;
 	l2:	/* end allocateSlots:format:classIndex: */;
 	if (!(newString == null)) {
@@ -58591,11 +62669,64 @@ sufficientSpaceAfterGC(sqInt numBytes)
     sqInt heapSizePostGC;
 
 	assert(numBytes == 0);
+	GIV(gcCause) = "eden";
 	scavengingGCTenuringIf(TenureByAge);
 	heapSizePostGC = (GIV(totalHeapSizeIncludingBridges) - (GIV(numSegments) * (2 * BaseHeaderSize))) - GIV(totalFreeOldSpace);
-	if (((((double) (heapSizePostGC - GIV(heapSizeAtPreviousGC)) )) / GIV(heapSizeAtPreviousGC)) >= GIV(heapGrowthToSizeGCRatio)) {
+	if (GIV(concurrentMarkInProgress)
+	 && (GIV(concurrentMarkFinished)
+	 && (!GIV(concurrentMarkInvalidated)))) {
+
+		/* the background mark is done; complete it with a remark */
+		GIV(gcCause) = "concurrentMark";
+		fullGC();
+	}
+	else if (((((double) (heapSizePostGC - GIV(heapSizeAtPreviousGC)) )) / GIV(heapSizeAtPreviousGC)) >= GIV(heapGrowthToSizeGCRatio)) {
+		GIV(gcCause) = "heapGrowth";
 		fullGC();
 	}
+	else {
+
+		/* Near a container's memory limit the kernel would kill us before the growth ratio
+		   called for a full GC, so collect (at most once a second) and give memory back. */
+		if ((sqMemoryIsNearLimit())
+		 && ((ioUTCMicrosecondsNow() - GIV(lastMemoryLimitGCUsecs)) >= MinUsecsBetweenMemoryLimitGCs)) {
+			GIV(memoryNearLimit) = 1;
+			GIV(gcCause) = "memoryLimit";
+			fullGC();
+			GIV(memoryNearLimit) = 0;
+			GIV(lastMemoryLimitGCUsecs) = ioUTCMicrosecondsNow();
+			GIV(statMemoryLimitGCs) += 1;
+			if ((sqMemoryIsNearLimit())
+			 && (GIV(lowSpaceThreshold) > 0)) {
+
+				/* still near the limit; have the image shed load, and avoid signalling low space twice */
+				GIV(lowSpaceThreshold) = 0;
+				return 0;
+			}
+		}
+	}
+	if (GIV(concurrentMarkInProgress)
+	 && (GIV(concurrentMarkFinished)
+	 && (GIV(concurrentMarkInvalidated)))) {
+		abortConcurrentMark();
+	}
+	if ((concurrentMarkEnabled
+	 || (maxGCPauseUsecs > 0))
+	 && ((!GIV(concurrentMarkInProgress))
+	 && (GIV(sweepCursor) == 0))) {
+
+		/* Start marking in the background, or in steps, once the heap has grown halfway
+		   to the size at which it would be collected, so that the mark is done by then. */
+		heapSizePostGC = (GIV(totalHeapSizeIncludingBridges) - (GIV(numSegments) * (2 * BaseHeaderSize))) - GIV(totalFreeOldSpace);
+		if (((((double) (heapSizePostGC - GIV(heapSizeAtPreviousGC)) )) / GIV(heapSizeAtPreviousGC)) >= (GIV(heapGrowthToSizeGCRatio) / 2)) {
+			startConcurrentMark();
+		}
+	}
+	if (GIV(sweepCursor) != 0) {
+
+		/* the incremental sweep has yet to find all the free space */
+		return 1;
+	}
 	while ((GIV(totalFreeOldSpace) < GIV(growHeadroom))
 	 && ((growOldSpaceByAtLeast(0)) != null)) {
 		if (GIV(totalFreeOldSpace) >= GIV(growHeadroom)) {
@@ -58614,6 +62745,241 @@ sufficientSpaceAfterGC(sqInt numBytes)
 }
 
 
+/*	Sweep old space from sweepCursor as sweepWithoutCompacting does, until
+	the end of old space, or, if they are non-zero, until budgetUsecs have
+	elapsed or a chunk has been freed that an allocation of wantedBytes
+	would fit. Stop only at a marked object, so that no run of free space
+	is split between steps, and leave sweepCursor there, or zero once the
+	sweep is complete. Only chunks below sweepCursor go on the free lists;
+	see addToFreeList:bytes:. Space freed is taken off the old space use
+	recorded at the last scavenge and full GC, so that it is not mistaken
+	for negative allocation.
+	When there are helper GC threads and no particular chunk is wanted, whole
+	segments are swept in parallel instead, as sweepWithoutCompacting does,
+	claimed in order until the budget has elapsed, and sweepCursor is left
+	at the start of the first segment not swept. */
+
+	/* SpurMemoryManager>>#sweepIncrementallyFor:bytes: */
+static void NoDbgRegParms
+sweepIncrementallyForbytes(usqLong budgetUsecs, usqInt wantedBytes)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt count;
+    sqInt done;
+    sqInt followingWord;
+    usqInt followingWordAddress;
+    usqInt freeBytes;
+    usqInt freed;
+    sqInt nextSegIndex;
+    usqInt numSlots;
+    sqInt objOop;
+    usqLong startUsecs;
+    sqInt startOfFree;
+
+	if ((wantedBytes == 0)
+	 && ((ioNumGCThreads() > 1)
+	 && ((GIV(numSegments) > 1)
+	 && (ensureSweepWorkers(ioNumGCThreads()))))) {
+		nextSegIndex = parallelSweepSegmentsFrombudget(GIV(sweepCursor), budgetUsecs);
+		if (nextSegIndex < GIV(numSegments)) {
+			/* begin objectStartingAt: */
+			numSlots = byteAt(((GIV(segments)[nextSegIndex]).segStart) + 7);
+			GIV(sweepCursor) = (numSlots == (numSlotsMask())
+				? (((GIV(segments)[nextSegIndex]).segStart)) + BaseHeaderSize
+				: ((GIV(segments)[nextSegIndex]).segStart));
+		}
+		else {
+			GIV(sweepCursor) = 0;
+		}
+		freed = mergeSweepWorkers(ioNumGCThreads());
+		GIV(oldSpaceUsePriorToScavenge) -= freed;
+		GIV(heapSizeAtPreviousGC) -= freed;
+		return;
+	}
+	startUsecs = ioUTCMicrosecondsNow();
+	startOfFree = null;
+	freeBytes = 0;
+	count = 0;
+	done = 0;
+	objOop = GIV(sweepCursor);
+	while (oopisLessThan(objOop, GIV(endOfMemory))) {
+		assert((long64At(objOop)) != 0);
+		if (((((usqInt) (longAt(objOop))) >> (markedBitFullShift())) & 1) != 0) {
+			if (!(startOfFree == null)) {
+				GIV(sweepCursor) = objOop;
+				/* begin addFreeChunkWithBytes:at: */
+				GIV(totalFreeOldSpace) += freeBytes;
+				freeChunkWithBytesat(freeBytes, startOfFree);
+				GIV(oldSpaceUsePriorToScavenge) -= freeBytes;
+				GIV(heapSizeAtPreviousGC) -= freeBytes;
+				if ((wantedBytes > 0)
+				 && ((freeBytes == wantedBytes)
+				 || ((freeBytes >= (64 /* numFreeLists */ * 8 /* allocationUnit */))
+				 && (freeBytes >= (wantedBytes + (2 * 8 /* allocationUnit */)))))) {
+					done = 1;
+				}
+				startOfFree = null;
+				freeBytes = 0;
+			}
+			if (done) {
+				GIV(sweepCursor) = objOop;
+				return;
+			}
+			if (((((usqInt) (longAt(objOop))) >> (pinnedBitShift())) & 1) != 0) {
+				/* begin unmarkPinned: */
+				if (!(((longAt(objOop)) & (classIndexMask())) == (segmentBridgePun()))) {
+					/* begin setIsMarkedOf:to: */
+					assert(!(isFreeObject(objOop)));
+					longAtput(objOop, (longAt(objOop)) & (~(usqIntptr_t)(1ULL << (markedBitFullShift()))));
+					/* begin notePinned: */
+					assert(isPinned(objOop));
+					while (oopisLessThan((((GIV(segments)[GIV(sweepIndex)]).segSize)) + (((GIV(segments)[GIV(sweepIndex)]).segStart)), objOop)) {
+						GIV(sweepIndex) += 1;
+					}
+					((GIV(segments)[GIV(sweepIndex)]).containsPinned = 1);
+				}
+			}
+			else {
+				/* begin setIsMarkedOf:to: */
+				assert(!(isFreeObject(objOop)));
+				longAtput(objOop, (longAt(objOop)) & (~(usqIntptr_t)(1ULL << (markedBitFullShift()))));
+			}
+		}
+		else {
+			if (!(startOfFree)) {
+				/* begin startOfObject: */
+				startOfFree = ((usqInt) (((byteAt(objOop + 7)) == (numSlotsMask())
+	? objOop - BaseHeaderSize
+	: objOop)));
+			}
+			freeBytes += bytesInObject(objOop);
+		}
+		if ((budgetUsecs > 0)
+		 && ((((count += 1)) % 1024) == 0)
+		 && ((ioUTCMicrosecondsNow() - startUsecs) >= budgetUsecs)) {
+			done = 1;
+		}
+		/* begin objectAfter:limit: */
+		followingWordAddress = addressAfter(objOop);
+		if (oopisGreaterThanOrEqualTo(followingWordAddress, GIV(endOfMemory))) {
+			objOop = GIV(endOfMemory);
+			goto l1;
+		}
+		flag("endianness");
+		followingWord = longAt(followingWordAddress);
+		objOop = ((((usqInt) followingWord) >> (numSlotsFullShift())) == (numSlotsMask())
+			? followingWordAddress + BaseHeaderSize
+			: followingWordAddress);
+	l1:	/* end objectAfter:limit: */;
+	}
+	assert(startOfFree == null);
+	GIV(sweepCursor) = 0;
+}
+
+
+/*	Sweep each segment claimed by this thread as sweepWithoutCompacting does
+	old space, putting the chunks freed on the thread's free lists (see
+	addFreeChunkWithBytes:at:worker:), and skipping the segments being
+	evacuated. The segment bridges stay marked, so
+	no run of free space crosses a segment boundary, and objects never
+	straddle segments, so the threads touch disjoint objects. A segment
+	containing a pinned object is claimed by one thread, which alone notes
+	it. */
+
+	/* SpurMemoryManager>>#sweepSegmentsWorker:arg: */
+static void
+sweepSegmentsWorkerarg(sqInt workerIndex, void *unused)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt fmt;
+    usqInt followingWordAddress;
+    usqInt freeBytes;
+    usqInt limit;
+    usqInt numSlots;
+    sqInt objOop;
+    SpurSegmentInfo *seg;
+    sqInt segIndex;
+    sqInt startOfFree;
+    SpurSweepWorker *worker;
+
+	worker = (&(GIV(sweepWorkers)[workerIndex]));
+	while (1) {
+		ioLockGCThreads();
+		segIndex = GIV(sweepSegmentIndex);
+		if ((segIndex >= GIV(numSegments))
+		 || ((segIndex > GIV(sweepFirstSegmentIndex))
+		 && ((GIV(sweepDeadlineUsecs) != 0)
+		 && (ioUTCMicrosecondsNow() >= GIV(sweepDeadlineUsecs))))) {
+			ioUnlockGCThreads();
+			return;
+		}
+		GIV(sweepSegmentIndex) = segIndex + 1;
+		ioUnlockGCThreads();
+		seg = (&(GIV(segments)[segIndex]));
+		limit = ((seg->segStart)) + ((seg->segSize));
+		if (limit > GIV(endOfMemory)) {
+			limit = GIV(endOfMemory);
+		}
+		if (segIndex == GIV(sweepFirstSegmentIndex)) {
+			objOop = GIV(sweepStartObj);
+		}
+		else {
+			/* begin objectStartingAt: */
+			numSlots = byteAt(((seg->segStart)) + 7);
+			objOop = (numSlots == (numSlotsMask())
+				? ((seg->segStart)) + BaseHeaderSize
+				: (seg->segStart));
+		}
+		if ((seg->isEvacuated)) {
+			objOop = limit;
+		}
+		startOfFree = null;
+		freeBytes = 0;
+		while (oopisLessThan(objOop, limit)) {
+			if (((((usqInt) (longAt(objOop))) >> (markedBitFullShift())) & 1) != 0) {
+				if (!(startOfFree == null)) {
+					addFreeChunkWithBytesatworker(freeBytes, startOfFree, worker);
+					startOfFree = null;
+					freeBytes = 0;
+				}
+				if (!(((longAt(objOop)) & (classIndexMask())) == (segmentBridgePun()))) {
+					if (GIV(numEvacuatedSegments) > 0) {
+						fmt = (((usqInt) (longAt(objOop))) >> (formatShift())) & (formatMask());
+						if ((fmt <= 5 /* lastPointerFormat */)
+						 || (fmt >= (firstCompiledMethodFormat()))) {
+							followForwardedObjectFieldstoDepth(objOop, 0);
+						}
+					}
+					if (((((usqInt) (longAt(objOop))) >> (pinnedBitShift())) & 1) != 0) {
+						(seg->containsPinned = 1);
+					}
+					/* begin setIsMarkedOf:to: */
+					longAtput(objOop, (longAt(objOop)) & (~(usqIntptr_t)(1ULL << (markedBitFullShift()))));
+				}
+			}
+			else {
+				if (!(startOfFree)) {
+					/* begin startOfObject: */
+					startOfFree = ((usqInt) (((byteAt(objOop + 7)) == (numSlotsMask())
+	? objOop - BaseHeaderSize
+	: objOop)));
+				}
+				freeBytes += bytesInObject(objOop);
+			}
+			/* begin objectAfter:limit: */
+			followingWordAddress = addressAfter(objOop);
+			if (followingWordAddress >= limit) {
+				break;
+			}
+			objOop = ((((usqInt) (longAt(followingWordAddress))) >> (numSlotsFullShift())) == (numSlotsMask())
+				? followingWordAddress + BaseHeaderSize
+				: followingWordAddress);
+		}
+		if (!(startOfFree == null)) {
+			addFreeChunkWithBytesatworker(freeBytes, startOfFree, worker);
+		}
+	}
+}
+
+
 /*	On load, swizzle the pointers in an obj stack. Answer the obj stack's oop. */
 
 	/* SpurMemoryManager>>#swizzleObjStackAt: */
@@ -58664,6 +63030,292 @@ swizzleObjStackAt(sqInt objStackRootIndex)
 }
 
 
+/*	Swizzle the fields of every object in old space using ioNumProcessors()
+	threads. A pass over the object headers alone first splits old space into
+	chunks that start on objects, a few per thread so that the threads stay
+	busy, and each thread then swizzles the next unclaimed chunk in turn.
+	Objects never straddle chunks and swizzleObj: only reads the segment
+	table, so the threads touch disjoint objects. Answer whether the heap
+	was swizzled, which it is not if there is only one processor or the
+	heap is too small for the threads to pay. */
+
+	/* SpurMemoryManager>>#swizzleObjectsInParallel */
+static sqInt NeverInline
+swizzleObjectsInParallel(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    usqInt chunkBytes;
+    sqInt followingWord;
+    usqInt followingWordAddress;
+    usqInt nextChunkStart;
+    sqInt numChunks;
+    usqInt numSlots;
+    sqInt numThreads;
+    sqInt obj;
+
+	numThreads = ioNumProcessors();
+	if ((numThreads <= 1)
+	 || ((GIV(freeOldSpaceStart) - GIV(oldSpaceStart)) < ParallelSwizzleThreshold)) {
+		return 0;
+	}
+	numChunks = numThreads * 4;
+	if (numChunks > MaxSwizzleChunks) {
+		numChunks = MaxSwizzleChunks;
+	}
+	chunkBytes = (GIV(freeOldSpaceStart) - GIV(oldSpaceStart)) / numChunks;
+	GIV(numSwizzleChunks) = 0;
+	nextChunkStart = GIV(oldSpaceStart);
+	/* begin objectStartingAt: */
+	numSlots = byteAt(GIV(oldSpaceStart) + 7);
+	obj = (numSlots == (numSlotsMask())
+		? GIV(oldSpaceStart) + BaseHeaderSize
+		: GIV(oldSpaceStart));
+	while (oopisLessThan(obj, GIV(freeOldSpaceStart))) {
+		if ((obj >= nextChunkStart)
+		 && (GIV(numSwizzleChunks) < MaxSwizzleChunks)) {
+			GIV(swizzleChunkStarts)[GIV(numSwizzleChunks)] = obj;
+			GIV(numSwizzleChunks) += 1;
+			nextChunkStart = obj + chunkBytes;
+		}
+		/* begin objectAfter:limit: */
+		followingWordAddress = addressAfter(obj);
+		if (oopisGreaterThanOrEqualTo(followingWordAddress, GIV(endOfMemory))) {
+			obj = GIV(endOfMemory);
+			goto l1;
+		}
+		flag("endianness");
+		followingWord = longAt(followingWordAddress);
+		obj = ((((usqInt) followingWord) >> (numSlotsFullShift())) == (numSlotsMask())
+			? followingWordAddress + BaseHeaderSize
+			: followingWordAddress);
+	l1:	/* end objectAfter:limit: */;
+	}
+	GIV(swizzleChunkStarts)[GIV(numSwizzleChunks)] = GIV(freeOldSpaceStart);
+	GIV(swizzleChunkIndex) = 0;
+	ioNumThreadsDo(numThreads, swizzleObjectsWorkerarg, 0);
+	return 1;
+}
+
+
+/*	Swizzle the fields of the objects in each chunk claimed by this thread. */
+
+	/* SpurMemoryManager>>#swizzleObjectsWorker:arg: */
+static void
+swizzleObjectsWorkerarg(sqInt workerIndex, void *unused)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    usqInt chunkBytes;
+    sqInt chunkIndex;
+    sqInt classIndex;
+    sqInt field;
+    sqInt fieldAddr;
+    sqInt fieldIndex;
+    sqInt fieldIndex1;
+    sqInt fieldOop;
+    sqInt followingWord;
+    usqInt followingWordAddress;
+    sqInt index;
+    sqInt indexLimiT;
+    usqInt limit;
+    sqInt obj;
+    sqInt valuePointer;
+    sqInt valuePointer1;
+
+	while (1) {
+		ioLockGCThreads();
+		chunkIndex = GIV(swizzleChunkIndex);
+		GIV(swizzleChunkIndex) += 1;
+		ioUnlockGCThreads();
+		if (chunkIndex >= GIV(numSwizzleChunks)) {
+			return;
+		}
+		obj = GIV(swizzleChunkStarts)[chunkIndex];
+		limit = GIV(swizzleChunkStarts)[chunkIndex + 1];
+		while (oopisLessThan(obj, limit)) {
+			classIndex = (longAt(obj)) & (classIndexMask());
+			if (classIndex >= (isForwardedObjectClassIndexPun())) {
+				/* begin swizzleFieldsOfObject: */
+				fieldAddr = obj + (lastPointerOfWhileSwizzling(obj));
+				while (oopisGreaterThanOrEqualTo(fieldAddr, obj + BaseHeaderSize)) {
+					fieldOop = longAt(fieldAddr);
+					if ((fieldOop & (tagMask())) == 0) {
+						longAtput(fieldAddr, swizzleObj(fieldOop));
+					}
+					fieldAddr -= BytesPerOop;
+				}
+			}
+			else {
+				if (classIndex == (isFreeObjectClassIndexPun())) {
+					/* begin swizzleFieldsOfFreeChunk: */
+					fieldIndex = 0 /* freeChunkNextIndex */;
+					field = longAt((obj + BaseHeaderSize) + (((sqInt)((usqInt)(fieldIndex) << (shiftForWord())))));
+					if (field != 0) {
+						/* begin storePointerNoAssert:ofFreeChunk:withValue: */
+						fieldIndex1 = 0 /* freeChunkNextIndex */;
+						valuePointer = swizzleObj(field);
+						longAtput((obj + BaseHeaderSize) + (((sqInt)((usqInt)(fieldIndex1) << (shiftForWord())))), valuePointer);
+					}
+					chunkBytes = bytesInObject(obj);
+					if (chunkBytes >= (64 /* numFreeLists */ * 8 /* allocationUnit */)) {
+						for (index = 2 /* freeChunkParentIndex */, indexLimiT = 4 /* freeChunkLargerIndex */; index <= indexLimiT; index += 1) {
+							/* begin fetchPointer:ofFreeChunk: */
+							field = longAt((obj + BaseHeaderSize) + (((sqInt)((usqInt)(index) << (shiftForWord())))));
+							if (field != 0) {
+								/* begin storePointerNoAssert:ofFreeChunk:withValue: */
+								valuePointer1 = swizzleObj(field);
+								longAtput((obj + BaseHeaderSize) + (((sqInt)((usqInt)(index) << (shiftForWord())))), valuePointer1);
+							}
+						}
+					}
+				}
+			}
+			/* begin objectAfter:limit: */
+			followingWordAddress = addressAfter(obj);
+			if (followingWordAddress >= limit) {
+				break;
+			}
+			followingWord = longAt(followingWordAddress);
+			obj = ((((usqInt) followingWord) >> (numSlotsFullShift())) == (numSlotsMask())
+				? followingWordAddress + BaseHeaderSize
+				: followingWordAddress);
+		}
+	}
+}
+
+
+/*	Count the instances of every class, and the bytes they occupy, in a
+	single pass over the heap, into censusCounts and censusBytes, indexed by
+	class index. The census remains valid until the next scavenge or full
+	GC, so repeated queries in between cost nothing. Answer the number of
+	classes with instances, or -1 if the census tables can't be allocated. */
+
+	/* SpurMemoryManager>>#takeClassCensus */
+static sqInt NeverInline
+takeClassCensus(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    usqInt address;
+    usqInt address1;
+    sqInt capacity;
+    sqInt classIndex;
+    usqInt followingWord;
+    usqInt followingWord1;
+    usqInt followingWord2;
+    usqInt followingWordAddress;
+    usqInt followingWordAddress1;
+    usqInt followingWordAddress2;
+    sqInt gcCount;
+    sqInt numSlots;
+    sqInt numSlots1;
+    sqInt objOop;
+
+	finishIncrementalSweep();
+	gcCount = GIV(statScavenges) + GIV(statFullGCs);
+	if ((GIV(censusCounts) != null)
+	 && (GIV(censusGCCount) == gcCount)) {
+		return GIV(censusNumClasses);
+	}
+	capacity = GIV(numClassTablePages) * (classTablePageSize());
+	if (capacity > GIV(censusCapacity)) {
+		free(GIV(censusCounts));
+		free(GIV(censusBytes));
+		GIV(censusCounts) = malloc(capacity * (sizeof(usqInt)));
+		GIV(censusBytes) = malloc(capacity * (sizeof(usqInt)));
+		if ((GIV(censusCounts) == null)
+		 || (GIV(censusBytes) == null)) {
+			free(GIV(censusCounts));
+			free(GIV(censusBytes));
+			GIV(censusCounts) = (GIV(censusBytes) = null);
+			GIV(censusCapacity) = 0;
+			return -1;
+		}
+		GIV(censusCapacity) = capacity;
+	}
+	memset(GIV(censusCounts), 0, GIV(censusCapacity) * (sizeof(usqInt)));
+	memset(GIV(censusBytes), 0, GIV(censusCapacity) * (sizeof(usqInt)));
+	GIV(censusNumClasses) = 0;
+	/* begin allObjectsDo: */
+	objOop = GIV(nilObj);
+	while (oopisLessThan(objOop, GIV(endOfMemory))) {
+		classIndex = (longAt(objOop)) & (classIndexMask());
+		if (classIndex > (lastClassIndexPun())) {
+			if (GIV(censusCounts)[classIndex] == 0) {
+				GIV(censusNumClasses) += 1;
+			}
+			GIV(censusCounts)[classIndex] += 1;
+			GIV(censusBytes)[classIndex] += bytesInObject(objOop);
+		}
+		/* begin objectAfter:limit: */
+		followingWordAddress = addressAfter(objOop);
+		if (oopisGreaterThanOrEqualTo(followingWordAddress, GIV(endOfMemory))) {
+			objOop = GIV(endOfMemory);
+			goto l1;
+		}
+		flag("endianness");
+		followingWord = longAt(followingWordAddress);
+		objOop = ((((usqInt) followingWord) >> (numSlotsFullShift())) == (numSlotsMask())
+			? followingWordAddress + BaseHeaderSize
+			: followingWordAddress);
+	l1:	/* end objectAfter:limit: */;
+	}
+	/* begin objectStartingAt: */
+	address = ((pastSpace()).start);
+	numSlots = byteAt(address + 7);
+	objOop = (numSlots == (numSlotsMask())
+		? address + BaseHeaderSize
+		: address);
+	while (oopisLessThan(objOop, GIV(pastSpaceStart))) {
+		classIndex = (longAt(objOop)) & (classIndexMask());
+		if (classIndex > (lastClassIndexPun())) {
+			if (GIV(censusCounts)[classIndex] == 0) {
+				GIV(censusNumClasses) += 1;
+			}
+			GIV(censusCounts)[classIndex] += 1;
+			GIV(censusBytes)[classIndex] += bytesInObject(objOop);
+		}
+		/* begin objectAfter:limit: */
+		followingWordAddress1 = addressAfter(objOop);
+		if (oopisGreaterThanOrEqualTo(followingWordAddress1, GIV(pastSpaceStart))) {
+			objOop = GIV(pastSpaceStart);
+			goto l2;
+		}
+		flag("endianness");
+		followingWord1 = longAt(followingWordAddress1);
+		objOop = ((((usqInt) followingWord1) >> (numSlotsFullShift())) == (numSlotsMask())
+			? followingWordAddress1 + BaseHeaderSize
+			: followingWordAddress1);
+	l2:	/* end objectAfter:limit: */;
+	}
+	/* begin objectStartingAt: */
+	address1 = ((eden()).start);
+	numSlots1 = byteAt(address1 + 7);
+	objOop = (numSlots1 == (numSlotsMask())
+		? address1 + BaseHeaderSize
+		: address1);
+	while (oopisLessThan(objOop, GIV(freeStart))) {
+		classIndex = (longAt(objOop)) & (classIndexMask());
+		if (classIndex > (lastClassIndexPun())) {
+			if (GIV(censusCounts)[classIndex] == 0) {
+				GIV(censusNumClasses) += 1;
+			}
+			GIV(censusCounts)[classIndex] += 1;
+			GIV(censusBytes)[classIndex] += bytesInObject(objOop);
+		}
+		/* begin objectAfter:limit: */
+		followingWordAddress2 = addressAfter(objOop);
+		if (oopisGreaterThanOrEqualTo(followingWordAddress2, GIV(freeStart))) {
+			objOop = GIV(freeStart);
+			goto l3;
+		}
+		flag("endianness");
+		followingWord2 = longAt(followingWordAddress2);
+		objOop = ((((usqInt) followingWord2) >> (numSlotsFullShift())) == (numSlotsMask())
+			? followingWordAddress2 + BaseHeaderSize
+			: followingWordAddress2);
+	l3:	/* end objectAfter:limit: */;
+	}
+	GIV(censusGCCount) = gcCount;
+	return GIV(censusNumClasses);
+}
+
+
 /*	Do an incremental GC that tenures all surviving young objects to old
 	space. 
  */
@@ -58678,6 +63330,7 @@ tenuringIncrementalGC(void)
 	savedTenuringThreshold = GIV(tenureThreshold);
 	/* begin setRawTenuringThreshold: */
 	GIV(tenureThreshold) = GIV(newSpaceLimit);
+	GIV(gcCause) = "tenure";
 	scavengingGCTenuringIf(TenureByAge);
 	/* begin setRawTenuringThreshold: */
 	GIV(tenureThreshold) = savedTenuringThreshold;
@@ -58852,6 +63505,10 @@ unlinkFreeChunkchunkBytes(sqInt freeChunk, sqInt chunkBytes)
     sqInt nextFreeChunk;
     sqInt prev;
 
+	if ((GIV(numPinnedSegments) > 0)
+	 && (isInPinnedSegment(freeChunk))) {
+		return unlinkPinnedFreeChunkchunkBytes(freeChunk, chunkBytes);
+	}
 
 	/* Pathological 64 bits case - size 1 - single linked list */
 	index = chunkBytes / 8 /* allocationUnit */;
@@ -58911,6 +63568,50 @@ unlinkFreeChunkchunkBytes(sqInt freeChunk, sqInt chunkBytes)
 	return freeChunk;
 }
 
+
+/*	Unlink a free chunk from the pinned free lists, for coalescing. Its
+	caller takes it off totalFreeOldSpace, where it was never counted, so
+	take it off totalFreePinnedSpace instead. */
+
+	/* SpurMemoryManager>>#unlinkPinnedFreeChunk:chunkBytes: */
+static sqInt NoDbgRegParms
+unlinkPinnedFreeChunkchunkBytes(sqInt freeChunk, usqInt chunkBytes)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt chunk;
+    sqInt index;
+    sqInt next;
+    sqInt prev;
+    usqInt units;
+
+	/* begin pinnedFreeListIndexFor: */
+	index = 0;
+	units = chunkBytes / 8 /* allocationUnit */;
+	while (((units = units >> 1) > 0)
+	 && (index < (NumPinnedFreeLists - 1))) {
+		index += 1;
+	}
+	GIV(totalFreeOldSpace) += chunkBytes;
+	GIV(totalFreePinnedSpace) -= chunkBytes;
+	prev = 0;
+	chunk = GIV(pinnedFreeLists)[index];
+	while (chunk != 0) {
+		next = longAt((chunk + BaseHeaderSize) + (0U << (shiftForWord())));
+		if (chunk == freeChunk) {
+			if (prev == 0) {
+				GIV(pinnedFreeLists)[index] = next;
+			}
+			else {
+				longAtput((prev + BaseHeaderSize) + (0U << (shiftForWord())), next);
+			}
+			return 0;
+		}
+		prev = chunk;
+		chunk = next;
+	}
+	error("free chunk not on pinned free list");
+	return 0;
+}
+
 	/* SpurMemoryManager>>#unlinkSmallChunk:index: */
 static sqInt NoDbgRegParms NeverInline
 unlinkSmallChunkindex(sqInt freeChunk, sqInt index)
@@ -59262,6 +63963,107 @@ vmEndianness(void)
 }
 
 
+/*	Write a full GC record to the GC log. Times are in microseconds; the
+	start time is relative to the Unix epoch. The mode is compact, sweep or
+	incrementalSweep, the latter's sweep continuing in subsequent
+	sweepStep records. */
+
+	/* SpurMemoryManager>>#writeFullGCLogRecord:rootMark:compactionStart: */
+static void NoDbgRegParms NeverInline
+writeFullGCLogRecordrootMarkcompactionStart(usqLong gcMarkEndUsecs, usqLong rootMarkUsecs, usqLong compactionStartUsecs)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    usqLong compactUsecs;
+    char *mode;
+    usqLong sweepUsecs;
+
+	if (GIV(sweepCursor) != 0) {
+		mode = "incrementalSweep";
+		sweepUsecs = GIV(gcSweepEndUsecs) - compactionStartUsecs;
+		compactUsecs = 0;
+	}
+	else {
+		if (GIV(gcSweepEndUsecs) != 0) {
+			mode = "sweep";
+			sweepUsecs = GIV(gcSweepEndUsecs) - compactionStartUsecs;
+			compactUsecs = 0;
+		}
+		else {
+			mode = "compact";
+			sweepUsecs = 0;
+			compactUsecs = GIV(statGCEndUsecs) - compactionStartUsecs;
+		}
+	}
+	fprintf(GIV(gcLog), "{\"event\":\"fullGC\",\"n\":%llu,\"cause\":\"%s\",\"unixUsecs\":%llu,\"usecs\":%llu,\"markUsecs\":%llu,\"rootMarkUsecs\":%llu,\"sweepUsecs\":%llu,\"compactUsecs\":%llu,\"mode\":\"%s\",\"oldSpaceBytesBefore\":%llu,\"oldSpaceBytesAfter\":%llu,\"heapBytes\":%llu,\"freeBytes\":%llu,\"tenuredBytes\":%llu,\"remSet\":%llu}\n", ((unsigned long long) GIV(statFullGCs)), (GIV(gcCause) == null
+		? "other"
+		: GIV(gcCause)), ((unsigned long long) (GIV(gcStartUsecs) - MicrosecondsFrom1901To1970)), ((unsigned long long) (GIV(statGCEndUsecs) - GIV(gcStartUsecs))), ((unsigned long long) (gcMarkEndUsecs - GIV(gcStartUsecs))), ((unsigned long long) rootMarkUsecs), ((unsigned long long) sweepUsecs), ((unsigned long long) compactUsecs), mode, ((unsigned long long) GIV(gcLogBytesBefore)), ((unsigned long long) ((GIV(totalHeapSizeIncludingBridges) - (GIV(numSegments) * (2 * BaseHeaderSize))) - GIV(totalFreeOldSpace))), ((unsigned long long) GIV(totalHeapSizeIncludingBridges)), ((unsigned long long) GIV(totalFreeOldSpace)), ((unsigned long long) (GIV(statTenuredBytes) - GIV(gcLogTenuredBytesBefore))), ((unsigned long long) GIV(rememberedSetSize)));
+	fflush(GIV(gcLog));
+}
+
+
+/*	Write an incremental mark step record to the GC log. */
+
+	/* SpurMemoryManager>>#writeIncrementalMarkLogRecord:usecs: */
+static void NoDbgRegParms NeverInline
+writeIncrementalMarkLogRecordusecs(usqLong startUsecs, usqLong usecs)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+	fprintf(GIV(gcLog), "{\"event\":\"markStep\",\"n\":%llu,\"unixUsecs\":%llu,\"usecs\":%llu,\"done\":%s,\"markStack\":%llu}\n", ((unsigned long long) GIV(statIncrGCs)), ((unsigned long long) (startUsecs - MicrosecondsFrom1901To1970)), ((unsigned long long) usecs), (GIV(concurrentMarkFinished)
+		? "true"
+		: "false"), ((unsigned long long) GIV(concurrentMarkStackTop)));
+	fflush(GIV(gcLog));
+}
+
+
+/*	Write an incremental sweep step record to the GC log. */
+
+	/* SpurMemoryManager>>#writeIncrementalSweepLogRecord:usecs: */
+static void NoDbgRegParms NeverInline
+writeIncrementalSweepLogRecordusecs(usqLong startUsecs, usqLong usecs)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+	fprintf(GIV(gcLog), "{\"event\":\"sweepStep\",\"n\":%llu,\"unixUsecs\":%llu,\"usecs\":%llu,\"done\":%s,\"freeBytes\":%llu}\n", ((unsigned long long) GIV(statIncrGCs)), ((unsigned long long) (startUsecs - MicrosecondsFrom1901To1970)), ((unsigned long long) usecs), (GIV(sweepCursor) == 0
+		? "true"
+		: "false"), ((unsigned long long) GIV(totalFreeOldSpace)));
+	fflush(GIV(gcLog));
+}
+
+
+/*	Answer if the survivors in seg can be moved. Pinned objects must stay
+	where they are. Hidden objects, such as obj stack pages and class table
+	pages, are referred to from outside the heap or through links that are
+	not followed as pointers, so they must stay where they are too. */
+
+	/* SpurPlanningCompactor>>#canEvacuateSegment: */
+static sqInt NoDbgRegParms
+canEvacuateSegment(SpurSegmentInfo *seg)
+{
+    usqInt followingWordAddress;
+    usqInt limit;
+    usqInt numSlots;
+    sqInt objOop;
+
+	limit = (((seg->segSize)) + ((seg->segStart))) - (2 * BaseHeaderSize);
+	/* begin objectStartingAt: */
+	numSlots = byteAt(((seg->segStart)) + 7);
+	objOop = (numSlots == (numSlotsMask())
+		? ((seg->segStart)) + BaseHeaderSize
+		: (seg->segStart));
+	while (oopisLessThan(objOop, limit)) {
+		if ((((((usqInt) (longAt(objOop))) >> (markedBitFullShift())) & 1) != 0)
+		 && ((((((usqInt) (longAt(objOop))) >> (pinnedBitShift())) & 1) != 0)
+		 || (((longAt(objOop)) & (classIndexMask())) <= (lastClassIndexPun())))) {
+			return 0;
+		}
+		/* begin objectAfter:limit: */
+		followingWordAddress = addressAfter(objOop);
+		if (followingWordAddress >= limit) {
+			break;
+		}
+		objOop = ((((usqInt) (longAt(followingWordAddress))) >> (numSlotsFullShift())) == (numSlotsMask())
+			? followingWordAddress + BaseHeaderSize
+			: followingWordAddress);
+	}
+	return 1;
+}
+
 /*	Sweep all of old space, sliding unpinned marked objects down over free and
 	unmarked objects.
 	Let the segmentManager mark which segments contain pinned objects via
@@ -59277,10 +64079,8 @@ compact(void)
     sqInt finalPass;
     sqInt firstPass;
     sqInt followingWord;
-    sqInt followingWord1;
     sqInt followingWord2;
     usqInt followingWordAddress;
-    usqInt followingWordAddress1;
     usqInt followingWordAddress2;
     sqInt highestSuitableFreeBlock;
     sqInt i;
@@ -59291,17 +64091,14 @@ compact(void)
     usqInt numSlots;
     usqInt numSlots1;
     sqInt objOop1;
-    sqInt objOop11;
     sqInt objOop111;
     sqInt objOop12;
     sqInt objOop13;
     sqInt objOop31;
     sqInt objOop4;
     sqInt prevObj;
-    sqInt prevObj1;
     sqInt prevObj2;
     sqInt prevPrevObj;
-    sqInt prevPrevObj1;
     sqInt prevPrevObj2;
     sqInt sizeOfEden;
     sqInt spaceEstimate;
@@ -59311,37 +64108,7 @@ compact(void)
 	/* for profiling */
 	if (initializeScanCheckingForFullyCompactedHeap()) {
 		/* begin unmarkObjectsInFullyCompactedHeap */
-		assert(isOldObject(GIV(nilObj)));
-		prevPrevObj1 = (prevObj1 = null);
-		objOop11 = GIV(nilObj);
-		while (1) {
-			assert((objOop11 % (allocationUnit())) == 0);
-			if (!(oopisLessThan(objOop11, GIV(endOfMemory)))) break;
-			assert((long64At(objOop11)) != 0);
-			if (isEnumerableObject(objOop11)) {
-				if (oopisGreaterThanOrEqualTo(objOop11, GIV(firstMobileObject))) {
-					goto l4;
-				}
-				/* begin setIsMarkedOf:to: */
-				assert(!(isFreeObject(objOop11)));
-				longAtput(objOop11, (longAt(objOop11)) & (~(usqIntptr_t)(1ULL << (markedBitFullShift()))));
-			}
-			prevPrevObj1 = prevObj1;
-			prevObj1 = objOop11;
-			/* begin objectAfter:limit: */
-			followingWordAddress1 = addressAfter(objOop11);
-			if (oopisGreaterThanOrEqualTo(followingWordAddress1, GIV(endOfMemory))) {
-				objOop11 = GIV(endOfMemory);
-				goto l3;
-			}
-			flag("endianness");
-			followingWord1 = longAt(followingWordAddress1);
-			objOop11 = ((((usqInt) followingWord1) >> (numSlotsFullShift())) == (numSlotsMask())
-				? followingWordAddress1 + BaseHeaderSize
-				: followingWordAddress1);
-	l3:	/* end objectAfter:limit: */;
-		}
-	l4:	/* end unmarkInitialImmobileObjects */;
+		unmarkInitialImmobileObjects();
 		/* begin unmarkSurvivingObjectsForCompact */
 		prevPrevObj = (prevObj = null);
 		/* begin objectStartingAt: */
@@ -59422,6 +64189,7 @@ compact(void)
 	GIV(savedFirstFieldsSpaceNotInOldSpace) = 1;
 	assert(!((savedFirstFieldsSpaceWasAllocated())));
 	l6:	/* end selectSavedFirstFieldsSpace */;
+	pinLargeObjects();
 	/* begin unpinRememberedSet */
 	objOop4 = longAt((GIV(hiddenRootsObj) + BaseHeaderSize) + (((sqInt)((usqInt)(RememberedSetRootIndex) << (shiftForWord())))));
 	GIV(firstFieldOfRememberedSet) = longAt((objOop4 + BaseHeaderSize) + (0U << (shiftForWord())));
@@ -59433,6 +64201,10 @@ compact(void)
 	for (i = 0, iLimiT = (64 /* numFreeLists */ - 1); i <= iLimiT; i += 1) {
 		GIV(freeLists)[i] = 0;
 	}
+	for (i = 0; i < NumPinnedFreeLists; i += 1) {
+		GIV(pinnedFreeLists)[i] = 0;
+	}
+	GIV(totalFreePinnedSpace) = 0;
 	/* begin totalFreeOldSpace: */
 	GIV(totalFreeOldSpace) = 0;
 	/* begin beginSlidingCompaction */
@@ -59532,6 +64304,7 @@ compact(void)
 	longAtput(objOop111, (longAt(objOop111)) | (1U << (pinnedBitShift())));
 	/* begin relocateRememberedSet */
 	GIV(rememberedSet) = firstIndexableField(longAt((GIV(hiddenRootsObj) + BaseHeaderSize) + (((sqInt)((usqInt)(RememberedSetRootIndex) << (shiftForWord()))))));
+	unpinLargeObjects();
 	/* begin releaseSavedFirstFieldsSpace */
 	if (GIV(savedFirstFieldsSpaceNotInOldSpace)
 	 && (oopisGreaterThan((GIV(savedFirstFieldsSpace).start), GIV(nilObj)))) {
@@ -59784,54 +64557,18 @@ static void NoDbgRegParms NeverInline
 copyAndUnmark(sqInt firstPass)
 {   DECL_MAYBE_SQ_GLOBAL_STRUCT
     sqInt finalPass;
-    sqInt followingWord;
     sqInt followingWord1;
-    usqInt followingWordAddress;
     usqInt followingWordAddress1;
     sqInt freeBytes;
-    sqInt objOop1;
     sqInt objOop2;
-    sqInt prevObj;
     sqInt prevObj1;
-    sqInt prevPrevObj;
     sqInt prevPrevObj1;
     sqInt startOfFree;
 
 	startOfFree = 0;
 	/* begin logPhase: */
 	if (firstPass) {
-		/* begin unmarkInitialImmobileObjects */
-		assert(isOldObject(GIV(nilObj)));
-		prevPrevObj = (prevObj = null);
-		objOop1 = GIV(nilObj);
-		while (1) {
-			assert((objOop1 % (allocationUnit())) == 0);
-			if (!(oopisLessThan(objOop1, GIV(endOfMemory)))) break;
-			assert((long64At(objOop1)) != 0);
-			if (isEnumerableObject(objOop1)) {
-				if (oopisGreaterThanOrEqualTo(objOop1, GIV(firstMobileObject))) {
-					goto l2;
-				}
-				/* begin setIsMarkedOf:to: */
-				assert(!(isFreeObject(objOop1)));
-				longAtput(objOop1, (longAt(objOop1)) & (~(usqIntptr_t)(1ULL << (markedBitFullShift()))));
-			}
-			prevPrevObj = prevObj;
-			prevObj = objOop1;
-			/* begin objectAfter:limit: */
-			followingWordAddress = addressAfter(objOop1);
-			if (oopisGreaterThanOrEqualTo(followingWordAddress, GIV(endOfMemory))) {
-				objOop1 = GIV(endOfMemory);
-				goto l1;
-			}
-			flag("endianness");
-			followingWord = longAt(followingWordAddress);
-			objOop1 = ((((usqInt) followingWord) >> (numSlotsFullShift())) == (numSlotsMask())
-				? followingWordAddress + BaseHeaderSize
-				: followingWordAddress);
-	l1:	/* end objectAfter:limit: */;
-		}
-	l2:	/* end unmarkInitialImmobileObjects */;
+		unmarkInitialImmobileObjects();
 	}
 	finalPass = copyAndUnmarkMobileObjects();
 	if ((GIV(lastMobileObject) != null)
@@ -59916,6 +64653,162 @@ copyAndUnmark(sqInt firstPass)
 	}
 }
 
+/*	Copy the marked objects in seg into free chunks outside the segments
+	being evacuated, turning each into a forwarder to its copy. The copies
+	are marked, so the sweep keeps them and follows the forwarders in their
+	fields like those in any other survivor. Chunks the free lists offer
+	from segments being evacuated are set aside; the sweep does not rebuild
+	the free lists from those segments. If space runs out part way, put the
+	segment back as it was and answer false. */
+
+	/* SpurPlanningCompactor>>#evacuateSegment: */
+static sqInt NoDbgRegParms
+evacuateSegment(SpurSegmentInfo *seg)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    usqInt bytes;
+    sqInt chunk;
+    sqInt copy;
+    usqInt followingWordAddress;
+    usqInt limit;
+    usqInt numSlots;
+    sqInt objOop;
+    sqInt start;
+
+	limit = (((seg->segSize)) + ((seg->segStart))) - (2 * BaseHeaderSize);
+	/* begin objectStartingAt: */
+	numSlots = byteAt(((seg->segStart)) + 7);
+	objOop = (numSlots == (numSlotsMask())
+		? ((seg->segStart)) + BaseHeaderSize
+		: (seg->segStart));
+	while (oopisLessThan(objOop, limit)) {
+		if (((((usqInt) (longAt(objOop))) >> (markedBitFullShift())) & 1) != 0) {
+			bytes = bytesInObject(objOop);
+			/* begin startOfObject: */
+			start = ((usqInt) (((byteAt(objOop + 7)) == (numSlotsMask())
+	? objOop - BaseHeaderSize
+	: objOop)));
+			while (1) {
+				chunk = allocateOldSpaceChunkOfBytes(bytes);
+				if (!((chunk != null)
+				 && (((segmentContainingObj(chunk))->isEvacuated)))) break;
+				initFreeChunkWithBytesat(bytes, chunk);
+			}
+			if (chunk == null) {
+				unevacuateSegment(seg);
+				return 0;
+			}
+			memcpy(((void *)chunk), ((void *)start), bytes);
+			copy = chunk + (objOop - start);
+			/* begin forward:to: */
+			longAtput(objOop, ((longAt(objOop)) & (~(usqIntptr_t)((((sqInt)((usqInt)((formatMask())) << (formatShift())))) + (classIndexMask())))) + ((isForwardedObjectClassIndexPun()) + (7U << (formatShift()))));
+			
+#    if IMMUTABILITY
+			/* begin setIsImmutableOf:to: */
+			longAtput(objOop, (longAt(objOop)) & (~(usqIntptr_t)(1U << (immutableBitShift()))));
+#    endif /* IMMUTABILITY */
+			longAtput(objOop + BaseHeaderSize, copy);
+		}
+		/* begin objectAfter:limit: */
+		followingWordAddress = addressAfter(objOop);
+		if (followingWordAddress >= limit) {
+			break;
+		}
+		objOop = ((((usqInt) (longAt(followingWordAddress))) >> (numSlotsFullShift())) == (numSlotsMask())
+			? followingWordAddress + BaseHeaderSize
+			: followingWordAddress);
+	}
+	return 1;
+}
+
+
+/*	Evacuate the sparse segments, those whose live bytes, counted during
+	marking, are fewer than their dead bytes divided by compactionMoveRatio.
+	This is the trade of bytes moved for bytes reclaimed that
+	shouldSweepInsteadOfCompacting makes for the heap as a whole, so the
+	work done grows with the garbage reclaimed, not with the heap. The
+	first segment, which holds nil, true, false and the free lists, and the
+	segments for large and pinned objects are never evacuated, and no more
+	is chosen than there is free space for. Answer the number of segments
+	evacuated. sweepWithoutCompacting then skips them, follows the
+	forwarders left in the survivors and the roots, and frees them. */
+
+	/* SpurPlanningCompactor>>#evacuateSparseSegments */
+static sqInt NeverInline
+evacuateSparseSegments(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    usqInt budget;
+    sqInt i;
+    sqInt j;
+    SpurSegmentInfo *seg;
+
+	GIV(numEvacuatedSegments) = 0;
+	budget = GIV(totalFreeOldSpace);
+	for (i = 1; i < GIV(numSegments); i += 1) {
+		seg = (&(GIV(segments)[i]));
+		(seg->isEvacuated = (!(((seg->isLargeObjectSegment))
+		 || ((seg->isPinnedSegment))))
+		 && (((((seg->liveBytes)) * compactionMoveRatio) < ((((seg->segSize)) - (2 * BaseHeaderSize)) - ((seg->liveBytes))))
+		 && ((((seg->liveBytes)) <= budget)
+		 && (canEvacuateSegment(seg)))));
+		if ((seg->isEvacuated)) {
+			budget -= (seg->liveBytes);
+		}
+	}
+	for (i = 1; i < GIV(numSegments); i += 1) {
+		seg = (&(GIV(segments)[i]));
+		if ((seg->isEvacuated)) {
+			if (!(evacuateSegment(seg))) {
+				for (j = i; j < GIV(numSegments); j += 1) {
+					((GIV(segments)[j]).isEvacuated = 0);
+				}
+				break;
+			}
+			GIV(numEvacuatedSegments) += 1;
+		}
+	}
+	return GIV(numEvacuatedSegments);
+}
+
+
+/*	Follow the forwarders evacuateSparseSegments left in the references
+	from outside the heap: the interpreter's and machine code's, the extra
+	roots, the remembered set and the mourn queue. The sweep follows those
+	in the heap. */
+
+	/* SpurPlanningCompactor>>#followForwardersInRoots */
+static void
+followForwardersInRoots(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt i;
+    sqInt objStackPage;
+    sqInt oop;
+
+	mapInterpreterOops();
+	mapExtraRoots();
+	for (i = 0; i < GIV(rememberedSetSize); i += 1) {
+		oop = GIV(rememberedSet)[i];
+		if (((longAt(oop)) & ((classIndexMask()) - (isForwardedObjectClassIndexPun()))) == 0) {
+			GIV(rememberedSet)[i] = (longAt((oop + BaseHeaderSize) + (0U << (shiftForWord()))));
+		}
+	}
+	/* begin objStack:do: */
+	if (GIV(mournQueue) == GIV(nilObj)) {
+		return;
+	}
+	objStackPage = GIV(mournQueue);
+	while (objStackPage != 0) {
+		for (i = (((longAt((objStackPage + BaseHeaderSize) + (((sqInt)((usqInt)(ObjStackTopx) << (shiftForWord())))))) + ObjStackFixedSlots) - 1); i >= ObjStackFixedSlots; i += -1) {
+			oop = longAt((objStackPage + BaseHeaderSize) + (((sqInt)((usqInt)(i) << (shiftForWord())))));
+			if (((oop & (tagMask())) == 0)
+			 && (((longAt(oop)) & ((classIndexMask()) - (isForwardedObjectClassIndexPun()))) == 0)) {
+				longAtput((objStackPage + BaseHeaderSize) + (((sqInt)((usqInt)(i) << (shiftForWord())))), longAt((oop + BaseHeaderSize) + (0U << (shiftForWord()))));
+			}
+		}
+		/* begin fetchPointer:ofObject: */
+		objStackPage = longAt((objStackPage + BaseHeaderSize) + (((sqInt)((usqInt)(ObjStackNextx) << (shiftForWord())))));
+	}
+}
+
 
 /*	Free from toFinger up to limit, dealing with possible intervening pinned
 	objects. 
@@ -60021,6 +64914,43 @@ isPostMobile(sqInt obj)
 }
 
 
+/*	Pin, for the duration of the compaction, the objects in the segments
+	allocateLargeObjectChunkOfBytes: makes for large objects, so that the
+	compactor treats them as it does pinned objects and never moves them.
+	The bridge filling the rest of each such segment is already pinned, so
+	nothing is moved into it either. Note which were pinned here, for
+	unpinLargeObjects to put back; those the image pinned stay pinned. */
+
+	/* SpurPlanningCompactor>>#pinLargeObjects */
+static void
+pinLargeObjects(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt i;
+    usqInt numSlots;
+    sqInt objOop;
+    SpurSegmentInfo *seg;
+
+	if (GIV(numLargeObjectSegments) == 0) {
+		return;
+	}
+	for (i = 1; i < GIV(numSegments); i += 1) {
+		seg = (&(GIV(segments)[i]));
+		if ((seg->isLargeObjectSegment)) {
+			/* begin objectStartingAt: */
+			numSlots = byteAt(((seg->segStart)) + 7);
+			objOop = (numSlots == (numSlotsMask())
+				? ((seg->segStart)) + BaseHeaderSize
+				: (seg->segStart));
+			(seg->pinnedForCompaction = !(((((usqInt) (longAt(objOop))) >> (pinnedBitShift())) & 1) != 0));
+			if ((seg->pinnedForCompaction)) {
+				/* begin setIsPinnedOf:to: */
+				longAtput(objOop, (longAt(objOop)) | (1U << (pinnedBitShift())));
+			}
+		}
+	}
+}
+
+
 /*	Sweep the heap from firstFreeObject forwarding marked objects to where
 	they can be moved to, saving their forwarding pointer in
 	savedFirstFieldsSpace. Continue until either the end of the heap is
@@ -60370,6 +65300,426 @@ shouldRemapObj(sqInt objOop)
 }
 
 
+/*	Answer if the full GC should sweep old space in place, evacuating only
+	its sparse segments, rather than slide it down. The sliding compactor
+	moves every unpinned object above the first free gap, so a single hole
+	near the start of the heap makes it move nearly everything. Estimate
+	from the live bytes marking counted in each segment the bytes that
+	would move and the bytes that would be reclaimed, and sweep when moving
+	would cost more than compactionMoveRatio times what it gains. The
+	objects in the segments for pinned objects never move, the segments
+	for large objects are left out altogether, and half the live bytes of
+	the first segment with a gap are taken to move.
+	A ratio of zero always compacts. */
+
+	/* SpurPlanningCompactor>>#shouldSweepInsteadOfCompacting */
+static sqInt NeverInline
+shouldSweepInsteadOfCompacting(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    usqInt bytesToMove;
+    usqInt deadBytes;
+    sqInt i;
+    SpurSegmentInfo *seg;
+    usqInt segDeadBytes;
+
+	if (compactionMoveRatio <= 0) {
+		return 0;
+	}
+	bytesToMove = (deadBytes = 0);
+	for (i = 0; i < GIV(numSegments); i += 1) {
+		seg = (&(GIV(segments)[i]));
+		if (!((seg->isLargeObjectSegment))) {
+			segDeadBytes = (((seg->segSize)) - (2 * BaseHeaderSize)) - ((seg->liveBytes));
+			if (!((seg->isPinnedSegment))) {
+				if (deadBytes > 0) {
+					bytesToMove += (seg->liveBytes);
+				}
+				else {
+					if (segDeadBytes > 0) {
+						bytesToMove += ((seg->liveBytes)) / 2;
+					}
+				}
+			}
+			deadBytes += segDeadBytes;
+		}
+	}
+	return (deadBytes > 0)
+	 && (bytesToMove > (deadBytes * compactionMoveRatio));
+}
+
+
+/*	Sweep old space in place, moving only the survivors of the sparse
+	segments that evacuateSparseSegments empties. Rebuild the free lists
+	from runs of unmarked objects and free chunks, and unmark the marked
+	objects, noting which segments contain pinned objects as the compactor
+	does. Bridges stay marked, so no run crosses a segment boundary. If any
+	segment was evacuated, skip it, follow the forwarders to its objects
+	in the fields of the survivors and in the roots, and free it. The cost
+	is one pass over the object headers, and over the fields of the
+	survivors when objects have moved. When there are helper GC threads the
+	segments are swept in parallel, each thread building free lists of its
+	own that are merged at the end. */
+
+	/* SpurPlanningCompactor>>#sweepWithoutCompacting */
+static void NeverInline
+sweepWithoutCompacting(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt address;
+    sqInt fmt;
+    sqInt followingWord;
+    sqInt followingWord1;
+    usqInt followingWordAddress;
+    usqInt followingWordAddress1;
+    sqInt freeBytes;
+    sqInt i;
+    sqInt iLimiT;
+    usqInt numSlots;
+    sqInt objOop;
+    sqInt objOop1;
+    sqInt prevObj;
+    sqInt prevObj1;
+    sqInt prevPrevObj;
+    sqInt prevPrevObj1;
+    sqInt segIndex;
+    sqInt startOfFree;
+
+	evacuateSparseSegments();
+	/* begin resetFreeListHeads */
+	GIV(freeListsMask) = 0;
+	for (i = 0, iLimiT = (64 /* numFreeLists */ - 1); i <= iLimiT; i += 1) {
+		GIV(freeLists)[i] = 0;
+	}
+	for (i = 0; i < NumPinnedFreeLists; i += 1) {
+		GIV(pinnedFreeLists)[i] = 0;
+	}
+	GIV(totalFreePinnedSpace) = 0;
+	/* begin totalFreeOldSpace: */
+	GIV(totalFreeOldSpace) = 0;
+	if ((ioNumGCThreads() > 1)
+	 && ((GIV(numSegments) > 1)
+	 && (ensureSweepWorkers(ioNumGCThreads())))) {
+		parallelSweepSegmentsFrombudget(GIV(nilObj), 0);
+		mergeSweepWorkers(ioNumGCThreads());
+		goto l3;
+	}
+	startOfFree = null;
+	freeBytes = 0;
+	segIndex = 0;
+	/* begin allOldSpaceEntitiesFrom:do: */
+	assert(isOldObject(GIV(nilObj)));
+	prevPrevObj = (prevObj = null);
+	objOop = GIV(nilObj);
+	while (1) {
+		assert((objOop % (allocationUnit())) == 0);
+		if (!(oopisLessThan(objOop, GIV(endOfMemory)))) break;
+		assert((long64At(objOop)) != 0);
+		if (GIV(numEvacuatedSegments) > 0) {
+			while (objOop >= ((((GIV(segments)[segIndex]).segSize)) + (((GIV(segments)[segIndex]).segStart)))) {
+				segIndex += 1;
+			}
+			if (((GIV(segments)[segIndex]).isEvacuated)) {
+
+				/* skip to its bridge; freeEvacuatedSegments frees it */
+				address = ((((GIV(segments)[segIndex]).segSize)) + (((GIV(segments)[segIndex]).segStart))) - (2 * BaseHeaderSize);
+				/* begin objectStartingAt: */
+				numSlots = byteAt(address + 7);
+				objOop = (numSlots == (numSlotsMask())
+					? address + BaseHeaderSize
+					: address);
+			}
+		}
+		if (((((usqInt) (longAt(objOop))) >> (markedBitFullShift())) & 1) != 0) {
+			if (!(startOfFree == null)) {
+				/* begin addFreeChunkWithBytes:at: */
+				GIV(totalFreeOldSpace) += freeBytes;
+				freeChunkWithBytesat(freeBytes, startOfFree);
+				startOfFree = null;
+				freeBytes = 0;
+			}
+			if (GIV(numEvacuatedSegments) > 0) {
+				fmt = (((usqInt) (longAt(objOop))) >> (formatShift())) & (formatMask());
+				if ((fmt <= 5 /* lastPointerFormat */)
+				 || (fmt >= (firstCompiledMethodFormat()))) {
+					followForwardedObjectFieldstoDepth(objOop, 0);
+				}
+			}
+			if (((((usqInt) (longAt(objOop))) >> (pinnedBitShift())) & 1) != 0) {
+				/* begin unmarkPinned: */
+				if (!(((longAt(objOop)) & (classIndexMask())) == (segmentBridgePun()))) {
+					/* begin setIsMarkedOf:to: */
+					assert(!(isFreeObject(objOop)));
+					longAtput(objOop, (longAt(objOop)) & (~(usqIntptr_t)(1ULL << (markedBitFullShift()))));
+					/* begin notePinned: */
+					assert(isPinned(objOop));
+					while (oopisLessThan((((GIV(segments)[GIV(sweepIndex)]).segSize)) + (((GIV(segments)[GIV(sweepIndex)]).segStart)), objOop)) {
+						GIV(sweepIndex) += 1;
+					}
+					((GIV(segments)[GIV(sweepIndex)]).containsPinned = 1);
+				}
+			}
+			else {
+				/* begin setIsMarkedOf:to: */
+				assert(!(isFreeObject(objOop)));
+				longAtput(objOop, (longAt(objOop)) & (~(usqIntptr_t)(1ULL << (markedBitFullShift()))));
+			}
+		}
+		else {
+			if (!(startOfFree)) {
+				/* begin startOfObject: */
+				startOfFree = ((usqInt) (((byteAt(objOop + 7)) == (numSlotsMask())
+	? objOop - BaseHeaderSize
+	: objOop)));
+			}
+			freeBytes += bytesInObject(objOop);
+		}
+		prevPrevObj = prevObj;
+		prevObj = objOop;
+		/* begin objectAfter:limit: */
+		followingWordAddress = addressAfter(objOop);
+		if (oopisGreaterThanOrEqualTo(followingWordAddress, GIV(endOfMemory))) {
+			objOop = GIV(endOfMemory);
+			goto l1;
+		}
+		flag("endianness");
+		followingWord = longAt(followingWordAddress);
+		objOop = ((((usqInt) followingWord) >> (numSlotsFullShift())) == (numSlotsMask())
+			? followingWordAddress + BaseHeaderSize
+			: followingWordAddress);
+	l1:	/* end objectAfter:limit: */;
+	}
+	if (!(startOfFree == null)) {
+		/* begin addFreeChunkWithBytes:at: */
+		GIV(totalFreeOldSpace) += freeBytes;
+		freeChunkWithBytesat(freeBytes, startOfFree);
+	}
+	l3:	/* end sweepSegments */;
+	/* begin unmarkSurvivingObjectsForCompact */
+	prevPrevObj1 = (prevObj1 = null);
+	/* begin objectStartingAt: */
+	address = ((pastSpace()).start);
+	numSlots = byteAt(address + 7);
+	objOop1 = (numSlots == (numSlotsMask())
+		? address + BaseHeaderSize
+		: address);
+	while (oopisLessThan(objOop1, GIV(pastSpaceStart))) {
+		assert(isEnumerableObjectNoAssert(objOop1));
+		if (((((usqInt) (longAt(objOop1))) >> (markedBitFullShift())) & 1) != 0) {
+			if (GIV(numEvacuatedSegments) > 0) {
+				fmt = (((usqInt) (longAt(objOop1))) >> (formatShift())) & (formatMask());
+				if ((fmt <= 5 /* lastPointerFormat */)
+				 || (fmt >= (firstCompiledMethodFormat()))) {
+					followForwardedObjectFieldstoDepth(objOop1, 0);
+				}
+			}
+			/* begin setIsMarkedOf:to: */
+			assert(!(isFreeObject(objOop1)));
+			longAtput(objOop1, (longAt(objOop1)) & (~(usqIntptr_t)(1ULL << (markedBitFullShift()))));
+		}
+		prevPrevObj1 = prevObj1;
+		prevObj1 = objOop1;
+		/* begin objectAfter:limit: */
+		followingWordAddress1 = addressAfter(objOop1);
+		if (oopisGreaterThanOrEqualTo(followingWordAddress1, GIV(pastSpaceStart))) {
+			objOop1 = GIV(pastSpaceStart);
+			goto l2;
+		}
+		flag("endianness");
+		followingWord1 = longAt(followingWordAddress1);
+		objOop1 = ((((usqInt) followingWord1) >> (numSlotsFullShift())) == (numSlotsMask())
+			? followingWordAddress1 + BaseHeaderSize
+			: followingWordAddress1);
+	l2:	/* end objectAfter:limit: */;
+	}
+	if (GIV(numEvacuatedSegments) > 0) {
+		followForwardersInRoots();
+		freeEvacuatedSegments();
+	}
+	GIV(statNonCompactingGCs) += 1;
+	GIV(gcSweepEndUsecs) = ioUTCMicrosecondsNow();
+}
+
+/*	Put back the objects evacuateSegment: had moved out of seg before it ran
+	out of space. Its forwarders are still marked, which tells them from
+	the dead forwarders in the segment. Their copies are left unmarked, for
+	the sweep to free. */
+
+	/* SpurPlanningCompactor>>#unevacuateSegment: */
+static void NoDbgRegParms
+unevacuateSegment(SpurSegmentInfo *seg)
+{
+    sqInt copy;
+    usqInt followingWordAddress;
+    usqInt limit;
+    usqInt numSlots;
+    sqInt objOop;
+
+	limit = (((seg->segSize)) + ((seg->segStart))) - (2 * BaseHeaderSize);
+	/* begin objectStartingAt: */
+	numSlots = byteAt(((seg->segStart)) + 7);
+	objOop = (numSlots == (numSlotsMask())
+		? ((seg->segStart)) + BaseHeaderSize
+		: (seg->segStart));
+	while (oopisLessThan(objOop, limit)) {
+		if ((((((usqInt) (longAt(objOop))) >> (markedBitFullShift())) & 1) != 0)
+		 && (((longAt(objOop)) & (classIndexMask())) == (isForwardedObjectClassIndexPun()))) {
+			copy = longAt((objOop + BaseHeaderSize) + (0U << (shiftForWord())));
+			longAtput(objOop, longAt(copy));
+			longAtput((objOop + BaseHeaderSize) + (0U << (shiftForWord())), longAt((copy + BaseHeaderSize) + (0U << (shiftForWord()))));
+			/* begin setIsMarkedOf:to: */
+			longAtput(copy, (longAt(copy)) & (~(usqIntptr_t)(1ULL << (markedBitFullShift()))));
+		}
+		/* begin objectAfter:limit: */
+		followingWordAddress = addressAfter(objOop);
+		if (followingWordAddress >= limit) {
+			break;
+		}
+		objOop = ((((usqInt) (longAt(followingWordAddress))) >> (numSlotsFullShift())) == (numSlotsMask())
+			? followingWordAddress + BaseHeaderSize
+			: followingWordAddress);
+	}
+}
+
+
+/*	Unmark the objects below firstMobileObject, which do not move. In a
+	fully compacted heap this is every object, so when there are helper GC
+	threads the segments are unmarked in parallel, each thread claiming
+	the next segment in turn. */
+
+	/* SpurPlanningCompactor>>#unmarkInitialImmobileObjects */
+static void NeverInline
+unmarkInitialImmobileObjects(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt followingWord;
+    usqInt followingWordAddress;
+    sqInt objOop;
+
+	if ((ioNumGCThreads() > 1)
+	 && (GIV(numSegments) > 1)) {
+		GIV(unmarkSegmentIndex) = 0;
+		ioGCThreadsDo(unmarkInitialImmobileObjectsWorkerarg, 0);
+		return;
+	}
+	assert(isOldObject(GIV(nilObj)));
+	objOop = GIV(nilObj);
+	while (1) {
+		assert((objOop % (allocationUnit())) == 0);
+		if (!(oopisLessThan(objOop, GIV(endOfMemory)))) break;
+		assert((long64At(objOop)) != 0);
+		if (isEnumerableObject(objOop)) {
+			if (oopisGreaterThanOrEqualTo(objOop, GIV(firstMobileObject))) {
+				return;
+			}
+			/* begin setIsMarkedOf:to: */
+			assert(!(isFreeObject(objOop)));
+			longAtput(objOop, (longAt(objOop)) & (~(usqIntptr_t)(1ULL << (markedBitFullShift()))));
+		}
+		/* begin objectAfter:limit: */
+		followingWordAddress = addressAfter(objOop);
+		if (oopisGreaterThanOrEqualTo(followingWordAddress, GIV(endOfMemory))) {
+			return;
+		}
+		flag("endianness");
+		followingWord = longAt(followingWordAddress);
+		objOop = ((((usqInt) followingWord) >> (numSlotsFullShift())) == (numSlotsMask())
+			? followingWordAddress + BaseHeaderSize
+			: followingWordAddress);
+	}
+}
+
+
+/*	Unmark the immobile objects of each segment claimed by this thread.
+	Objects never straddle segments, so the threads touch disjoint objects. */
+
+	/* SpurPlanningCompactor>>#unmarkInitialImmobileObjectsWorker:arg: */
+static void
+unmarkInitialImmobileObjectsWorkerarg(sqInt workerIndex, void *unused)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt followingWord;
+    usqInt followingWordAddress;
+    usqInt limit;
+    usqInt numSlots;
+    sqInt objOop;
+    SpurSegmentInfo *seg;
+    sqInt segIndex;
+
+	while (1) {
+		ioLockGCThreads();
+		segIndex = GIV(unmarkSegmentIndex);
+		GIV(unmarkSegmentIndex) += 1;
+		ioUnlockGCThreads();
+		if (segIndex >= GIV(numSegments)) {
+			return;
+		}
+		seg = (&(GIV(segments)[segIndex]));
+		if (((seg->segStart)) >= GIV(firstMobileObject)) {
+			return;
+		}
+		limit = ((seg->segStart)) + ((seg->segSize));
+		if (limit > GIV(firstMobileObject)) {
+			limit = GIV(firstMobileObject);
+		}
+		if (limit > GIV(endOfMemory)) {
+			limit = GIV(endOfMemory);
+		}
+		if (segIndex == 0) {
+			objOop = GIV(nilObj);
+		}
+		else {
+			/* begin objectStartingAt: */
+			numSlots = byteAt(((seg->segStart)) + 7);
+			objOop = (numSlots == (numSlotsMask())
+				? ((seg->segStart)) + BaseHeaderSize
+				: (seg->segStart));
+		}
+		while (oopisLessThan(objOop, limit)) {
+			if (isEnumerableObject(objOop)) {
+				/* begin setIsMarkedOf:to: */
+				longAtput(objOop, (longAt(objOop)) & (~(usqIntptr_t)(1ULL << (markedBitFullShift()))));
+			}
+			/* begin objectAfter:limit: */
+			followingWordAddress = addressAfter(objOop);
+			if (followingWordAddress >= limit) {
+				break;
+			}
+			followingWord = longAt(followingWordAddress);
+			objOop = ((((usqInt) followingWord) >> (numSlotsFullShift())) == (numSlotsMask())
+				? followingWordAddress + BaseHeaderSize
+				: followingWordAddress);
+		}
+	}
+}
+
+
+/*	Unpin the large objects pinLargeObjects pinned for the compaction. */
+
+	/* SpurPlanningCompactor>>#unpinLargeObjects */
+static void
+unpinLargeObjects(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt i;
+    usqInt numSlots;
+    sqInt objOop;
+    SpurSegmentInfo *seg;
+
+	if (GIV(numLargeObjectSegments) == 0) {
+		return;
+	}
+	for (i = 1; i < GIV(numSegments); i += 1) {
+		seg = (&(GIV(segments)[i]));
+		if ((seg->pinnedForCompaction)) {
+			/* begin objectStartingAt: */
+			numSlots = byteAt(((seg->segStart)) + 7);
+			objOop = (numSlots == (numSlotsMask())
+				? ((seg->segStart)) + BaseHeaderSize
+				: (seg->segStart));
+			/* begin setIsPinnedOf:to: */
+			longAtput(objOop, (longAt(objOop)) & (~(usqIntptr_t)(1U << (pinnedBitShift()))));
+			(seg->pinnedForCompaction = 0);
+		}
+	}
+}
+
+
 /*	Sweep the heap, updating all objects to their eventual locations.
 	Remember to update the savedFirstFields of pointer objects, as these have
 	been forwarded. */
@@ -61158,6 +66508,48 @@ segLimit(SpurSegmentInfo * self_in_segLimit)
 	return ((self_in_segLimit->segSize)) + ((self_in_segLimit->segStart));
 }
 
+
+/*	Add a segment of pinnedSegmentSize bytes, or enough for chunkBytes if
+	that is larger, for pinned objects alone, and put its free space on the
+	pinned free lists. Answer the segment, or nil if one cannot be had
+	within maxOldSpaceSize. */
+
+	/* SpurSegmentManager>>#addPinnedSegmentFor: */
+static SpurSegmentInfo * NoDbgRegParms
+addPinnedSegmentFor(usqInt chunkBytes)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt ammount;
+    usqInt freeBytes;
+    SpurSegmentInfo *segInfo;
+
+	ammount = (chunkBytes + (2 * BaseHeaderSize)) + (2 * BaseHeaderSize);
+	if (ammount < pinnedSegmentSize) {
+		ammount = pinnedSegmentSize;
+	}
+	if ((maxOldSpaceSize > 0)
+	 && ((GIV(totalHeapSizeIncludingBridges) + ammount) > maxOldSpaceSize)) {
+		return null;
+	}
+	segInfo = addSegmentOfSize(ammount);
+	if (segInfo == null) {
+		return null;
+	}
+	/* begin assimilateNewSegment: */
+	if ((((segInfo->segSize)) + ((segInfo->segStart))) >= GIV(endOfMemory)) {
+		GIV(freeOldSpaceStart) = (GIV(endOfMemory) = (((segInfo->segSize)) + ((segInfo->segStart))) - (2 * BaseHeaderSize));
+	}
+	sqMakeMemoryNotExecutableFromTo((segInfo->segStart), ((segInfo->segSize)) + ((segInfo->segStart)));
+	(segInfo->isPinnedSegment = 1);
+	(segInfo->containsPinned = 1);
+	GIV(numPinnedSegments) += 1;
+	freeBytes = ((segInfo->segSize)) - (2 * BaseHeaderSize);
+	/* begin addFreeChunkWithBytes:at: */
+	GIV(totalFreeOldSpace) += freeBytes;
+	freeChunkWithBytesat(freeBytes, (segInfo->segStart));
+	checkSegments();
+	return segInfo;
+}
+
 	/* SpurSegmentManager>>#addSegmentOfSize: */
 static SpurSegmentInfo * NoDbgRegParms
 addSegmentOfSize(sqInt ammount)
@@ -61172,6 +66564,7 @@ addSegmentOfSize(sqInt ammount)
     sqInt segAddress1;
     sqInt segIndex;
 
+	finishIncrementalSweep();
 	allocatedSize = 0;
 	newSegIndex = 0;
 	segAddress = sqAllocateMemorySegmentOfSizeAboveAllocatedSizeInto(ammount, firstGapOfSizeAtLeast(ammount), (&allocatedSize));
@@ -61201,6 +66594,11 @@ addSegmentOfSize(sqInt ammount)
 		(newSeg->segStart = ((usqIntptr_t)segAddress));
 		(newSeg->segSize = allocatedSize);
 		(newSeg->swizzle = 0);
+		(newSeg->isLargeObjectSegment = 0);
+		(newSeg->isPinnedSegment = 0);
+		(newSeg->liveBytes = 0);
+		(newSeg->isEvacuated = 0);
+		(newSeg->pinnedForCompaction = 0);
 		assert(!(segmentOverlap()));
 		bridgeFromto((&(GIV(segments)[newSegIndex - 1])), newSeg);
 		bridgeFromto(newSeg, (!(newSegIndex == (GIV(numSegments) - 1))
@@ -61274,6 +66672,46 @@ allBridgesMarked(void)
 }
 
 
+/*	Answer a chunk of chunkBytes at the start of a new segment of its own,
+	or nil if no segment can be had within maxOldSpaceSize. The segment
+	is immobile: the compactor neither moves its object nor moves anything
+	into it (see pinLargeObjects). Whatever the platform's rounding leaves
+	over is filled with a second, permanently marked bridge rather than a
+	free chunk, so nothing else is ever allocated in the segment, and it
+	is freed as soon as a full GC finds its object dead. */
+
+	/* SpurSegmentManager>>#allocateLargeObjectChunkOfBytes: */
+static sqInt NoDbgRegParms
+allocateLargeObjectChunkOfBytes(usqInt chunkBytes)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt ammount;
+    usqInt remainder;
+    SpurSegmentInfo *segInfo;
+
+	ammount = (chunkBytes + (2 * BaseHeaderSize)) + (2 * BaseHeaderSize);
+	if ((maxOldSpaceSize > 0)
+	 && ((GIV(totalHeapSizeIncludingBridges) + ammount) > maxOldSpaceSize)) {
+		return null;
+	}
+	segInfo = addSegmentOfSize(ammount);
+	if (segInfo == null) {
+		return null;
+	}
+	/* begin assimilateNewSegment: */
+	if ((((segInfo->segSize)) + ((segInfo->segStart))) >= GIV(endOfMemory)) {
+		GIV(freeOldSpaceStart) = (GIV(endOfMemory) = (((segInfo->segSize)) + ((segInfo->segStart))) - (2 * BaseHeaderSize));
+	}
+	sqMakeMemoryNotExecutableFromTo((segInfo->segStart), ((segInfo->segSize)) + ((segInfo->segStart)));
+	(segInfo->isLargeObjectSegment = 1);
+	remainder = (((segInfo->segSize)) - (2 * BaseHeaderSize)) - chunkBytes;
+	assert(remainder >= (2 * BaseHeaderSize));
+	initSegmentBridgeWithBytesat(remainder, ((segInfo->segStart)) + chunkBytes);
+	GIV(numLargeObjectSegments) += 1;
+	checkSegments();
+	return (segInfo->segStart);
+}
+
+
 /*	Increase the number of allocated segInfos by 16. */
 
 	/* SpurSegmentManager>>#allocateOrExtendSegmentInfos */
@@ -61417,6 +66855,229 @@ firstGapOfSizeAtLeast(sqInt size)
 	return ((void *)((((GIV(segments)[GIV(numSegments) - 1]).segSize)) + (((GIV(segments)[GIV(numSegments) - 1]).segStart))));
 }
 
+
+/*	Make the pinned segments ordinary ones and move their free space to the
+	general free lists. Sent by a full GC for a snapshot, since the pinned
+	free lists are not saved, and pinned segments, like large-object
+	segments, are not distinguished after a reload. */
+
+	/* SpurSegmentManager>>#forgetPinnedSegments */
+static void
+forgetPinnedSegments(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    usqInt chunkBytes;
+    sqInt freeChunk;
+    sqInt i;
+    sqInt next;
+
+	for (i = 0; i < GIV(numSegments); i += 1) {
+		((GIV(segments)[i]).isPinnedSegment = 0);
+	}
+	GIV(numPinnedSegments) = 0;
+	for (i = 0; i < NumPinnedFreeLists; i += 1) {
+		freeChunk = GIV(pinnedFreeLists)[i];
+		GIV(pinnedFreeLists)[i] = 0;
+		while (freeChunk != 0) {
+			next = longAt((freeChunk + BaseHeaderSize) + (0U << (shiftForWord())));
+			chunkBytes = bytesInObject(freeChunk);
+			/* begin addFreeChunkWithBytes:at: */
+			GIV(totalFreeOldSpace) += chunkBytes;
+			addToFreeListbytes(freeChunk, chunkBytes);
+			freeChunk = next;
+		}
+	}
+	GIV(totalFreePinnedSpace) = 0;
+}
+
+/*	Free the segments allocated for large objects once nothing in them is
+	alive, giving their memory back to the OS straight away rather than
+	leaving it to attemptToShrink. Sent after marking and before the heap
+	is swept or compacted, so neither sees the dead segments. The bridge
+	filling the space after the object is always marked, so it does not
+	count, and nothing in the segment is on the free lists. */
+
+	/* SpurSegmentManager>>#freeDeadLargeObjectSegments */
+static void NeverInline
+freeDeadLargeObjectSegments(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    usqInt currentEnd;
+    sqInt dead;
+    sqInt followingWord;
+    usqInt followingWordAddress;
+    sqInt i;
+    sqInt j;
+    usqInt limit;
+    usqInt numSlots;
+    sqInt objOop;
+    SpurSegmentInfo *seg;
+    SpurSegmentInfo *segInfo;
+
+	for (i = GIV(numSegments) - 1; i >= 1; i += -1) {
+		seg = (&(GIV(segments)[i]));
+		if ((seg->isLargeObjectSegment)) {
+			limit = (((seg->segSize)) + ((seg->segStart))) - (2 * BaseHeaderSize);
+			dead = 1;
+			/* begin objectStartingAt: */
+			numSlots = byteAt(((seg->segStart)) + 7);
+			objOop = (numSlots == (numSlotsMask())
+				? ((seg->segStart)) + BaseHeaderSize
+				: (seg->segStart));
+			while (oopisLessThan(objOop, limit)) {
+				if ((((((usqInt) (longAt(objOop))) >> (markedBitFullShift())) & 1) != 0)
+				 && (!(((longAt(objOop)) & (classIndexMask())) == (segmentBridgePun())))) {
+					dead = 0;
+					objOop = limit;
+					goto l1;
+				}
+				/* begin objectAfter:limit: */
+				followingWordAddress = addressAfter(objOop);
+				if (oopisGreaterThanOrEqualTo(followingWordAddress, limit)) {
+					objOop = limit;
+					goto l1;
+				}
+				flag("endianness");
+				followingWord = longAt(followingWordAddress);
+				objOop = ((((usqInt) followingWord) >> (numSlotsFullShift())) == (numSlotsMask())
+					? followingWordAddress + BaseHeaderSize
+					: followingWordAddress);
+			l1:	/* end objectAfter:limit: */;
+			}
+			if (dead) {
+				/* begin removeSegment: */
+				GIV(totalHeapSizeIncludingBridges) -= (seg->segSize);
+				sqDeallocateMemorySegmentAtOfSize(((void *)((seg->segStart))), (seg->segSize));
+				for (j = i; j < GIV(numSegments); j += 1) {
+					GIV(segments)[j] = (GIV(segments)[j + 1]);
+				}
+				GIV(numSegments) -= 1;
+				bridgeFromto((&(GIV(segments)[i - 1])), (i <= (GIV(numSegments) - 1)
+					? (&(GIV(segments)[i]))
+					: 0));
+				/* begin setLastSegment: */
+				segInfo = ((SpurSegmentInfo *) ((&(GIV(segments)[GIV(numSegments) - 1]))));
+				currentEnd = (((segInfo->segSize)) + ((segInfo->segStart))) - (2 * BaseHeaderSize);
+				if (currentEnd <= GIV(endOfMemory)) {
+					GIV(endOfMemory) = currentEnd;
+					if (GIV(freeOldSpaceStart) > currentEnd) {
+						GIV(freeOldSpaceStart) = currentEnd;
+					}
+				}
+				GIV(numLargeObjectSegments) -= 1;
+				GIV(statShrinkMemory) += 1;
+			}
+		}
+	}
+}
+
+/*	Free pinned segments that hold nothing, keeping one back so that a
+	program that pins and drops buffers does not map and unmap a segment at
+	every full GC. */
+
+	/* SpurSegmentManager>>#freeEmptyPinnedSegments */
+static void
+freeEmptyPinnedSegments(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt address;
+    usqInt chunkBytes;
+    usqInt currentEnd;
+    sqInt freeChunk;
+    sqInt i;
+    sqInt j;
+    usqInt numSlots;
+    SpurSegmentInfo *seg;
+    SpurSegmentInfo *segInfo;
+
+	for (i = GIV(numSegments) - 1; i >= 1; i += -1) {
+		seg = (&(GIV(segments)[i]));
+		if (((seg->isPinnedSegment))
+		 && ((GIV(numPinnedSegments) > 1)
+		 && (isEmptySegment(seg)))) {
+			/* begin objectStartingAt: */
+			address = (seg->segStart);
+			numSlots = byteAt(address + 7);
+			freeChunk = (numSlots == (numSlotsMask())
+				? address + BaseHeaderSize
+				: address);
+			chunkBytes = bytesInObject(freeChunk);
+			unlinkPinnedFreeChunkchunkBytes(freeChunk, chunkBytes);
+			GIV(totalFreeOldSpace) -= chunkBytes;
+			/* begin removeSegment: */
+			GIV(totalHeapSizeIncludingBridges) -= (seg->segSize);
+			sqDeallocateMemorySegmentAtOfSize(((void *)((seg->segStart))), (seg->segSize));
+			for (j = i; j < GIV(numSegments); j += 1) {
+				GIV(segments)[j] = (GIV(segments)[j + 1]);
+			}
+			GIV(numSegments) -= 1;
+			bridgeFromto((&(GIV(segments)[i - 1])), (i <= (GIV(numSegments) - 1)
+				? (&(GIV(segments)[i]))
+				: 0));
+			/* begin setLastSegment: */
+			segInfo = ((SpurSegmentInfo *) ((&(GIV(segments)[GIV(numSegments) - 1]))));
+			currentEnd = (((segInfo->segSize)) + ((segInfo->segStart))) - (2 * BaseHeaderSize);
+			if (currentEnd <= GIV(endOfMemory)) {
+				GIV(endOfMemory) = currentEnd;
+				if (GIV(freeOldSpaceStart) > currentEnd) {
+					GIV(freeOldSpaceStart) = currentEnd;
+				}
+			}
+			GIV(numPinnedSegments) -= 1;
+			GIV(statShrinkMemory) += 1;
+		}
+	}
+}
+
+
+/*	Free the segments evacuateSparseSegments emptied, now that nothing
+	refers to the forwarders left in them. Keep growHeadroom free, so a
+	program that goes on allocating does not grow the heap again at once; a
+	segment kept for that becomes a single free chunk. */
+
+	/* SpurSegmentManager>>#freeEvacuatedSegments */
+static void
+freeEvacuatedSegments(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    usqInt currentEnd;
+    sqInt i;
+    sqInt j;
+    SpurSegmentInfo *seg;
+    SpurSegmentInfo *segInfo;
+
+	for (i = GIV(numSegments) - 1; i >= 1; i += -1) {
+		seg = (&(GIV(segments)[i]));
+		if ((seg->isEvacuated)) {
+			(seg->isEvacuated = 0);
+			if (GIV(totalFreeOldSpace) < GIV(growHeadroom)) {
+				/* begin addFreeChunkWithBytes:at: */
+				GIV(totalFreeOldSpace) += (((seg->segSize)) - (2 * BaseHeaderSize));
+				freeChunkWithBytesat(((seg->segSize)) - (2 * BaseHeaderSize), (seg->segStart));
+			}
+			else {
+				/* begin removeSegment: */
+				GIV(totalHeapSizeIncludingBridges) -= (seg->segSize);
+				sqDeallocateMemorySegmentAtOfSize(((void *)((seg->segStart))), (seg->segSize));
+				for (j = i; j < GIV(numSegments); j += 1) {
+					GIV(segments)[j] = (GIV(segments)[j + 1]);
+				}
+				GIV(numSegments) -= 1;
+				bridgeFromto((&(GIV(segments)[i - 1])), (i <= (GIV(numSegments) - 1)
+					? (&(GIV(segments)[i]))
+					: 0));
+				/* begin setLastSegment: */
+				segInfo = ((SpurSegmentInfo *) ((&(GIV(segments)[GIV(numSegments) - 1]))));
+				currentEnd = (((segInfo->segSize)) + ((segInfo->segStart))) - (2 * BaseHeaderSize);
+				if (currentEnd <= GIV(endOfMemory)) {
+					GIV(endOfMemory) = currentEnd;
+					if (GIV(freeOldSpaceStart) > currentEnd) {
+						GIV(freeOldSpaceStart) = currentEnd;
+					}
+				}
+				GIV(statShrinkMemory) += 1;
+			}
+		}
+	}
+	GIV(numEvacuatedSegments) = 0;
+}
+
 	/* SpurSegmentManager>>#isEmptySegment: */
 static sqInt NoDbgRegParms
 isEmptySegment(SpurSegmentInfo *seg)
@@ -61435,6 +67096,23 @@ isEmptySegment(SpurSegmentInfo *seg)
 	 && ((addressAfter(firstObj)) == ((((seg->segSize)) + ((seg->segStart))) - (2 * BaseHeaderSize)));
 }
 
+
+/*	Answer whether address lies in a segment set aside for pinned objects. */
+
+	/* SpurSegmentManager>>#isInPinnedSegment: */
+static sqInt NoDbgRegParms
+isInPinnedSegment(usqInt address)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt i;
+
+	for (i = (GIV(numSegments) - 1); i >= 0; i += -1) {
+		if (address >= (((GIV(segments)[i]).segStart))) {
+			return ((GIV(segments)[i]).isPinnedSegment);
+		}
+	}
+	return 0;
+}
+
 	/* SpurSegmentManager>>#isInSegments: */
 static sqInt NoDbgRegParms
 isInSegments(usqInt address)
@@ -61719,7 +67397,9 @@ readHeapFromImageFiledataBytes(sqImageFile f, sqInt numBytes)
 		(segInfo->segStart = oldBase);
 		(segInfo->segSize = nextSegmentSize);
 		(segInfo->swizzle = newBase - oldBase);
-		bytesRead = sqImageFileRead(pointerForOop(newBase), sizeof(char), nextSegmentSize, f);
+		bytesRead = (GIV(compressImageHeapData)
+			? sqImageFileReadCompressed(pointerForOop(newBase), nextSegmentSize, f)
+			: sqImageFileReadSegment(pointerForOop(newBase), sizeof(char), nextSegmentSize, f));
 		if (bytesRead > 0) {
 			totalBytesRead += bytesRead;
 		}
@@ -61818,6 +67498,7 @@ shrinkObjectMemory(usqInt delta)
     SpurSegmentInfo *segInfo;
     usqInt shrinkage;
 
+	finishIncrementalSweep();
 	i = 0;
 	/* begin checkFreeSpace: */
 	assert(bitsSetInFreeSpaceMaskForAllFreeLists());
@@ -61832,7 +67513,8 @@ shrinkObjectMemory(usqInt delta)
 		delta1 = shrinkage;
 		for (i2 = 0; i2 < GIV(numSegments); i2 += 1) {
 			seg = (&(GIV(segments)[i2]));
-			if (isEmptySegment(seg)) {
+			if ((!((seg->isPinnedSegment)))
+			 && (isEmptySegment(seg))) {
 				if (best == null) {
 					best = seg;
 				}
@@ -61942,6 +67624,41 @@ totalBytesInSegments(void)
 	return total;
 }
 
+/*	Answer how many bytes of old space are backed by huge pages. */
+
+	/* SpurSegmentManager>>#totalHugePageBytesInSegments */
+static usqInt
+totalHugePageBytesInSegments(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt i;
+    usqInt total;
+
+	total = 0;
+	for (i = 0; i < GIV(numSegments); i += 1) {
+		total += sqHugePageBytesFromTo(((GIV(segments)[i]).segStart), (((GIV(segments)[i]).segSize)) + (((GIV(segments)[i]).segStart)));
+	}
+	return total;
+}
+
+/*	Answer how many bytes of old space are backed by physical memory, as
+	opposed to merely reserved; the difference is the free space that
+	decommitFreeSpace has given back to the OS and that has not been
+	reused since. */
+
+	/* SpurSegmentManager>>#totalResidentBytesInSegments */
+static usqInt
+totalResidentBytesInSegments(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt i;
+    usqInt total;
+
+	total = 0;
+	for (i = 0; i < GIV(numSegments); i += 1) {
+		total += sqResidentBytesFromTo(((GIV(segments)[i]).segStart), (((GIV(segments)[i]).segSize)) + (((GIV(segments)[i]).segStart)));
+	}
+	return total;
+}
+
 	/* SpurSegmentManager>>#writeImageSegmentsToFile: */
 static sqInt NoDbgRegParms
 writeImageSegmentsToFile(sqImageFile aBinaryStream)
@@ -61972,7 +67689,7 @@ writeImageSegmentsToFile(sqImageFile aBinaryStream)
 	/* SpurSegmentManager>>#writeSegment:nextSegment:toFile: */
 static sqInt NoDbgRegParms
 writeSegmentnextSegmenttoFile(SpurSegmentInfo *segment, SpurSegmentInfo *nextSegment, sqImageFile aBinaryStream)
-{
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
     usqLong firstSavedBridgeWord;
     sqInt nWritten;
     sqInt pier1;
@@ -61989,7 +67706,9 @@ writeSegmentnextSegmenttoFile(SpurSegmentInfo *segment, SpurSegmentInfo *nextSeg
 	long64Atput(pier2, (nextSegment == null
 		? 0
 		: (nextSegment->segSize)));
-	nWritten = sqImageFileWrite(((void *)((segment->segStart))), 1, (segment->segSize), aBinaryStream);
+	nWritten = (GIV(compressImageHeapData)
+		? sqImageFileWriteCompressed(((void *)((segment->segStart))), (segment->segSize), aBinaryStream)
+		: sqImageFileWrite(((void *)((segment->segStart))), 1, (segment->segSize), aBinaryStream));
 	long64Atput(pier1, firstSavedBridgeWord);
 	long64Atput(pier2, secondSavedBridgeWord);
 	return nWritten;
@@ -62119,6 +67838,37 @@ addressCouldBeClassObj(sqInt maybeClassObj)
 	 && (objCouldBeClassObj(maybeClassObj));
 }
 
+
+/*	Allocate the method cache with methodCacheEntries entries (by default
+	MethodCacheEntries), rounded up to a power of two, in sets of
+	MethodCacheWays entries. The cache is indexed from 1, so the allocation is
+	offset by a word to start each set on a cache line. The cache must not
+	move once allocated since machine code embeds its address and mask. */
+
+	/* StackInterpreter>>#allocateMethodCache */
+static void
+allocateMethodCache(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    usqInt numEntries;
+    char *space;
+
+	numEntries = MethodCacheWays;
+	while ((numEntries < MethodCacheMaxEntries)
+	 && (numEntries < (methodCacheEntries == 0
+		? MethodCacheEntries
+		: methodCacheEntries))) {
+		numEntries = numEntries * 2;
+	}
+	methodCacheEntries = numEntries;
+	GIV(methodCacheSize) = numEntries * MethodCacheEntrySize;
+	GIV(methodCacheSetMask) = GIV(methodCacheSize) - (MethodCacheWays * MethodCacheEntrySize);
+	space = calloc(((GIV(methodCacheSize) + 1) * BytesPerWord) + 64, 1);
+	if (space == null) {
+		error("could not allocate the method cache");
+	}
+	GIV(methodCache) = ((sqIntptr_t *) (((((usqIntptr_t) space) + BytesPerWord) + 63) & ~((usqIntptr_t) 63))) - 1;
+}
+
 	/* StackInterpreter>>#allOnesAsCharStar */
 static char *
 allOnesAsCharStar(void)
@@ -62525,6 +68275,23 @@ checkForEventsMayContextSwitch(sqInt mayContextSwitch)
 			setSignalLowSpaceFlagAndSaveProcess();
 		}
 	}
+	else {
+		if (((GIV(sweepCursor) != 0)
+		 || (GIV(concurrentMarkSteps)
+		 && (!GIV(concurrentMarkFinished))))
+		 && ((ioUTCMicrosecondsNow() - GIV(incrGCStepEndUsecs)) >= maxGCPauseUsecs)) {
+
+			/* Interrupt checks can come much more often than every pause target. Leave
+			   the mutator at least as long as a step between steps, so that the steps
+			   take no more than half its time. */
+			if (GIV(sweepCursor) != 0) {
+				incrementalSweepStepForbytes(maxGCPauseUsecs, 0);
+			}
+			else {
+				incrementalMarkStepFor(maxGCPauseUsecs);
+			}
+		}
+	}
 	if (!mayContextSwitch) {
 		return 0;
 	}
@@ -62565,6 +68332,10 @@ checkForEventsMayContextSwitch(sqInt mayContextSwitch)
 	}
 	if (((now = ioUTCMicroseconds())) >= GIV(nextPollUsecs)) {
 		GIV(statIOProcessEvents) += 1;
+		if ((!(GIV(gcLog) == null))
+		 && ((now - GIV(codeLogUsecs)) >= (60 * 1000000))) {
+			writeCodeZoneLogRecord(now);
+		}
 		ioProcessEvents();
 
 		/* msecs to wait before next call to ioProcessEvents.  Note that strictly
@@ -62815,7 +68586,7 @@ checkOkayInterpreterObjects(sqInt writeBack)
 	ok = ok && (checkOkayFields(GIV(messageSelector)));
 	ok = ok && (checkOkayFields(GIV(newMethod)));
 	ok = ok && (checkOkayFields(GIV(lkupClass)));
-	for (i = 0; i < MethodCacheEntries; i += MethodCacheEntrySize) {
+	for (i = 0; i < GIV(methodCacheSize); i += MethodCacheEntrySize) {
 		oopOrZero = GIV(methodCache)[i + MethodCacheSelector];
 		if (!(oopOrZero == 0)) {
 			ok = ok && (checkOkayFields(GIV(methodCache)[i + MethodCacheSelector]));
@@ -63278,6 +69049,9 @@ createActualMessageTo(sqInt lookupClass)
 	}
 	long64Atput(newObj, (((((usqLong) GIV(argumentCount))) << (numSlotsFullShift())) + (2U << (formatShift()))) + ClassArrayCompactIndex);
 	GIV(freeStart) += numBytes;
+	if (GIV(allocationSampleInterval) > 0) {
+		sampleAllocationbytes(newObj, numBytes);
+	}
 	argumentArray = newObj;
 	l4:	/* end eeInstantiateSmallClassIndex:format:numSlots: */;
 	/* begin eeInstantiateSmallClassIndex:format:numSlots: */
@@ -63307,6 +69081,9 @@ createActualMessageTo(sqInt lookupClass)
 	}
 	long64Atput(newObj1, (((((usqLong) numSlots)) << (numSlotsFullShift())) + (1U << (formatShift()))) + ClassMessageCompactIndex);
 	GIV(freeStart) += numBytes1;
+	if (GIV(allocationSampleInterval) > 0) {
+		sampleAllocationbytes(newObj1, numBytes1);
+	}
 	message = newObj1;
 	l5:	/* end eeInstantiateSmallClassIndex:format:numSlots: */;
 	for (i = ((GIV(argumentCount) - 1) * BytesPerOop); i >= 0; i += (-BytesPerOop)) {
@@ -65137,12 +70914,13 @@ flushMethodCacheForMethod(sqInt oldMethod)
     sqInt probe;
 
 	probe = 0;
-	for (i = 1; i <= MethodCacheEntries; i += 1) {
+	for (i = 1; i <= methodCacheEntries; i += 1) {
 		if ((GIV(methodCache)[probe + MethodCacheMethod]) == oldMethod) {
 			GIV(methodCache)[probe + MethodCacheSelector] = 0;
 		}
 		probe += MethodCacheEntrySize;
 	}
+	flushMegamorphicCaches();
 	flushExternalPrimitiveOf(oldMethod);
 }
 
@@ -65202,6 +70980,30 @@ followForwardedFrameContentsstackPointer(char *theFP, char *theSP)
 }
 
 
+/*	Follow forwarders to the methods of the allocation samples not yet
+	answered, as followForwardingPointersInProfileState does for
+	profileMethod. */
+
+	/* StackInterpreter>>#followForwardingPointersInAllocationSamples */
+static void
+followForwardingPointersInAllocationSamples(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt i;
+    sqInt index;
+    sqInt method;
+
+	index = ((GIV(allocationSampleIndex) - GIV(numAllocationSamples)) + AllocationSampleBufferSize) % AllocationSampleBufferSize;
+	for (i = 0; i < GIV(numAllocationSamples); i += 1) {
+		method = GIV(allocationSamples)[(4 * index) + 2];
+		if ((method != 0)
+		 && (((longAt(method)) & ((classIndexMask()) - (isForwardedObjectClassIndexPun()))) == 0)) {
+			GIV(allocationSamples)[(4 * index) + 2] = followForwarded(method);
+		}
+		index = (index + 1) % AllocationSampleBufferSize;
+	}
+}
+
+
 /*	Force an interrupt check ASAP.
 	Must set the stack page's limit before stackLimit to avoid
 	a race condition if this is called from an interrupt handler. */
@@ -65426,6 +71228,9 @@ getErrorObjectFromPrimFailCode(void)
 				}
 				long64Atput(newObj, (((((usqLong) numSlots)) << (numSlotsFullShift())) + (1U << (formatShift()))) + knownClassIndex);
 				GIV(freeStart) += numBytes;
+				if (GIV(allocationSampleInterval) > 0) {
+					sampleAllocationbytes(newObj, numBytes);
+				}
 				clone = newObj;
 	l5:	/* end eeInstantiateSmallClassIndex:format:numSlots: */;
 				for (i = 0; i < numSlots; i += 1) {
@@ -66803,9 +72608,10 @@ longStoreBytecodeForHeader(sqInt methodHeader)
 }
 
 
-/*	This method implements a simple method lookup cache. If an entry for the
-	given selector and classTag is found in the cache, set the values of
-	'newMethod' and
+/*	This method implements a set-associative method lookup cache. The hash
+	of the selector and classTag selects a set of MethodCacheWays entries,
+	kept in most recently used order. If an entry for the given selector and
+	classTag is found in the set, set the values of 'newMethod' and
 	'primitiveFunctionPointer' and answer true. Otherwise, answer false. */
 
 	/* StackInterpreter>>#lookupInMethodCacheSel:classTag: */
@@ -66816,32 +72622,62 @@ lookupInMethodCacheSelclassTag(sqInt selector, sqInt classTag)
     sqInt probe;
 
 	/* begin inlineLookupInMethodCacheSel:classTag: */
-	hash = selector ^ (((sqInt)((usqInt)(classTag) << 2)));
-
-	/* first probe */
-	probe = hash & MethodCacheMask;
+	hash = selector ^ (((sqInt)((usqInt)(classTag) << MethodCacheClassTagShift)));
+	probe = hash & GIV(methodCacheSetMask);
 	if (((GIV(methodCache)[probe + MethodCacheSelector]) == selector)
 	 && ((GIV(methodCache)[probe + MethodCacheClass]) == classTag)) {
 		GIV(newMethod) = GIV(methodCache)[probe + MethodCacheMethod];
 		primitiveFunctionPointer = ((void (*)()) (GIV(methodCache)[probe + MethodCachePrimFunction]));
+		GIV(statMethodCacheHits) += 1;
 		return 1;
 	}
+	return lookupInMethodCacheSetselclassTag(probe, selector, classTag);
+}
 
-	/* second probe */
-	probe = (((usqInt) hash) >> 1) & MethodCacheMask;
-	if (((GIV(methodCache)[probe + MethodCacheSelector]) == selector)
-	 && ((GIV(methodCache)[probe + MethodCacheClass]) == classTag)) {
-		GIV(newMethod) = GIV(methodCache)[probe + MethodCacheMethod];
-		primitiveFunctionPointer = ((void (*)()) (GIV(methodCache)[probe + MethodCachePrimFunction]));
-		return 1;
-	}
-	probe = (((usqInt) hash) >> 2) & MethodCacheMask;
-	if (((GIV(methodCache)[probe + MethodCacheSelector]) == selector)
-	 && ((GIV(methodCache)[probe + MethodCacheClass]) == classTag)) {
-		GIV(newMethod) = GIV(methodCache)[probe + MethodCacheMethod];
-		primitiveFunctionPointer = ((void (*)()) (GIV(methodCache)[probe + MethodCachePrimFunction]));
-		return 1;
+
+/*	Search the remaining entries of the method cache set at setIndex, the
+	first having missed, for selector and classTag. On a hit move the entry
+	to the front of the set, so that the set is kept in least recently used
+	order and the inline probe of the first entry finds it next time, and
+	answer true. Otherwise answer false. */
+
+	/* StackInterpreter>>#lookupInMethodCacheSet:sel:classTag: */
+static sqInt NoDbgRegParms
+lookupInMethodCacheSetselclassTag(sqInt setIndex, sqInt selector, sqInt classTag)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt probe;
+    sqInt way;
+
+	for (way = 1; way < MethodCacheWays; way += 1) {
+		probe = setIndex + (way * MethodCacheEntrySize);
+		if (((GIV(methodCache)[probe + MethodCacheSelector]) == selector)
+		 && ((GIV(methodCache)[probe + MethodCacheClass]) == classTag)) {
+			GIV(newMethod) = GIV(methodCache)[probe + MethodCacheMethod];
+			primitiveFunctionPointer = ((void (*)()) (GIV(methodCache)[probe + MethodCachePrimFunction]));
+			while (probe > setIndex) {
+				GIV(methodCache)[probe + MethodCacheSelector] = GIV(methodCache)[(probe - MethodCacheEntrySize) + MethodCacheSelector];
+				GIV(methodCache)[probe + MethodCacheClass] = GIV(methodCache)[(probe - MethodCacheEntrySize) + MethodCacheClass];
+				GIV(methodCache)[probe + MethodCacheMethod] = GIV(methodCache)[(probe - MethodCacheEntrySize) + MethodCacheMethod];
+				GIV(methodCache)[probe + MethodCachePrimFunction] = GIV(methodCache)[(probe - MethodCacheEntrySize) + MethodCachePrimFunction];
+				probe -= MethodCacheEntrySize;
+			}
+			GIV(methodCache)[setIndex + MethodCacheSelector] = selector;
+			GIV(methodCache)[setIndex + MethodCacheClass] = classTag;
+			GIV(methodCache)[setIndex + MethodCacheMethod] = GIV(newMethod);
+			GIV(methodCache)[setIndex + MethodCachePrimFunction] = (((sqIntptr_t) primitiveFunctionPointer));
+
+			/* keep primitiveExternalMethod's entry in step with the move */
+			if ((GIV(lastMethodCacheProbeWrite) >= setIndex)
+			 && (GIV(lastMethodCacheProbeWrite) <= (setIndex + (way * MethodCacheEntrySize)))) {
+				GIV(lastMethodCacheProbeWrite) = (GIV(lastMethodCacheProbeWrite) == (setIndex + (way * MethodCacheEntrySize))
+					? setIndex
+					: GIV(lastMethodCacheProbeWrite) + MethodCacheEntrySize);
+			}
+			GIV(statMethodCacheHits) += 1;
+			return 1;
+		}
 	}
+	GIV(statMethodCacheMisses) += 1;
 	return 0;
 }
 
@@ -67526,6 +73362,9 @@ makePointwithxValueyValue(sqInt xValue, sqInt yValue)
 	}
 	long64Atput(newObj, (((((usqLong) numSlots)) << (numSlotsFullShift())) + (((sqInt)((usqInt)(objFormat) << (formatShift()))))) + knownClassIndex);
 	GIV(freeStart) += numBytes;
+	if (GIV(allocationSampleInterval) > 0) {
+		sampleAllocationbytes(newObj, numBytes);
+	}
 	pointResult = newObj;
 	l3:	/* end eeInstantiateSmallClass:numSlots: */;
 	/* begin storePointerUnchecked:ofObject:withValue: */
@@ -67538,6 +73377,29 @@ makePointwithxValueyValue(sqInt xValue, sqInt yValue)
 }
 
 
+/*	Map the methods of the allocation samples not yet answered, as
+	mapProfileState does profileMethod. */
+
+	/* StackInterpreter>>#mapAllocationSamples */
+static void
+mapAllocationSamples(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt i;
+    sqInt index;
+    sqInt method;
+
+	index = ((GIV(allocationSampleIndex) - GIV(numAllocationSamples)) + AllocationSampleBufferSize) % AllocationSampleBufferSize;
+	for (i = 0; i < GIV(numAllocationSamples); i += 1) {
+		method = GIV(allocationSamples)[(4 * index) + 2];
+		if ((method != 0)
+		 && (shouldRemapObj(method))) {
+			GIV(allocationSamples)[(4 * index) + 2] = remapObj(method);
+		}
+		index = (index + 1) % AllocationSampleBufferSize;
+	}
+}
+
+
 /*	Map all oops in the interpreter's state to their new values 
 	during garbage collection or a become: operation. */
 /*	Assume: All traced variables contain valid oops. */
@@ -67551,7 +73413,9 @@ mapInterpreterOops(void)
     usqInt oop;
     sqInt theGCMode;
 
-	mapStackPages();
+	if (!GIV(stackPagesScavenged)) {
+		mapStackPages();
+	}
 	/* begin mapMachineCode: */
 	theGCMode = GIV(gcMode);
 	mapObjectReferencesInMachineCode(theGCMode);
@@ -67586,6 +73450,7 @@ mapInterpreterOops(void)
 	if (shouldRemapObj(GIV(profileSemaphore))) {
 		GIV(profileSemaphore) = remapObj(GIV(profileSemaphore));
 	}
+	mapAllocationSamples();
 	sqLowLevelMFence();
 	if (!(GIV(longRunningPrimitiveCheckMethod) == null)) {
 		if (GIV(longRunningPrimitiveCheckSequenceNumber) == GIV(statCheckForEvents)) {
@@ -67628,6 +73493,29 @@ mapInterpreterOops(void)
 }
 
 
+/*	Mark the methods of the allocation samples not yet answered, so that
+	primitiveAllocationSamples can answer them. */
+
+	/* StackInterpreter>>#markAndTraceAllocationSamples */
+static void
+markAndTraceAllocationSamples(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    sqInt i;
+    sqInt index;
+    sqInt method;
+
+	followForwardingPointersInAllocationSamples();
+	index = ((GIV(allocationSampleIndex) - GIV(numAllocationSamples)) + AllocationSampleBufferSize) % AllocationSampleBufferSize;
+	for (i = 0; i < GIV(numAllocationSamples); i += 1) {
+		method = GIV(allocationSamples)[(4 * index) + 2];
+		if (method != 0) {
+			markAndTrace(method);
+		}
+		index = (index + 1) % AllocationSampleBufferSize;
+	}
+}
+
+
 /*	GC of pages. Throwing away all stack pages on full GC is simple but
 	dangerous because it causes us to allocate lots of contexts immediately
 	before a GC.
@@ -71870,9 +77758,11 @@ retryPrimitiveOnFailure(void)
 			if (canRetry) {
 				if (gcDone == 1) {
 					/* begin scavengingGC */
+					GIV(gcCause) = "primitiveFailure";
 					scavengingGCTenuringIf(TenureByAge);
 				}
 				if (gcDone == 2) {
+					GIV(gcCause) = "primitiveFailure";
 					fullGC();
 				}
 				retry = gcDone <= 2;
@@ -72813,6 +78703,10 @@ snapshot(sqInt embedded)
 	longAtput((sp2 = GIV(stackPointer) - BytesPerWord), GIV(instructionPointer));
 	GIV(stackPointer) = sp2;
 
+	if (!(GIV(machineCodeCacheFile) == null)) {
+		writeMachineCodeCache();
+	}
+
 	/* update state of active process */
 	activeContext = voidVMStateForSnapshotFlushingExternalPrimitivesIf(1);
 	/* begin activeProcess */
@@ -72839,6 +78733,7 @@ snapshot(sqInt embedded)
 	savedTenuringThreshold = GIV(tenureThreshold);
 	/* begin setRawTenuringThreshold: */
 	GIV(tenureThreshold) = GIV(newSpaceLimit);
+	GIV(gcCause) = "snapshot";
 	scavengingGCTenuringIf(TenureByAge);
 	/* begin setRawTenuringThreshold: */
 	GIV(tenureThreshold) = savedTenuringThreshold;
@@ -72848,6 +78743,7 @@ snapshot(sqInt embedded)
 	flag("If we wanted to shrink the rememberedSet prior to snapshot this is the place to do it.");
 	/* begin biasForSnapshot */
 	GIV(biasForGC) = 0;
+	GIV(gcCause) = "snapshot";
 	fullGC();
 	/* begin biasForGC */
 	GIV(biasForGC) = 1;
@@ -72876,7 +78772,12 @@ snapshot(sqInt embedded)
 		valuePointer = GIV(trueObj);
 		assert(!(isOopForwarded(activeContext)));
 		longAtput((activeContext + BaseHeaderSize) + (((sqInt)((usqInt)(((stackIndex + CtxtTempFrameStart) - 1)) << (shiftForWord())))), valuePointer);
-		writeImageFileIO();
+		if (GIV(backgroundSnapshotSemaphoreIndex) > 0) {
+			writeImageFileInBackground();
+		}
+		else {
+			writeImageFileIO();
+		}
 		if ((!GIV(primFailCode))
 		 && (!embedded)) {
 
@@ -73081,7 +78982,7 @@ spurPostBecomeAction(sqInt theBecomeEffectsFlags)
 	if (theBecomeEffectsFlags != 0) {
 		if (theBecomeEffectsFlags & BecameCompiledMethodFlag) {
 			/* begin followForwardedMethodsInMethodCache */
-			for (i = 0; i < MethodCacheSize; i += MethodCacheEntrySize) {
+			for (i = 0; i < GIV(methodCacheSize); i += MethodCacheEntrySize) {
 				c = GIV(methodCache)[i + MethodCacheClass];
 				s = GIV(methodCache)[i + MethodCacheSelector];
 				m = GIV(methodCache)[i + MethodCacheMethod];
@@ -73105,10 +79006,11 @@ spurPostBecomeAction(sqInt theBecomeEffectsFlags)
 			}
 			/* begin followForwardedMethodsInMethodZone */
 			followForwardedMethods();
+			flushMegamorphicCaches();
 		}
 		if (theBecomeEffectsFlags & BecameActiveClassFlag) {
 			/* begin flushBecommedClassesInMethodCache */
-			for (i1 = 0; i1 < MethodCacheSize; i1 += MethodCacheEntrySize) {
+			for (i1 = 0; i1 < GIV(methodCacheSize); i1 += MethodCacheEntrySize) {
 				c1 = GIV(methodCache)[i1 + MethodCacheClass];
 				s1 = GIV(methodCache)[i1 + MethodCacheSelector];
 				if ((c1 != 0)
@@ -73120,6 +79022,7 @@ spurPostBecomeAction(sqInt theBecomeEffectsFlags)
 			}
 			/* begin flushBecommedClassesInMethodZone */
 			unlinkSendsLinkedForInvalidClasses();
+			flushMegamorphicCaches();
 		}
 		if (theBecomeEffectsFlags & BecamePointerObjectFlag) {
 			/* begin followForwardingPointersInScheduler */
@@ -73383,6 +79286,7 @@ spurPostBecomeAction(sqInt theBecomeEffectsFlags)
 				}
 				GIV(profileSemaphore) = referent2;
 			}
+			followForwardingPointersInAllocationSamples();
 		}
 	}
 	followForwardingPointersInStackZone(theBecomeEffectsFlags);
@@ -74490,6 +80394,12 @@ writeImageFileIO(void)
 	}
 	imageBytes = total;
 	headerStart = sqImageFileStartLocation(f, imageName, headerSize + imageBytes);
+
+	if (!GIV(compressImageHeapData)) {
+
+		/* pad the header if the platform would map the heap data from the file */
+		headerSize += sqImageFileHeaderPadding(headerStart + headerSize, GIV(oldSpaceStart));
+	}
 	/* Note: on Unix systems one could put an exec command here, padded to 512 bytes */;
 	sqImageFileSeek(f, headerStart);
 	putWord32toFile(68021 /* imageFormatVersion */, f);
@@ -74499,7 +80409,7 @@ writeImageFileIO(void)
 	putLongtoFile(GIV(specialObjectsOop), f);
 	putLongtoFile(newObjectHash(), f);
 	putLongtoFile(getSnapshotScreenSize(), f);
-	putLongtoFile(((((GIV(fullScreenFlag) + ((VMBIGENDIAN
+	putLongtoFile((((((GIV(fullScreenFlag) + ((VMBIGENDIAN
 	? 0
 	: 2))) + ((GIV(flagInterpretedMethods)
 	? 8
@@ -74507,6 +80417,8 @@ writeImageFileIO(void)
 	? 0
 	: 16))) + ((GIV(newFinalization)
 	? 64
+	: 0))) + ((GIV(compressImageHeapData)
+	? 256
 	: 0))) + (((GIV(imageHeaderFlags) | 91) - 91)), f);
 	putWord32toFile(extraVMMemory, f);
 	putShorttoFile(desiredNumStackPages, f);
@@ -74523,7 +80435,7 @@ writeImageFileIO(void)
 	putLongtoFile(0, f);
 	putLongtoFile(0, f);
 	putLongtoFile(0, f);
-	assert((headerStart + headerSize) == (sqImageFilePosition(f)));
+	assert((headerStart + 128) == (sqImageFilePosition(f)));
 	sqImageFileSeek(f, headerStart + headerSize);
 	if (GIV(primFailCode)) {
 
@@ -74544,6 +80456,38 @@ writeImageFileIO(void)
 	return 0;
 }
 
+
+/*	Write the image file from a forked child process, which sees the heap as
+	it is now through its copy-on-write view of memory, and let the parent,
+	i.e. the running VM, resume at once. The platform signals the semaphore
+	at backgroundSnapshotSemaphoreIndex when the child exits; its exit status
+	is answered by vm parameter 89. If the platform can't fork, write the
+	image in the foreground. Fail if a previous background snapshot is still
+	being written, since both would write the same file. */
+
+	/* StackInterpreter>>#writeImageFileInBackground */
+static sqInt NeverInline
+writeImageFileInBackground(void)
+{   DECL_MAYBE_SQ_GLOBAL_STRUCT
+    int forked;
+
+	forked = ioForkForSnapshot(GIV(backgroundSnapshotSemaphoreIndex));
+	if (forked == -1) {
+		return writeImageFileIO();
+	}
+	if (forked == -2) {
+		/* begin primitiveFailFor: */
+		return (GIV(primFailCode) = PrimErrInappropriate);
+	}
+	if (forked == 0) {
+		writeImageFileIO();
+		ioExitSnapshotChild((GIV(primFailCode)
+			? 1
+			: 0));
+	}
+	return 0;
+}
+
 	/* StackInterpreterPrimitives>>#cloneContext: */
 static sqInt NoDbgRegParms
 cloneContext(sqInt aContext)
@@ -76789,6 +82733,7 @@ primitiveFullGC(void)
 	(GIV(stackPage)->headSP = GIV(stackPointer));
 	assert(pageListIsWellFormed());
 	/* begin pop:thenPushInteger: */
+	GIV(gcCause) = "request";
 	integerVal = fullGC();
 	longAtput((sp = GIV(stackPointer) + ((1 - 1) * BytesPerWord)), (((usqInt)integerVal << 3) | 1));
 	GIV(stackPointer) = sp;
@@ -76835,6 +82780,7 @@ primitiveIncrementalGC(void)
 	(GIV(stackPage)->headSP = GIV(stackPointer));
 	assert(pageListIsWellFormed());
 	/* begin scavengingGC */
+	GIV(gcCause) = "request";
 	scavengingGCTenuringIf(TenureByAge);
 	/* begin pop:thenPushInteger: */
 	integerVal = (((GIV(totalFreeOldSpace) + ((((eden()).limit)) - GIV(freeStart))) + ((((pastSpace()).limit)) - GIV(pastSpaceStart))) + ((((futureSpace()).limit)) - (((futureSpace()).limit)))) - (interpreterAllocationReserveBytes());
@@ -78242,6 +84188,71 @@ primitiveStoreStackp(void)
 	72 total milliseconds in full GCs Mark phase since startup (read-only)
 	73 total milliseconds in full GCs Sweep phase since startup (read-only,
 	can be 0 depending on compactors)
+	74 total milliseconds in full GCs marking from the stack pages and interpreter
+	roots and pruning the remembered set since startup (read-only)
+	75 the number of scavenges an object must survive before it is tenured, at
+	most 15, or 0 if tenuring is by proportion of survivor space (the default)
+	(read-write)
+	76 an Array of the bytes surviving scavenges since startup, indexed by the
+	number of scavenges survived beforehand (0 for objects leaving eden), the
+	last element counting that age and older (read-only)
+	77 the ratio of bytes moved to bytes reclaimed above which a full GC sweeps
+	old space in place instead of compacting it, or 0 to always compact
+	(read-write)
+	78 the number of full GCs that swept old space instead of compacting it
+	since startup (read-only)
+	79 the size in bytes at or above which an old space object is allocated in a
+	segment of its own, or 0 if large objects are not treated specially; if
+	not 0, at least the size of a page (read-write)
+	80 the number of segments currently holding a large object (read-only)
+	81 the bytes of address space reserved for old space segments (read-only)
+	82 the bytes of old space segments committed, i.e. backed by physical
+	memory (read-only)
+	83 total bytes of free old space given back to the OS since startup
+	(read-only)
+	84 the bytes of old space segments backed by huge pages (read-only)
+	85 the bytes of new space backed by huge pages (read-only)
+	86 the memory limit imposed on the VM process, e.g. by its cgroup, or 0 if
+	none (read-only)
+	87 the number of full GCs run because memory use neared that limit
+	(read-only)
+	88 the index of the semaphore to signal when a snapshot written in the
+	background completes, or 0 to write snapshots in the foreground
+	(read-write)
+	89 the exit status of the process that wrote the last background snapshot,
+	0 on success, or -1 while it is still being written (read-only)
+	90 non-zero if snapshots write the heap data compressed, which is set
+	when an image that was saved compressed is loaded (read-write)
+	91 the pause target in microseconds for full GCs, which when non-zero sweep
+	old space incrementally, in steps of at most this long (read-write)
+	92 number of incremental mark and sweep steps since startup (read-only)
+	93 total microseconds spent in incremental mark and sweep steps since startup (read-only)
+	94 microseconds taken by the last incremental mark or sweep step (read-only)
+	95 microseconds taken by the longest incremental mark or sweep step (read-only)
+	96 the size in bytes of the segments set aside for pinned objects, or 0 if
+	pinned objects are allocated amongst the others (read-write)
+	97 the number of segments set aside for pinned objects (read-only)
+	98 the free space in bytes in segments set aside for pinned objects (read-only)
+	99 the number of pinned buffers reused from the pool since startup (read-only)
+	100 the number of entries in the interpreter's method cache, as set by
+	-methodcache (read-only)
+	101 number of interpreter method cache hits since startup (read-only)
+	102 number of interpreter method cache misses since startup (read-only)
+	103 number of interpreter method cache entries evicted since startup (read-only)
+	104 number of methods and blocks compiled to machine code since startup (read-only)
+	105 number of machine code methods freed by code compaction since startup
+	(read-only)
+	106 the size in bytes up to which the machine code zone may grow, as set by
+	-maxcodesize (read-only)
+	107 number of methods compiled at start-up from the -codecache file
+	(read-only)
+	108 non-zero if old space is marked in the background between full GCs, as
+	set by -concurrentmark (read-write)
+	109 number of background marks completed since startup (read-only)
+	110 total milliseconds spent marking in the background since startup
+	(read-only)
+	111 total milliseconds in the pauses that complete background marks since
+	startup (read-only)
 	
 	Note: Thanks to Ian Piumarta for this primitive. */
 
@@ -78316,13 +84327,51 @@ primitiveVMParameter(void)
     sqInt valuePointer56;
     sqInt valuePointer57;
     sqInt valuePointer58;
+    sqInt valuePointer59;
     sqInt valuePointer6;
+    sqInt valuePointer60;
+    sqInt valuePointer61;
+    sqInt valuePointer62;
+    sqInt valuePointer63;
+    sqInt valuePointer64;
+    sqInt valuePointer65;
+    sqInt valuePointer66;
+    sqInt valuePointer67;
+    sqInt valuePointer68;
+    sqInt valuePointer69;
     sqInt valuePointer7;
+    sqInt valuePointer70;
+    sqInt valuePointer71;
+    sqInt valuePointer72;
+    sqInt valuePointer73;
+    sqInt valuePointer74;
+    sqInt valuePointer75;
+    sqInt valuePointer76;
+    sqInt valuePointer77;
+    sqInt valuePointer78;
+    sqInt valuePointer79;
     sqInt valuePointer8;
+    sqInt valuePointer80;
+    sqInt valuePointer81;
+    sqInt valuePointer82;
+    sqInt valuePointer83;
+    sqInt valuePointer84;
+    sqInt valuePointer85;
+    sqInt valuePointer86;
+    sqInt valuePointer87;
+    sqInt valuePointer88;
+    sqInt valuePointer89;
+    sqInt valuePointer90;
+    sqInt valuePointer91;
+    sqInt valuePointer92;
+    sqInt valuePointer93;
+    sqInt valuePointer94;
+    sqInt valuePointer95;
+    sqInt valuePointer96;
     sqInt valuePointer9;
 
 	result = 0;
-	paramsArraySize = 73;
+	paramsArraySize = 111;
 	if (GIV(argumentCount) == 0) {
 		result = instantiateClassindexableSize(splObj(ClassArray), paramsArraySize);
 		/* begin storePointerUnchecked:ofObject:withValue: */
@@ -78596,6 +84645,158 @@ primitiveVMParameter(void)
 		valuePointer58 = ((((GIV(statSweepUsecs) + 500) / 1000) << 3) | 1);
 		assert(!(isOopForwarded(result)));
 		longAtput((result + BaseHeaderSize) + (72U << (shiftForWord())), valuePointer58);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer59 = ((((GIV(statRootMarkUsecs) + 500) / 1000) << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (73U << (shiftForWord())), valuePointer59);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer60 = (((usqInt)tenuringAge << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (74U << (shiftForWord())), valuePointer60);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer61 = survivorAgeHistogram();
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (75U << (shiftForWord())), valuePointer61);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer62 = (((usqInt)compactionMoveRatio << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (76U << (shiftForWord())), valuePointer62);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer63 = (((usqInt)GIV(statNonCompactingGCs) << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (77U << (shiftForWord())), valuePointer63);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer64 = (((usqInt)largeObjectThreshold << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (78U << (shiftForWord())), valuePointer64);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer65 = (((usqInt)GIV(numLargeObjectSegments) << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (79U << (shiftForWord())), valuePointer65);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer66 = (((usqInt)GIV(totalHeapSizeIncludingBridges) << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (80U << (shiftForWord())), valuePointer66);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer67 = (((usqInt)(totalResidentBytesInSegments()) << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (81U << (shiftForWord())), valuePointer67);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer68 = positive64BitIntegerFor(GIV(statDecommittedBytes));
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (82U << (shiftForWord())), valuePointer68);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer69 = (((usqInt)(totalHugePageBytesInSegments()) << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (83U << (shiftForWord())), valuePointer69);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer70 = (((usqInt)(sqHugePageBytesFromTo(GIV(newSpaceStart), GIV(newSpaceLimit))) << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (84U << (shiftForWord())), valuePointer70);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer71 = (((usqInt)(sqMemoryLimit()) << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (85U << (shiftForWord())), valuePointer71);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer72 = (((usqInt)GIV(statMemoryLimitGCs) << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (86U << (shiftForWord())), valuePointer72);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer73 = (((usqInt)GIV(backgroundSnapshotSemaphoreIndex) << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (87U << (shiftForWord())), valuePointer73);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer74 = (((sqInt)((usqInt)(ioBackgroundSnapshotStatus()) << 3) | 1));
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (88U << (shiftForWord())), valuePointer74);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer75 = (((usqInt)GIV(compressImageHeapData) << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (89U << (shiftForWord())), valuePointer75);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer76 = (((usqInt)maxGCPauseUsecs << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (90U << (shiftForWord())), valuePointer76);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer77 = (((usqInt)GIV(statIncrGCs) << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (91U << (shiftForWord())), valuePointer77);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer78 = positive64BitIntegerFor(GIV(statIncrGCUsecs));
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (92U << (shiftForWord())), valuePointer78);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer79 = positive64BitIntegerFor(GIV(statIGCDeltaUsecs));
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (93U << (shiftForWord())), valuePointer79);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer80 = positive64BitIntegerFor(GIV(statMaxIncrGCUsecs));
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (94U << (shiftForWord())), valuePointer80);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer81 = (((usqInt)pinnedSegmentSize << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (95U << (shiftForWord())), valuePointer81);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer82 = (((usqInt)GIV(numPinnedSegments) << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (96U << (shiftForWord())), valuePointer82);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer83 = (((usqInt)GIV(totalFreePinnedSpace) << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (97U << (shiftForWord())), valuePointer83);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer84 = (((usqInt)GIV(statPinnedBufferReuses) << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (98U << (shiftForWord())), valuePointer84);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer85 = (((usqInt)methodCacheEntries << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (99U << (shiftForWord())), valuePointer85);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer86 = positive64BitIntegerFor(GIV(statMethodCacheHits));
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (100U << (shiftForWord())), valuePointer86);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer87 = positive64BitIntegerFor(GIV(statMethodCacheMisses));
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (101U << (shiftForWord())), valuePointer87);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer88 = positive64BitIntegerFor(GIV(statMethodCacheEvictions));
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (102U << (shiftForWord())), valuePointer88);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer89 = positive64BitIntegerFor(statCodeCompilations);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (103U << (shiftForWord())), valuePointer89);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer90 = positive64BitIntegerFor(statCodeEvictions);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (104U << (shiftForWord())), valuePointer90);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer91 = (((usqInt)GIV(cogCodeSizeLimit) << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (105U << (shiftForWord())), valuePointer91);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer92 = (((usqInt)GIV(statMachineCodeCacheCompilations) << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (106U << (shiftForWord())), valuePointer92);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer93 = (((usqInt)concurrentMarkEnabled << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (107U << (shiftForWord())), valuePointer93);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer94 = (((usqInt)GIV(statConcurrentMarks) << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (108U << (shiftForWord())), valuePointer94);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer95 = ((((GIV(statConcurrentMarkUsecs) + 500) / 1000) << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (109U << (shiftForWord())), valuePointer95);
+		/* begin storePointerUnchecked:ofObject:withValue: */
+		valuePointer96 = ((((GIV(statConcurrentRemarkUsecs) + 500) / 1000) << 3) | 1);
+		assert(!(isOopForwarded(result)));
+		longAtput((result + BaseHeaderSize) + (110U << (shiftForWord())), valuePointer96);
 		beRootIfOld(result);
 		/* begin pop:thenPush: */
 		longAtput((sp = GIV(stackPointer) + ((1 - 1) * BytesPerWord)), result);
@@ -78847,6 +85048,120 @@ primitiveVMParameter(void)
 		if (arg == 73) {
 			result = ((((GIV(statSweepUsecs) + 500) / 1000) << 3) | 1);
 		}
+		if (arg == 74) {
+			result = ((((GIV(statRootMarkUsecs) + 500) / 1000) << 3) | 1);
+		}
+		if (arg == 75) {
+			result = (((usqInt)tenuringAge << 3) | 1);
+		}
+		if (arg == 76) {
+			result = survivorAgeHistogram();
+		}
+		if (arg == 77) {
+			result = (((usqInt)compactionMoveRatio << 3) | 1);
+		}
+		if (arg == 78) {
+			result = (((usqInt)GIV(statNonCompactingGCs) << 3) | 1);
+		}
+		if (arg == 79) {
+			result = (((usqInt)largeObjectThreshold << 3) | 1);
+		}
+		if (arg == 80) {
+			result = (((usqInt)GIV(numLargeObjectSegments) << 3) | 1);
+		}
+		if (arg == 81) {
+			result = (((usqInt)GIV(totalHeapSizeIncludingBridges) << 3) | 1);
+		}
+		if (arg == 82) {
+			result = (((usqInt)(totalResidentBytesInSegments()) << 3) | 1);
+		}
+		if (arg == 83) {
+			result = positive64BitIntegerFor(GIV(statDecommittedBytes));
+		}
+		if (arg == 84) {
+			result = (((usqInt)(totalHugePageBytesInSegments()) << 3) | 1);
+		}
+		if (arg == 85) {
+			result = (((usqInt)(sqHugePageBytesFromTo(GIV(newSpaceStart), GIV(newSpaceLimit))) << 3) | 1);
+		}
+		if (arg == 86) {
+			result = (((usqInt)(sqMemoryLimit()) << 3) | 1);
+		}
+		if (arg == 87) {
+			result = (((usqInt)GIV(statMemoryLimitGCs) << 3) | 1);
+		}
+		if (arg == 88) {
+			result = (((usqInt)GIV(backgroundSnapshotSemaphoreIndex) << 3) | 1);
+		}
+		if (arg == 89) {
+			result = (((sqInt)((usqInt)(ioBackgroundSnapshotStatus()) << 3) | 1));
+		}
+		if (arg == 90) {
+			result = (((usqInt)GIV(compressImageHeapData) << 3) | 1);
+		}
+		if (arg == 91) {
+			result = (((usqInt)maxGCPauseUsecs << 3) | 1);
+		}
+		if (arg == 92) {
+			result = (((usqInt)GIV(statIncrGCs) << 3) | 1);
+		}
+		if (arg == 93) {
+			result = positive64BitIntegerFor(GIV(statIncrGCUsecs));
+		}
+		if (arg == 94) {
+			result = positive64BitIntegerFor(GIV(statIGCDeltaUsecs));
+		}
+		if (arg == 95) {
+			result = positive64BitIntegerFor(GIV(statMaxIncrGCUsecs));
+		}
+		if (arg == 96) {
+			result = (((usqInt)pinnedSegmentSize << 3) | 1);
+		}
+		if (arg == 97) {
+			result = (((usqInt)GIV(numPinnedSegments) << 3) | 1);
+		}
+		if (arg == 98) {
+			result = (((usqInt)GIV(totalFreePinnedSpace) << 3) | 1);
+		}
+		if (arg == 99) {
+			result = (((usqInt)GIV(statPinnedBufferReuses) << 3) | 1);
+		}
+		if (arg == 100) {
+			result = (((usqInt)methodCacheEntries << 3) | 1);
+		}
+		if (arg == 101) {
+			result = positive64BitIntegerFor(GIV(statMethodCacheHits));
+		}
+		if (arg == 102) {
+			result = positive64BitIntegerFor(GIV(statMethodCacheMisses));
+		}
+		if (arg == 103) {
+			result = positive64BitIntegerFor(GIV(statMethodCacheEvictions));
+		}
+		if (arg == 104) {
+			result = positive64BitIntegerFor(statCodeCompilations);
+		}
+		if (arg == 105) {
+			result = positive64BitIntegerFor(statCodeEvictions);
+		}
+		if (arg == 106) {
+			result = (((usqInt)GIV(cogCodeSizeLimit) << 3) | 1);
+		}
+		if (arg == 107) {
+			result = (((usqInt)GIV(statMachineCodeCacheCompilations) << 3) | 1);
+		}
+		if (arg == 108) {
+			result = (((usqInt)concurrentMarkEnabled << 3) | 1);
+		}
+		if (arg == 109) {
+			result = (((usqInt)GIV(statConcurrentMarks) << 3) | 1);
+		}
+		if (arg == 110) {
+			result = ((((GIV(statConcurrentMarkUsecs) + 500) / 1000) << 3) | 1);
+		}
+		if (arg == 111) {
+			result = ((((GIV(statConcurrentRemarkUsecs) + 500) / 1000) << 3) | 1);
+		}
 		/* begin pop:thenPush: */
 		longAtput((sp1 = GIV(stackPointer) + ((2 - 1) * BytesPerWord)), result);
 		GIV(stackPointer) = sp1;
@@ -79065,6 +85380,64 @@ primitiveVMParameter(void)
 		/* begin initPrimCall */
 		GIV(primFailCode) = 0;
 	}
+	if ((index == 75)
+	 && ((arg >= 0)
+	 && (arg <= MaxSurvivorAge))) {
+		result = (((usqInt)tenuringAge << 3) | 1);
+		tenuringAge = arg;
+		/* begin initPrimCall */
+		GIV(primFailCode) = 0;
+	}
+	if ((index == 77)
+	 && (arg >= 0)) {
+		result = (((usqInt)compactionMoveRatio << 3) | 1);
+		compactionMoveRatio = arg;
+		/* begin initPrimCall */
+		GIV(primFailCode) = 0;
+	}
+	if ((index == 79)
+	 && ((arg == 0)
+	 || (arg >= ((sqInt) (sqDirtyPageSize()))))) {
+		result = (((usqInt)largeObjectThreshold << 3) | 1);
+		largeObjectThreshold = arg;
+		/* begin initPrimCall */
+		GIV(primFailCode) = 0;
+	}
+	if ((index == 88)
+	 && (arg >= 0)) {
+		result = (((usqInt)GIV(backgroundSnapshotSemaphoreIndex) << 3) | 1);
+		GIV(backgroundSnapshotSemaphoreIndex) = arg;
+		/* begin initPrimCall */
+		GIV(primFailCode) = 0;
+	}
+	if ((index == 90)
+	 && (arg >= 0)) {
+		result = (((usqInt)GIV(compressImageHeapData) << 3) | 1);
+		GIV(compressImageHeapData) = arg != 0;
+		/* begin initPrimCall */
+		GIV(primFailCode) = 0;
+	}
+	if ((index == 91)
+	 && (arg >= 0)) {
+		result = (((usqInt)maxGCPauseUsecs << 3) | 1);
+		maxGCPauseUsecs = arg;
+		/* begin initPrimCall */
+		GIV(primFailCode) = 0;
+	}
+	if ((index == 96)
+	 && (arg >= 0)) {
+		result = (((usqInt)pinnedSegmentSize << 3) | 1);
+		pinnedSegmentSize = arg;
+		/* begin initPrimCall */
+		GIV(primFailCode) = 0;
+	}
+	if ((index == 108)
+	 && (arg >= 0)) {
+		result = (((usqInt)concurrentMarkEnabled << 3) | 1);
+		concurrentMarkEnabled = arg;
+		/* begin initPrimCall */
+		GIV(primFailCode) = 0;
+	}
 	if (!GIV(primFailCode)) {
 		/* begin pop:thenPush: */
 		longAtput((sp2 = GIV(stackPointer) + ((3 - 1) * BytesPerWord)), result);
@@ -79354,10 +85727,12 @@ void* vm_exports[][3] = {
 	{(void*)_m, "primitiveAddLargeIntegers\000\377", (void*)primitiveAddLargeIntegers},
 	{(void*)_m, "primitiveAllInstances\000\377", (void*)primitiveAllInstances},
 	{(void*)_m, "primitiveAllObjects\000\377", (void*)primitiveAllObjects},
+	{(void*)_m, "primitiveAllocationSamples\000\377", (void*)primitiveAllocationSamples},
 	{(void*)_m, "primitiveBitAndLargeIntegers\000\377", (void*)primitiveBitAndLargeIntegers},
 	{(void*)_m, "primitiveBitOrLargeIntegers\000\377", (void*)primitiveBitOrLargeIntegers},
 	{(void*)_m, "primitiveBitShiftLargeIntegers\000\377", (void*)primitiveBitShiftLargeIntegers},
 	{(void*)_m, "primitiveBitXorLargeIntegers\000\377", (void*)primitiveBitXorLargeIntegers},
+	{(void*)_m, "primitiveClassCensus\000\377", (void*)primitiveClassCensus},
 	{(void*)_m, "primitiveClockLogAddresses\000\377", (void*)primitiveClockLogAddresses},
 	{(void*)_m, "primitiveCompareBytes\000\377", (void*)primitiveCompareBytes},
 	{(void*)_m, "primitiveCompareWith\000\377", (void*)primitiveCompareWith},
@@ -79402,6 +85777,8 @@ void* vm_exports[][3] = {
 	{(void*)_m, "primitiveSetLogDirectory\000\377", (void*)primitiveSetLogDirectory},
 	{(void*)_m, "primitiveSetWindowLabel\000\377", (void*)primitiveSetWindowLabel},
 	{(void*)_m, "primitiveSetWindowSize\000\377", (void*)primitiveSetWindowSize},
+	{(void*)_m, "primitiveStartAllocationSampling\000\377", (void*)primitiveStartAllocationSampling},
+	{(void*)_m, "primitiveStopAllocationSampling\000\377", (void*)primitiveStopAllocationSampling},
 	{(void*)_m, "primitiveSubtractLargeIntegers\000\377", (void*)primitiveSubtractLargeIntegers},
 	{(void*)_m, "primitiveUtcWithOffset\000\377", (void*)primitiveUtcWithOffset},
 	{(void*)_m, "primitiveVoidReceiver\000\377", (void*)primitiveVoidReceiver},
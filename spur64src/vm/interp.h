@@ -3,7 +3,7 @@
  */
 
 #define VM_PROXY_MAJOR 1
-#define VM_PROXY_MINOR 14
+#define VM_PROXY_MINOR 15
 
 #define SQ_VI_BYTES_PER_WORD 8
 
@@ -45,10 +45,16 @@
 
 #define STACKVM 1
 #define SPURVM 1
+#define SPURGCOPTIONS 1
+#define SIZABLEMETHODCACHE 1
 #define DisownVMLockOutFullGC 8
 #define DisownVMForFFICall 16
 #define DisownVMForThreading 32
 #define COGVM 1
+#define COGMAXPIC 1
+#define COGCODELOADHOOK 1
+#define COGGROWABLECODEZONE 1
+#define COGCODECACHE 1
 #if !defined(COGMTVM)
 # define COGMTVM 0
 #endif
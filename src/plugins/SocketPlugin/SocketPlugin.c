@@ -70,6 +70,7 @@ EXPORT(sqInt) primitiveSocketAccept(void);
 EXPORT(sqInt) primitiveSocketAccept3Semaphores(void);
 EXPORT(sqInt) primitiveSocketAddressGetPort(void);
 EXPORT(sqInt) primitiveSocketAddressSetPort(void);
+EXPORT(sqInt) primitiveSocketAllocateBuffer(void);
 EXPORT(sqInt) primitiveSocketBindTo(void);
 EXPORT(sqInt) primitiveSocketBindToPort(void);
 EXPORT(sqInt) primitiveSocketCloseConnection(void);
@@ -94,6 +95,7 @@ EXPORT(sqInt) primitiveSocketLocalPort(void);
 EXPORT(sqInt) primitiveSocketReceiveDataAvailable(void);
 EXPORT(sqInt) primitiveSocketReceiveDataBufCount(void);
 EXPORT(sqInt) primitiveSocketReceiveUDPDataBufCount(void);
+EXPORT(sqInt) primitiveSocketReleaseBuffer(void);
 EXPORT(sqInt) primitiveSocketRemoteAddress(void);
 EXPORT(sqInt) primitiveSocketRemoteAddressResult(void);
 EXPORT(sqInt) primitiveSocketRemoteAddressSize(void);
@@ -112,6 +114,7 @@ static sqInt sqAssert(sqInt aBool);
 /*** Variables ***/
 
 #if !defined(SQUEAK_BUILTIN_PLUGIN)
+static sqInt (*allocatePinnedBuffer)(sqInt byteSize);
 static sqInt (*byteSizeOf)(sqInt oop);
 static sqInt (*classArray)(void);
 static sqInt (*classByteArray)(void);
@@ -131,6 +134,7 @@ static sqInt (*popthenPush)(sqInt nItems, sqInt oop);
 static sqInt (*popRemappableOop)(void);
 static sqInt (*primitiveFail)(void);
 static sqInt (*pushRemappableOop)(sqInt oop);
+static sqInt (*releasePinnedBuffer)(sqInt buffer);
 static sqInt (*slotSizeOf)(sqInt oop);
 static sqInt (*stackIntegerValue)(sqInt offset);
 static sqInt (*stackValue)(sqInt offset);
@@ -138,6 +142,11 @@ static sqInt (*storePointerofObjectwithValue)(sqInt index, sqInt oop, sqInt valu
 static sqInt (*success)(sqInt aBoolean);
 static sqInt (*trueObject)(void);
 #else /* !defined(SQUEAK_BUILTIN_PLUGIN) */
+#if VM_PROXY_MAJOR > 1 || (VM_PROXY_MAJOR == 1 && VM_PROXY_MINOR >= 15)
+extern sqInt allocatePinnedBuffer(sqInt byteSize);
+#else
+# define allocatePinnedBuffer(byteSize) 0
+#endif
 extern sqInt byteSizeOf(sqInt oop);
 extern sqInt classArray(void);
 extern sqInt classByteArray(void);
@@ -157,6 +166,11 @@ extern sqInt popthenPush(sqInt nItems, sqInt oop);
 extern sqInt popRemappableOop(void);
 extern sqInt primitiveFail(void);
 extern sqInt pushRemappableOop(sqInt oop);
+#if VM_PROXY_MAJOR > 1 || (VM_PROXY_MAJOR == 1 && VM_PROXY_MINOR >= 15)
+extern sqInt releasePinnedBuffer(sqInt buffer);
+#else
+# define releasePinnedBuffer(buffer) 0
+#endif
 extern sqInt slotSizeOf(sqInt oop);
 extern sqInt stackIntegerValue(sqInt offset);
 extern sqInt stackValue(sqInt offset);
@@ -956,6 +970,41 @@ primitiveSocketAddressSetPort(void)
 	return null;
 }
 
+
+/*	Answer a pinned ByteArray of at least size bytes to send from or receive
+	into, which is not moved while a transfer is under way. It is taken from
+	the VM's pool of pinned buffers when there is one of the right size. The
+	VM keeps it alive until it is handed back by
+	primitiveSocketReleaseBuffer:; see releasePinnedBuffer:. */
+
+	/* SocketPlugin>>#primitiveSocketAllocateBuffer: */
+EXPORT(sqInt)
+primitiveSocketAllocateBuffer(void)
+{
+#if VM_PROXY_MAJOR > 1 || (VM_PROXY_MAJOR == 1 && VM_PROXY_MINOR >= 15)
+	sqInt buffer;
+	sqInt size;
+
+	if ((interpreterProxy->minorVersion()) < 15) {
+		primitiveFail();
+		return null;
+	}
+	size = stackIntegerValue(0);
+	if (failed()) {
+		return null;
+	}
+	buffer = allocatePinnedBuffer(size);
+	if (buffer == 0) {
+		primitiveFail();
+		return null;
+	}
+	popthenPush(2, buffer);
+#else
+	primitiveFail();
+#endif
+	return null;
+}
+
 	/* SocketPlugin>>#primitiveSocket:bindTo: */
 EXPORT(sqInt)
 primitiveSocketBindTo(void)
@@ -1877,6 +1926,35 @@ primitiveSocketReceiveUDPDataBufCount(void)
 	return null;
 }
 
+
+/*	Hand back a buffer answered by primitiveSocketAllocateBuffer:. If the
+	next full GC finds nothing else referring to it, it is returned to the
+	pool; if something still does, it is left to the GC like any other
+	object. */
+
+	/* SocketPlugin>>#primitiveSocketReleaseBuffer: */
+EXPORT(sqInt)
+primitiveSocketReleaseBuffer(void)
+{
+#if VM_PROXY_MAJOR > 1 || (VM_PROXY_MAJOR == 1 && VM_PROXY_MINOR >= 15)
+	sqInt buffer;
+
+	if ((interpreterProxy->minorVersion()) < 15) {
+		primitiveFail();
+		return null;
+	}
+	buffer = stackValue(0);
+	if (failed()) {
+		return null;
+	}
+	releasePinnedBuffer(buffer);
+	pop(1);
+#else
+	primitiveFail();
+#endif
+	return null;
+}
+
 	/* SocketPlugin>>#primitiveSocketRemoteAddress: */
 EXPORT(sqInt)
 primitiveSocketRemoteAddress(void)
@@ -2227,6 +2305,15 @@ setInterpreter(struct VirtualMachine*anInterpreter)
 	if (ok) {
 		
 #if !defined(SQUEAK_BUILTIN_PLUGIN)
+#if VM_PROXY_MAJOR > 1 || (VM_PROXY_MAJOR == 1 && VM_PROXY_MINOR >= 15)
+		allocatePinnedBuffer = ((interpreterProxy->minorVersion()) >= 15
+			? interpreterProxy->allocatePinnedBuffer
+			: 0);
+#else
+#if !defined(allocatePinnedBuffer)
+		allocatePinnedBuffer = 0;
+#endif
+#endif
 		byteSizeOf = interpreterProxy->byteSizeOf;
 		classArray = interpreterProxy->classArray;
 		classByteArray = interpreterProxy->classByteArray;
@@ -2246,6 +2333,15 @@ setInterpreter(struct VirtualMachine*anInterpreter)
 		popRemappableOop = interpreterProxy->popRemappableOop;
 		primitiveFail = interpreterProxy->primitiveFail;
 		pushRemappableOop = interpreterProxy->pushRemappableOop;
+#if VM_PROXY_MAJOR > 1 || (VM_PROXY_MAJOR == 1 && VM_PROXY_MINOR >= 15)
+		releasePinnedBuffer = ((interpreterProxy->minorVersion()) >= 15
+			? interpreterProxy->releasePinnedBuffer
+			: 0);
+#else
+#if !defined(releasePinnedBuffer)
+		releasePinnedBuffer = 0;
+#endif
+#endif
 		slotSizeOf = interpreterProxy->slotSizeOf;
 		stackIntegerValue = interpreterProxy->stackIntegerValue;
 		stackValue = interpreterProxy->stackValue;
@@ -2335,6 +2431,7 @@ void* SocketPlugin_exports[][3] = {
 	{(void*)_m, "primitiveSocketAccept3Semaphores\000\000", (void*)primitiveSocketAccept3Semaphores},
 	{(void*)_m, "primitiveSocketAddressGetPort\000\000", (void*)primitiveSocketAddressGetPort},
 	{(void*)_m, "primitiveSocketAddressSetPort\000\000", (void*)primitiveSocketAddressSetPort},
+	{(void*)_m, "primitiveSocketAllocateBuffer\000\000", (void*)primitiveSocketAllocateBuffer},
 	{(void*)_m, "primitiveSocketBindTo\000\000", (void*)primitiveSocketBindTo},
 	{(void*)_m, "primitiveSocketBindToPort\000\000", (void*)primitiveSocketBindToPort},
 	{(void*)_m, "primitiveSocketCloseConnection\000\000", (void*)primitiveSocketCloseConnection},
@@ -2359,6 +2456,7 @@ void* SocketPlugin_exports[][3] = {
 	{(void*)_m, "primitiveSocketReceiveDataAvailable\000\000", (void*)primitiveSocketReceiveDataAvailable},
 	{(void*)_m, "primitiveSocketReceiveDataBufCount\000\000", (void*)primitiveSocketReceiveDataBufCount},
 	{(void*)_m, "primitiveSocketReceiveUDPDataBufCount\000\000", (void*)primitiveSocketReceiveUDPDataBufCount},
+	{(void*)_m, "primitiveSocketReleaseBuffer\000\000", (void*)primitiveSocketReleaseBuffer},
 	{(void*)_m, "primitiveSocketRemoteAddress\000\000", (void*)primitiveSocketRemoteAddress},
 	{(void*)_m, "primitiveSocketRemoteAddressResult\000\000", (void*)primitiveSocketRemoteAddressResult},
 	{(void*)_m, "primitiveSocketRemoteAddressSize\000\000", (void*)primitiveSocketRemoteAddressSize},
@@ -2382,6 +2480,7 @@ signed char primitiveSocketAcceptAccessorDepth = 0;
 signed char primitiveSocketAccept3SemaphoresAccessorDepth = 0;
 signed char primitiveSocketAddressGetPortAccessorDepth = 0;
 signed char primitiveSocketAddressSetPortAccessorDepth = 0;
+signed char primitiveSocketAllocateBufferAccessorDepth = 0;
 signed char primitiveSocketBindToAccessorDepth = 0;
 signed char primitiveSocketBindToPortAccessorDepth = 0;
 signed char primitiveSocketCloseConnectionAccessorDepth = 0;
@@ -2406,6 +2505,7 @@ signed char primitiveSocketLocalPortAccessorDepth = 0;
 signed char primitiveSocketReceiveDataAvailableAccessorDepth = 0;
 signed char primitiveSocketReceiveDataBufCountAccessorDepth = 0;
 signed char primitiveSocketReceiveUDPDataBufCountAccessorDepth = 0;
+signed char primitiveSocketReleaseBufferAccessorDepth = 0;
 signed char primitiveSocketRemoteAddressAccessorDepth = 0;
 signed char primitiveSocketRemoteAddressResultAccessorDepth = 0;
 signed char primitiveSocketRemoteAddressSizeAccessorDepth = 0;